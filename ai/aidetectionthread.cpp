@@ -1,4 +1,8 @@
 #include "aidetectionthread.h"
+#include "../core/Logging.h"
+#include "../core/TraceRecorder.h"
+#include "../core/FlightRecorder.h"
+#include "snapshotservice.h"
 #include <QDebug>
 #include <QCoreApplication>
 #include <QTimer>
@@ -11,13 +15,31 @@ AIDetectionThread::AIDetectionThread(QObject *parent)
     , m_faceDatabase(new FaceDatabase(this))
     , m_faceManager(nullptr)
     , m_faceRecognitionEnabled(true)
-    , m_faceDetectionFrameCounter(0)
     , m_totalFaceDetections(0)
     , m_totalFaceRecognitions(0)
+    , m_pendingFaceFrames(m_resultPool)
 {
     qDebug() << "--------AIDetectionThread constructor started------------";
     qDebug() << "m_faceDatabase created at address:" << (void*)m_faceDatabase;
 
+    m_latencyClock.start();
+    applySchedulerBudget(m_config);
+
+    // 与来源无关的指标在构造时注册
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    m_recognitionEvents = metrics.counter("ai.recognition.events");
+    m_unknownFaceEvents = metrics.counter("ai.recognition.unknown_events");
+    m_recognitionSimilarity = metrics.histogram("ai.recognition.similarity", MetricsRegistry::kAllSources,
+                                                { 0.3, 0.4, 0.5, 0.6, 0.65, 0.7, 0.75, 0.8, 0.85, 0.9, 0.95, 1.0 });
+    m_qualitySkipped = metrics.gauge("ai.quality.skipped");
+    m_qualityReused = metrics.gauge("ai.quality.reused_from_track");
+    m_poolInUse = metrics.gauge("ai.pool.in_use");
+    m_poolAverageWaitMs = metrics.gauge("ai.pool.average_wait_ms");
+    m_queueDepth = metrics.gauge("ai.queue.depth");
+    m_queueFillPercent = metrics.gauge("ai.queue.fill_pct");
+    m_queueDropped = metrics.counter("ai.queue.dropped");
+    m_batchPendingFrames = metrics.gauge("ai.batch.pending_frames");
+
     // 初始化人脸识别管理器
     if (!initializeFaceRecognition()) {
         qDebug() << "AIDetectionThread: Face recognition initialization failed";
@@ -81,31 +103,106 @@ AIConfig AIDetectionThread::getConfig() {
 
 void AIDetectionThread::setConfig(const AIConfig& config)
 {
-    QMutexLocker locker(&m_mutex);
-    m_config = config;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_config = config;
 
-    // 更新检测器配置
-    if (m_motionDetector) {
-        m_motionDetector->setThreshold(config.motionThreshold);
-        m_motionDetector->setROI(config.roiArea);
+        applySchedulerBudget(config);
+
+        // 更新检测器配置
+        if (m_motionDetector) {
+            m_motionDetector->setThreshold(config.motionThreshold);
+            m_motionDetector->setROI(config.roiArea);
+        }
+    }
+
+    // 🔧 人脸相关配置在锁外应用：切换后端/池大小会加载模型，持有 m_mutex 会让采集线程的 addFrame 一直阻塞。
+    //    推理池在新上下文就绪后才整体换入，期间检测继续使用旧上下文
+    if (m_faceManager) {
+        // 多模板人脸库的聚合与容量策略
+        m_faceManager->setTemplatePolicy(config.templateAggregation,
+                                         config.templateTopN,
+                                         config.maxTemplatesPerPerson);
+        m_faceManager->batchScheduler()->setMaxBatchSize(config.faceBatchSize);
+        m_faceManager->batchScheduler()->setMaxLatencyMs(config.faceBatchLatencyMs);
+        m_faceManager->setInferenceBackend(config.inferenceBackend);
+        m_faceManager->setInferencePoolSize(config.inferencePoolSize);
+
+        FaceQualityConfig quality;
+        quality.enabled = config.enableFaceQualityGate;
+        quality.minFaceSize = config.minFaceSize;
+        quality.minSharpness = config.minFaceSharpness;
+        quality.maxYaw = config.maxFaceYaw;
+        quality.minBrightness = config.minFaceBrightness;
+        quality.maxBrightness = config.maxFaceBrightness;
+        quality.trackReuseMs = config.faceTrackReuseMs;
+        m_faceManager->setQualityConfig(quality);
     }
 }
 
-void AIDetectionThread::addFrame(const QImage& frame)
+void AIDetectionThread::applySchedulerBudget(const AIConfig& config)
 {
-    QMutexLocker locker(&m_mutex);
+    LatencyScheduler::Budget budget;
+    budget.adaptive = config.enableAdaptiveScheduling;
+    budget.targetLatencyMs = config.targetLatencyMs;
+    budget.cpuBudget = config.cpuBudget;
+    budget.baseInterval = config.faceDetectionInterval;
+    budget.baseResolution = QSize(config.maxImageWidth, config.maxImageHeight);
+    m_scheduler.setBudget(budget);
+}
+
+void AIDetectionThread::addFrame(const QImage& frame, int sourceId)
+{
+    // 未经采集线程追踪的帧：只带来源，不计入全链路统计
+    FrameMeta meta;
+    meta.sourceId = sourceId;
+    addFrame(frame, meta);
+}
+
+void AIDetectionThread::addFrame(const QImage& frame, const FrameMeta& meta)
+{
+    bool computeSignature = false;
+    {
+        QMutexLocker locker(&m_mutex);
 
-    if (!m_config.enableAI || !m_running) return;
+        if (!m_config.enableAI || !m_running) return;
 
-    // 跳帧处理
-    if (++m_frameCounter % (m_config.skipFrames + 1) != 0) return;
+        // 跳帧处理
+        if (++m_frameCounter % (m_config.skipFrames + 1) != 0) return;
+
+        computeSignature = m_config.enableFrameReuse;
+    }
+
+    QueuedFrame queued;
+    queued.image = frame;
+    queued.sourceId = meta.sourceId;
+    queued.meta = meta;
+
+    // 🆕 帧签名在调用方（采集侧）线程计算，不占用 AI 线程
+    if (computeSignature) {
+        queued.signature = FrameSignature::compute(frame);
+    }
+
+    QMutexLocker locker(&m_mutex);
 
     // 队列管理
     if (m_frameQueue.size() >= MAX_QUEUE_SIZE) {
         m_frameQueue.dequeue(); // 丢弃旧帧
+        m_queueDropped->add();
+        FlightRecorder::instance().recordEvent(FlightRecorder::FrameDrop, meta.sourceId,
+                                               static_cast<qint64>(m_queueDropped->value()), "ai_queue_full");
     }
 
-    m_frameQueue.enqueue(frame);
+    queued.enqueuedMs = m_latencyClock.elapsed();
+    FrameLatencyTracker::instance().mark(queued.meta, FrameMeta::AIEnqueue);
+    m_frameQueue.enqueue(queued);
+    publishQueueDepth(m_frameQueue.size());
+}
+
+void AIDetectionThread::publishQueueDepth(int depth)
+{
+    m_queueDepth->set(depth);
+    m_queueFillPercent->set(depth * 100.0 / MAX_QUEUE_SIZE);
 }
 
 void AIDetectionThread::run()
@@ -118,39 +215,172 @@ void AIDetectionThread::run()
             if (!m_running) break;
         }
 
-        QImage frame;
+        QueuedFrame frame;
         {
             QMutexLocker locker(&m_mutex);
             if (m_frameQueue.isEmpty()) {
                 locker.unlock();
-                msleep(33); // ~30fps
+
+                // 空闲时处理到期的人脸批，并且不睡过批的截止时间
+                flushFaceBatch(false);
+                int sleepMs = 33; // ~30fps
+                if (m_faceManager) {
+                    int dueMs = m_faceManager->batchScheduler()->msUntilDue();
+                    if (dueMs >= 0) {
+                        sleepMs = qBound(1, dueMs, sleepMs);
+                    }
+                }
+                msleep(sleepMs);
                 continue;
             }
             frame = m_frameQueue.dequeue();
+            publishQueueDepth(m_frameQueue.size());
+        }
+        FrameLatencyTracker::instance().mark(frame.meta, FrameMeta::AIStart);
+
+        // 🆕 与上次分析帧近似相同：跳过运动/人脸阶段，沿用上次结果
+        DetectionResult* result = m_resultPool.acquire();
+        if (reuseAnalyzedResult(frame, *result)) {
+            emitFrameResult(*result, frame);
+            m_resultPool.release(result);
+            flushFaceBatch(false);
+            continue;
         }
 
-        // 处理帧
-        DetectionResult result = processFrame(frame);
-        emit detectionResult(result);
-
-        // 检查是否需要录制
-        if (shouldRecord(result)) {
-            RecordTrigger trigger = RecordTrigger::None;
-            if (result.hasMotion) trigger = RecordTrigger::MotionDetected;
-            if (!result.faces.isEmpty()) trigger = RecordTrigger::FaceDetected;
-
-            emit recordTrigger(trigger, frame);
+        // 处理帧（人脸入批时 result 转交待识别列表）
+        if (!processFrame(frame, result)) {
+            rememberAnalyzedFrame(frame, *result);
+            emitFrameResult(*result, frame);
+            m_resultPool.release(result);
         }
+
+        flushFaceBatch(false);
+        m_batchPendingFrames->set(m_pendingFaceFrames.size());
     }
 
+    // 退出前把批中剩余人脸识别完，避免结果丢失
+    flushFaceBatch(true);
+
     qDebug() << "AIDetectionThread finished";
 }
 
+bool AIDetectionThread::reuseAnalyzedResult(const QueuedFrame& frame, DetectionResult& result)
+{
+    if (!m_config.enableFrameReuse || !frame.signature.isValid()) {
+        return false;
+    }
+
+    auto it = m_lastAnalyzed.constFind(frame.sourceId);
+    if (it == m_lastAnalyzed.constEnd()) {
+        return false;
+    }
+
+    const AnalyzedFrame& analyzed = it.value();
+
+    // 到期强制重新分析，保证人脸识别结果和调度统计持续刷新
+    if (m_latencyClock.elapsed() - analyzed.analyzedMs > m_config.frameReuseMaxAgeMs) {
+        return false;
+    }
+
+    const int changed = frame.signature.changedBlocks(analyzed.signature, m_config.frameReuseBlockTolerance);
+    if (changed > m_config.frameReuseMaxChangedBlocks) {
+        return false;
+    }
+
+    // 画面与上次分析帧一致即没有新的运动；人脸（静止站立的人）保持不变
+    result = analyzed.result;
+    result.timestampNs = monotonicNowNs();
+    result.frameSequence = frame.meta.sequence;
+    result.captureNs = frame.meta.stampNs[FrameMeta::Capture];
+    result.hasMotion = false;
+    result.motionArea = QRect();
+    result.motionProcessTime = 0.0f;
+    result.faceDetectionTime = 0.0f;
+    result.faceRecognitionTime = 0.0f;
+
+    sourceMetrics(frame.sourceId).framesReused->add();
+    return true;
+}
+
+void AIDetectionThread::rememberAnalyzedFrame(const QueuedFrame& frame, const DetectionResult& result)
+{
+    sourceMetrics(frame.sourceId).framesAnalyzed->add();
+
+    if (!frame.signature.isValid()) {
+        return;
+    }
+
+    AnalyzedFrame& analyzed = m_lastAnalyzed[frame.sourceId];
+    analyzed.signature = frame.signature;
+    analyzed.result = result;
+    analyzed.analyzedMs = m_latencyClock.elapsed();
+}
+
+void AIDetectionThread::emitFrameResult(const DetectionResult& result, const QueuedFrame& frame)
+{
+    // 🆕 采集到检测结果发出（glass-to-detection）
+    FrameMeta meta = frame.meta;
+    FrameLatencyTracker::instance().mark(meta, FrameMeta::AIDone);
+    FlightRecorder::instance().recordFrame(meta);
+
+    emit detectionResult(result);
+
+    // 🆕 事件快照：只把帧（引用计数拷贝）和人脸框交给快照服务，编码与写盘在其后台线程
+    SnapshotService::instance().submitEvent(result, frame.image);
+
+    // 检查是否需要录制
+    if (shouldRecord(result)) {
+        RecordTrigger trigger = RecordTrigger::None;
+        if (result.hasMotion) trigger = RecordTrigger::MotionDetected;
+        if (result.faceCount > 0) trigger = RecordTrigger::FaceDetected;
+
+        emit recordTrigger(trigger, frame.image);
+    }
+
+    // 🆕 端到端延迟（入队到结果发出）反馈给调度器，级别变化时记录日志
+    const float endToEndMs = m_latencyClock.elapsed() - frame.enqueuedMs;
+    SourceMetrics& metrics = sourceMetrics(frame.sourceId);
+    metrics.endToEndMs->record(endToEndMs);
+    if (m_scheduler.recordFrameDone(frame.sourceId, endToEndMs)) {
+        svInfo(lcAI) << "AIDetectionThread:" << m_scheduler.summary();
+    }
+    metrics.schedulerLevel->set(static_cast<int>(m_scheduler.level(frame.sourceId)));
+}
+
+AIDetectionThread::SourceMetrics& AIDetectionThread::sourceMetrics(int sourceId)
+{
+    auto it = m_sourceMetrics.find(sourceId);
+    if (it != m_sourceMetrics.end()) {
+        return it.value();
+    }
+
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    SourceMetrics metrics;
+    metrics.framesAnalyzed = registry.counter("ai.frames.analyzed", sourceId);
+    metrics.framesReused = registry.counter("ai.frames.reused", sourceId);
+    metrics.facesDetected = registry.counter("ai.faces.detected", sourceId);
+    metrics.facesRecognized = registry.counter("ai.faces.recognized", sourceId);
+    metrics.facesUnknown = registry.counter("ai.faces.unknown", sourceId);
+    metrics.motionMs = registry.histogram("ai.stage.motion_ms", sourceId);
+    metrics.detectionMs = registry.histogram("ai.stage.detection_ms", sourceId);
+    metrics.recognitionMs = registry.histogram("ai.stage.recognition_ms", sourceId);
+    metrics.endToEndMs = registry.histogram("ai.latency.end_to_end_ms", sourceId);
+    metrics.schedulerLevel = registry.gauge("ai.scheduler.level", sourceId);
+    return m_sourceMetrics.insert(sourceId, metrics).value();
+}
+
 // 修改现有的 processFrame 方法
-DetectionResult AIDetectionThread::processFrame(const QImage& frame)
+bool AIDetectionThread::processFrame(QueuedFrame& queued, DetectionResult* out)
 {
-    DetectionResult result;
-    result.timestamp = QDateTime::currentDateTime();
+    SV_TRACE_SCOPE_ARG("ai", "ai_frame", queued.meta.sequence);
+    const QImage& frame = queued.image;
+    FrameLatencyTracker& tracker = FrameLatencyTracker::instance();
+
+    DetectionResult& result = *out;
+    result.timestampNs = monotonicNowNs();
+    result.sourceId = queued.sourceId;
+    result.frameSequence = queued.meta.sequence;
+    result.captureNs = queued.meta.stampNs[FrameMeta::Capture];
 
     QTime totalTimer;
     totalTimer.start();
@@ -165,62 +395,68 @@ DetectionResult AIDetectionThread::processFrame(const QImage& frame)
         result.motionArea = motionArea;
 
         result.motionProcessTime = motionTimer.elapsed();
+        m_scheduler.recordMotion(queued.sourceId, result.motionProcessTime);
+        sourceMetrics(queued.sourceId).motionMs->record(result.motionProcessTime);
+        tracker.mark(queued.meta, FrameMeta::Motion);
     }
 
-    // 2. 🆕 人脸检测和识别
-    if (m_config.enableFaceDetect && m_faceManager && m_faceRecognitionEnabled && shouldProcessFaces()) {
+    // 2. 🆕 人脸检测和识别：由延迟预算调度器决定本帧是否检测、工作分辨率以及是否识别
+    const LatencyScheduler::Plan plan = m_scheduler.plan(queued.sourceId, result.hasMotion);
+    if (m_config.enableFaceDetect && m_faceManager && m_faceRecognitionEnabled && plan.runFaceDetection) {
         QTime faceTimer;
         faceTimer.start();
 
-        QVector<FaceInfo> detectedFaces;
+        m_faceManager->setMaxImageSize(plan.workingSize.width(), plan.workingSize.height());
 
-        if (m_config.enableFaceRecognition) {
-            // 执行检测+识别
-            detectedFaces = m_faceManager->detectAndRecognizeFaces(frame);
+        QVector<FaceInfo> detectedFaces;
+        bool recognizedInline = false;
+
+        if (m_config.enableFaceRecognition && !plan.runRecognition) {
+            // 🆕 降级：本帧只检测，沿用同轨迹的识别结果
+            detectedFaces = m_faceManager->detectAndReuseFaces(frame, queued.sourceId);
+        } else if (m_config.enableFaceRecognition && m_config.faceBatchLatencyMs > 0) {
+            // 🆕 检测+对齐后入批，识别结果在批到期后回填
+            const quint64 frameId = ++m_frameSequence;
+            int queuedFaces = 0;
+            detectedFaces = m_faceManager->detectAndQueueFaces(frame, queued.sourceId, frameId, &queuedFaces);
+
+            if (queuedFaces > 0) {
+                result.setFaces(detectedFaces);
+                result.faceDetectionTime = faceTimer.elapsed();
+                m_scheduler.recordDetection(queued.sourceId, result.faceDetectionTime);
+                sourceMetrics(queued.sourceId).detectionMs->record(result.faceDetectionTime);
+                tracker.mark(queued.meta, FrameMeta::Detection);
+
+                m_pendingFaceFrames.add(frameId, queued, out, queuedFaces);
+
+                m_lastResult = result;
+                return true;
+            }
+        } else if (m_config.enableFaceRecognition) {
+            // 执行检测+识别（本帧所有人脸一批）
+            detectedFaces = m_faceManager->detectAndRecognizeFaces(frame, queued.sourceId);
+            recognizedInline = true;
         } else {
             // 仅执行检测
             detectedFaces = m_faceManager->detectFaces(frame);
         }
 
-        // 更新结果
-        result.faceInfos = detectedFaces;
-        result.hasFaceDetection = !detectedFaces.isEmpty();
-        result.totalFaceCount = detectedFaces.size();
-        result.recognizedFaceCount = 0;
-        result.unknownFaceCount = 0;
-
-        // 统计识别结果
-        for (const auto& face : detectedFaces) {
-            if (face.isRecognized) {
-                result.recognizedFaceCount++;
-            } else {
-                result.unknownFaceCount++;
-            }
-        }
-
+        // 更新结果（逐帧识别时检测与识别在同一次调用中完成）
+        result.setFaces(detectedFaces);
         result.faceDetectionTime = faceTimer.elapsed();
-
-        // 更新统计信息
-        updateFaceDetectionStatistics(result);
-
-        // 🆕 触发录制逻辑
-        if (result.hasFaceDetection) {
-            if (result.recognizedFaceCount > 0 && m_config.recordKnownFaces) {
-                emit recordTrigger(RecordTrigger::KnownFaceDetected, frame);
-            }
-            if (result.unknownFaceCount > 0 && m_config.recordUnknownFaces) {
-                emit recordTrigger(RecordTrigger::UnknownFaceDetected, frame);
-            }
-            if (result.totalFaceCount > 1) {
-                emit recordTrigger(RecordTrigger::MultipleFacesDetected, frame);
-            }
+        m_scheduler.recordDetection(queued.sourceId, result.faceDetectionTime);
+        sourceMetrics(queued.sourceId).detectionMs->record(result.faceDetectionTime);
+        tracker.mark(queued.meta, FrameMeta::Detection);
+        if (recognizedInline) {
+            tracker.mark(queued.meta, FrameMeta::Recognition);
         }
+        finishFaceResult(result, frame);
     }
 
     // 保存当前结果用于下次处理
     m_lastResult = result;
 
-    return result;
+    return false;
 }
 
 bool AIDetectionThread::shouldRecord(const DetectionResult& result)
@@ -236,6 +472,7 @@ void AIDetectionThread::clearQueue()
 {
     QMutexLocker locker(&m_mutex);
     m_frameQueue.clear();
+    publishQueueDepth(0);
 }
 
 bool AIDetectionThread::initializeFaceRecognition()
@@ -255,6 +492,9 @@ bool AIDetectionThread::initializeFaceRecognition()
             this, &AIDetectionThread::onFaceManagerInitializationFailed);
 
     // 初始化人脸识别管理器
+    m_faceManager->setInferenceBackend(m_config.inferenceBackend);
+    m_faceManager->setInferencePoolSize(m_config.inferencePoolSize);
+    m_faceManager->setMaxImageSize(m_config.maxImageWidth, m_config.maxImageHeight);
     if (!m_faceManager->initialize()) {
         qDebug() << "AIDetectionThread: Failed to initialize face recognition manager";
         delete m_faceManager;
@@ -273,34 +513,25 @@ bool AIDetectionThread::initializeFaceRecognition()
 }
 
 // 🆕 信号槽处理方法
+// 人脸数按来源计入 ai.faces.*（见 updateFaceDetectionStatistics），这里只维护总数
 void AIDetectionThread::onFaceDetected(const QVector<FaceInfo>& faces)
 {
+    Q_UNUSED(faces);
     m_totalFaceDetections++;
-    qDebug() << QString("AIDetectionThread: Detected %1 faces (total: %2)")
-                    .arg(faces.size())
-                    .arg(m_totalFaceDetections);
-
-    // 发出性能更新信号
-    emit performanceUpdate(QString("Face Detection: %1 faces detected").arg(faces.size()));
 }
 
 void AIDetectionThread::onFaceRecognized(const QString& name, float similarity)
 {
+    Q_UNUSED(name);
     m_totalFaceRecognitions++;
-    qDebug() << QString("AIDetectionThread: Recognized face: %1 (similarity: %.2f) (total: %3)")
-                    .arg(name)
-                    .arg(similarity)
-                    .arg(m_totalFaceRecognitions);
-
-    emit performanceUpdate(QString("Face Recognition: %1 (%.1f%%)").arg(name).arg(similarity * 100));
+    m_recognitionEvents->add();
+    m_recognitionSimilarity->record(similarity);
 }
 
 void AIDetectionThread::onUnknownFaceDetected(const QRect& faceRect)
 {
-    qDebug() << "AIDetectionThread: Unknown face detected at:" << faceRect;
-    emit performanceUpdate(QString("Unknown face detected: %1x%2")
-                               .arg(faceRect.width())
-                               .arg(faceRect.height()));
+    Q_UNUSED(faceRect);
+    m_unknownFaceEvents->add();
 }
 
 void AIDetectionThread::onFaceManagerInitializationFailed(const QString& reason)
@@ -376,32 +607,82 @@ void AIDetectionThread::setFaceRecognitionThreshold(float threshold)
     }
 }
 
-bool AIDetectionThread::shouldProcessFaces()
+void AIDetectionThread::finishFaceResult(DetectionResult& result, const QImage& frame)
 {
-    // 智能调度：根据运动检测结果调整人脸检测频率
-    m_faceDetectionFrameCounter++;
+    // 统计识别结果
+    result.updateFaceCounts();
 
-    if (m_lastResult.hasMotion) {
-        // 有运动时增加人脸检测频率
-        return m_faceDetectionFrameCounter % 2 == 0;
-    } else {
-        // 无运动时降低人脸检测频率
-        return m_faceDetectionFrameCounter % 5 == 0;
+    // 更新统计信息
+    updateFaceDetectionStatistics(result);
+
+    // 🆕 触发录制逻辑
+    if (result.hasFaceDetection) {
+        if (result.recognizedFaceCount > 0 && m_config.recordKnownFaces) {
+            emit recordTrigger(RecordTrigger::KnownFaceDetected, frame);
+        }
+        if (result.unknownFaceCount > 0 && m_config.recordUnknownFaces) {
+            emit recordTrigger(RecordTrigger::UnknownFaceDetected, frame);
+        }
+        if (result.faceCount > 1) {
+            emit recordTrigger(RecordTrigger::MultipleFacesDetected, frame);
+        }
     }
 }
 
+void AIDetectionThread::flushFaceBatch(bool force)
+{
+    if (!m_faceManager || m_pendingFaceFrames.isEmpty()) {
+        return;
+    }
+
+    // 1. 取出到期的批（force 时取空为止）并把结果回填到所属帧
+    while (true) {
+        const QVector<QueuedFaceResult> results = m_faceManager->recognizeQueuedFaces(force);
+        if (results.isEmpty()) {
+            break;
+        }
+        m_scheduler.recordRecognition(m_faceManager->getLastRecognitionTime(), results.size());
+
+        for (const QueuedFaceResult& queued : results) {
+            m_pendingFaceFrames.fill(queued.ticket.frameId, queued.ticket.faceIndex, queued.face);
+        }
+    }
+
+    // 2. 人脸全部返回的帧按入队顺序发出（发出后结果归还到 m_resultPool）
+    const float recognitionTime = m_faceManager->getLastRecognitionTime();
+    m_pendingFaceFrames.takeCompleted([this, recognitionTime](QueuedFrame& frame, DetectionResult& result) {
+        result.faceRecognitionTime = recognitionTime;
+        FrameLatencyTracker::instance().mark(frame.meta, FrameMeta::Recognition);
+        finishFaceResult(result, frame.image);
+        rememberAnalyzedFrame(frame, result);
+        emitFrameResult(result, frame);
+    });
+}
+
 void AIDetectionThread::updateFaceDetectionStatistics(const DetectionResult& result)
 {
     if (result.hasFaceDetection) {
         m_lastFaceDetectionTime = QDateTime::currentDateTime();
 
-        // 可以在这里添加更多统计逻辑
-        QString stats = QString("Faces: %1 detected, %2 recognized, %3 unknown")
-                            .arg(result.totalFaceCount)
-                            .arg(result.recognizedFaceCount)
-                            .arg(result.unknownFaceCount);
+        // 🆕 计入类型化指标，界面按自己的节奏采样（不再逐帧格式化字符串）
+        SourceMetrics& metrics = sourceMetrics(result.sourceId);
+        metrics.facesDetected->add(result.faceCount);
+        metrics.facesRecognized->add(result.recognizedFaceCount);
+        metrics.facesUnknown->add(result.unknownFaceCount);
+        if (result.faceRecognitionTime > 0.0f) {
+            metrics.recognitionMs->record(result.faceRecognitionTime);
+        }
+
+        // 质量门限跳过数与推理池占用
+        if (m_faceManager) {
+            const FaceQualityStats quality = m_faceManager->qualityStats();
+            m_qualitySkipped->set(quality.skipped());
+            m_qualityReused->set(quality.reusedFromTrack);
 
-        emit performanceUpdate(stats);
+            const InferencePool::Stats pool = m_faceManager->inferencePool()->stats();
+            m_poolInUse->set(pool.inUse);
+            m_poolAverageWaitMs->set(pool.averageWaitMs());
+        }
     }
 }
 
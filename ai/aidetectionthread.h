@@ -16,6 +16,14 @@
 
 // 🆕 新增包含
 #include "facerecognitionmanager.h"  // 人脸识别管理器
+#include "latencyscheduler.h"         // 延迟预算调度
+#include "framesignature.h"           // 近似重复帧检测
+#include "detectionresultpool.h"      // 逐帧结果对象池
+#include "pendingfaceresults.h"       // 攒批识别等待回填的帧
+#include "../core/MetricsRegistry.h"  // 类型化性能指标
+#include "../core/FrameLatencyTracker.h" // 全链路帧延迟
+#include <QMap>
+#include <QElapsedTimer>
 
 class AIDetectionThread : public QThread
 {
@@ -28,7 +36,9 @@ public:
     // 🔧 现有方法保持不变
     void startDetection();
     void stopDetection();
-    void addFrame(const QImage& frame);
+    void addFrame(const QImage& frame, int sourceId = 0);
+    // 🆕 带采集追踪信息入队，各 AI 阶段在 meta 上补打时间戳
+    void addFrame(const QImage& frame, const FrameMeta& meta);
     void setConfig(const AIConfig& config);
     AIConfig getConfig();
     void clearQueue();
@@ -52,6 +62,11 @@ public:
     void setFaceDetectionThreshold(float threshold);
     void setFaceRecognitionThreshold(float threshold);
 
+    // 🆕 延迟预算调度：当前降级级别与各阶段耗时摘要
+    // 逐帧性能数据见 MetricsRegistry 中的 "ai." 指标，界面按需采样
+    LatencyScheduler::Level degradationLevel(int sourceId = 0) const { return m_scheduler.level(sourceId); }
+    QString schedulerSummary() const { return m_scheduler.summary(); }
+
 signals:
     // 现有信号保持不变
     void detectionResult(const DetectionResult& result);
@@ -61,7 +76,6 @@ signals:
     void faceDetectionStatusChanged(bool enabled);
     void faceRegistered(const QString& name);
     void faceRecognitionError(const QString& error);
-    void performanceUpdate(const QString& info);
 
 protected:
     void run() override;
@@ -78,10 +92,55 @@ private:
     MotionDetector* m_motionDetector;
     FaceDatabase* m_faceDatabase;
 
+    // 🆕 队列中的帧：来源与入队时刻用于按来源调度和端到端延迟统计
+    struct QueuedFrame {
+        QImage image;
+        int sourceId = 0;
+        qint64 enqueuedMs = 0;
+        FrameSignature signature;   // 🆕 采集侧计算，用于跳过近似重复帧
+        FrameMeta meta;             // 🆕 采集序号与各阶段时间戳
+    };
+
+    // 🆕 每路来源最近一次完整分析的帧签名与结果
+    struct AnalyzedFrame {
+        FrameSignature signature;
+        DetectionResult result;
+        qint64 analyzedMs = 0;
+    };
+    QMap<int, AnalyzedFrame> m_lastAnalyzed;
+
+    // 🆕 每路来源的指标句柄：首次出现时注册，之后只做原子更新
+    struct SourceMetrics {
+        MetricCounter* framesAnalyzed = nullptr;
+        MetricCounter* framesReused = nullptr;
+        MetricCounter* facesDetected = nullptr;
+        MetricCounter* facesRecognized = nullptr;
+        MetricCounter* facesUnknown = nullptr;
+        MetricHistogram* motionMs = nullptr;
+        MetricHistogram* detectionMs = nullptr;
+        MetricHistogram* recognitionMs = nullptr;
+        MetricHistogram* endToEndMs = nullptr;
+        MetricGauge* schedulerLevel = nullptr;
+    };
+    QMap<int, SourceMetrics> m_sourceMetrics;
+
+    // 🆕 与来源无关的指标
+    MetricCounter* m_recognitionEvents;
+    MetricCounter* m_unknownFaceEvents;
+    MetricHistogram* m_recognitionSimilarity;
+    MetricGauge* m_qualitySkipped;
+    MetricGauge* m_qualityReused;
+    MetricGauge* m_poolInUse;
+    MetricGauge* m_poolAverageWaitMs;
+    MetricGauge* m_queueDepth;          // 🆕 待分析帧队列的实际深度
+    MetricGauge* m_queueFillPercent;
+    MetricCounter* m_queueDropped;      // 🆕 队列满时丢弃的旧帧
+    MetricGauge* m_batchPendingFrames;  // 🆕 等待攒批识别结果的帧
+
     // 线程控制
     QMutex m_mutex;
     volatile bool m_running = false;
-    QQueue<QImage> m_frameQueue;
+    QQueue<QueuedFrame> m_frameQueue;
     int m_frameCounter = 0;
 
     // 配置和状态
@@ -94,7 +153,10 @@ private:
     // 🆕 人脸识别相关成员变量
     FaceRecognitionManager* m_faceManager;
     bool m_faceRecognitionEnabled;
-    int m_faceDetectionFrameCounter;
+
+    // 🆕 延迟预算调度
+    LatencyScheduler m_scheduler;
+    QElapsedTimer m_latencyClock;
 
 
     void testFeatureConsistency(const QImage& testImage, const QString& userName);
@@ -104,16 +166,31 @@ private:
     int m_totalFaceDetections;
     int m_totalFaceRecognitions;
 
+    // 🆕 逐帧结果对象池（仅 AI 线程使用）
+    DetectionResultPool m_resultPool;
+
+    // 🆕 攒批识别中尚未拿到结果的帧（result 借自 m_resultPool，发出后归还；须在池之后构造）
+    PendingFaceResults<QueuedFrame> m_pendingFaceFrames;
+    quint64 m_frameSequence = 0;
+
     // 🔧 现有私有方法保持不变
-    DetectionResult processFrame(const QImage& frame);
+    // 返回 true 表示人脸仍在批中等待识别，result 已转交 m_pendingFaceFrames，稍后由 flushFaceBatch 发出并归还
+    bool processFrame(QueuedFrame& frame, DetectionResult* result);
     bool shouldRecord(const DetectionResult& result);
     void testFaceDatabase();
 
     // 🆕 人脸识别相关私有方法
     bool initializeFaceRecognition();
     DetectionResult processFrameWithFaces(const QImage& frame);
-    bool shouldProcessFaces();
     void updateFaceDetectionStatistics(const DetectionResult& result);
+    void finishFaceResult(DetectionResult& result, const QImage& frame);
+    void emitFrameResult(const DetectionResult& result, const QueuedFrame& frame);
+    void applySchedulerBudget(const AIConfig& config);
+    SourceMetrics& sourceMetrics(int sourceId);
+    bool reuseAnalyzedResult(const QueuedFrame& frame, DetectionResult& result);
+    void rememberAnalyzedFrame(const QueuedFrame& frame, const DetectionResult& result);
+    void flushFaceBatch(bool force);
+    void publishQueueDepth(int depth);
     void logFaceDetectionPerformance();
 };
 
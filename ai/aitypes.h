@@ -6,6 +6,8 @@
 #include <QDateTime>
 #include <QVector>
 #include <QString>
+#include <QByteArray>
+#include "../core/FrameMeta.h"
 
 // 🆕 人脸信息结构体
 struct FaceInfo {
@@ -19,26 +21,68 @@ struct FaceInfo {
     FaceInfo() : confidence(0.0f), faceId(-1), isRecognized(false), similarity(0.0f) {}
 };
 
-// 🔧 扩展现有的DetectionResult结构体
+// 🆕 结果中的单个人脸：定长、可按字节拷贝，人名以驻留 id 保存（见 PersonNameTable）
+struct ResultFace {
+    QRect bbox;                 // 人脸边界框（原始帧坐标）
+    float confidence = 0.0f;    // 检测置信度
+    float similarity = 0.0f;    // 相似度分数
+    qint32 faceId = -1;         // 人脸ID（数据库中的ID）
+    quint16 nameId = 0;         // 人名驻留 id，0 表示未识别
+    bool isRecognized = false;  // 是否成功识别
+};
+
+// 🔧 紧凑的逐帧检测结果：内联定长数组 + 单调时钟时间戳，拷贝不触发堆分配
+// 人脸超过 kMaxFaces 时只保留前 kMaxFaces 个（droppedFaceCount 记录丢弃数）
 struct DetectionResult {
-    // 现有字段保持不变
-    QVector<QRect> faces;           // 人脸检测框（保持向后兼容）
-    QVector<float> confidences;     // 置信度（保持向后兼容）
-    QDateTime timestamp;            // 检测时间
-    bool hasMotion;                 // 是否有移动
-    QRect motionArea;              // 移动区域
-
-    // 🆕 新增人脸检测相关字段
-    QVector<FaceInfo> faceInfos;        // 详细的人脸信息
+    static const int kMaxFaces = 16;
+
+    qint64 timestampNs = 0;         // 检测时间（单调时钟纳秒，见 monotonicNowNs）
+    int sourceId = 0;               // 帧来源
+    quint64 frameSequence = 0;      // 🆕 来源内帧序号（FrameMeta::sequence，0 表示未追踪）
+    qint64 captureNs = 0;           // 🆕 帧的采集时间戳（同一单调时钟）
+    bool hasMotion = false;         // 是否有移动
+    QRect motionArea;               // 移动区域
+
+    // 人脸检测相关字段
+    ResultFace faces[kMaxFaces];        // 前 faceCount 个有效
+    int faceCount = 0;                  // 总人脸数量
+    int droppedFaceCount = 0;           // 超出容量被丢弃的人脸数
     bool hasFaceDetection = false;      // 是否检测到人脸
-    int totalFaceCount = 0;             // 总人脸数量
     int recognizedFaceCount = 0;        // 已识别人脸数量
     int unknownFaceCount = 0;           // 未知人脸数量
 
-    // 🆕 性能统计
+    // 性能统计
     float motionProcessTime = 0.0f;     // 运动检测耗时(ms)
     float faceDetectionTime = 0.0f;     // 人脸检测耗时(ms)
     float faceRecognitionTime = 0.0f;   // 人脸识别耗时(ms)
+
+    bool isValid() const { return timestampNs > 0; }
+    void clear() { *this = DetectionResult(); }
+
+    // 人脸写入（人名在此驻留）；容量已满时返回 false
+    bool appendFace(const FaceInfo& face);
+    void setFace(int index, const FaceInfo& face);
+    void setFaces(const QVector<FaceInfo>& faceInfos);
+
+    // 🆕 按 faces 重新统计 hasFaceDetection / 已识别 / 未知人脸数（人脸写完或回填完后调用）
+    void updateFaceCounts();
+
+    // 展开为 FaceInfo / 查人名（供界面显示，会分配字符串）
+    FaceInfo faceInfo(int index) const;
+    QString personName(int index) const;
+
+    // 时间戳换算为墙上时间（仅用于显示）
+    QDateTime wallTime() const;
+};
+
+// 🆕 进程内单调时钟（纳秒），DetectionResult 等逐帧数据的时间基准
+// 与采集侧 FrameMeta 时间戳同源（frameClockNs），可直接相减
+qint64 monotonicNowNs();
+
+// 🆕 多模板人员的相似度聚合方式
+enum class TemplateAggregation {
+    Max,        // 取该人员所有模板中的最高相似度
+    MeanTopN    // 取前N个最高相似度的均值，对单张异常模板更稳健
 };
 
 // 🔧 扩展现有的AIConfig结构体
@@ -55,15 +99,52 @@ struct AIConfig {
     // 🆕 新增人脸识别相关配置
     bool enableFaceRecognition = true;      // 启用人脸识别
     float faceRecognitionThreshold = 0.7f;  // 人脸识别相似度阈值
-    int faceDetectionInterval = 2;          // 人脸检测间隔（帧数）
+    int faceDetectionInterval = 2;          // 人脸检测间隔（帧数，无运动时放宽到 2n+1）
     bool recordUnknownFaces = true;         // 记录未知人脸
     bool recordKnownFaces = false;          // 记录已知人脸
     QString faceModelPath = "/demo/src/rockx_data";  // RockX模型路径
 
+    // 🆕 多模板人脸库配置
+    int maxTemplatesPerPerson = 5;          // 每人最多保留的模板数（按质量淘汰）
+    TemplateAggregation templateAggregation = TemplateAggregation::Max;  // 模板分数聚合方式
+    int templateTopN = 3;                   // MeanTopN 使用的模板数
+
+    // 🆕 批量特征提取配置
+    int faceBatchSize = 8;                  // 单批最多提取的人脸数
+    int faceBatchLatencyMs = 30;            // 跨帧攒批的最长等待（毫秒，0表示逐帧识别）
+
+    // 🆕 人脸质量门限：不达标的人脸跳过特征提取，沿用同轨迹更好帧的结果
+    bool enableFaceQualityGate = true;      // 启用质量门限
+    int minFaceSize = 40;                   // 人脸框短边最小像素
+    float minFaceSharpness = 60.0f;         // 拉普拉斯方差下限（越大越清晰）
+    float maxFaceYaw = 0.6f;                // 侧脸程度上限（鼻尖偏移/眼距，0表示不评估）
+    float minFaceBrightness = 40.0f;        // 平均亮度下限
+    float maxFaceBrightness = 220.0f;       // 平均亮度上限
+    int faceTrackReuseMs = 1500;            // 沿用轨迹识别结果的有效期（毫秒）
+
+    // 🆕 推理后端（见 InferenceBackendRegistry）：rockx 为板端NPU，cpu 为主机参考实现
+#ifdef SV_HAVE_ROCKX
+    QString inferenceBackend = "rockx";
+#else
+    QString inferenceBackend = "cpu";
+#endif
+    int inferencePoolSize = 2;              // 推理上下文数量（可并行检测/提取特征的线程数）
+
     // 🆕 性能优化配置
     int maxImageWidth = 640;                // 最大处理图像宽度
     int maxImageHeight = 480;               // 最大处理图像高度
     bool enablePerformanceLogging = false;  // 启用性能日志
+
+    // 🆕 延迟预算调度：超出预算时按来源逐级降低检测频率、工作分辨率、识别频率
+    bool enableAdaptiveScheduling = true;   // 关闭时固定按 faceDetectionInterval 调度
+    int targetLatencyMs = 200;              // 目标端到端延迟（入队到结果发出，毫秒）
+    float cpuBudget = 0.7f;                 // AI线程忙碌占比上限（0~1）
+
+    // 🆕 近似重复帧跳过：与上次分析帧相比变化的块数不超过阈值时，直接沿用上次结果
+    bool enableFrameReuse = true;
+    int frameReuseMaxChangedBlocks = 0;     // 允许变化的块数（32x24 网格；画面有闪烁指示灯等可调大）
+    int frameReuseBlockTolerance = 6;       // 块亮度均值的变化容差（0~255）
+    int frameReuseMaxAgeMs = 2000;          // 沿用结果的最长时间，到期强制重新分析
 };
 
 // 🔧 扩展现有的RecordTrigger枚举
@@ -87,8 +168,18 @@ struct FaceRecord {
     int recognitionCount;      // 识别次数
     QString description;       // 描述信息
     bool isActive;            // 是否激活
+    int templateCount;        // 🆕 该人员的特征模板数量
+
+    FaceRecord() : id(-1), recognitionCount(0), isActive(true), templateCount(0) {}
+};
 
-    FaceRecord() : id(-1), recognitionCount(0), isActive(true) {}
+// 🆕 批量注册条目（用于 FaceDatabase::addFaceRecords）
+struct FaceEnrollment {
+    QString name;              // 人员姓名
+    QString imagePath;         // 图像文件路径
+    QByteArray feature;        // 人脸特征（512个float）
+    QString description;       // 描述信息
+    float quality = 1.0f;      // 🆕 模板质量分（超出上限时优先淘汰低分模板）
 };
 
 // 🆕 人脸识别配置状态
@@ -105,5 +196,6 @@ Q_DECLARE_METATYPE(RecordTrigger)
 Q_DECLARE_METATYPE(FaceInfo)
 Q_DECLARE_METATYPE(FaceRecord)
 Q_DECLARE_METATYPE(FaceRecognitionStatus)
+Q_DECLARE_METATYPE(TemplateAggregation)
 
 #endif // AI_TYPES_H
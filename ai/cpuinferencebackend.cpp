@@ -0,0 +1,162 @@
+// ai/cpuinferencebackend.cpp
+#include "cpuinferencebackend.h"
+#include <QtMath>
+#include <cmath>
+
+namespace {
+
+const int kGridSize = 16;                                   // 特征网格边长
+const int kBlockSize = FaceBatch::kCropSize / kGridSize;     // 每格像素数（7）
+const float kMinTextureStdDev = 6.0f;                        // 低于此亮度标准差视为无内容画面
+
+inline float luma(const uchar* rgb)
+{
+    return 0.299f * rgb[0] + 0.587f * rgb[1] + 0.114f * rgb[2];
+}
+
+} // namespace
+
+CpuInferenceBackend::CpuInferenceBackend()
+    : m_syntheticFaceCount(1)
+{
+    bool ok = false;
+    int count = qEnvironmentVariableIntValue("SV_CPU_SYNTHETIC_FACES", &ok);
+    if (ok) {
+        m_syntheticFaceCount = qMax(0, count);
+    }
+}
+
+bool CpuInferenceBackend::initialize(const QString& modelPath)
+{
+    Q_UNUSED(modelPath);
+    return true;
+}
+
+QVector<DetectedFace> CpuInferenceBackend::detect(const QImage& frame)
+{
+    QVector<DetectedFace> faces;
+    if (frame.isNull() || m_syntheticFaceCount == 0) {
+        return faces;
+    }
+
+    // 1. 稀疏采样亮度，纯色/黑屏画面不输出人脸
+    const int step = qMax(1, qMin(frame.width(), frame.height()) / 32);
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    int samples = 0;
+    for (int y = 0; y < frame.height(); y += step) {
+        const uchar* line = frame.constScanLine(y);
+        for (int x = 0; x < frame.width(); x += step) {
+            float value = luma(line + x * 3);
+            sum += value;
+            sumSquares += value * value;
+            samples++;
+        }
+    }
+    const double mean = sum / samples;
+    const double stdDev = std::sqrt(qMax(0.0, sumSquares / samples - mean * mean));
+    if (stdDev < kMinTextureStdDev) {
+        return faces;
+    }
+
+    // 2. 按网格均匀放置合成人脸框
+    const int cols = qCeil(std::sqrt(double(m_syntheticFaceCount)));
+    const int rows = (m_syntheticFaceCount + cols - 1) / cols;
+    const int cellW = frame.width() / cols;
+    const int cellH = frame.height() / rows;
+    const int side = int(qMin(cellW, cellH) * 0.6);
+    if (side < 16) {
+        return faces;
+    }
+
+    faces.reserve(m_syntheticFaceCount);
+    for (int i = 0; i < m_syntheticFaceCount; ++i) {
+        const int col = i % cols;
+        const int row = i / cols;
+
+        DetectedFace face;
+        face.box = QRect(col * cellW + (cellW - side) / 2,
+                         row * cellH + (cellH - side) / 2,
+                         side, side);
+        face.score = 0.9f;
+        faces.append(face);
+    }
+
+    return faces;
+}
+
+bool CpuInferenceBackend::landmarks(const QImage& frame, const QRect& box, QPointF* points)
+{
+    Q_UNUSED(frame);
+
+    // 标准正脸在人脸框中的相对位置
+    static const qreal kLayout[5][2] = {
+        { 0.30, 0.40 }, { 0.70, 0.40 }, { 0.50, 0.60 }, { 0.35, 0.80 }, { 0.65, 0.80 }
+    };
+
+    for (int i = 0; i < 5; ++i) {
+        points[i] = QPointF(box.x() + kLayout[i][0] * box.width(),
+                            box.y() + kLayout[i][1] * box.height());
+    }
+    return true;
+}
+
+bool CpuInferenceBackend::align(const QImage& frame, const QRect& box, uchar* dst, int dstStride)
+{
+    const QRect region = box.intersected(QRect(0, 0, frame.width(), frame.height()));
+    if (region.isEmpty()) {
+        return false;
+    }
+
+    // 16.16 定点最近邻缩放
+    const int cropSize = FaceBatch::kCropSize;
+    const int stepX = (region.width() << 16) / cropSize;
+    const int stepY = (region.height() << 16) / cropSize;
+
+    for (int y = 0; y < cropSize; ++y) {
+        const uchar* src = frame.constScanLine(region.top() + ((y * stepY) >> 16)) + region.left() * 3;
+        uchar* out = dst + y * dstStride;
+        for (int x = 0; x < cropSize; ++x) {
+            const uchar* pixel = src + ((x * stepX) >> 16) * 3;
+            out[x * 3 + 0] = pixel[0];
+            out[x * 3 + 1] = pixel[1];
+            out[x * 3 + 2] = pixel[2];
+        }
+    }
+
+    return true;
+}
+
+bool CpuInferenceBackend::embed(const uchar* alignedRgb, float* feature)
+{
+    const int rowBytes = FaceBatch::kCropSize * FaceBatch::kChannels;
+
+    // 1. 16×16 分块亮度均值
+    float blocks[kGridSize * kGridSize];
+    float mean = 0.0f;
+    for (int gy = 0; gy < kGridSize; ++gy) {
+        for (int gx = 0; gx < kGridSize; ++gx) {
+            float sum = 0.0f;
+            for (int y = 0; y < kBlockSize; ++y) {
+                const uchar* line = alignedRgb + (gy * kBlockSize + y) * rowBytes + gx * kBlockSize * 3;
+                for (int x = 0; x < kBlockSize; ++x) {
+                    sum += luma(line + x * 3);
+                }
+            }
+            blocks[gy * kGridSize + gx] = sum / (kBlockSize * kBlockSize);
+            mean += blocks[gy * kGridSize + gx];
+        }
+    }
+    mean /= kGridSize * kGridSize;
+
+    // 2. 前256维：去均值的分块亮度；后256维：水平梯度
+    const int half = kGridSize * kGridSize;
+    for (int i = 0; i < half; ++i) {
+        const int gx = i % kGridSize;
+        const float next = (gx + 1 < kGridSize) ? blocks[i + 1] : blocks[i - gx];
+        feature[i] = (blocks[i] - mean) / 255.0f;
+        feature[half + i] = (next - blocks[i]) / 255.0f;
+    }
+
+    return true;
+}
@@ -0,0 +1,34 @@
+// ai/cpuinferencebackend.h
+#ifndef CPUINFERENCEBACKEND_H
+#define CPUINFERENCEBACKEND_H
+
+#include "inferencebackend.h"
+
+// 🆕 CPU 参考后端：不依赖任何模型文件的确定性实现
+// - 检测：画面有足够纹理时，按网格输出固定数量的合成人脸框（关键点为标准正脸位置）
+// - 对齐：把人脸框最近邻缩放到 kCropSize 见方
+// - 特征：16×16 分块亮度均值 + 水平梯度，共 512 维
+// 同一张输入总是得到同一特征，注册后用同一画面识别可以命中，
+// 用于在开发主机上跑通并剖析检测→对齐→批量特征→匹配→调度整条流水线。
+class CpuInferenceBackend : public InferenceBackend
+{
+public:
+    CpuInferenceBackend();
+
+    QString name() const override { return "cpu"; }
+    bool initialize(const QString& modelPath) override;
+
+    QVector<DetectedFace> detect(const QImage& frame) override;
+    bool landmarks(const QImage& frame, const QRect& box, QPointF* points) override;
+    bool align(const QImage& frame, const QRect& box, uchar* dst, int dstStride) override;
+    bool embed(const uchar* alignedRgb, float* feature) override;
+
+    // 每帧输出的合成人脸数（默认取环境变量 SV_CPU_SYNTHETIC_FACES，缺省为1）
+    void setSyntheticFaceCount(int count) { m_syntheticFaceCount = qMax(0, count); }
+    int syntheticFaceCount() const { return m_syntheticFaceCount; }
+
+private:
+    int m_syntheticFaceCount;
+};
+
+#endif // CPUINFERENCEBACKEND_H
@@ -0,0 +1,90 @@
+// ai/detectionresult.cpp
+#include "aitypes.h"
+#include "personnametable.h"
+
+qint64 monotonicNowNs()
+{
+    return frameClockNs();
+}
+
+bool DetectionResult::appendFace(const FaceInfo& face)
+{
+    if (faceCount >= kMaxFaces) {
+        droppedFaceCount++;
+        return false;
+    }
+    setFace(faceCount++, face);
+    return true;
+}
+
+void DetectionResult::setFace(int index, const FaceInfo& face)
+{
+    if (index < 0 || index >= faceCount) {
+        return;
+    }
+
+    ResultFace& slot = faces[index];
+    slot.bbox = face.bbox;
+    slot.confidence = face.confidence;
+    slot.similarity = face.similarity;
+    slot.faceId = face.faceId;
+    slot.isRecognized = face.isRecognized;
+    slot.nameId = face.isRecognized ? PersonNameTable::instance().intern(face.personName)
+                                    : PersonNameTable::kNoName;
+}
+
+void DetectionResult::setFaces(const QVector<FaceInfo>& faceInfos)
+{
+    faceCount = 0;
+    droppedFaceCount = 0;
+    for (const FaceInfo& face : faceInfos) {
+        appendFace(face);
+    }
+}
+
+void DetectionResult::updateFaceCounts()
+{
+    hasFaceDetection = faceCount > 0;
+    recognizedFaceCount = 0;
+    unknownFaceCount = 0;
+    for (int i = 0; i < faceCount; ++i) {
+        if (faces[i].isRecognized) {
+            recognizedFaceCount++;
+        } else {
+            unknownFaceCount++;
+        }
+    }
+}
+
+FaceInfo DetectionResult::faceInfo(int index) const
+{
+    FaceInfo info;
+    if (index < 0 || index >= faceCount) {
+        return info;
+    }
+
+    const ResultFace& face = faces[index];
+    info.bbox = face.bbox;
+    info.confidence = face.confidence;
+    info.similarity = face.similarity;
+    info.faceId = face.faceId;
+    info.isRecognized = face.isRecognized;
+    info.personName = PersonNameTable::instance().name(face.nameId);
+    return info;
+}
+
+QString DetectionResult::personName(int index) const
+{
+    if (index < 0 || index >= faceCount) {
+        return QString();
+    }
+    return PersonNameTable::instance().name(faces[index].nameId);
+}
+
+QDateTime DetectionResult::wallTime() const
+{
+    if (!isValid()) {
+        return QDateTime();
+    }
+    return QDateTime::fromMSecsSinceEpoch(frameClockWallAnchorMs() + timestampNs / 1000000);
+}
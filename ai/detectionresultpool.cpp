@@ -0,0 +1,47 @@
+// ai/detectionresultpool.cpp
+#include "detectionresultpool.h"
+#include <QDebug>
+
+DetectionResultPool::DetectionResultPool(int capacity)
+{
+    const int count = qMax(1, capacity);
+    m_slots.reserve(count);
+    m_free.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        DetectionResult* result = new DetectionResult;
+        m_slots.append(result);
+        m_free.append(result);
+    }
+}
+
+DetectionResultPool::~DetectionResultPool()
+{
+    if (inUse() > 0) {
+        qDebug() << "DetectionResultPool: Destroyed with" << inUse() << "results still in use";
+    }
+    qDeleteAll(m_slots);
+}
+
+DetectionResult* DetectionResultPool::acquire()
+{
+    if (m_free.isEmpty()) {
+        // 借空说明并发中的帧超过预估，扩容并让 free 列表容量跟上，之后仍不再分配
+        DetectionResult* result = new DetectionResult;
+        m_slots.append(result);
+        m_free.reserve(m_slots.size());
+        m_growCount++;
+        qDebug() << "DetectionResultPool: Grew to" << m_slots.size() << "results";
+        return result;
+    }
+
+    DetectionResult* result = m_free.takeLast();
+    result->clear();
+    return result;
+}
+
+void DetectionResultPool::release(DetectionResult* result)
+{
+    if (result) {
+        m_free.append(result);
+    }
+}
@@ -0,0 +1,33 @@
+// ai/detectionresultpool.h
+#ifndef DETECTIONRESULTPOOL_H
+#define DETECTIONRESULTPOOL_H
+
+#include <QVector>
+#include "aitypes.h"
+
+// 🆕 逐帧结果对象池：AI 线程处理帧、攒批等待识别时使用的 DetectionResult 从这里借出
+// 容量预先分配，稳态下借还不触发堆分配；借空时扩容一个并计入 growCount
+// 仅供单个线程（AI 检测线程）使用，不加锁
+class DetectionResultPool
+{
+public:
+    explicit DetectionResultPool(int capacity = 16);
+    ~DetectionResultPool();
+
+    // 返回已清空的结果对象
+    DetectionResult* acquire();
+    void release(DetectionResult* result);
+
+    int capacity() const { return m_slots.size(); }
+    int inUse() const { return m_slots.size() - m_free.size(); }
+    int growCount() const { return m_growCount; }
+
+private:
+    QVector<DetectionResult*> m_slots;
+    QVector<DetectionResult*> m_free;
+    int m_growCount = 0;
+
+    Q_DISABLE_COPY(DetectionResultPool)
+};
+
+#endif // DETECTIONRESULTPOOL_H
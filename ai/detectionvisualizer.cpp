@@ -26,8 +26,8 @@ QImage DetectionVisualizer::drawDetections(const QImage& originalImage, const De
     }
 
     // 绘制人脸检测框
-    if (!result.faces.isEmpty()) {
-        drawFaceBoxes(painter, result.faces, result.confidences);
+    if (result.faceCount > 0) {
+        drawFaceBoxes(painter, result);
     }
 
     // 绘制状态信息
@@ -37,7 +37,7 @@ QImage DetectionVisualizer::drawDetections(const QImage& originalImage, const De
 
     // 绘制时间戳
     if (m_showTimestamp) {
-        drawTimestamp(painter, result.timestamp, resultImage.size());
+        drawTimestamp(painter, result.wallTime(), resultImage.size());
     }
 
     return resultImage;
@@ -100,8 +100,7 @@ void DetectionVisualizer::drawMotionBox(QPainter& painter, const QRect& motionAr
     painter.drawText(textRect, Qt::AlignCenter, label);
 }
 
-void DetectionVisualizer::drawFaceBoxes(QPainter& painter, const QVector<QRect>& faces,
-                                        const QVector<float>& confidences)
+void DetectionVisualizer::drawFaceBoxes(QPainter& painter, const DetectionResult& result)
 {
     QPen pen(m_faceBoxColor, m_boxLineWidth);
     painter.setPen(pen);
@@ -112,16 +111,16 @@ void DetectionVisualizer::drawFaceBoxes(QPainter& painter, const QVector<QRect>&
     font.setBold(true);
     painter.setFont(font);
 
-    for (int i = 0; i < faces.size(); ++i) {
-        const QRect& face = faces[i];
+    for (int i = 0; i < result.faceCount; ++i) {
+        const QRect& face = result.faces[i].bbox;
 
         // 绘制人脸框
         painter.drawRect(face);
 
         // 绘制置信度标签
         QString label = QString("FACE %1").arg(i + 1);
-        if (i < confidences.size() && m_showConfidence) {
-            label += QString(" (%.1f%%)").arg(confidences[i] * 100);
+        if (m_showConfidence) {
+            label += QString(" (%.1f%%)").arg(result.faces[i].confidence * 100);
         }
 
         QFontMetrics fm(font);
@@ -150,8 +149,8 @@ void DetectionVisualizer::drawStatusInfo(QPainter& painter, const DetectionResul
         statusLines << "⚪ MONITORING";
     }
 
-    if (!result.faces.isEmpty()) {
-        statusLines << QString("👤 %1 Face(s)").arg(result.faces.size());
+    if (result.faceCount > 0) {
+        statusLines << QString("👤 %1 Face(s)").arg(result.faceCount);
     }
 
     // 绘制状态背景
@@ -41,8 +41,7 @@ private:
 
     // 绘制辅助函数
     void drawMotionBox(QPainter& painter, const QRect& motionArea);
-    void drawFaceBoxes(QPainter& painter, const QVector<QRect>& faces,
-                       const QVector<float>& confidences);
+    void drawFaceBoxes(QPainter& painter, const DetectionResult& result);
     void drawStatusInfo(QPainter& painter, const DetectionResult& result,
                         const QSize& imageSize);
     void drawTimestamp(QPainter& painter, const QDateTime& timestamp,
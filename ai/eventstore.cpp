@@ -0,0 +1,517 @@
+// ai/eventstore.cpp
+#include "eventstore.h"
+#include "../core/MetricsRegistry.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QSqlError>
+#include <QVariant>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+const char* const kInsertSQL =
+    "INSERT INTO events (ts_ms, source_id, trigger_type, face_count, face_ids, "
+    "motion_x, motion_y, motion_w, motion_h, recording_start_ms) "
+    "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+const char* const kLinkRecordingSQL =
+    "UPDATE events SET recording_start_ms = ? "
+    "WHERE ts_ms >= ? AND ts_ms <= ? AND recording_start_ms = 0";
+
+} // namespace
+
+RecordTrigger EventCoalescer::classify(const DetectionResult& result)
+{
+    if (result.recognizedFaceCount > 0) {
+        return RecordTrigger::KnownFaceDetected;
+    }
+    if (result.unknownFaceCount > 0) {
+        return RecordTrigger::UnknownFaceDetected;
+    }
+    if (result.faceCount > 0) {
+        return RecordTrigger::FaceDetected;
+    }
+    return RecordTrigger::MotionDetected;
+}
+
+bool EventCoalescer::accept(const DetectionResult& result, int coalesceMs, Event* event)
+{
+    if (!result.isValid() || (!result.hasMotion && result.faceCount == 0)) {
+        return false;
+    }
+
+    Event candidate;
+    candidate.timeMs = result.wallTime().toMSecsSinceEpoch();
+    candidate.trigger = classify(result);
+    const int faces = qMin(result.faceCount, int(DetectionResult::kMaxFaces));
+    candidate.faceIds.reserve(faces);
+    for (int i = 0; i < faces; ++i) {
+        candidate.faceIds.append(result.faces[i].isRecognized ? result.faces[i].faceId : -1);
+    }
+
+    QVector<qint32> sortedIds = candidate.faceIds;
+    std::sort(sortedIds.begin(), sortedIds.end());
+    {
+        QMutexLocker locker(&m_mutex);
+        LastEvent& last = m_lastBySource[result.sourceId];
+        if (last.timeMs > 0 && last.trigger == candidate.trigger && last.sortedFaceIds == sortedIds
+            && candidate.timeMs - last.timeMs < coalesceMs) {
+            return false;
+        }
+        last.trigger = candidate.trigger;
+        last.sortedFaceIds = sortedIds;
+        last.timeMs = candidate.timeMs;
+    }
+
+    *event = candidate;
+    return true;
+}
+
+EventStore::EventStore(QObject* parent)
+    : QThread(parent)
+    , m_pendingGauge(MetricsRegistry::instance().gauge("eventstore.pending"))
+    , m_writtenCounter(MetricsRegistry::instance().counter("eventstore.events.written"))
+    , m_droppedCounter(MetricsRegistry::instance().counter("eventstore.events.dropped"))
+    , m_flushMs(MetricsRegistry::instance().histogram("eventstore.flush_ms"))
+{
+    setObjectName("sv-eventstore");
+}
+
+EventStore::~EventStore()
+{
+    close();
+}
+
+bool EventStore::openConnection(QSqlDatabase& database, const QString& connectionName)
+{
+    database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    database.setDatabaseName(m_databasePath);
+    // 读写两个连接偶尔同时做检查点，等待而不是直接报 SQLITE_BUSY
+    database.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+    if (!database.open()) {
+        qWarning() << "EventStore: Failed to open" << m_databasePath << database.lastError().text();
+        return false;
+    }
+
+    QSqlQuery query(database);
+    const QStringList pragmas = {
+        "PRAGMA journal_mode=WAL",
+        "PRAGMA synchronous=NORMAL",
+        "PRAGMA temp_store=MEMORY",
+        "PRAGMA cache_size=-2048"
+    };
+    for (const QString& pragma : pragmas) {
+        if (!query.exec(pragma)) {
+            qWarning() << "EventStore: Failed to apply" << pragma << query.lastError().text();
+        }
+    }
+    return true;
+}
+
+bool EventStore::createSchema(QSqlDatabase& database)
+{
+    QSqlQuery query(database);
+
+    // 只追加的事件表；id 即 rowid，时间索引自带 rowid，按 (ts_ms, id) 排序无需额外排序
+    const QString createEventsSQL = R"(
+        CREATE TABLE IF NOT EXISTS events (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            ts_ms INTEGER NOT NULL,                 -- 墙钟毫秒
+            source_id INTEGER NOT NULL,             -- 帧来源（FrameSource）
+            trigger_type INTEGER NOT NULL,          -- RecordTrigger
+            face_count INTEGER DEFAULT 0,
+            face_ids BLOB,                          -- qint32 数组，-1 为未识别
+            motion_x INTEGER, motion_y INTEGER,     -- 运动区域
+            motion_w INTEGER, motion_h INTEGER,
+            recording_start_ms INTEGER DEFAULT 0    -- 所属录像开始时间，0 为无录像
+        )
+    )";
+
+    if (!query.exec(createEventsSQL)) {
+        qWarning() << "EventStore: Failed to create events table" << query.lastError().text();
+        return false;
+    }
+
+    const QStringList indexes = {
+        "CREATE INDEX IF NOT EXISTS idx_events_ts ON events(ts_ms)",
+        "CREATE INDEX IF NOT EXISTS idx_events_source_ts ON events(source_id, ts_ms)"
+    };
+    for (const QString& sql : indexes) {
+        if (!query.exec(sql)) {
+            qWarning() << "EventStore: Failed to create index" << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EventStore::open(const QString& dbPath)
+{
+    if (m_open) {
+        return true;
+    }
+
+    m_databasePath = dbPath.isEmpty()
+        ? QCoreApplication::applicationDirPath() + "/data/database/events.db"
+        : dbPath;
+    QDir().mkpath(QFileInfo(m_databasePath).absolutePath());
+
+    static std::atomic<int> connectionCounter{0};
+    m_connectionPrefix = QString("EventStore_%1_%2")
+        .arg(QCoreApplication::applicationPid())
+        .arg(++connectionCounter);
+
+    // 建表用读连接完成，写线程启动时表和索引已经存在
+    if (!openConnection(m_readDatabase, m_connectionPrefix + "_read") || !createSchema(m_readDatabase)) {
+        m_readDatabase.close();
+        m_readDatabase = QSqlDatabase();
+        QSqlDatabase::removeDatabase(m_connectionPrefix + "_read");
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = false;
+        m_accepting = true;
+    }
+    start(QThread::LowPriority);
+    m_open = true;
+
+    qDebug() << "EventStore: Opened" << m_databasePath;
+    return true;
+}
+
+void EventStore::close()
+{
+    if (!m_open) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_accepting = false;
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    wait();
+
+    m_readStatements.clear();
+    m_readDatabase.close();
+    m_readDatabase = QSqlDatabase();
+    QSqlDatabase::removeDatabase(m_connectionPrefix + "_read");
+    m_open = false;
+
+    qDebug() << "EventStore: Closed" << m_databasePath;
+}
+
+void EventStore::append(const StoredEvent& event)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_accepting) {
+        return;
+    }
+
+    // 磁盘卡住时宁可丢事件，也不让检测/界面线程等待
+    if (m_pending.size() >= m_options.maxPending) {
+        m_droppedCounter->add();
+        return;
+    }
+
+    m_pending.append(event);
+    m_pendingGauge->set(m_pending.size());
+    if (m_pending.size() >= m_options.batchSize) {
+        m_wake.wakeOne();
+    }
+}
+
+bool EventStore::recordDetection(const DetectionResult& result, qint64 recordingStartMs)
+{
+    EventCoalescer::Event accepted;
+    if (!m_coalescer.accept(result, m_options.coalesceMs, &accepted)) {
+        return false;
+    }
+
+    StoredEvent event;
+    event.timeMs = accepted.timeMs;
+    event.sourceId = result.sourceId;
+    event.trigger = accepted.trigger;
+    event.faceCount = result.faceCount;
+    event.faceIds = accepted.faceIds;
+    event.motionArea = result.hasMotion ? result.motionArea : QRect();
+    event.recordingStartMs = recordingStartMs;
+
+    append(event);
+    return true;
+}
+
+void EventStore::linkRecording(qint64 fromMs, qint64 recordingStartMs)
+{
+    if (recordingStartMs <= 0) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_accepting) {
+        return;
+    }
+
+    for (StoredEvent& event : m_pending) {
+        if (event.recordingStartMs == 0 && event.timeMs >= fromMs && event.timeMs <= recordingStartMs) {
+            event.recordingStartMs = recordingStartMs;
+        }
+    }
+
+    // 已交给写线程的批次在写入后由 UPDATE 补上
+    RecordingLink link;
+    link.fromMs = fromMs;
+    link.recordingStartMs = recordingStartMs;
+    m_pendingLinks.append(link);
+    m_wake.wakeOne();
+}
+
+void EventStore::purgeBefore(qint64 timeMs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_purgeBeforeMs = qMax(m_purgeBeforeMs, timeMs);
+    m_wake.wakeOne();
+}
+
+void EventStore::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    const quint64 target = ++m_flushRequested;
+    m_wake.wakeOne();
+    while (m_flushCompleted < target && isRunning()) {
+        m_flushed.wait(&m_mutex, 100);
+    }
+}
+
+QByteArray EventStore::packFaceIds(const QVector<qint32>& faceIds)
+{
+    return QByteArray(reinterpret_cast<const char*>(faceIds.constData()),
+                      faceIds.size() * int(sizeof(qint32)));
+}
+
+QVector<qint32> EventStore::unpackFaceIds(const QByteArray& blob)
+{
+    QVector<qint32> faceIds(blob.size() / int(sizeof(qint32)));
+    if (!faceIds.isEmpty()) {
+        memcpy(faceIds.data(), blob.constData(), faceIds.size() * sizeof(qint32));
+    }
+    return faceIds;
+}
+
+bool EventStore::writeBatch(QSqlDatabase& database, QSqlQuery& insert, const QVector<StoredEvent>& batch)
+{
+    if (!database.transaction()) {
+        qWarning() << "EventStore: Failed to begin transaction" << database.lastError().text();
+        return false;
+    }
+
+    for (const StoredEvent& event : batch) {
+        insert.bindValue(0, event.timeMs);
+        insert.bindValue(1, event.sourceId);
+        insert.bindValue(2, static_cast<int>(event.trigger));
+        insert.bindValue(3, event.faceCount);
+        insert.bindValue(4, packFaceIds(event.faceIds));
+        insert.bindValue(5, event.motionArea.x());
+        insert.bindValue(6, event.motionArea.y());
+        insert.bindValue(7, event.motionArea.width());
+        insert.bindValue(8, event.motionArea.height());
+        insert.bindValue(9, event.recordingStartMs);
+        if (!insert.exec()) {
+            qWarning() << "EventStore: Insert failed" << insert.lastError().text();
+            database.rollback();
+            return false;
+        }
+    }
+
+    if (!database.commit()) {
+        qWarning() << "EventStore: Commit failed" << database.lastError().text();
+        database.rollback();
+        return false;
+    }
+    return true;
+}
+
+void EventStore::run()
+{
+    const QString connectionName = m_connectionPrefix + "_write";
+    {
+        QSqlDatabase database;
+        const bool connected = openConnection(database, connectionName);
+        QSqlQuery insert(database);
+        const bool prepared = connected && insert.prepare(kInsertSQL);
+        if (connected && !prepared) {
+            qWarning() << "EventStore: Failed to prepare insert" << insert.lastError().text();
+        }
+
+        while (true) {
+            QVector<StoredEvent> batch;
+            QVector<RecordingLink> links;
+            qint64 purgeBeforeMs = -1;
+            quint64 flushRequest = 0;
+            bool stopping = false;
+            {
+                QMutexLocker locker(&m_mutex);
+                if (m_pending.size() < m_options.batchSize && !m_stopping
+                    && m_flushRequested == m_flushCompleted && m_purgeBeforeMs < 0 && m_pendingLinks.isEmpty()) {
+                    m_wake.wait(&m_mutex, m_options.flushIntervalMs);
+                }
+                batch.swap(m_pending);
+                links.swap(m_pendingLinks);
+                purgeBeforeMs = m_purgeBeforeMs;
+                m_purgeBeforeMs = -1;
+                flushRequest = m_flushRequested;
+                stopping = m_stopping;
+                m_pendingGauge->set(0);
+            }
+
+            if (!batch.isEmpty()) {
+                QElapsedTimer timer;
+                timer.start();
+                if (prepared && writeBatch(database, insert, batch)) {
+                    m_writtenCounter->add(batch.size());
+                    m_flushMs->record(timer.nsecsElapsed() / 1e6);
+                    emit eventsWritten(batch.size());
+                } else {
+                    m_droppedCounter->add(batch.size());
+                }
+            }
+
+            // 回填在本轮批次写入之后执行，覆盖回填请求之前已出队的事件
+            if (!links.isEmpty() && connected) {
+                QSqlQuery link(database);
+                link.prepare(kLinkRecordingSQL);
+                for (const RecordingLink& request : links) {
+                    link.bindValue(0, request.recordingStartMs);
+                    link.bindValue(1, request.fromMs);
+                    link.bindValue(2, request.recordingStartMs);
+                    if (!link.exec()) {
+                        qWarning() << "EventStore: Recording link failed" << link.lastError().text();
+                    }
+                }
+            }
+
+            if (purgeBeforeMs >= 0 && connected) {
+                QSqlQuery purge(database);
+                purge.prepare("DELETE FROM events WHERE ts_ms < ?");
+                purge.addBindValue(purgeBeforeMs);
+                if (!purge.exec()) {
+                    qWarning() << "EventStore: Purge failed" << purge.lastError().text();
+                } else {
+                    qDebug() << "EventStore: Purged" << purge.numRowsAffected() << "events before"
+                             << QDateTime::fromMSecsSinceEpoch(purgeBeforeMs).toString(Qt::ISODate);
+                }
+            }
+
+            // 本轮开始前发出的 flush 请求此时都已满足
+            QMutexLocker locker(&m_mutex);
+            m_flushCompleted = flushRequest;
+            m_flushed.wakeAll();
+            if (stopping && m_pending.isEmpty() && m_pendingLinks.isEmpty()) {
+                break;
+            }
+        }
+
+        insert.finish();
+        insert = QSqlQuery();
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+QSharedPointer<QSqlQuery> EventStore::cachedReadQuery(const QString& sql)
+{
+    auto it = m_readStatements.constFind(sql);
+    if (it != m_readStatements.constEnd()) {
+        return it.value();
+    }
+
+    QSharedPointer<QSqlQuery> query(new QSqlQuery(m_readDatabase));
+    query->setForwardOnly(true);
+    if (!query->prepare(sql)) {
+        qWarning() << "EventStore: Failed to prepare" << sql << query->lastError().text();
+        return QSharedPointer<QSqlQuery>();
+    }
+    m_readStatements.insert(sql, query);
+    return query;
+}
+
+EventPage EventStore::query(const EventQuery& request)
+{
+    EventPage page;
+    if (!m_open) {
+        return page;
+    }
+
+    // 只有 4 种 SQL 形态（是否按来源 × 是否有游标），各自缓存预编译语句
+    QString sql = "SELECT id, ts_ms, source_id, trigger_type, face_count, face_ids, "
+                  "motion_x, motion_y, motion_w, motion_h, recording_start_ms "
+                  "FROM events WHERE ts_ms >= ? AND ts_ms <= ?";
+    if (request.sourceId >= 0) {
+        sql += " AND source_id = ?";
+    }
+    if (request.beforeMs >= 0) {
+        // 上界已收紧到游标时刻，这里只处理同一毫秒内按 id 续页；OR 条件本身不能作为索引边界
+        sql += " AND (ts_ms < ? OR (ts_ms = ? AND id < ?))";
+    }
+    sql += " ORDER BY ts_ms DESC, id DESC LIMIT ?";
+
+    QSharedPointer<QSqlQuery> query = cachedReadQuery(sql);
+    if (!query) {
+        return page;
+    }
+
+    const int limit = qMax(1, request.limit);
+    // 有游标时上界取 min(toMs, 游标时刻)：索引区间直接从游标处开始，已翻过的行不再逐条读出丢弃
+    query->addBindValue(request.fromMs);
+    query->addBindValue(request.beforeMs >= 0 ? qMin(request.toMs, request.beforeMs) : request.toMs);
+    if (request.sourceId >= 0) {
+        query->addBindValue(request.sourceId);
+    }
+    if (request.beforeMs >= 0) {
+        query->addBindValue(request.beforeMs);
+        query->addBindValue(request.beforeMs);
+        query->addBindValue(request.beforeId);
+    }
+    query->addBindValue(limit + 1);     // 多取一条判断是否还有下一页
+
+    if (!query->exec()) {
+        qWarning() << "EventStore: Query failed" << query->lastError().text();
+        return page;
+    }
+
+    page.events.reserve(limit);
+    while (query->next()) {
+        if (page.events.size() == limit) {
+            page.hasMore = true;
+            break;
+        }
+        StoredEvent event;
+        event.id = query->value(0).toLongLong();
+        event.timeMs = query->value(1).toLongLong();
+        event.sourceId = query->value(2).toInt();
+        event.trigger = static_cast<RecordTrigger>(query->value(3).toInt());
+        event.faceCount = query->value(4).toInt();
+        event.faceIds = unpackFaceIds(query->value(5).toByteArray());
+        event.motionArea = QRect(query->value(6).toInt(), query->value(7).toInt(),
+                                 query->value(8).toInt(), query->value(9).toInt());
+        event.recordingStartMs = query->value(10).toLongLong();
+        page.events.append(event);
+    }
+    query->finish();
+
+    if (!page.events.isEmpty()) {
+        page.nextBeforeMs = page.events.last().timeMs;
+        page.nextBeforeId = page.events.last().id;
+    }
+    return page;
+}
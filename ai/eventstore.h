@@ -0,0 +1,174 @@
+// ai/eventstore.h
+#ifndef EVENTSTORE_H
+#define EVENTSTORE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSharedPointer>
+#include <QHash>
+#include <QVector>
+#include <QRect>
+#include <limits>
+#include "aitypes.h"
+
+class MetricCounter;
+class MetricGauge;
+class MetricHistogram;
+
+// 🆕 持久化的检测/录像事件
+struct StoredEvent {
+    qint64 id = 0;
+    qint64 timeMs = 0;                  // 墙钟毫秒（UTC epoch）
+    int sourceId = 0;
+    RecordTrigger trigger = RecordTrigger::None;
+    int faceCount = 0;
+    QVector<qint32> faceIds;            // 数据库人员 id，-1 表示未识别
+    QRect motionArea;
+    qint64 recordingStartMs = 0;        // 所属录像的开始时间（分段索引按它定位片段），0 表示没有录像
+};
+
+// 🆕 分页查询：按时间倒序，游标为上一页最后一条的 (timeMs, id)
+struct EventQuery {
+    qint64 fromMs = 0;
+    qint64 toMs = std::numeric_limits<qint64>::max();
+    int sourceId = -1;                  // -1 表示全部来源
+    int limit = 50;
+    qint64 beforeMs = -1;               // 游标；-1 表示从 toMs 开始
+    qint64 beforeId = 0;
+};
+
+struct EventPage {
+    QVector<StoredEvent> events;
+    bool hasMore = false;
+    qint64 nextBeforeMs = -1;           // 下一页的游标
+    qint64 nextBeforeId = 0;
+};
+
+// 🆕 检测结果 → 事件的归类与去重：无运动且无人脸的帧不算事件；同一来源、同类触发、
+// 同一批人脸在 coalesceMs 内只算一次，触发类型或人员组合变化时立即算新事件
+// 事件库与快照服务各持一份：输入同一串检测结果时得到相同的事件时刻，快照文件可按 (来源, 时刻) 对应到事件
+class EventCoalescer
+{
+public:
+    struct Event {
+        qint64 timeMs = 0;              // 墙钟毫秒
+        RecordTrigger trigger = RecordTrigger::None;
+        QVector<qint32> faceIds;        // 按人脸顺序，-1 表示未识别
+    };
+
+    static RecordTrigger classify(const DetectionResult& result);
+
+    // 线程安全；是新事件时返回 true 并填写 event
+    bool accept(const DetectionResult& result, int coalesceMs, Event* event);
+
+private:
+    struct LastEvent {
+        RecordTrigger trigger = RecordTrigger::None;
+        QVector<qint32> sortedFaceIds;
+        qint64 timeMs = 0;
+    };
+
+    QMutex m_mutex;
+    QHash<int, LastEvent> m_lastBySource;
+};
+
+// 🆕 事件库（SQLite）：写入只进内存队列，后台线程按批在一个事务里插入
+// - append/recordDetection 任意线程调用，不触碰数据库、不阻塞；队列超过上限时丢弃并计数
+// - 查询使用独立的只读连接（WAL 下不被写入阻塞），只能在调用 open() 的线程中使用
+// - 索引 (ts_ms) 与 (source_id, ts_ms)，分页用游标而非 OFFSET：上界收紧到游标时刻，
+//   翻到多深都从游标处开始一次索引区间扫描（索引隐含 rowid，(ts_ms, id) 倒序无需额外排序）
+// 指标：eventstore.pending / eventstore.events.written / eventstore.events.dropped /
+// eventstore.flush_ms
+class EventStore : public QThread
+{
+    Q_OBJECT
+
+public:
+    struct Options {
+        int flushIntervalMs = 1000;     // 最长攒批时间
+        int batchSize = 256;            // 攒够即写
+        int maxPending = 10000;         // 内存队列上限
+        int coalesceMs = 2000;          // recordDetection：同一来源、同类触发、同一批人脸在此间隔内只记一条
+    };
+
+    explicit EventStore(QObject* parent = nullptr);
+    ~EventStore() override;
+
+    void setOptions(const Options& options) { m_options = options; }
+    Options options() const { return m_options; }
+
+    // 打开/建表并启动写线程；dbPath 为空时使用 <应用目录>/data/database/events.db
+    bool open(const QString& dbPath = QString());
+    void close();                       // 写完队列中的事件后停止写线程
+    bool isOpen() const { return m_open; }
+    QString databasePath() const { return m_databasePath; }
+
+    void append(const StoredEvent& event);
+
+    // 把一帧检测结果归类为事件（无运动且无人脸时忽略），按 coalesceMs 合并重复事件；返回是否入队
+    bool recordDetection(const DetectionResult& result, qint64 recordingStartMs = 0);
+
+    // 🆕 录像开始后回填关联：[fromMs, recordingStartMs] 内还没有关联录像的事件（触发本次录像的检测
+    // 发生在预录阶段，入库时录像尚未开始）改为属于该录像；队列中的直接修改，已写入的在写线程中更新
+    void linkRecording(qint64 fromMs, qint64 recordingStartMs);
+
+    // 删除早于 timeMs 的事件（在写线程中执行）
+    void purgeBefore(qint64 timeMs);
+
+    // 阻塞直到此前入队的事件与清理请求都已处理完
+    void flush();
+
+    EventPage query(const EventQuery& query);
+
+signals:
+    void eventsWritten(int count);      // 在写线程发出
+
+protected:
+    void run() override;
+
+private:
+    bool openConnection(QSqlDatabase& database, const QString& connectionName);
+    bool createSchema(QSqlDatabase& database);
+    bool writeBatch(QSqlDatabase& database, QSqlQuery& insert, const QVector<StoredEvent>& batch);
+    QSharedPointer<QSqlQuery> cachedReadQuery(const QString& sql);
+
+    static QByteArray packFaceIds(const QVector<qint32>& faceIds);
+    static QVector<qint32> unpackFaceIds(const QByteArray& blob);
+
+    Options m_options;
+    QString m_databasePath;
+    QString m_connectionPrefix;
+    bool m_open = false;
+
+    // 写队列
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QWaitCondition m_flushed;
+    QVector<StoredEvent> m_pending;
+    struct RecordingLink {
+        qint64 fromMs;
+        qint64 recordingStartMs;
+    };
+    QVector<RecordingLink> m_pendingLinks;  // 等待写线程执行的录像回填
+    qint64 m_purgeBeforeMs = -1;
+    quint64 m_flushRequested = 0;       // flush() 请求序号
+    quint64 m_flushCompleted = 0;       // 写线程处理完的请求序号
+    bool m_accepting = false;
+    bool m_stopping = false;
+
+    EventCoalescer m_coalescer;         // recordDetection 的去重状态
+
+    // 只读连接（open() 所在线程）
+    QSqlDatabase m_readDatabase;
+    QHash<QString, QSharedPointer<QSqlQuery>> m_readStatements;
+
+    MetricGauge* m_pendingGauge;
+    MetricCounter* m_writtenCounter;
+    MetricCounter* m_droppedCounter;
+    MetricHistogram* m_flushMs;
+};
+
+#endif // EVENTSTORE_H
@@ -0,0 +1,164 @@
+// ai/facebatchscheduler.cpp
+#include "facebatchscheduler.h"
+#include <QMutexLocker>
+#include <cstring>
+
+// ========== FaceBatch ==========
+void FaceBatch::reserve(int count)
+{
+    m_pixels.reserve(count * kCropBytes);
+    m_tickets.reserve(count);
+}
+
+void FaceBatch::clear()
+{
+    // 保留容量，批缓冲区可反复复用
+    m_pixels.resize(0);
+    m_tickets.resize(0);
+}
+
+void FaceBatch::append(const FaceCropTicket& ticket, const uchar* rgb, int stride)
+{
+    const int offset = m_pixels.size();
+    m_pixels.resize(offset + kCropBytes);
+
+    uchar* dst = reinterpret_cast<uchar*>(m_pixels.data()) + offset;
+    const int rowBytes = kCropSize * kChannels;
+    if (stride == rowBytes) {
+        memcpy(dst, rgb, kCropBytes);
+    } else {
+        for (int y = 0; y < kCropSize; ++y) {
+            memcpy(dst + y * rowBytes, rgb + y * stride, rowBytes);
+        }
+    }
+
+    m_tickets.append(ticket);
+}
+
+uchar* FaceBatch::appendSlot(const FaceCropTicket& ticket)
+{
+    const int offset = m_pixels.size();
+    m_pixels.resize(offset + kCropBytes);
+    m_tickets.append(ticket);
+    return reinterpret_cast<uchar*>(m_pixels.data()) + offset;
+}
+
+void FaceBatch::removeLast()
+{
+    if (m_tickets.isEmpty()) {
+        return;
+    }
+    m_tickets.removeLast();
+    m_pixels.resize(m_pixels.size() - kCropBytes);
+}
+
+void FaceBatch::append(const FaceBatch& other)
+{
+    m_pixels.append(other.m_pixels);
+    m_tickets += other.m_tickets;
+}
+
+// ========== FaceBatchScheduler ==========
+FaceBatchScheduler::FaceBatchScheduler()
+{
+    m_pending.reserve(m_maxBatchSize);
+}
+
+void FaceBatchScheduler::setMaxBatchSize(int size)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxBatchSize = qMax(1, size);
+    m_pending.reserve(m_maxBatchSize);
+}
+
+void FaceBatchScheduler::setMaxLatencyMs(int ms)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxLatencyMs = qMax(0, ms);
+}
+
+void FaceBatchScheduler::submit(const FaceBatch& faces)
+{
+    if (faces.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_pending.isEmpty()) {
+        m_oldestTimer.start();
+    }
+    m_pending.append(faces);
+}
+
+int FaceBatchScheduler::pendingCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pending.size();
+}
+
+bool FaceBatchScheduler::isDue() const
+{
+    QMutexLocker locker(&m_mutex);
+    return isDueLocked();
+}
+
+bool FaceBatchScheduler::isDueLocked() const
+{
+    if (m_pending.isEmpty()) {
+        return false;
+    }
+    return m_pending.size() >= m_maxBatchSize || m_oldestTimer.elapsed() >= m_maxLatencyMs;
+}
+
+int FaceBatchScheduler::msUntilDue() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_pending.isEmpty()) {
+        return -1;
+    }
+    if (isDueLocked()) {
+        return 0;
+    }
+    return int(m_maxLatencyMs - m_oldestTimer.elapsed());
+}
+
+FaceBatch FaceBatchScheduler::takeBatch(bool force)
+{
+    QMutexLocker locker(&m_mutex);
+
+    FaceBatch batch;
+    if (m_pending.isEmpty() || (!force && !isDueLocked())) {
+        return batch;
+    }
+
+    if (m_pending.size() <= m_maxBatchSize) {
+        batch = m_pending;
+        m_pending.clear();
+    } else {
+        // 超出批大小：先取最早的一批，其余留待下次（沿用原计时，剩余部分已到期）
+        FaceBatch rest;
+        rest.reserve(m_maxBatchSize);
+        batch.reserve(m_maxBatchSize);
+        for (int i = 0; i < m_pending.size(); ++i) {
+            FaceBatch& target = (i < m_maxBatchSize) ? batch : rest;
+            target.append(m_pending.ticket(i), m_pending.crop(i), FaceBatch::kCropSize * FaceBatch::kChannels);
+        }
+        m_pending = rest;
+    }
+
+    m_batchesDispatched++;
+    m_facesDispatched += batch.size();
+    return batch;
+}
+
+quint64 FaceBatchScheduler::batchesDispatched() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_batchesDispatched;
+}
+
+quint64 FaceBatchScheduler::facesDispatched() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_facesDispatched;
+}
@@ -0,0 +1,93 @@
+// ai/facebatchscheduler.h
+#ifndef FACEBATCHSCHEDULER_H
+#define FACEBATCHSCHEDULER_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QRect>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+// 🆕 一张对齐后的人脸对应的来源信息（结果按此回填到所属帧）
+struct FaceCropTicket {
+    int sourceId = 0;          // 摄像头/视频源编号
+    quint64 frameId = 0;       // 源内帧序号
+    int faceIndex = 0;         // 在该帧检测结果中的下标
+    QRect bbox;                // 原始帧坐标系下的人脸框
+    float confidence = 0.0f;   // 检测置信度
+};
+
+// 🆕 人脸批：所有对齐人脸连续存放在同一块缓冲区
+// 每张人脸固定 kCropSize × kCropSize 的 RGB888，推理后端可直接按下标取用
+class FaceBatch
+{
+public:
+    static const int kCropSize = 112;
+    static const int kChannels = 3;
+    static const int kCropBytes = kCropSize * kCropSize * kChannels;
+
+    void reserve(int count);
+    void clear();
+
+    // rgb 必须是 kCropSize × kCropSize 的 RGB888，stride 为行字节数
+    void append(const FaceCropTicket& ticket, const uchar* rgb, int stride);
+    void append(const FaceBatch& other);
+
+    // 追加一个未初始化的槽位，由调用方直接写入像素（行字节数 kCropSize*kChannels）
+    uchar* appendSlot(const FaceCropTicket& ticket);
+    void removeLast();
+
+    int size() const { return m_tickets.size(); }
+    bool isEmpty() const { return m_tickets.isEmpty(); }
+
+    const uchar* crop(int index) const {
+        return reinterpret_cast<const uchar*>(m_pixels.constData()) + index * kCropBytes;
+    }
+    const FaceCropTicket& ticket(int index) const { return m_tickets[index]; }
+
+private:
+    QByteArray m_pixels;                  // size() × kCropBytes
+    QVector<FaceCropTicket> m_tickets;
+};
+
+// 🆕 跨帧/跨摄像头的人脸批调度器
+// 对齐后的人脸先进入待处理批，批满或最早一张等待超过截止时间时才交给推理，
+// 让后端尽量一次处理多张人脸；截止时间限制了因攒批带来的额外延迟。
+// 线程安全：可由多个采集/检测线程同时提交。
+class FaceBatchScheduler
+{
+public:
+    FaceBatchScheduler();
+
+    void setMaxBatchSize(int size);
+    void setMaxLatencyMs(int ms);
+    int maxBatchSize() const { return m_maxBatchSize; }
+    int maxLatencyMs() const { return m_maxLatencyMs; }
+
+    void submit(const FaceBatch& faces);
+
+    int pendingCount() const;
+    bool isDue() const;           // 批满或已到截止时间
+    int msUntilDue() const;       // 距截止时间的毫秒数，无待处理时返回 -1
+
+    // 取出最多 maxBatchSize 张人脸；force=false 时未到期返回空批
+    FaceBatch takeBatch(bool force = false);
+
+    // 统计
+    quint64 batchesDispatched() const;
+    quint64 facesDispatched() const;
+
+private:
+    bool isDueLocked() const;
+
+    mutable QMutex m_mutex;
+    FaceBatch m_pending;
+    QElapsedTimer m_oldestTimer;  // 自最早一张待处理人脸入队起计时
+    int m_maxBatchSize = 8;
+    int m_maxLatencyMs = 30;
+    quint64 m_batchesDispatched = 0;
+    quint64 m_facesDispatched = 0;
+};
+
+#endif // FACEBATCHSCHEDULER_H
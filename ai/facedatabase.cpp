@@ -1,5 +1,9 @@
 // ai/facedatabase.cpp
 #include "facedatabase.h"
+#include "gallerysnapshot.h"
+#include "../core/Logging.h"
+#include "../core/TraceRecorder.h"
+#include "../core/FlightRecorder.h"
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDir>
@@ -8,27 +12,37 @@
 #include <QStandardPaths>
 #include <QCoreApplication>
 #include <QVariant>
+#include <QSharedPointer>
+#include <QTimer>
 #include <cmath>
 
 FaceDatabase::FaceDatabase(QObject *parent)
     : QObject(parent), m_isConnected(false)
 {
-    qDebug() << "FaceDatabase constructor started";
-    qDebug() << "FaceDatabase object created at address:" << (void*)this;
-    qDebug() << "Parent object:" << (void*)parent;
-    qDebug() << "m_isConnected initialized to:" << m_isConnected;
-    qDebug() << "FaceDatabase constructor completed successfully";
+    m_snapshotTimer = new QTimer(this);
+    m_snapshotTimer->setSingleShot(true);
+    m_snapshotTimer->setInterval(kSnapshotDelayMs);
+    connect(m_snapshotTimer, &QTimer::timeout, this, &FaceDatabase::saveGallerySnapshot);
+
+    svDebug(lcFaceDatabase) << "FaceDatabase created at address:" << (void*)this
+                            << "parent:" << (void*)parent;
 }
 
-// 同时也为 isConnected 方法添加调试信息
+// 🔧 每帧都可能调用，不再记录日志
 bool FaceDatabase::isConnected() const
 {
-    qDebug() << "isConnected() called, m_isConnected value:" << m_isConnected;
     return m_isConnected;
 }
 
 FaceDatabase::~FaceDatabase()
 {
+    // 尚未写入的识别统计与推迟的快照
+    flushRecognitionStats();
+    saveGallerySnapshot();
+
+    // 缓存的语句必须先于连接释放
+    clearStatementCache();
+
     // 析构时关闭数据库连接
     if (m_database.isOpen()) {
         m_database.close();
@@ -72,6 +86,14 @@ bool FaceDatabase::initialize(const QString& dbPath)
 
     qDebug() << "Database opened successfully:" << m_databasePath;
 
+    QFileInfo dbInfo(m_databasePath);
+    m_snapshotPath = dbInfo.absolutePath() + "/" + dbInfo.completeBaseName() + ".gallery";
+
+    // 4.1 应用存储调优参数（WAL / synchronous / cache / mmap）
+    if (!applyStoragePragmas()) {
+        qDebug() << "Warning: Failed to apply some storage pragmas, but continuing...";
+    }
+
     // 5. 创建表结构
     if (!createTables()) {
         m_database.close();
@@ -84,6 +106,9 @@ bool FaceDatabase::initialize(const QString& dbPath)
     }
 
     m_isConnected = true;
+
+    // 7. 🔧 启动时即发布人脸库，匹配线程的第一次比对不再加载
+    refreshGalleryLocked();
     qDebug() << "Face database initialized successfully";
 
     return true;
@@ -93,14 +118,12 @@ bool FaceDatabase::createTables()
 {
     QSqlQuery query(m_database);
 
-    // 创建人脸记录表的SQL语句
-    // 详细解释每个字段的作用：
-    QString createTableSQL = R"(
-        CREATE TABLE IF NOT EXISTS face_records (
+    // 🔧 人员表：每人一行元数据，姓名唯一
+    QString createPersonsSQL = R"(
+        CREATE TABLE IF NOT EXISTS persons (
             id INTEGER PRIMARY KEY AUTOINCREMENT,  -- 主键，自动递增
             name TEXT UNIQUE NOT NULL,              -- 人员姓名，唯一且不能为空
-            image_path TEXT,                        -- 人脸图片文件路径
-            feature BLOB NOT NULL,                  -- 人脸特征数据（二进制大对象）
+            image_path TEXT,                        -- 代表性人脸图片路径
             description TEXT,                       -- 描述信息
             create_time DATETIME DEFAULT CURRENT_TIMESTAMP,  -- 创建时间，默认当前时间
             last_seen DATETIME,                     -- 最后识别时间
@@ -109,43 +132,202 @@ bool FaceDatabase::createTables()
         )
     )";
 
-    if (!query.exec(createTableSQL)) {
-        logError("Failed to create face_records table", query.lastError());
+    if (!query.exec(createPersonsSQL)) {
+        logError("Failed to create persons table", query.lastError());
         return false;
     }
 
-    qDebug() << "face_records table created successfully";
+    // 🆕 模板表：同一人可有多条特征（不同姿态/光照）
+    QString createTemplatesSQL = R"(
+        CREATE TABLE IF NOT EXISTS face_templates (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,  -- 主键，自动递增
+            person_id INTEGER NOT NULL REFERENCES persons(id) ON DELETE CASCADE,
+            feature BLOB NOT NULL,                  -- 人脸特征数据（512个float）
+            quality REAL DEFAULT 1.0,               -- 模板质量分，超出上限时淘汰低分
+            image_path TEXT,                        -- 该模板对应的图片路径
+            create_time DATETIME DEFAULT CURRENT_TIMESTAMP
+        )
+    )";
+
+    if (!query.exec(createTemplatesSQL)) {
+        logError("Failed to create face_templates table", query.lastError());
+        return false;
+    }
+
+    // 🆕 人脸库代数：模板每次变更+1，用于判断磁盘快照是否过期
+    QString createMetaSQL = R"(
+        CREATE TABLE IF NOT EXISTS gallery_meta (
+            key TEXT PRIMARY KEY,
+            value INTEGER NOT NULL
+        )
+    )";
+
+    if (!query.exec(createMetaSQL) ||
+        !query.exec("INSERT OR IGNORE INTO gallery_meta (key, value) VALUES ('generation', 0)")) {
+        logError("Failed to create gallery_meta table", query.lastError());
+        return false;
+    }
+
+    if (!migrateLegacyRecords()) {
+        return false;
+    }
+
+    qDebug() << "persons / face_templates tables created successfully";
     return true;
 }
 
-bool FaceDatabase::createIndexes()
+bool FaceDatabase::migrateLegacyRecords()
 {
     QSqlQuery query(m_database);
 
-    // 创建姓名索引，提高按姓名查询的性能
-    QString createNameIndexSQL = "CREATE INDEX IF NOT EXISTS idx_face_name ON face_records(name)";
-    if (!query.exec(createNameIndexSQL)) {
-        logError("Failed to create name index", query.lastError());
+    // 旧版单模板表 face_records：存在则迁移为 人员 + 模板
+    if (!query.exec("SELECT name FROM sqlite_master WHERE type = 'table' AND name = 'face_records'")) {
+        logError("Failed to inspect schema", query.lastError());
+        return false;
+    }
+    if (!query.next()) {
+        return true;
+    }
+    query.finish();
+
+    qDebug() << "Migrating legacy face_records table to persons / face_templates...";
+
+    if (!m_database.transaction()) {
+        logError("Failed to start migration transaction", m_database.lastError());
+        return false;
+    }
+
+    const QStringList statements = {
+        "INSERT INTO persons (id, name, image_path, description, create_time, last_seen, recognition_count, is_active) "
+        "SELECT id, name, image_path, description, create_time, last_seen, recognition_count, is_active FROM face_records",
+        "INSERT INTO face_templates (person_id, feature, quality, image_path, create_time) "
+        "SELECT id, feature, 1.0, image_path, create_time FROM face_records",
+        "DROP TABLE face_records",
+        "UPDATE gallery_meta SET value = value + 1 WHERE key = 'generation'"
+    };
+
+    for (const QString& sql : statements) {
+        if (!query.exec(sql)) {
+            logError("Legacy migration failed", query.lastError());
+            m_database.rollback();
+            return false;
+        }
+    }
+
+    if (!m_database.commit()) {
+        logError("Failed to commit migration", m_database.lastError());
+        m_database.rollback();
         return false;
     }
 
-    // 创建激活状态索引
-    QString createActiveIndexSQL = "CREATE INDEX IF NOT EXISTS idx_face_active ON face_records(is_active)";
+    qDebug() << "Legacy face_records migrated successfully";
+    return true;
+}
+
+bool FaceDatabase::applyStoragePragmas()
+{
+    QSqlQuery query(m_database);
+    QStringList pragmas;
+
+    if (m_storageOptions.enableWAL) {
+        // WAL模式下识别线程的读取不会被注册写入阻塞
+        pragmas << "PRAGMA journal_mode=WAL";
+    }
+    if (!m_storageOptions.synchronous.isEmpty()) {
+        pragmas << QString("PRAGMA synchronous=%1").arg(m_storageOptions.synchronous);
+    }
+    if (m_storageOptions.cacheSizeKiB > 0) {
+        // 负值表示以KiB为单位
+        pragmas << QString("PRAGMA cache_size=-%1").arg(m_storageOptions.cacheSizeKiB);
+        pragmas << "PRAGMA temp_store=MEMORY";
+    }
+    if (m_storageOptions.mmapSizeBytes > 0) {
+        pragmas << QString("PRAGMA mmap_size=%1").arg(m_storageOptions.mmapSizeBytes);
+    }
+    // 删除人员时级联删除其模板
+    pragmas << "PRAGMA foreign_keys=ON";
+
+    bool allApplied = true;
+    for (const QString& pragma : pragmas) {
+        if (!query.exec(pragma)) {
+            logError("Failed to apply " + pragma, query.lastError());
+            allApplied = false;
+            continue;
+        }
+        if (query.next()) {
+            logDebug(QString("%1 -> %2").arg(pragma, query.value(0).toString()));
+        }
+        query.finish();
+    }
+
+    return allApplied;
+}
+
+QSharedPointer<QSqlQuery> FaceDatabase::cachedQuery(const QString& sql)
+{
+    if (m_storageOptions.cacheStatements) {
+        auto it = m_statementCache.constFind(sql);
+        if (it != m_statementCache.constEnd()) {
+            return it.value();
+        }
+    }
+
+    QSharedPointer<QSqlQuery> query(new QSqlQuery(m_database));
+    if (!query->prepare(sql)) {
+        logError("Failed to prepare statement: " + sql, query->lastError());
+        return QSharedPointer<QSqlQuery>();
+    }
+
+    if (m_storageOptions.cacheStatements) {
+        m_statementCache.insert(sql, query);
+    }
+    return query;
+}
+
+void FaceDatabase::clearStatementCache()
+{
+    QMutexLocker locker(&m_mutex);
+    m_statementCache.clear();
+}
+
+bool FaceDatabase::createIndexes()
+{
+    QSqlQuery query(m_database);
+
+    // 姓名已有UNIQUE约束（隐式索引），这里只需激活状态索引
+    QString createActiveIndexSQL = "CREATE INDEX IF NOT EXISTS idx_person_active ON persons(is_active)";
     if (!query.exec(createActiveIndexSQL)) {
         logError("Failed to create active index", query.lastError());
         return false;
     }
 
+    // 按人员取模板、按质量淘汰
+    QString createTemplateIndexSQL = "CREATE INDEX IF NOT EXISTS idx_template_person ON face_templates(person_id, quality)";
+    if (!query.exec(createTemplateIndexSQL)) {
+        logError("Failed to create template index", query.lastError());
+        return false;
+    }
+
     qDebug() << "Database indexes created successfully";
     return true;
 }
 
+void FaceDatabase::setMatchPolicy(TemplateAggregation aggregation, int topN, int maxTemplatesPerPerson)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxTemplatesPerPerson = qMax(1, maxTemplatesPerPerson);
+
+    QMutexLocker galleryLocker(&m_galleryMutex);
+    m_aggregation = aggregation;
+    m_templateTopN = qMax(1, topN);
+}
+
 bool FaceDatabase::addFaceRecord(const QString& name,
                                  const QString& imagePath,
                                  const QByteArray& feature,
-                                 const QString& description)
+                                 const QString& description,
+                                 float quality)
 {
-    qDebug() << "addFaceRecord: Method entered";
     QMutexLocker locker(&m_mutex);
 
     // 基本验证
@@ -159,69 +341,222 @@ bool FaceDatabase::addFaceRecord(const QString& name,
         return false;
     }
 
-    if (feature.isEmpty()) {
-        qDebug() << "addFaceRecord: Feature data cannot be empty";
+    if (!isValidFeature(feature)) {
+        qDebug() << "addFaceRecord: Invalid feature data";
         return false;
     }
 
-    qDebug() << "addFaceRecord: Starting transaction for complete record insertion";
+    FaceEnrollment enrollment;
+    enrollment.name = name.trimmed();
+    enrollment.imagePath = imagePath;
+    enrollment.feature = feature;
+    enrollment.description = description;
+    enrollment.quality = quality;
 
-    // 🔧 使用事务确保数据一致性
+    // 🔧 代数推进、人员、模板、淘汰是多条语句，放在一个事务里：模板写入失败时不留下无模板的人员
     if (!m_database.transaction()) {
-        qDebug() << "addFaceRecord: Failed to start transaction";
+        logError("addFaceRecord: Failed to start transaction", m_database.lastError());
         return false;
     }
 
-    // 🔧 一次性插入完整记录，包括BLOB数据
-    QSqlQuery query(m_database);
-
-    // 准备完整的INSERT语句
-    QString insertSQL = "INSERT INTO face_records (name, image_path, feature, description, create_time, last_seen, recognition_count, is_active) "
-                        "VALUES (?, ?, ?, ?, ?, ?, ?, ?)";
-
-    if (!query.prepare(insertSQL)) {
-        qDebug() << "addFaceRecord: Failed to prepare INSERT statement";
-        qDebug() << "SQL Error:" << query.lastError().text();
+    int newId = insertFaceRecordLocked(enrollment);
+    if (newId < 0) {
         m_database.rollback();
         return false;
     }
 
-    // 绑定所有参数
-    query.addBindValue(name.trimmed());                                     // name
-    query.addBindValue(imagePath);                                          // image_path
-    query.addBindValue(feature);                                            // feature (BLOB)
-    query.addBindValue(description);                                        // description
-    query.addBindValue(QDateTime::currentDateTime());                       // create_time
-    query.addBindValue(QDateTime::currentDateTime());                       // last_seen
-    query.addBindValue(0);                                                  // recognition_count
-    query.addBindValue(true);                                               // is_active
-
-    qDebug() << "addFaceRecord: Executing complete INSERT with all data";
-    qDebug() << "  - Name:" << name.trimmed();
-    qDebug() << "  - Image path:" << imagePath;
-    qDebug() << "  - Feature size:" << feature.size() << "bytes";
-    qDebug() << "  - Description:" << description;
-
-    if (!query.exec()) {
-        qDebug() << "addFaceRecord: Complete INSERT failed";
-        qDebug() << "SQL Error:" << query.lastError().text();
-        qDebug() << "SQL Error Type:" << query.lastError().type();
+    if (!m_database.commit()) {
+        logError("addFaceRecord: Failed to commit transaction", m_database.lastError());
         m_database.rollback();
         return false;
     }
 
-    // 提交事务
+    // 🔧 提交成功后在注册线程增量更新并发布人脸库，匹配线程在此期间继续使用旧的一份
+    publishPersonLocked(newId);
+    locker.unlock();
+
+    FlightRecorder::instance().recordEvent(FlightRecorder::DbWrite, -1, 1, "add_face");
+    qDebug() << "addFaceRecord: Record inserted successfully with ID:" << newId;
+    emit faceAdded(enrollment.name, newId);
+    return true;
+}
+
+int FaceDatabase::addFaceRecords(const QVector<FaceEnrollment>& batch)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_isConnected || batch.isEmpty()) {
+        return 0;
+    }
+
+    // 先整体校验，避免写到一半才回滚
+    for (const FaceEnrollment& enrollment : batch) {
+        if (enrollment.name.trimmed().isEmpty() || !isValidFeature(enrollment.feature)) {
+            logDebug(QString("addFaceRecords: Invalid entry '%1', batch rejected").arg(enrollment.name));
+            return 0;
+        }
+    }
+
+    QDateTime startTime = QDateTime::currentDateTime();
+
+    if (!m_database.transaction()) {
+        logError("addFaceRecords: Failed to start transaction", m_database.lastError());
+        return 0;
+    }
+
+    QVector<int> newIds;
+    newIds.reserve(batch.size());
+
+    for (const FaceEnrollment& enrollment : batch) {
+        int newId = insertFaceRecordLocked(enrollment);
+        if (newId < 0) {
+            m_database.rollback();
+            logDebug(QString("addFaceRecords: Insert of '%1' failed, batch rolled back").arg(enrollment.name));
+            return 0;
+        }
+        newIds.append(newId);
+    }
+
     if (!m_database.commit()) {
-        qDebug() << "addFaceRecord: Failed to commit transaction";
-        qDebug() << "SQL Error:" << m_database.lastError().text();
-        return false;
+        logError("addFaceRecords: Failed to commit transaction", m_database.lastError());
+        m_database.rollback();
+        return 0;
     }
 
-    int newId = query.lastInsertId().toInt();
-    qDebug() << "addFaceRecord: Complete record inserted successfully with ID:" << newId;
+    // 整批只重新加载一次人脸库，快照推迟回写
+    const QSharedPointer<const FaceGallery> reloaded = loadGalleryLocked();
+    {
+        QMutexLocker galleryLocker(&m_galleryMutex);
+        m_gallery = reloaded;
+    }
+    scheduleSnapshotLocked();
+    locker.unlock();
 
-    emit faceAdded(name.trimmed(), newId);
-    return true;
+    FlightRecorder::instance().recordEvent(FlightRecorder::DbWrite, -1, newIds.size(), "add_face_batch");
+    logDebug(QString("addFaceRecords: %1 records committed in %2 ms")
+                 .arg(newIds.size())
+                 .arg(startTime.msecsTo(QDateTime::currentDateTime())));
+
+    for (int i = 0; i < newIds.size(); ++i) {
+        emit faceAdded(batch[i].name.trimmed(), newIds[i]);
+    }
+
+    return newIds.size();
+}
+
+int FaceDatabase::insertFaceRecordLocked(const FaceEnrollment& enrollment)
+{
+    const QString name = enrollment.name.trimmed();
+
+    // 0. 先推进代数：即使后续写入中途失败，旧快照也只会被判为过期而不会被误用
+    if (!bumpGalleryGenerationLocked()) {
+        return -1;
+    }
+
+    // 1. 已有同名人员则追加模板，否则新建人员
+    int personId = findPersonIdLocked(name);
+    if (personId < 0) {
+        QSharedPointer<QSqlQuery> query = cachedQuery(
+            "INSERT INTO persons (name, image_path, description, create_time, last_seen, recognition_count, is_active) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?)");
+        if (!query) {
+            return -1;
+        }
+
+        const QDateTime now = QDateTime::currentDateTime();
+
+        query->bindValue(0, name);                         // name
+        query->bindValue(1, enrollment.imagePath);         // image_path
+        query->bindValue(2, enrollment.description);       // description
+        query->bindValue(3, now);                          // create_time
+        query->bindValue(4, now);                          // last_seen
+        query->bindValue(5, 0);                            // recognition_count
+        query->bindValue(6, true);                         // is_active
+
+        if (!query->exec()) {
+            logError(QString("Failed to insert person '%1'").arg(name), query->lastError());
+            return -1;
+        }
+
+        personId = query->lastInsertId().toInt();
+        query->finish();
+    }
+
+    // 2. 写入模板并按质量裁剪到上限
+    if (insertTemplateLocked(personId, enrollment) < 0) {
+        return -1;
+    }
+    pruneTemplatesLocked(personId);
+
+    return personId;
+}
+
+int FaceDatabase::findPersonIdLocked(const QString& name)
+{
+    QSharedPointer<QSqlQuery> query = cachedQuery("SELECT id FROM persons WHERE name = ?");
+    if (!query) {
+        return -1;
+    }
+
+    query->bindValue(0, name);
+
+    int personId = -1;
+    if (query->exec() && query->next()) {
+        personId = query->value(0).toInt();
+    }
+    query->finish();
+
+    return personId;
+}
+
+int FaceDatabase::insertTemplateLocked(int personId, const FaceEnrollment& enrollment)
+{
+    QSharedPointer<QSqlQuery> query = cachedQuery(
+        "INSERT INTO face_templates (person_id, feature, quality, image_path, create_time) "
+        "VALUES (?, ?, ?, ?, ?)");
+    if (!query) {
+        return -1;
+    }
+
+    query->bindValue(0, personId);                     // person_id
+    query->bindValue(1, enrollment.feature);           // feature (BLOB)
+    query->bindValue(2, enrollment.quality);           // quality
+    query->bindValue(3, enrollment.imagePath);         // image_path
+    query->bindValue(4, QDateTime::currentDateTime()); // create_time
+
+    if (!query->exec()) {
+        logError(QString("Failed to insert template for person %1").arg(personId), query->lastError());
+        return -1;
+    }
+
+    int templateId = query->lastInsertId().toInt();
+    query->finish();
+    return templateId;
+}
+
+void FaceDatabase::pruneTemplatesLocked(int personId)
+{
+    // 保留质量最高的 m_maxTemplatesPerPerson 个模板（同分时保留较新的）
+    QSharedPointer<QSqlQuery> query = cachedQuery(
+        "DELETE FROM face_templates WHERE person_id = ? AND id NOT IN ("
+        "SELECT id FROM face_templates WHERE person_id = ? ORDER BY quality DESC, id DESC LIMIT ?)");
+    if (!query) {
+        return;
+    }
+
+    query->bindValue(0, personId);
+    query->bindValue(1, personId);
+    query->bindValue(2, m_maxTemplatesPerPerson);
+
+    if (!query->exec()) {
+        logError("Failed to prune face templates", query->lastError());
+        return;
+    }
+
+    if (query->numRowsAffected() > 0) {
+        logDebug(QString("Pruned %1 low-quality templates of person %2")
+                     .arg(query->numRowsAffected()).arg(personId));
+    }
 }
 
 QVector<FaceRecord> FaceDatabase::getAllFaceRecords()
@@ -234,21 +569,29 @@ QVector<FaceRecord> FaceDatabase::getAllFaceRecords()
     }
 
     // SQL查询语句：获取所有激活的人脸记录
-    QSqlQuery query("SELECT id, name, image_path, description, create_time, last_seen, recognition_count, is_active FROM face_records WHERE is_active = 1 ORDER BY name", m_database);
+    QSharedPointer<QSqlQuery> query = cachedQuery(
+        "SELECT p.id, p.name, p.image_path, p.description, p.create_time, p.last_seen, p.recognition_count, p.is_active, "
+        "(SELECT COUNT(*) FROM face_templates t WHERE t.person_id = p.id) "
+        "FROM persons p WHERE p.is_active = 1 ORDER BY p.name");
+    if (!query || !query->exec()) {
+        return records;
+    }
 
-    while (query.next()) {
+    while (query->next()) {
         FaceRecord record;
-        record.id = query.value(0).toInt();
-        record.name = query.value(1).toString();
-        record.imagePath = query.value(2).toString();
-        record.description = query.value(3).toString();
-        record.createTime = query.value(4).toDateTime();
-        record.lastSeen = query.value(5).toDateTime();
-        record.recognitionCount = query.value(6).toInt();
-        record.isActive = query.value(7).toBool();
+        record.id = query->value(0).toInt();
+        record.name = query->value(1).toString();
+        record.imagePath = query->value(2).toString();
+        record.description = query->value(3).toString();
+        record.createTime = query->value(4).toDateTime();
+        record.lastSeen = query->value(5).toDateTime();
+        record.recognitionCount = query->value(6).toInt();
+        record.isActive = query->value(7).toBool();
+        record.templateCount = query->value(8).toInt();
 
         records.append(record);
     }
+    query->finish();
 
     logDebug(QString("Retrieved %1 face records").arg(records.size()));
     return records;
@@ -262,209 +605,401 @@ QByteArray FaceDatabase::getFaceFeature(int id)
         return QByteArray();
     }
 
-    QSqlQuery query(m_database);
-    query.prepare("SELECT feature FROM face_records WHERE id = ? AND is_active = 1");
-    query.addBindValue(id);
+    // 多模板人员返回质量最高的模板
+    QSharedPointer<QSqlQuery> query = cachedQuery(
+        "SELECT t.feature FROM face_templates t JOIN persons p ON p.id = t.person_id "
+        "WHERE p.id = ? AND p.is_active = 1 ORDER BY t.quality DESC, t.id DESC LIMIT 1");
+    if (!query) {
+        return QByteArray();
+    }
 
-    if (query.exec() && query.next()) {
-        return query.value(0).toByteArray();
+    query->bindValue(0, id);
+
+    QByteArray feature;
+    if (query->exec() && query->next()) {
+        feature = query->value(0).toByteArray();
     }
+    query->finish();
 
-    return QByteArray();
+    return feature;
 }
 
 bool FaceDatabase::faceExists(const QString& name)
 {
-    qDebug() << "faceExists: Method entered, checking name:" << name;
     QMutexLocker locker(&m_mutex);
 
     if (!m_isConnected) {
-        qDebug() << "faceExists: Database not connected";
+        svWarningEvery(lcFaceDatabase, 5000) << "faceExists: Database not connected";
         return false;
     }
 
-    qDebug() << "faceExists: Creating query";
-    QSqlQuery query(m_database);
-
-    // 尝试最简单的查询，不使用参数绑定
-    qDebug() << "faceExists: Testing simple query without parameters";
-    if (!query.exec("SELECT COUNT(*) FROM face_records")) {
-        qDebug() << "faceExists: Simple count query failed";
-        qDebug() << "SQL Error:" << query.lastError().text();
-        qDebug() << "SQL Error Type:" << query.lastError().type();
+    QSharedPointer<QSqlQuery> query = cachedQuery("SELECT COUNT(*) FROM persons WHERE name = ?");
+    if (!query) {
         return false;
     }
-    qDebug() << "faceExists: Simple count query succeeded";
 
-    // 现在尝试带WHERE条件但不用参数绑定的查询
-    QString directSQL = QString("SELECT COUNT(*) FROM face_records WHERE name = '%1'").arg(name.trimmed());
-    qDebug() << "faceExists: Testing direct SQL:" << directSQL;
+    query->bindValue(0, name.trimmed());
 
-    QSqlQuery directQuery(m_database);
-    if (!directQuery.exec(directSQL)) {
-        qDebug() << "faceExists: Direct SQL query failed";
-        qDebug() << "SQL Error:" << directQuery.lastError().text();
-        qDebug() << "SQL Error Type:" << directQuery.lastError().type();
-        return false;
-    }
-    qDebug() << "faceExists: Direct SQL query succeeded";
-
-    if (directQuery.next()) {
-        int count = directQuery.value(0).toInt();
-        qDebug() << "faceExists: Found" << count << "matching records";
-        return count > 0;
+    bool exists = false;
+    if (query->exec() && query->next()) {
+        exists = query->value(0).toInt() > 0;
+    } else {
+        logError("faceExists: Query failed", query->lastError());
     }
+    query->finish();
 
-    qDebug() << "faceExists: No results from query";
-    return false;
+    return exists;
 }
 
 int FaceDatabase::getTotalFaceCount()
 {
-    qDebug() << "getTotalFaceCount: Checking connection status...";
-
     QMutexLocker locker(&m_mutex);
 
-    // 详细的状态检查
-    qDebug() << "getTotalFaceCount: Checking connection status...";
-
-    if (!m_isConnected) {
-        qDebug() << "getTotalFaceCount: Not connected";
-        return 0;
-    }
-    qDebug() << "getTotalFaceCount: Connection status OK";
-
-    if (!m_database.isOpen()) {
-        qDebug() << "getTotalFaceCount: Database is not open";
-        return 0;
-    }
-    qDebug() << "getTotalFaceCount: Database is open";
-
-    // 使用更安全的查询方式
-    qDebug() << "getTotalFaceCount: Creating query...";
-    QSqlQuery query(m_database);
-
-    qDebug() << "getTotalFaceCount: Preparing query...";
-    if (!query.prepare("SELECT COUNT(*) FROM face_records WHERE is_active = 1")) {
-        qDebug() << "getTotalFaceCount: Failed to prepare query:" << query.lastError().text();
+    if (!m_isConnected || !m_database.isOpen()) {
+        svWarningEvery(lcFaceDatabase, 5000) << "getTotalFaceCount: Not connected";
         return 0;
     }
 
-    qDebug() << "getTotalFaceCount: Executing query...";
-    if (!query.exec()) {
-        qDebug() << "getTotalFaceCount: Failed to execute query:" << query.lastError().text();
-        qDebug() << "getTotalFaceCount: Database error:" << m_database.lastError().text();
+    QSharedPointer<QSqlQuery> query = cachedQuery("SELECT COUNT(*) FROM persons WHERE is_active = 1");
+    if (!query) {
         return 0;
     }
 
-    qDebug() << "getTotalFaceCount: Query executed successfully";
-
-    if (query.next()) {
-        int count = query.value(0).toInt();
-        qDebug() << "getTotalFaceCount: Retrieved count:" << count;
-        return count;
+    int count = 0;
+    if (query->exec() && query->next()) {
+        count = query->value(0).toInt();
     } else {
-        qDebug() << "getTotalFaceCount: No result from query";
-        return 0;
+        logError("getTotalFaceCount: Query failed", query->lastError());
     }
+    query->finish();
+
+    return count;
 }
 
 void FaceDatabase::updateLastSeen(int id)
 {
     QMutexLocker locker(&m_mutex);
+    updateLastSeenLocked(id);
+}
 
+void FaceDatabase::updateLastSeenLocked(int id)
+{
     if (!m_isConnected) return;
 
-    QSqlQuery query(m_database);
-    query.prepare("UPDATE face_records SET last_seen = ? WHERE id = ?");
-    query.addBindValue(QDateTime::currentDateTime());
-    query.addBindValue(id);
+    QSharedPointer<QSqlQuery> query = cachedQuery("UPDATE persons SET last_seen = ? WHERE id = ?");
+    if (!query) return;
+
+    query->bindValue(0, QDateTime::currentDateTime());
+    query->bindValue(1, id);
 
-    if (!query.exec()) {
-        logError("Failed to update last_seen", query.lastError());
+    if (!query->exec()) {
+        logError("Failed to update last_seen", query->lastError());
     }
 }
 
 void FaceDatabase::incrementRecognitionCount(int id)
 {
     QMutexLocker locker(&m_mutex);
+    incrementRecognitionCountLocked(id);
+}
 
+void FaceDatabase::incrementRecognitionCountLocked(int id)
+{
     if (!m_isConnected) return;
 
-    QSqlQuery query(m_database);
-    query.prepare("UPDATE face_records SET recognition_count = recognition_count + 1 WHERE id = ?");
-    query.addBindValue(id);
+    QSharedPointer<QSqlQuery> query = cachedQuery("UPDATE persons SET recognition_count = recognition_count + 1 WHERE id = ?");
+    if (!query) return;
+
+    query->bindValue(0, id);
 
-    if (!query.exec()) {
-        logError("Failed to increment recognition count", query.lastError());
+    if (!query->exec()) {
+        logError("Failed to increment recognition count", query->lastError());
     }
 }
 
 // ========== 核心特征匹配功能 ==========
 int FaceDatabase::findBestMatch(const QByteArray& queryFeature,
                                 float& bestSimilarity,
-                                float minSimilarity)
+                                float minSimilarity,
+                                QString* personName)
 {
-    QMutexLocker locker(&m_mutex);
+    SV_TRACE_SCOPE("ai", "db_match");
+    bestSimilarity = 0.0f;
 
     // 1. 参数验证
     if (!m_isConnected || !isValidFeature(queryFeature)) {
-        bestSimilarity = 0.0f;
         return -1;
     }
 
-    bestSimilarity = 0.0f;
-    int bestMatchId = -1;
-    int comparedCount = 0;
+    // 2. 🔧 取当前发布的内存人脸库，只持有 m_galleryMutex；从不在匹配线程重建或访问数据库
+    QSharedPointer<const FaceGallery> gallery;
+    TemplateAggregation aggregation;
+    int topN;
+    {
+        QMutexLocker locker(&m_galleryMutex);
+        gallery = m_gallery;
+        aggregation = m_aggregation;
+        topN = m_templateTopN;
+    }
 
-    // 2. 获取所有激活的人脸特征进行比对
-    QSqlQuery query("SELECT id, name, feature FROM face_records WHERE is_active = 1", m_database);
+    if (!gallery || gallery->isEmpty()) {
+        return -1;
+    }
 
-    while (query.next()) {
-        int recordId = query.value(0).toInt();
-        QString recordName = query.value(1).toString();
-        QByteArray recordFeature = query.value(2).toByteArray();
+    // 3. 按人员聚合打分
+    const FaceGallery::Match match = gallery->bestMatch(
+        reinterpret_cast<const float*>(queryFeature.constData()), aggregation, topN);
+    bestSimilarity = match.score;
 
-        // 3. 验证记录中的特征数据
-        if (!isValidFeature(recordFeature)) {
-            qDebug() << "Invalid feature data for record ID:" << recordId;
-            continue;
+    // 🔧 每张人脸一次：分类关闭时参数不求值
+    svDebug(lcFaceDatabase) << "Feature matching completed:" << gallery->personCount() << "persons /"
+                            << gallery->templateCount() << "templates, best similarity =" << bestSimilarity
+                            << "threshold =" << minSimilarity;
+
+    // 4. 检查是否达到最小相似度阈值
+    if (match.personId <= 0 || bestSimilarity < minSimilarity) {
+        return -1;
+    }
+
+    // 5. 🔧 识别统计排队到所在线程批量写入（SQLite 连接不能跨线程使用）
+    recordRecognition(match.personId);
+
+    const QString name = gallery->personName(match.personIndex);
+    if (personName) {
+        *personName = name;
+    }
+
+    emit faceRecognized(name, match.personId, bestSimilarity);
+    return match.personId;
+}
+
+QSharedPointer<const FaceGallery> FaceDatabase::gallery() const
+{
+    QMutexLocker locker(&m_galleryMutex);
+    return m_gallery;
+}
+
+// 调用方持有 m_mutex（数据库所在线程）。新人脸库构建完成后才换入，匹配线程只会看到旧的或新的完整一份
+void FaceDatabase::refreshGalleryLocked()
+{
+    QDateTime startTime = QDateTime::currentDateTime();
+    QSharedPointer<const FaceGallery> gallery;
+
+    if (!m_isConnected || !m_storageOptions.enableGallerySnapshot) {
+        gallery = loadGalleryLocked();
+    } else {
+        const quint64 generation = galleryGenerationLocked();
+
+        // 1. 代数一致的快照直接映射，无需读取任何BLOB
+        gallery = GallerySnapshot::load(m_snapshotPath, generation);
+        if (gallery) {
+            logDebug(QString("Gallery mapped from snapshot in %1 ms (generation %2)")
+                         .arg(startTime.msecsTo(QDateTime::currentDateTime())).arg(generation));
+        } else {
+            // 2. 快照缺失/过期/损坏：以数据库为准重建，并原子回写快照
+            gallery = loadGalleryLocked();
+            GallerySnapshot::save(*gallery, m_snapshotPath, generation);
         }
+    }
+
+    QMutexLocker galleryLocker(&m_galleryMutex);
+    m_gallery = gallery;
+}
 
-        // 4. 计算相似度
-        float similarity = calculateFeatureSimilarity(queryFeature, recordFeature);
-        comparedCount++;
+void FaceDatabase::publishPersonLocked(int personId)
+{
+    QSharedPointer<QSqlQuery> query = cachedQuery(
+        "SELECT p.name, t.id, t.feature FROM face_templates t "
+        "JOIN persons p ON p.id = t.person_id WHERE p.id = ? AND p.is_active = 1 ORDER BY t.quality DESC");
+    QSharedPointer<const FaceGallery> updated;
+    if (query) {
+        query->bindValue(0, personId);
+    }
+
+    if (!query || !query->exec()) {
+        // 读不到该人员的模板时退回整体加载
+        updated = loadGalleryLocked();
+    } else {
+        // 其余人员的特征原样拷贝（已归一化），该人员按数据库当前的模板（含淘汰结果）重新加入
+        QSharedPointer<FaceGallery> gallery(new FaceGallery());
+        const QSharedPointer<const FaceGallery> current = this->gallery();
+        if (current) {
+            gallery->appendFrom(*current, personId);
+        }
 
-        // 5. 更新最佳匹配
-        if (similarity > bestSimilarity) {
-            bestSimilarity = similarity;
-            bestMatchId = recordId;
+        bool begun = false;
+        while (query->next()) {
+            if (!begun) {
+                gallery->beginPerson(personId, query->value(0).toString());
+                begun = true;
+            }
+            const QByteArray feature = query->value(2).toByteArray();
+            if (isValidFeature(feature)) {
+                gallery->addTemplate(query->value(1).toInt(), reinterpret_cast<const float*>(feature.constData()));
+            }
         }
+        query->finish();
+        updated = gallery;
+    }
 
-        logDebug(QString("Compared with %1 (ID:%2): similarity=%3")
-                     .arg(recordName).arg(recordId).arg(similarity, 0, 'f', 3));
+    {
+        QMutexLocker galleryLocker(&m_galleryMutex);
+        m_gallery = updated;
     }
+    scheduleSnapshotLocked();
+}
 
-    logDebug(QString("Feature matching completed: compared %1 faces, best similarity=%2, threshold=%3")
-                 .arg(comparedCount).arg(bestSimilarity, 0, 'f', 3).arg(minSimilarity, 0, 'f', 3));
+void FaceDatabase::scheduleSnapshotLocked()
+{
+    if (!m_storageOptions.enableGallerySnapshot) {
+        return;
+    }
 
-    // 6. 检查是否达到最小相似度阈值
-    if (bestSimilarity < minSimilarity) {
-        logDebug("Best similarity below threshold, treating as unknown face");
-        bestMatchId = -1;
-    } else if (bestMatchId > 0) {
-        // 7. 更新识别统计信息
-        updateLastSeen(bestMatchId);
-        incrementRecognitionCount(bestMatchId);
+    // 连续注册时重新计时，停止注册后只写一次
+    m_snapshotDirty = true;
+    m_snapshotTimer->start();
+}
 
-        // 获取匹配的人员姓名
-        FaceRecord record = getFaceRecord(bestMatchId);
-        if (record.id > 0) {
-            emit faceRecognized(record.name, bestMatchId, bestSimilarity);
+void FaceDatabase::saveGallerySnapshot()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_snapshotDirty || !m_isConnected) {
+        return;
+    }
+    m_snapshotDirty = false;
+
+    // 持有 m_mutex 时代数与发布的人脸库一致
+    const QSharedPointer<const FaceGallery> current = gallery();
+    if (current) {
+        GallerySnapshot::save(*current, m_snapshotPath, galleryGenerationLocked());
+    }
+}
+
+quint64 FaceDatabase::galleryGenerationLocked()
+{
+    QSharedPointer<QSqlQuery> query = cachedQuery("SELECT value FROM gallery_meta WHERE key = 'generation'");
+    if (!query) {
+        return 0;
+    }
+
+    quint64 generation = 0;
+    if (query->exec() && query->next()) {
+        generation = query->value(0).toULongLong();
+    }
+    query->finish();
+
+    return generation;
+}
+
+bool FaceDatabase::bumpGalleryGenerationLocked()
+{
+    QSharedPointer<QSqlQuery> query = cachedQuery(
+        "UPDATE gallery_meta SET value = value + 1 WHERE key = 'generation'");
+    if (!query) {
+        return false;
+    }
+
+    if (!query->exec()) {
+        logError("Failed to bump gallery generation", query->lastError());
+        return false;
+    }
+    return true;
+}
+
+QSharedPointer<const FaceGallery> FaceDatabase::loadGalleryLocked()
+{
+    QSharedPointer<FaceGallery> gallery(new FaceGallery());
+
+    if (!m_isConnected) {
+        return gallery;
+    }
+
+    // 按人员排序，保证同一人的模板连续
+    QSharedPointer<QSqlQuery> query = cachedQuery(
+        "SELECT p.id, p.name, t.id, t.feature FROM face_templates t "
+        "JOIN persons p ON p.id = t.person_id WHERE p.is_active = 1 ORDER BY p.id, t.quality DESC");
+    if (!query || !query->exec()) {
+        return gallery;
+    }
+
+    int currentPerson = -1;
+    int skipped = 0;
+    while (query->next()) {
+        int personId = query->value(0).toInt();
+        if (personId != currentPerson) {
+            gallery->beginPerson(personId, query->value(1).toString());
+            currentPerson = personId;
         }
+
+        QByteArray feature = query->value(3).toByteArray();
+        if (!isValidFeature(feature) ||
+            !gallery->addTemplate(query->value(2).toInt(), reinterpret_cast<const float*>(feature.constData()))) {
+            skipped++;
+        }
+    }
+    query->finish();
+
+    logDebug(QString("Gallery loaded: %1 persons, %2 templates, %3 invalid skipped")
+                 .arg(gallery->personCount()).arg(gallery->templateCount()).arg(skipped));
+
+    return gallery;
+}
+
+// 任意线程：累积到待写入统计，首条时排队一次 flushRecognitionStats
+void FaceDatabase::recordRecognition(int personId)
+{
+    bool schedule = false;
+    {
+        QMutexLocker locker(&m_galleryMutex);
+        RecognitionStats& stats = m_pendingStats[personId];
+        stats.count++;
+        stats.lastSeen = QDateTime::currentDateTime();
+        schedule = !m_statsFlushQueued;
+        m_statsFlushQueued = true;
+    }
+
+    if (schedule) {
+        QMetaObject::invokeMethod(this, "flushRecognitionStats", Qt::QueuedConnection);
+    }
+}
+
+void FaceDatabase::flushRecognitionStats()
+{
+    QHash<int, RecognitionStats> pending;
+    {
+        QMutexLocker locker(&m_galleryMutex);
+        pending.swap(m_pendingStats);
+        m_statsFlushQueued = false;
     }
 
-    return bestMatchId;
+    if (pending.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_isConnected) {
+        return;
+    }
+
+    QSharedPointer<QSqlQuery> query = cachedQuery(
+        "UPDATE persons SET last_seen = ?, recognition_count = recognition_count + ? WHERE id = ?");
+    if (!query) {
+        return;
+    }
+
+    const bool inTransaction = m_database.transaction();
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        query->bindValue(0, it.value().lastSeen);
+        query->bindValue(1, it.value().count);
+        query->bindValue(2, it.key());
+        if (!query->exec()) {
+            logError("Failed to update recognition stats", query->lastError());
+        }
+    }
+    if (inTransaction && !m_database.commit()) {
+        logError("Failed to commit recognition stats", m_database.lastError());
+        m_database.rollback();
+    }
 }
 
 // ========== 特征相似度计算 ==========
@@ -532,26 +1067,39 @@ bool FaceDatabase::isValidFeature(const QByteArray& feature)
 FaceRecord FaceDatabase::getFaceRecord(int id)
 {
     QMutexLocker locker(&m_mutex);
+    return getFaceRecordLocked(id);
+}
+
+FaceRecord FaceDatabase::getFaceRecordLocked(int id)
+{
     FaceRecord record;
 
     if (!m_isConnected) {
         return record;
     }
 
-    QSqlQuery query(m_database);
-    query.prepare("SELECT id, name, image_path, description, create_time, last_seen, recognition_count, is_active FROM face_records WHERE id = ?");
-    query.addBindValue(id);
+    QSharedPointer<QSqlQuery> query = cachedQuery(
+        "SELECT p.id, p.name, p.image_path, p.description, p.create_time, p.last_seen, p.recognition_count, p.is_active, "
+        "(SELECT COUNT(*) FROM face_templates t WHERE t.person_id = p.id) "
+        "FROM persons p WHERE p.id = ?");
+    if (!query) {
+        return record;
+    }
 
-    if (query.exec() && query.next()) {
-        record.id = query.value(0).toInt();
-        record.name = query.value(1).toString();
-        record.imagePath = query.value(2).toString();
-        record.description = query.value(3).toString();
-        record.createTime = query.value(4).toDateTime();
-        record.lastSeen = query.value(5).toDateTime();
-        record.recognitionCount = query.value(6).toInt();
-        record.isActive = query.value(7).toBool();
+    query->bindValue(0, id);
+
+    if (query->exec() && query->next()) {
+        record.id = query->value(0).toInt();
+        record.name = query->value(1).toString();
+        record.imagePath = query->value(2).toString();
+        record.description = query->value(3).toString();
+        record.createTime = query->value(4).toDateTime();
+        record.lastSeen = query->value(5).toDateTime();
+        record.recognitionCount = query->value(6).toInt();
+        record.isActive = query->value(7).toBool();
+        record.templateCount = query->value(8).toInt();
     }
+    query->finish();
 
     return record;
 }
@@ -570,11 +1118,11 @@ QString FaceDatabase::generateConnectionName()
 void FaceDatabase::logError(const QString& operation, const QSqlError& error)
 {
     QString errorMsg = QString("%1: %2").arg(operation, error.text());
-    qDebug() << "FaceDatabase Error:" << errorMsg;
+    svWarningEvery(lcFaceDatabase, 1000) << "FaceDatabase Error:" << errorMsg;
     emit databaseError(errorMsg);
 }
 
 void FaceDatabase::logDebug(const QString& message)
 {
-    qDebug() << "FaceDatabase:" << message;
+    svDebug(lcFaceDatabase) << message;
 }
@@ -10,25 +10,64 @@
 #include <QSqlError>      // 新增：用于错误处理
 #include <QSqlDatabase>   // 新增：数据库操作
 #include <QDateTime>
+#include <QHash>
+#include <QSharedPointer>
 #include "aitypes.h"
+#include "facegallery.h"
 
+class QTimer;
+
+// 🔧 线程约定：SQLite 连接只在 FaceDatabase 所在线程（创建它的线程）使用，注册、查询、统计写入都在该线程调用；
+// findBestMatch / gallery 可在任意线程调用，只读内存人脸库，识别统计排队回所在线程批量写入
 class FaceDatabase : public QObject
 {
     Q_OBJECT
 
 public:
+    // 🆕 SQLite 存储调优参数（需在 initialize() 之前设置）
+    struct StorageOptions {
+        bool enableWAL = true;                   // WAL日志模式，读写互不阻塞
+        QString synchronous = "NORMAL";          // WAL下NORMAL即可保证一致性
+        int cacheSizeKiB = 4096;                 // 页缓存大小(KiB)
+        qint64 mmapSizeBytes = 32 * 1024 * 1024; // 内存映射读取上限
+        bool cacheStatements = true;             // 复用已prepare的语句
+        bool enableGallerySnapshot = true;       // 人脸库二进制快照，启动时直接mmap
+
+        // 旧版行为：默认pragma、每次调用重新prepare（用于基准对比）
+        static StorageOptions legacy() {
+            StorageOptions options;
+            options.enableWAL = false;
+            options.synchronous = "FULL";
+            options.cacheSizeKiB = 0;
+            options.mmapSizeBytes = 0;
+            options.cacheStatements = false;
+            options.enableGallerySnapshot = false;
+            return options;
+        }
+    };
+
     explicit FaceDatabase(QObject *parent = nullptr);
     ~FaceDatabase();
 
     // 数据库初始化和管理
+    void setStorageOptions(const StorageOptions& options) { m_storageOptions = options; }
+    StorageOptions storageOptions() const { return m_storageOptions; }
     bool initialize(const QString& dbPath = QString());
     bool isConnected() const;
 
     // 人脸记录管理
+    // 🔧 同名人员已存在时追加一个模板，超过上限后按质量淘汰
     bool addFaceRecord(const QString& name,
                        const QString& imagePath,
                        const QByteArray& feature,
-                       const QString& description = QString());
+                       const QString& description = QString(),
+                       float quality = 1.0f);
+
+    // 🆕 批量注册：整批在一个事务中写入，任一条失败则整体回滚
+    int addFaceRecords(const QVector<FaceEnrollment>& batch);
+
+    // 🆕 多模板匹配策略
+    void setMatchPolicy(TemplateAggregation aggregation, int topN, int maxTemplatesPerPerson);
 
     QVector<FaceRecord> getAllFaceRecords();
     FaceRecord getFaceRecord(int id);
@@ -38,15 +77,32 @@ public:
     bool faceExists(const QString& name);
     int getTotalFaceCount();
 
-    // 人脸识别核心功能
+    // 人脸识别核心功能（返回人员ID，按人员聚合模板分数）
     int findBestMatch(const QByteArray& queryFeature,
                       float& bestSimilarity,
-                      float minSimilarity = 0.7f);
+                      float minSimilarity = 0.7f,
+                      QString* personName = nullptr);   // 🆕 命中时从人脸库快照取人名，免去回查
+
+    // 🔧 当前发布的只读内存人脸库：在注册线程构建新的一份后整体换入，匹配线程从不重建，构建期间继续使用上一份
+    // - initialize：优先映射磁盘快照（代数一致时），否则从数据库加载并回写快照
+    // - 单条注册：复制当前人脸库并只从数据库读取该人员的模板（增量，不随人脸库规模整体重读）
+    // - 批量注册：整批提交后从数据库重新加载一次
+    // 注册后的快照回写推迟到停止注册 kSnapshotDelayMs 之后（或析构时），连续注册只写一次
+    QSharedPointer<const FaceGallery> gallery() const;
+    QString gallerySnapshotPath() const { return m_snapshotPath; }
 
     // 统计更新
     void updateLastSeen(int id);
     void incrementRecognitionCount(int id);
 
+public slots:
+    // 🆕 把 findBestMatch 累积的识别统计（最后识别时间、识别次数）在一个事务中写入；
+    // 由匹配线程排队到所在线程的事件循环调用，也可在所在线程直接调用
+    void flushRecognitionStats();
+
+    // 🆕 把当前人脸库写成磁盘快照（有未写入的注册时）；注册后由定时器触发，析构时也会调用
+    void saveGallerySnapshot();
+
     // 特征相似度计算 - 设为public以便测试
     static float calculateFeatureSimilarity(const QByteArray& feature1, const QByteArray& feature2);
     static bool isValidFeature(const QByteArray& feature);
@@ -63,8 +119,30 @@ private:
     // 数据库管理
     bool createTables();
     bool createIndexes();
+    bool migrateLegacyRecords();
+    bool applyStoragePragmas();
     QString generateConnectionName();
 
+    // 🆕 预编译语句缓存（调用方需持有 m_mutex）
+    QSharedPointer<QSqlQuery> cachedQuery(const QString& sql);
+    void clearStatementCache();
+
+    // 🆕 已持锁版本，供内部复合操作调用，避免重复加锁
+    int insertFaceRecordLocked(const FaceEnrollment& enrollment);
+    int findPersonIdLocked(const QString& name);
+    int insertTemplateLocked(int personId, const FaceEnrollment& enrollment);
+    void pruneTemplatesLocked(int personId);
+    void refreshGalleryLocked();
+    void publishPersonLocked(int personId);
+    void scheduleSnapshotLocked();
+    QSharedPointer<const FaceGallery> loadGalleryLocked();
+    void recordRecognition(int personId);
+    quint64 galleryGenerationLocked();
+    bool bumpGalleryGenerationLocked();
+    FaceRecord getFaceRecordLocked(int id);
+    void updateLastSeenLocked(int id);
+    void incrementRecognitionCountLocked(int id);
+
     // 日志功能
     void logError(const QString& operation, const QSqlError& error);
     void logDebug(const QString& message);
@@ -72,8 +150,32 @@ private:
     // 成员变量
     QSqlDatabase m_database;        // 数据库连接
     QString m_databasePath;         // 数据库文件路径
+    QString m_snapshotPath;         // 人脸库快照路径（与数据库同目录）
     bool m_isConnected;             // 连接状态
     mutable QMutex m_mutex;         // 线程安全锁
+    StorageOptions m_storageOptions;            // 存储调优参数
+    QHash<QString, QSharedPointer<QSqlQuery>> m_statementCache; // SQL -> 已prepare的语句
+
+    // 🆕 多模板人脸库；匹配只用 m_galleryMutex（短暂持有），不等待数据库锁 m_mutex
+    // 锁顺序：m_mutex -> m_galleryMutex
+    mutable QMutex m_galleryMutex;
+    QSharedPointer<const FaceGallery> m_gallery;   // 当前发布的内存人脸库
+    TemplateAggregation m_aggregation = TemplateAggregation::Max;
+    int m_templateTopN = 3;
+    int m_maxTemplatesPerPerson = 5;               // 受 m_mutex 保护
+
+    // 🆕 注册后推迟的快照回写（受 m_mutex 保护）
+    static const int kSnapshotDelayMs = 5000;
+    QTimer* m_snapshotTimer;
+    bool m_snapshotDirty = false;
+
+    // 🆕 待写入的识别统计（受 m_galleryMutex 保护）
+    struct RecognitionStats {
+        int count = 0;
+        QDateTime lastSeen;
+    };
+    QHash<int, RecognitionStats> m_pendingStats;
+    bool m_statsFlushQueued = false;
 
     friend class AIDetectionThread;
 };
@@ -0,0 +1,242 @@
+// ai/facegallery.cpp
+#include "facegallery.h"
+#include <QFile>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+// MeanTopN 的上限，保证打分过程只用栈上数组
+const int kMaxTopN = 8;
+
+inline float dotProduct(const float* a, const float* b, int dim)
+{
+    // 4路展开，便于编译器自动向量化（NEON / SSE）
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    int i = 0;
+    for (; i + 4 <= dim; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < dim; ++i) {
+        s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+} // namespace
+
+FaceGallery::FaceGallery() = default;
+
+// QFile 在头文件中仅前置声明，析构需在此处定义
+FaceGallery::~FaceGallery() = default;
+
+void FaceGallery::reserve(int personCount, int templateCount)
+{
+    m_persons.reserve(personCount);
+    m_templateIds.reserve(templateCount);
+    m_features.reserve(templateCount * kFeatureDim);
+}
+
+void FaceGallery::beginPerson(int personId, const QString& name)
+{
+    if (isMapped()) {
+        return;
+    }
+
+    const QByteArray utf8 = name.toUtf8();
+
+    PersonRecord record;
+    record.personId = personId;
+    record.nameOffset = m_stringPool.size();
+    record.nameLength = utf8.size();
+    record.firstTemplate = m_templateIds.size();
+    record.templateCount = 0;
+
+    m_stringPool.append(utf8);
+    m_persons.append(record);
+    m_personCount = m_persons.size();
+}
+
+bool FaceGallery::addTemplate(int templateId, const float* feature)
+{
+    if (isMapped() || m_persons.isEmpty() || !feature) {
+        return false;
+    }
+
+    const int offset = m_features.size();
+    m_features.resize(offset + kFeatureDim);
+    if (normalize(feature, m_features.data() + offset) == 0.0f) {
+        // 零向量无法参与余弦比对
+        m_features.resize(offset);
+        return false;
+    }
+
+    m_templateIds.append(templateId);
+    m_persons.last().templateCount++;
+    m_templateCount = m_templateIds.size();
+    return true;
+}
+
+void FaceGallery::appendFrom(const FaceGallery& source, int skipPersonId)
+{
+    if (isMapped()) {
+        return;
+    }
+
+    reserve(m_personCount + source.personCount(), m_templateCount + source.templateCount());
+
+    const PersonRecord* persons = source.personRecords();
+    const float* features = source.featureData();
+    const qint32* templateIds = source.templateIds();
+    for (int p = 0; p < source.personCount(); ++p) {
+        const PersonRecord& person = persons[p];
+        if (person.personId == skipPersonId) {
+            continue;
+        }
+
+        beginPerson(person.personId, source.personName(p));
+        const int offset = m_features.size();
+        const int count = int(person.templateCount);
+        m_features.resize(offset + count * kFeatureDim);
+        std::copy(features + size_t(person.firstTemplate) * kFeatureDim,
+                  features + size_t(person.firstTemplate + person.templateCount) * kFeatureDim,
+                  m_features.data() + offset);
+        for (int t = 0; t < count; ++t) {
+            m_templateIds.append(templateIds[person.firstTemplate + t]);
+        }
+        m_persons.last().templateCount = person.templateCount;
+    }
+    m_templateCount = m_templateIds.size();
+}
+
+QString FaceGallery::personName(int personIndex) const
+{
+    const PersonRecord& record = personRecords()[personIndex];
+    return QString::fromUtf8(stringPool() + record.nameOffset, record.nameLength);
+}
+
+int FaceGallery::personIndexOf(int personId) const
+{
+    const PersonRecord* persons = personRecords();
+    for (int i = 0; i < m_personCount; ++i) {
+        if (persons[i].personId == personId) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const float* FaceGallery::featureData() const
+{
+    return isMapped() ? m_mappedFeatures : m_features.constData();
+}
+
+const qint32* FaceGallery::templateIds() const
+{
+    return isMapped() ? m_mappedTemplateIds : m_templateIds.constData();
+}
+
+const FaceGallery::PersonRecord* FaceGallery::personRecords() const
+{
+    return isMapped() ? m_mappedPersons : m_persons.constData();
+}
+
+const char* FaceGallery::stringPool() const
+{
+    return isMapped() ? m_mappedStringPool : m_stringPool.constData();
+}
+
+int FaceGallery::stringPoolSize() const
+{
+    return isMapped() ? m_mappedStringPoolSize : m_stringPool.size();
+}
+
+float FaceGallery::normalize(const float* in, float* out, int dim)
+{
+    float norm = std::sqrt(dotProduct(in, in, dim));
+    if (norm == 0.0f || !std::isfinite(norm)) {
+        return 0.0f;
+    }
+
+    const float inv = 1.0f / norm;
+    for (int i = 0; i < dim; ++i) {
+        out[i] = in[i] * inv;
+    }
+    return norm;
+}
+
+float FaceGallery::scorePerson(const PersonRecord& person, const float* query,
+                               TemplateAggregation aggregation, int topN, float* bestTemplate) const
+{
+    const float* base = featureData() + size_t(person.firstTemplate) * kFeatureDim;
+
+    float best = 0.0f;
+    float top[kMaxTopN];
+    int topCount = 0;
+    const int n = qBound(1, topN, kMaxTopN);
+
+    for (quint32 t = 0; t < person.templateCount; ++t) {
+        // 余弦相似度映射到[0,1]，与 FaceDatabase::calculateFeatureSimilarity 一致
+        float similarity = std::max(0.0f, dotProduct(query, base + t * kFeatureDim, kFeatureDim));
+        best = std::max(best, similarity);
+
+        if (aggregation == TemplateAggregation::MeanTopN) {
+            // 维护降序的前N个分数（N很小，插入排序即可）
+            if (topCount < n) {
+                top[topCount++] = similarity;
+            } else if (similarity > top[topCount - 1]) {
+                top[topCount - 1] = similarity;
+            } else {
+                continue;
+            }
+            for (int k = topCount - 1; k > 0 && top[k] > top[k - 1]; --k) {
+                std::swap(top[k], top[k - 1]);
+            }
+        }
+    }
+
+    *bestTemplate = best;
+
+    if (aggregation == TemplateAggregation::MeanTopN && topCount > 0) {
+        float sum = 0.0f;
+        for (int k = 0; k < topCount; ++k) {
+            sum += top[k];
+        }
+        return sum / topCount;
+    }
+    return best;
+}
+
+FaceGallery::Match FaceGallery::bestMatch(const float* queryFeature,
+                                          TemplateAggregation aggregation, int topN) const
+{
+    Match match;
+    if (!queryFeature || isEmpty()) {
+        return match;
+    }
+
+    float query[kFeatureDim];
+    if (normalize(queryFeature, query) == 0.0f) {
+        return match;
+    }
+
+    const PersonRecord* persons = personRecords();
+    for (int p = 0; p < m_personCount; ++p) {
+        const PersonRecord& person = persons[p];
+        if (person.templateCount == 0) {
+            continue;
+        }
+
+        float bestTemplate = 0.0f;
+        float score = scorePerson(person, query, aggregation, topN, &bestTemplate);
+        if (score > match.score) {
+            match.personId = person.personId;
+            match.personIndex = p;
+            match.score = score;
+            match.bestTemplateScore = bestTemplate;
+        }
+    }
+
+    return match;
+}
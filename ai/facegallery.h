@@ -0,0 +1,99 @@
+// ai/facegallery.h
+#ifndef FACEGALLERY_H
+#define FACEGALLERY_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QtGlobal>
+#include <memory>
+#include "aitypes.h"
+
+class QFile;
+
+// 🆕 内存人脸库：按人员分组的模板特征矩阵
+// 特征在加入时做L2归一化，比对时点积即余弦相似度；
+// 同一人员的模板在矩阵中连续存放，元数据每人只保存一份。
+// 构建完成后只读，可被多个识别线程共享。
+// 数据既可由本进程构建（QVector持有），也可直接映射自二进制快照文件（见 GallerySnapshot）。
+class FaceGallery
+{
+public:
+    static const int kFeatureDim = 512;
+
+    // 人员表条目，与快照文件中的布局一致（POD）
+    struct PersonRecord {
+        qint32 personId;         // 数据库中的人员ID
+        quint32 nameOffset;      // 姓名在字符串池中的偏移（UTF-8）
+        quint32 nameLength;      // 姓名字节数
+        quint32 firstTemplate;   // 第一个模板在特征矩阵中的行号
+        quint32 templateCount;   // 模板数量
+    };
+
+    struct Match {
+        int personId = -1;       // 数据库中的人员ID
+        int personIndex = -1;    // 在本库中的下标
+        float score = 0.0f;      // 聚合后的相似度
+        float bestTemplateScore = 0.0f;  // 单模板最高相似度
+    };
+
+    FaceGallery();
+    ~FaceGallery();
+
+    // 构建接口：模板必须按人员连续加入（先 beginPerson 再 addTemplate）
+    void reserve(int personCount, int templateCount);
+    void beginPerson(int personId, const QString& name);
+    bool addTemplate(int templateId, const float* feature);
+    // 🆕 增量更新用：复制 source 中除 skipPersonId 以外的全部人员（特征已归一化，直接拷贝）
+    void appendFrom(const FaceGallery& source, int skipPersonId = -1);
+
+    int personCount() const { return m_personCount; }
+    int templateCount() const { return m_templateCount; }
+    bool isEmpty() const { return m_templateCount == 0; }
+    bool isMapped() const { return m_mappedFile != nullptr; }
+
+    int personId(int personIndex) const { return personRecords()[personIndex].personId; }
+    QString personName(int personIndex) const;
+    int personIndexOf(int personId) const;
+
+    // 原始数据视图（构建模式指向QVector，映射模式指向文件页）
+    const float* featureData() const;
+    const qint32* templateIds() const;
+    const PersonRecord* personRecords() const;
+    const char* stringPool() const;
+    int stringPoolSize() const;
+
+    // 按人员聚合打分：Max取单模板最高分，MeanTopN取前N个模板的均值
+    Match bestMatch(const float* queryFeature,
+                    TemplateAggregation aggregation = TemplateAggregation::Max,
+                    int topN = 3) const;
+
+    // 工具函数：L2归一化，返回原模长
+    static float normalize(const float* in, float* out, int dim = kFeatureDim);
+
+private:
+    Q_DISABLE_COPY(FaceGallery)
+    friend class GallerySnapshot;
+
+    // 构建模式的数据
+    QVector<PersonRecord> m_persons;
+    QVector<float> m_features;      // templateCount × kFeatureDim，已归一化
+    QVector<qint32> m_templateIds;  // 模板在数据库中的ID
+    QByteArray m_stringPool;
+
+    // 映射模式的数据（指向只读映射页，文件关闭前有效）
+    std::unique_ptr<QFile> m_mappedFile;
+    const float* m_mappedFeatures = nullptr;
+    const qint32* m_mappedTemplateIds = nullptr;
+    const PersonRecord* m_mappedPersons = nullptr;
+    const char* m_mappedStringPool = nullptr;
+    int m_mappedStringPoolSize = 0;
+
+    int m_personCount = 0;
+    int m_templateCount = 0;
+
+    float scorePerson(const PersonRecord& person, const float* query,
+                      TemplateAggregation aggregation, int topN, float* bestTemplate) const;
+};
+
+#endif // FACEGALLERY_H
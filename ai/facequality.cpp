@@ -0,0 +1,183 @@
+// ai/facequality.cpp
+#include "facequality.h"
+#include <QtMath>
+#include <cmath>
+
+void FaceQualityStats::add(const FaceQualityStats& other)
+{
+    evaluated += other.evaluated;
+    passed += other.passed;
+    skippedTooSmall += other.skippedTooSmall;
+    skippedBrightness += other.skippedBrightness;
+    skippedBlurry += other.skippedBlurry;
+    skippedPose += other.skippedPose;
+    reusedFromTrack += other.reusedFromTrack;
+}
+
+QString FaceQualityStats::summary() const
+{
+    return QString("Quality gate: %1 evaluated, %2 passed, skipped size/brightness/blur/pose %3/%4/%5/%6, %7 reused")
+        .arg(evaluated).arg(passed)
+        .arg(skippedTooSmall).arg(skippedBrightness).arg(skippedBlurry).arg(skippedPose)
+        .arg(reusedFromTrack);
+}
+
+// ========== FaceQualityScorer ==========
+FaceQualityScore FaceQualityScorer::evaluate(const QImage& frame, const QRect& box) const
+{
+    FaceQualityScore score;
+
+    const QRect region = box.intersected(QRect(0, 0, frame.width(), frame.height()));
+    score.faceSize = qMin(region.width(), region.height());
+
+    // 1. 尺寸
+    if (score.faceSize < m_config.minFaceSize || region.isEmpty()) {
+        score.verdict = FaceQualityScore::TooSmall;
+        return score;
+    }
+
+    // 2. 最近邻采样缩小灰度图（16.16定点）
+    uchar probe[kProbeSize * kProbeSize];
+    const int stepX = (region.width() << 16) / kProbeSize;
+    const int stepY = (region.height() << 16) / kProbeSize;
+    quint32 sum = 0;
+    for (int y = 0; y < kProbeSize; ++y) {
+        const uchar* line = frame.constScanLine(region.top() + ((y * stepY) >> 16)) + region.left() * 3;
+        for (int x = 0; x < kProbeSize; ++x) {
+            const uchar* pixel = line + ((x * stepX) >> 16) * 3;
+            // 整数近似 0.299R + 0.587G + 0.114B
+            const uchar value = uchar((pixel[0] * 77 + pixel[1] * 150 + pixel[2] * 29) >> 8);
+            probe[y * kProbeSize + x] = value;
+            sum += value;
+        }
+    }
+
+    // 3. 亮度
+    score.brightness = float(sum) / (kProbeSize * kProbeSize);
+    if (score.brightness < m_config.minBrightness || score.brightness > m_config.maxBrightness) {
+        score.verdict = FaceQualityScore::BadBrightness;
+        return score;
+    }
+
+    // 4. 清晰度：4邻域拉普拉斯响应的方差
+    double lapSum = 0.0;
+    double lapSquares = 0.0;
+    const int inner = (kProbeSize - 2) * (kProbeSize - 2);
+    for (int y = 1; y < kProbeSize - 1; ++y) {
+        const uchar* row = probe + y * kProbeSize;
+        for (int x = 1; x < kProbeSize - 1; ++x) {
+            const int lap = row[x - 1] + row[x + 1] + row[x - kProbeSize] + row[x + kProbeSize] - 4 * row[x];
+            lapSum += lap;
+            lapSquares += double(lap) * lap;
+        }
+    }
+    const double lapMean = lapSum / inner;
+    score.sharpness = float(lapSquares / inner - lapMean * lapMean);
+    if (score.sharpness < m_config.minSharpness) {
+        score.verdict = FaceQualityScore::Blurry;
+    }
+
+    return score;
+}
+
+void FaceQualityScorer::checkPose(FaceQualityScore& score, const QPointF* landmarks) const
+{
+    if (!score.passed() || !landmarks || m_config.maxYaw <= 0.0f) {
+        return;
+    }
+
+    score.yaw = estimateYaw(landmarks);
+    if (std::fabs(score.yaw) > m_config.maxYaw) {
+        score.verdict = FaceQualityScore::BadPose;
+    }
+}
+
+float FaceQualityScorer::estimateYaw(const QPointF* landmarks)
+{
+    // 正脸时鼻尖位于双眼中点正下方；侧脸时鼻尖向一侧偏移、眼距缩短
+    const QPointF& leftEye = landmarks[0];
+    const QPointF& rightEye = landmarks[1];
+    const QPointF& nose = landmarks[2];
+
+    const qreal eyeDistance = std::hypot(rightEye.x() - leftEye.x(), rightEye.y() - leftEye.y());
+    if (eyeDistance < 1.0) {
+        return 1.0f;  // 眼睛重合：完全侧脸
+    }
+
+    const qreal eyeCenterX = (leftEye.x() + rightEye.x()) * 0.5;
+    return float((nose.x() - eyeCenterX) / eyeDistance);
+}
+
+// ========== FaceTrackCache ==========
+FaceTrackCache::FaceTrackCache()
+{
+    m_clock.start();
+}
+
+float FaceTrackCache::iou(const QRect& a, const QRect& b)
+{
+    const QRect inter = a.intersected(b);
+    if (inter.isEmpty()) {
+        return 0.0f;
+    }
+    const float interArea = float(inter.width()) * inter.height();
+    const float unionArea = float(a.width()) * a.height() + float(b.width()) * b.height() - interArea;
+    return unionArea > 0.0f ? interArea / unionArea : 0.0f;
+}
+
+void FaceTrackCache::update(int sourceId, const FaceInfo& face)
+{
+    const qint64 now = m_clock.elapsed();
+
+    // 同一位置的旧轨迹直接更新
+    for (Track& track : m_tracks) {
+        if (track.sourceId == sourceId && iou(track.face.bbox, face.bbox) >= kMinIoU) {
+            track.face = face;
+            track.updatedMs = now;
+            return;
+        }
+    }
+
+    if (m_tracks.size() >= kMaxTracks) {
+        // 淘汰最久未更新的轨迹
+        int oldest = 0;
+        for (int i = 1; i < m_tracks.size(); ++i) {
+            if (m_tracks[i].updatedMs < m_tracks[oldest].updatedMs) {
+                oldest = i;
+            }
+        }
+        m_tracks.removeAt(oldest);
+    }
+
+    Track track;
+    track.sourceId = sourceId;
+    track.face = face;
+    track.updatedMs = now;
+    m_tracks.append(track);
+}
+
+bool FaceTrackCache::lookup(int sourceId, const QRect& bbox, int maxAgeMs, FaceInfo& face) const
+{
+    const qint64 now = m_clock.elapsed();
+    float bestIoU = kMinIoU;
+    const Track* best = nullptr;
+
+    for (const Track& track : m_tracks) {
+        if (track.sourceId != sourceId || now - track.updatedMs > maxAgeMs) {
+            continue;
+        }
+        const float overlap = iou(track.face.bbox, bbox);
+        if (overlap >= bestIoU) {
+            bestIoU = overlap;
+            best = &track;
+        }
+    }
+
+    if (!best) {
+        return false;
+    }
+
+    face = best->face;
+    face.bbox = bbox;
+    return true;
+}
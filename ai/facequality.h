@@ -0,0 +1,108 @@
+// ai/facequality.h
+#ifndef FACEQUALITY_H
+#define FACEQUALITY_H
+
+#include <QImage>
+#include <QRect>
+#include <QPointF>
+#include <QVector>
+#include <QElapsedTimer>
+#include "aitypes.h"
+
+// 🆕 特征提取前的人脸质量门限（阈值来自 AIConfig）
+struct FaceQualityConfig {
+    bool enabled = true;
+    int minFaceSize = 40;               // 人脸框短边最小像素（处理帧坐标）
+    float minSharpness = 60.0f;         // 拉普拉斯方差下限
+    float maxYaw = 0.6f;                // 鼻尖偏离双眼中点 / 眼距 的上限，<=0 表示不评估姿态
+    float minBrightness = 40.0f;        // 平均亮度范围
+    float maxBrightness = 220.0f;
+    int trackReuseMs = 1500;            // 低质量人脸沿用同轨迹识别结果的有效期
+};
+
+struct FaceQualityScore {
+    enum Verdict {
+        Passed,
+        TooSmall,
+        BadBrightness,
+        Blurry,
+        BadPose
+    };
+
+    Verdict verdict = Passed;
+    int faceSize = 0;
+    float brightness = 0.0f;
+    float sharpness = 0.0f;
+    float yaw = 0.0f;
+
+    bool passed() const { return verdict == Passed; }
+};
+
+// 🆕 各阶段跳过的人脸计数
+struct FaceQualityStats {
+    quint64 evaluated = 0;
+    quint64 passed = 0;
+    quint64 skippedTooSmall = 0;
+    quint64 skippedBrightness = 0;
+    quint64 skippedBlurry = 0;
+    quint64 skippedPose = 0;
+    quint64 reusedFromTrack = 0;     // 低质量但沿用同轨迹更好帧的识别结果
+
+    quint64 skipped() const {
+        return skippedTooSmall + skippedBrightness + skippedBlurry + skippedPose;
+    }
+    void add(const FaceQualityStats& other);
+    QString summary() const;
+};
+
+// 🆕 廉价质量评分：按开销从低到高依次检查，首个不达标项即判定
+// 亮度与清晰度在 kProbeSize 见方的缩小灰度图上计算，开销与人脸大小无关
+class FaceQualityScorer
+{
+public:
+    static const int kProbeSize = 48;
+    static const int kLandmarkCount = 5;  // 左眼、右眼、鼻尖、左嘴角、右嘴角
+
+    void setConfig(const FaceQualityConfig& config) { m_config = config; }
+    const FaceQualityConfig& config() const { return m_config; }
+    bool needsLandmarks() const { return m_config.enabled && m_config.maxYaw > 0.0f; }
+
+    // frame 为 RGB888，box 为 frame 坐标；依次检查尺寸、亮度、清晰度
+    FaceQualityScore evaluate(const QImage& frame, const QRect& box) const;
+    // 姿态检查单独进行：只有前几项通过时才值得花费一次关键点推理
+    void checkPose(FaceQualityScore& score, const QPointF* landmarks) const;
+
+    static float estimateYaw(const QPointF* landmarks);
+
+private:
+    FaceQualityConfig m_config;
+};
+
+// 🆕 简单 IoU 轨迹缓存：记录每个源最近一次成功识别的人脸，
+// 同一位置后续的低质量人脸可直接沿用，等待更好的帧再重新提取
+class FaceTrackCache
+{
+public:
+    FaceTrackCache();
+
+    void update(int sourceId, const FaceInfo& face);
+    // 返回 IoU 最大且未过期的轨迹结果，未命中返回 false
+    bool lookup(int sourceId, const QRect& bbox, int maxAgeMs, FaceInfo& face) const;
+
+    static float iou(const QRect& a, const QRect& b);
+
+private:
+    struct Track {
+        int sourceId;
+        FaceInfo face;
+        qint64 updatedMs;
+    };
+
+    static const int kMaxTracks = 32;
+    static constexpr float kMinIoU = 0.3f;
+
+    QVector<Track> m_tracks;
+    QElapsedTimer m_clock;
+};
+
+#endif // FACEQUALITY_H
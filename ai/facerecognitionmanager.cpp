@@ -1,19 +1,29 @@
 // ai/FaceRecognitionManager.cpp
 #include "facerecognitionmanager.h"
+#include "imageresampler.h"
+#include "snapshotservice.h"
+#include "../core/Logging.h"
+#include "../core/TraceRecorder.h"
 #include <QTime>
 #include <QCoreApplication>
 #include <QDir>
+#include <QElapsedTimer>
 #include <cmath>        // 提供 std::isfinite 函数
 #include <algorithm>    // 提供 std::max_element 函数
 
 FaceRecognitionManager::FaceRecognitionManager(QObject *parent)
     : QObject(parent)
-    , m_faceDetHandle(nullptr)
-    , m_faceLandmarkHandle(nullptr)
-    , m_faceRecognizeHandle(nullptr)
+#ifdef SV_HAVE_ROCKX
+    , m_backendName("rockx")
+#else
+    , m_backendName("cpu")
+#endif
+    , m_poolSize(2)
     , m_initialized(false)
     , m_detectionThreshold(0.5f)
     , m_recognitionThreshold(0.7f)
+    , m_maxImageWidth(640)
+    , m_maxImageHeight(480)
     , m_lastDetectionTime(0.0f)
     , m_lastRecognitionTime(0.0f)
     , m_detectionCount(0)
@@ -41,81 +51,30 @@ bool FaceRecognitionManager::initialize(const QString& modelPath)
         return true;
     }
 
-    // Define possible model paths on target device (ordered by priority)
-    QStringList possiblePaths;
-
-    // 1. First try user-specified path
-    if (!modelPath.isEmpty()) {
-        possiblePaths << modelPath;
-    }
-
-    // 2. Try environment variable
-    QString envPath = QString::fromLocal8Bit(qgetenv("ROCKX_MODEL_PATH"));
-    if (!envPath.isEmpty()) {
-        possiblePaths << envPath;
-    }
-
-    // 3. Standard installation paths (where CMake would install them)
-    possiblePaths << "/usr/local/share/rockx_data"      // Primary CMake install location
-                  << "/share/rockx_data"                // Alternate CMake install location
-                  << "/opt/rockx/data"                  // Possible RockX standard path
-                  << "/usr/share/rockx/data"            // System standard path
-                  << "/usr/share/rockx_data"            // Variant path
-                  << "/oem/usr/share/rockx_data";       // Common OEM partition path for RV1126
-
-    // 4. Application-relative paths
-    QString appDir = QCoreApplication::applicationDirPath();
-    possiblePaths << appDir + "/rockx_data"
-                  << appDir + "/../share/rockx_data"
-                  << appDir + "/../../share/rockx_data";
-
-    // Find first valid path
-    QString validPath;
-    qDebug() << "========== Searching for RockX model files ==========";
-
-    for (const QString& path : possiblePaths) {
-        qDebug() << "Checking path:" << path;
-
-        QDir dir(path);
-        if (!dir.exists()) {
-            qDebug() << "  ✗ Directory does not exist";
-            continue;
-        }
-
-        if (validateModelFiles(path)) {
-            validPath = path;
-            qDebug() << "  ✓ Found valid model path:" << validPath;
-            break;
-        } else {
-            qDebug() << "  ✗ Directory exists but model files are missing";
-        }
+    // 1. 确认推理后端可用（名称来自 AIConfig::inferenceBackend）
+    if (!probeBackend()) {
+        emit initializationFailed(QString("Inference backend '%1' unavailable").arg(m_backendName));
+        return false;
     }
 
-    if (validPath.isEmpty()) {
-        qDebug() << " No valid RockX model path found!";
-        qDebug() << "All searched paths:";
-        for (const QString& path : possiblePaths) {
-            qDebug() << "  - " << path;
+    // 2. 依赖模型文件的后端先定位模型目录
+    if (!m_requiredModelFiles.isEmpty()) {
+        m_modelPath = findModelPath(modelPath);
+        if (m_modelPath.isEmpty()) {
+            emit initializationFailed("No valid RockX model path found");
+            cleanup();
+            return false;
         }
-        qDebug() << "";
-        qDebug() << "Possible solutions:";
-        qDebug() << "1. Ensure model files are properly installed on target device";
-        qDebug() << "2. Set environment variable: export ROCKX_MODEL_PATH=/path/to/models";
-        qDebug() << "3. Verify file permissions are correct";
-
-        emit initializationFailed("No valid RockX model path found");
-        return false;
     }
 
-    m_modelPath = validPath;
-
     qDebug() << "========== FaceRecognitionManager Initialization Started ==========";
+    qDebug() << "✓ Inference backend:" << m_backendName << "x" << m_poolSize;
     qDebug() << "✓ Final model path:" << m_modelPath;
     qDebug() << "✓ Current user:" << qgetenv("USER");
     qDebug() << "✓ Application path:" << QCoreApplication::applicationDirPath();
     qDebug() << "✓ Current working directory:" << QDir::currentPath();
 
-    // 2. Initialize database - 使用用户主目录避免权限问题
+    // 3. Initialize database - 使用用户主目录避免权限问题
     QString appDataDir;
 
     // 尝试不同的数据目录位置
@@ -126,6 +85,10 @@ bool FaceRecognitionManager::initialize(const QString& modelPath)
         "/var/tmp/SecureVision"                                 // 系统临时目录
     };
 
+    if (!m_dataDirectory.isEmpty()) {
+        possibleDataDirs.prepend(m_dataDirectory);
+    }
+
     for (const QString& dir : possibleDataDirs) {
         QDir testDir(dir);
         if (testDir.exists() || testDir.mkpath(".")) {
@@ -161,13 +124,23 @@ bool FaceRecognitionManager::initialize(const QString& modelPath)
     }
     qDebug() << "✓ Database initialized successfully";
 
-    // 3. Initialize RockX
-    if (!initializeRockX()) {
-        qDebug() << " RockX initialization failed";
-        emit initializationFailed("RockX initialization failed");
+    // 3.1 预热人脸库：有效快照直接mmap，避免首帧识别时才逐行加载特征
+    QElapsedTimer galleryTimer;
+    galleryTimer.start();
+    QSharedPointer<const FaceGallery> gallery = m_database->gallery();
+    qDebug() << "✓ Face gallery ready in" << galleryTimer.elapsed() << "ms"
+             << (gallery && gallery->isMapped() ? "(mapped snapshot)" : "(loaded from database)")
+             << "persons:" << (gallery ? gallery->personCount() : 0);
+
+    // 4. Initialize inference contexts（每个上下文一套独立句柄）
+    if (!m_pool.initialize(m_backendName, m_modelPath, m_poolSize)) {
+        qDebug() << " Inference backend initialization failed:" << m_backendName;
+        emit initializationFailed(QString("%1 initialization failed").arg(m_backendName));
+        cleanup();
         return false;
     }
-    qDebug() << "✓ RockX initialized successfully";
+    qDebug() << "✓ Inference backend initialized successfully:" << m_backendName
+             << "contexts:" << m_pool.size();
 
     m_initialized = true;
     qDebug() << "========== FaceRecognitionManager Initialization Completed ==========";
@@ -179,6 +152,77 @@ bool FaceRecognitionManager::initialize(const QString& modelPath)
     return true;
 }
 
+QString FaceRecognitionManager::findModelPath(const QString& modelPath)
+{
+    // Define possible model paths on target device (ordered by priority)
+    QStringList possiblePaths;
+
+    // 1. First try user-specified path
+    if (!modelPath.isEmpty()) {
+        possiblePaths << modelPath;
+    }
+
+    // 2. Try environment variable
+    QString envPath = QString::fromLocal8Bit(qgetenv("ROCKX_MODEL_PATH"));
+    if (!envPath.isEmpty()) {
+        possiblePaths << envPath;
+    }
+
+    // 3. Standard installation paths (where CMake would install them)
+    possiblePaths << "/usr/local/share/rockx_data"      // Primary CMake install location
+                  << "/share/rockx_data"                // Alternate CMake install location
+                  << "/opt/rockx/data"                  // Possible RockX standard path
+                  << "/usr/share/rockx/data"            // System standard path
+                  << "/usr/share/rockx_data"            // Variant path
+                  << "/oem/usr/share/rockx_data";       // Common OEM partition path for RV1126
+
+    // 4. Application-relative paths
+    QString appDir = QCoreApplication::applicationDirPath();
+    possiblePaths << appDir + "/rockx_data"
+                  << appDir + "/../share/rockx_data"
+                  << appDir + "/../../share/rockx_data";
+
+    // Find first valid path
+    QString validPath;
+    qDebug() << "========== Searching for RockX model files ==========";
+
+    for (const QString& path : possiblePaths) {
+        qDebug() << "Checking path:" << path;
+
+        QDir dir(path);
+        if (!dir.exists()) {
+            qDebug() << "  ✗ Directory does not exist";
+            continue;
+        }
+
+        if (validateModelFiles(path)) {
+            validPath = path;
+            qDebug() << "  ✓ Found valid model path:" << validPath;
+            break;
+        } else {
+            qDebug() << "  ✗ Directory exists but model files are missing";
+        }
+    }
+
+    if (validPath.isEmpty()) {
+        qDebug() << " No valid RockX model path found!";
+        qDebug() << "All searched paths:";
+        for (const QString& path : possiblePaths) {
+            qDebug() << "  - " << path;
+        }
+        qDebug() << "";
+        qDebug() << "Possible solutions:";
+        qDebug() << "1. Ensure model files are properly installed on target device";
+        qDebug() << "2. Set environment variable: export ROCKX_MODEL_PATH=/path/to/models";
+        qDebug() << "3. Verify file permissions are correct";
+
+        return QString();
+    }
+
+    return validPath;
+
+}
+
 bool FaceRecognitionManager::validateModelFiles(const QString& modelPath)
 {
     qDebug() << "========== Validating Model Files ==========";
@@ -192,12 +236,8 @@ bool FaceRecognitionManager::validateModelFiles(const QString& modelPath)
     }
     qDebug() << "✓ Model directory exists";
 
-    // 🔧 仅检查人脸识别必需的模型文件
-    QStringList requiredFiles = {
-        "face_detection_v3_fast.data",  // 人脸检测模型
-        "face_landmark5.data",          // 5点关键点模型
-        "face_recognition.data"         // 人脸识别模型
-    };
+    // 🔧 仅检查当前后端必需的模型文件
+    const QStringList requiredFiles = m_requiredModelFiles;
 
     qDebug() << "Checking required face recognition model files:";
     for (const QString& fileName : requiredFiles) {
@@ -230,26 +270,97 @@ void FaceRecognitionManager::cleanup()
 {
     qDebug() << "FaceRecognitionManager: Cleanup started";
 
-    if (m_faceDetHandle) {
-        rockx_destroy(m_faceDetHandle);
-        m_faceDetHandle = nullptr;
-        qDebug() << "FaceRecognitionManager: Face detection handle destroyed";
+    m_initialized = false;
+    m_pool.shutdown();
+
+    qDebug() << "FaceRecognitionManager: Cleanup completed";
+}
+
+bool FaceRecognitionManager::probeBackend()
+{
+    // 只为查询模型文件需求创建一个临时实例，真正的句柄由推理池创建
+    InferenceBackend* probe = InferenceBackendRegistry::create(m_backendName);
+    if (!probe) {
+        qDebug() << "FaceRecognitionManager: Inference backend" << m_backendName
+                 << "not available, built-in backends:" << InferenceBackendRegistry::availableBackends();
+        return false;
     }
 
-    if (m_faceLandmarkHandle) {
-        rockx_destroy(m_faceLandmarkHandle);
-        m_faceLandmarkHandle = nullptr;
-        qDebug() << "FaceRecognitionManager: Face landmark handle destroyed";
+    m_requiredModelFiles = probe->requiredModelFiles();
+    delete probe;
+    return true;
+}
+
+void FaceRecognitionManager::setInferenceBackend(const QString& name)
+{
+    QString previous;
+    {
+        QMutexLocker locker(&m_mutex);
+        previous = m_backendName;
     }
+    if (name.compare(previous, Qt::CaseInsensitive) == 0) {
+        return;
+    }
+
+    reconfigurePool(name.toLower(), -1);
+}
 
-    if (m_faceRecognizeHandle) {
-        rockx_destroy(m_faceRecognizeHandle);
-        m_faceRecognizeHandle = nullptr;
-        qDebug() << "FaceRecognitionManager: Face recognition handle destroyed";
+void FaceRecognitionManager::setInferencePoolSize(int size)
+{
+    size = qMax(1, size);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (size == m_poolSize) {
+            return;
+        }
     }
 
-    m_initialized = false;
-    qDebug() << "FaceRecognitionManager: Cleanup completed";
+    reconfigurePool(QString(), size);
+}
+
+// 🔧 后端名/池大小变更：已初始化时在调用线程重建推理池。重建不持有 m_mutex（加载模型较慢），
+// 期间旧上下文照常服务检测；新池就绪后整体换入，失败时保留旧池与旧配置
+void FaceRecognitionManager::reconfigurePool(const QString& backendName, int size)
+{
+    QMutexLocker reconfigureLocker(&m_reconfigureMutex);
+
+    QString oldBackend;
+    int oldSize = 0;
+    QString newBackend;
+    int newSize = 0;
+    QString modelPath;
+    {
+        QMutexLocker locker(&m_mutex);
+        oldBackend = m_backendName;
+        oldSize = m_poolSize;
+        if (!backendName.isEmpty()) {
+            m_backendName = backendName;
+        }
+        if (size > 0) {
+            m_poolSize = size;
+        }
+        newBackend = m_backendName;
+        newSize = m_poolSize;
+        modelPath = m_modelPath;
+    }
+
+    if (!m_initialized || (newBackend == oldBackend && newSize == oldSize)) {
+        return;
+    }
+
+    if (!m_pool.initialize(newBackend, modelPath, newSize)) {
+        qDebug() << "FaceRecognitionManager: Failed to rebuild inference pool with backend" << newBackend
+                 << "size" << newSize << "- keeping" << oldBackend << "x" << oldSize;
+        QMutexLocker locker(&m_mutex);
+        m_backendName = oldBackend;
+        m_poolSize = oldSize;
+    }
+}
+
+QString FaceRecognitionManager::inferenceBackendName() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_backendName;
 }
 
 QStringList FaceRecognitionManager::getAllRegisteredNames()
@@ -269,529 +380,513 @@ int FaceRecognitionManager::getTotalRegisteredFaces()
     return m_database->getTotalFaceCount();
 }
 
+void FaceRecognitionManager::setTemplatePolicy(TemplateAggregation aggregation, int topN, int maxTemplatesPerPerson)
+{
+    m_database->setMatchPolicy(aggregation, topN, maxTemplatesPerPerson);
+}
+
 void FaceRecognitionManager::logPerformance(const QString& operation, float timeMs)
 {
     if (timeMs > 50) {  // 只记录耗时较长的操作
-        qDebug() << QString("FaceRecognitionManager: %1 took %.2f ms").arg(operation).arg(timeMs);
+        svDebugEvery(lcFaceRecognition, 1000) << "FaceRecognitionManager:" << operation << "took" << timeMs << "ms";
     }
 }
 
-bool FaceRecognitionManager::initializeRockX()
+// 🆕 一帧只做一次预处理，检测和该帧所有人脸的对齐都复用同一份像素
+bool FaceRecognitionManager::prepareFrame(const QImage& image, PreparedFrame& frame)
 {
-    rockx_ret_t ret;
-
-    qDebug() << "========== RockX Initialization Debug ==========";
-
-    // 1. Set environment variable
-    qDebug() << "Setting ROCKX_MODEL_PATH environment variable:" << m_modelPath;
-    qputenv("ROCKX_MODEL_PATH", m_modelPath.toLocal8Bit());
-
-    // Verify environment variable
-    QByteArray envValue = qgetenv("ROCKX_MODEL_PATH");
-    qDebug() << "Current ROCKX_MODEL_PATH value:" << QString::fromLocal8Bit(envValue);
-
-    // 2. Try alternative path settings
-    qDebug() << "Attempting to set alternative environment variables...";
-    qputenv("ROCKX_DATA_PATH", m_modelPath.toLocal8Bit());
-    qputenv("ROCKX_MODEL_DIR", m_modelPath.toLocal8Bit());
-
-    // 3. Check current working directory
-    QString oldWorkDir = QDir::currentPath();
-    qDebug() << "Original working directory:" << oldWorkDir;
-
-    // Try changing to model directory
-    QDir::setCurrent(m_modelPath);
-    qDebug() << "Changed to model directory:" << QDir::currentPath();
-
-    // 4. Create RockX handles
-    qDebug() << "Creating RockX handles...";
-
-    // Create face detection handle
-    qDebug() << "Creating face detection handle (ROCKX_MODULE_FACE_DETECTION)...";
-    qDebug() << "Module ID:" << ROCKX_MODULE_FACE_DETECTION;
-
-    ret = rockx_create(&m_faceDetHandle, ROCKX_MODULE_FACE_DETECTION, nullptr, 0);
-    if (ret != ROCKX_RET_SUCCESS) {
-        qDebug() << " Failed to create face detection handle!";
-        qDebug() << "   Error code:" << ret;
-        qDebug() << "   Error details:";
-        switch (ret) {
-        case -1:
-            qDebug() << "     ROCKX_RET_FAIL (-1): General error";
-            break;
-        case -2:
-            qDebug() << "     Possible model file not found";
-            break;
-        case -3:
-            qDebug() << "     Possible memory allocation failure";
-            break;
-        default:
-            qDebug() << "     Unknown error code:" << ret;
-        }
-
-        // List files in current directory
-        qDebug() << "Current directory file list:";
-        QDir currentDir(".");
-        QStringList files = currentDir.entryList(QDir::Files);
-        for (const QString& file : files) {
-            if (file.contains("face_detection")) {
-                qDebug() << "   Found related file:" << file;
-            }
-        }
-
-        // Restore working directory
-        QDir::setCurrent(oldWorkDir);
-        return false;
-    }
-    qDebug() << "✓ Face detection handle created successfully";
-
-    // Create face landmark handle
-    qDebug() << "Creating face landmark handle (ROCKX_MODULE_FACE_LANDMARK_5)...";
-    ret = rockx_create(&m_faceLandmarkHandle, ROCKX_MODULE_FACE_LANDMARK_5, nullptr, 0);
-    if (ret != ROCKX_RET_SUCCESS) {
-        qDebug() << " Failed to create face landmark handle, error code:" << ret;
-        cleanup();
-        QDir::setCurrent(oldWorkDir);
-        return false;
-    }
-    qDebug() << "✓ Face landmark handle created successfully";
-
-    // Create face recognition handle
-    qDebug() << "Creating face recognition handle (ROCKX_MODULE_FACE_RECOGNIZE)...";
-    ret = rockx_create(&m_faceRecognizeHandle, ROCKX_MODULE_FACE_RECOGNIZE, nullptr, 0);
-    if (ret != ROCKX_RET_SUCCESS) {
-        qDebug() << " Failed to create face recognition handle, error code:" << ret;
-        cleanup();
-        QDir::setCurrent(oldWorkDir);
+    SV_TRACE_SCOPE("ai", "convert");
+    frame.image = preprocessImage(image);
+    if (frame.image.isNull()) {
         return false;
     }
-    qDebug() << "✓ Face recognition handle created successfully";
-
-    // Restore original working directory
-    QDir::setCurrent(oldWorkDir);
-    qDebug() << "Restored working directory:" << QDir::currentPath();
 
-    qDebug() << "========== RockX Initialization Successful! ==========";
+    frame.scaleX = float(frame.image.width()) / image.width();
+    frame.scaleY = float(frame.image.height()) / image.height();
     return true;
 }
 
-rockx_image_t FaceRecognitionManager::qImageToRockxImage(const QImage& image)
-{
-    rockx_image_t rockxImage;
-    memset(&rockxImage, 0, sizeof(rockx_image_t));
-
-    // 🔧 方案1：使用成员变量缓存图像数据，避免临时对象销毁
-    m_imageBuffer = image.convertToFormat(QImage::Format_RGB888);
-
-    // 验证图像转换是否成功
-    if (m_imageBuffer.isNull()) {
-        qDebug() << "FaceRecognitionManager: Image conversion failed";
-        return rockxImage;
-    }
-
-    rockxImage.width = m_imageBuffer.width();
-    rockxImage.height = m_imageBuffer.height();
-    rockxImage.pixel_format = ROCKX_PIXEL_FORMAT_RGB888;
-    rockxImage.data = (uint8_t*)m_imageBuffer.bits();
-    rockxImage.size = m_imageBuffer.sizeInBytes();
-
-    // 🔧 添加安全检查
-    if (!rockxImage.data || rockxImage.size == 0) {
-        qDebug() << "FaceRecognitionManager: Invalid image data";
-        memset(&rockxImage, 0, sizeof(rockx_image_t));
-        return rockxImage;
-    }
-
-    qDebug() << QString("FaceRecognitionManager: Image converted - size: %1x%2, data: %3 bytes")
-                    .arg(rockxImage.width)
-                    .arg(rockxImage.height)
-                    .arg(rockxImage.size);
-
-    return rockxImage;
-}
-
 // 🔧 改进的图像预处理方法
 QImage FaceRecognitionManager::preprocessImage(const QImage& image)
 {
     if (image.isNull()) {
-        qDebug() << "FaceRecognitionManager: Input image is null";
+        svWarningEvery(lcFaceRecognition, 5000) << "FaceRecognitionManager: Input image is null";
         return QImage();
     }
 
     QImage processedImage = image;
 
-    // 🔧 确保图像尺寸适中，避免RGA处理过大图像时出错
-    const int MAX_WIDTH = 1280;
-    const int MAX_HEIGHT = 720;
-
-    if (processedImage.width() > MAX_WIDTH || processedImage.height() > MAX_HEIGHT) {
-        qDebug() << QString("FaceRecognitionManager: Resizing image from %1x%2 to fit %3x%4")
-        .arg(processedImage.width())
-            .arg(processedImage.height())
-            .arg(MAX_WIDTH)
-            .arg(MAX_HEIGHT);
-
-        processedImage = processedImage.scaled(MAX_WIDTH, MAX_HEIGHT,
-                                               Qt::KeepAspectRatio,
-                                               Qt::SmoothTransformation);
+    // 🔧 缩放到 AIConfig 配置的工作分辨率（等比），检测框由 prepareFrame 记录的比例换算回原图
+    // 先缩放再转格式：转换只作用于小图
+    int maxWidth, maxHeight;
+    {
+        QMutexLocker locker(&m_mutex);
+        maxWidth = m_maxImageWidth;
+        maxHeight = m_maxImageHeight;
+    }
+    const QSize workingSize = ImageResampler::fitWithin(processedImage.size(), maxWidth, maxHeight);
+    if (workingSize != processedImage.size()) {
+        processedImage = ImageResampler::resized(processedImage, workingSize);
     }
 
     // 🔧 确保图像格式兼容
     if (processedImage.format() != QImage::Format_RGB888) {
-        qDebug() << "FaceRecognitionManager: Converting to RGB888 format";
         processedImage = processedImage.convertToFormat(QImage::Format_RGB888);
     }
 
     // 🔧 验证处理结果
     if (processedImage.isNull()) {
-        qDebug() << "FaceRecognitionManager: Image preprocessing failed";
+        svWarningEvery(lcFaceRecognition, 5000) << "FaceRecognitionManager: Image preprocessing failed";
         return QImage();
     }
 
-    qDebug() << QString("FaceRecognitionManager: Image preprocessed - final size: %1x%2")
-                    .arg(processedImage.width())
-                    .arg(processedImage.height());
+    svDebug(lcFaceRecognition) << "FaceRecognitionManager: Image preprocessed - final size:" << processedImage.size();
 
     return processedImage;
 }
-// 获取最大人脸（基于官方示例的get_max_face函数）
-rockx_object_t* FaceRecognitionManager::getMaxFace(rockx_object_array_t* faceArray)
-{
-    if (faceArray->count == 0) {
-        return nullptr;
-    }
-
-    rockx_object_t* maxFace = nullptr;
-    int maxArea = 0;
-
-    for (int i = 0; i < faceArray->count; i++) {
-        rockx_object_t* curFace = &(faceArray->object[i]);
-
-        int curArea = (curFace->box.right - curFace->box.left) *
-                      (curFace->box.bottom - curFace->box.top);
-
-        if (curArea > maxArea) {
-            maxArea = curArea;
-            maxFace = curFace;
-        }
-    }
-
-    qDebug() << "FaceRecognitionManager: Selected max face with area:" << maxArea;
-
-    // 🔧 修复格式化问题
-    if (maxFace) {
-        qDebug() << QString("FaceRecognitionManager: Max face selected - bbox=(%1,%2,%3,%4) score=%5")
-        .arg(maxFace->box.left).arg(maxFace->box.top)
-            .arg(maxFace->box.right).arg(maxFace->box.bottom)
-            .arg(maxFace->score, 0, 'f', 3);
-    }
-
-    return maxFace;
-}
 // 添加到 FaceRecognitionManager.cpp 中
 QVector<FaceInfo> FaceRecognitionManager::detectFaces(const QImage& image)
 {
-    QMutexLocker locker(&m_mutex);
-
     if (!m_initialized || image.isNull()) {
-        qDebug() << "FaceRecognitionManager: Not initialized or invalid image";
+        svWarningEvery(lcFaceRecognition, 5000) << "FaceRecognitionManager: Not initialized or invalid image";
         return QVector<FaceInfo>();
     }
 
     QTime timer;
     timer.start();
 
-    QVector<FaceInfo> faces = processDetection(image);
+    InferencePool::Lease lease = m_pool.acquire();
+    if (!lease) {
+        return QVector<FaceInfo>();
+    }
 
-    m_lastDetectionTime = timer.elapsed();
-    m_detectionCount++;
+    QVector<FaceInfo> faces;
+    PreparedFrame frame;
+    if (prepareFrame(image, frame)) {
+        faces = detectOnFrame(lease.backend(), frame);
+    }
+    lease.release();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_lastDetectionTime = timer.elapsed();
+        m_detectionCount++;
+    }
 
     logPerformance("Face Detection", m_lastDetectionTime);
 
     if (!faces.isEmpty()) {
-        qDebug() << "FaceRecognitionManager: Detected" << faces.size() << "faces";
+        svDebug(lcFaceRecognition) << "FaceRecognitionManager: Detected" << faces.size() << "faces";
         emit faceDetected(faces);
     }
 
     return faces;
 }
 
-QVector<FaceInfo> FaceRecognitionManager::processDetection(const QImage& image)
+QVector<FaceInfo> FaceRecognitionManager::detectOnFrame(InferenceBackend* backend, PreparedFrame& frame,
+                                                        QVector<QRect>* boxes)
 {
     QVector<FaceInfo> faces;
 
-    // 1. 预处理图像
-    QImage processedImage = preprocessImage(image);
-    rockx_image_t rockxImage = qImageToRockxImage(processedImage);
-
-    // 2. 执行人脸检测（基于官方示例）
-    rockx_object_array_t faceArray;
-    memset(&faceArray, 0, sizeof(rockx_object_array_t));
-
-    rockx_ret_t ret = rockx_face_detect(m_faceDetHandle, &rockxImage, &faceArray, nullptr);
-    if (ret != ROCKX_RET_SUCCESS) {
-        qDebug() << "FaceRecognitionManager: Face detection failed, error:" << ret;
-        return faces;
+    // 1. 执行人脸检测（坐标基于处理帧）
+    QVector<DetectedFace> detected;
+    {
+        SV_TRACE_SCOPE("ai", "face_detect");
+        detected = backend->detect(frame.image);
     }
 
-    qDebug() << "FaceRecognitionManager: RockX detected" << faceArray.count << "faces";
-
-    // 3. 解析检测结果
-    for (int i = 0; i < faceArray.count; ++i) {
-        const rockx_object_t& obj = faceArray.object[i];
-
+    // 2. 解析检测结果
+    for (const DetectedFace& obj : detected) {
         // 过滤低置信度的检测结果
-        if (obj.score >= m_detectionThreshold) {
-            FaceInfo faceInfo;
-            faceInfo.bbox = QRect(obj.box.left, obj.box.top,
-                                  obj.box.right - obj.box.left,
-                                  obj.box.bottom - obj.box.top);
-            faceInfo.confidence = obj.score;
-            faceInfo.isRecognized = false;  // 仅检测，未识别
-
-            faces.append(faceInfo);
-
-            qDebug() << QString("FaceRecognitionManager: Face %1: bbox=(%2,%3,%4,%5) confidence=%6")
-                            .arg(i)
-                            .arg(faceInfo.bbox.x()).arg(faceInfo.bbox.y())
-                            .arg(faceInfo.bbox.width()).arg(faceInfo.bbox.height())
-                            .arg(faceInfo.confidence, 0, 'f', 3);
-        } else {
-            qDebug() << QString("FaceRecognitionManager: Face %1 filtered (confidence %.3f < threshold %.3f)")
-            .arg(i).arg(obj.score).arg(m_detectionThreshold);
+        if (obj.score < m_detectionThreshold) {
+            continue;
+        }
+
+        // 🔧 检测在处理帧上进行，对外输出换算回原始帧坐标
+        FaceInfo faceInfo;
+        faceInfo.bbox = QRect(qRound(obj.box.x() / frame.scaleX),
+                              qRound(obj.box.y() / frame.scaleY),
+                              qRound(obj.box.width() / frame.scaleX),
+                              qRound(obj.box.height() / frame.scaleY));
+        faceInfo.confidence = obj.score;
+        faceInfo.isRecognized = false;  // 仅检测，未识别
+
+        faces.append(faceInfo);
+        if (boxes) {
+            boxes->append(obj.box);
         }
     }
 
     return faces;
 }
 
-// 在 ai/FaceRecognitionManager.cpp 文件末尾添加这些方法
-
 // ========== 人脸检测+识别组合功能 ==========
-QVector<FaceInfo> FaceRecognitionManager::detectAndRecognizeFaces(const QImage& image)
+QVector<FaceInfo> FaceRecognitionManager::detectAndRecognizeFaces(const QImage& image, int sourceId)
 {
-    QMutexLocker locker(&m_mutex);
-
     if (!m_initialized || image.isNull()) {
-        qDebug() << "FaceRecognitionManager: Not initialized or invalid image for recognition";
+        svWarningEvery(lcFaceRecognition, 5000) << "FaceRecognitionManager: Not initialized or invalid image for recognition";
         return QVector<FaceInfo>();
     }
 
     QTime timer;
     timer.start();
 
-    // 1. 首先进行人脸检测
-    QVector<FaceInfo> detectedFaces = processDetection(image);
+    InferencePool::Lease lease = m_pool.acquire();
+    if (!lease) {
+        return QVector<FaceInfo>();
+    }
 
-    if (detectedFaces.isEmpty()) {
-        qDebug() << "FaceRecognitionManager: No faces detected for recognition";
-        return detectedFaces;
+    // 1. 检测并把所有人脸对齐到该上下文的批缓冲区
+    FaceBatch& batch = lease->scratch;
+    batch.clear();
+    QVector<FaceInfo> faces = detectAndAlign(lease.backend(), image, sourceId, 0, batch);
+    if (faces.isEmpty()) {
+        return faces;
     }
 
-    // 2. 对每个检测到的人脸进行识别
-    QVector<FaceInfo> recognizedFaces;
-    for (int i = 0; i < detectedFaces.size(); ++i) {
-        FaceInfo faceInfo = detectedFaces[i];
+    // 2. 整批提取特征并匹配，结果按下标回填
+    const QVector<QueuedFaceResult> results = recognizeBatch(lease.backend(), batch);
+    lease.release();
 
-        // 对单个人脸进行识别
-        FaceInfo recognizedFace = processRecognition(faceInfo, image);
-        recognizedFaces.append(recognizedFace);
+    for (const QueuedFaceResult& result : results) {
+        faces[result.ticket.faceIndex] = result.face;
+    }
 
-        // 发出相应信号
-        if (recognizedFace.isRecognized) {
-            emit faceRecognized(recognizedFace.personName, recognizedFace.similarity);
-        } else {
-            emit unknownFaceDetected(recognizedFace.bbox);
-        }
+    float elapsed = timer.elapsed();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_lastRecognitionTime = elapsed;
+        m_recognitionCount++;
+    }
+
+    logPerformance("Face Recognition", elapsed);
+
+    return faces;
+}
+
+QVector<FaceInfo> FaceRecognitionManager::detectAndReuseFaces(const QImage& image, int sourceId)
+{
+    if (!m_initialized || image.isNull()) {
+        return QVector<FaceInfo>();
+    }
+
+    QTime timer;
+    timer.start();
+
+    InferencePool::Lease lease = m_pool.acquire();
+    if (!lease) {
+        return QVector<FaceInfo>();
     }
 
-    m_lastRecognitionTime = timer.elapsed();
-    m_recognitionCount++;
+    QVector<FaceInfo> faces;
+    PreparedFrame frame;
+    if (prepareFrame(image, frame)) {
+        faces = detectOnFrame(lease.backend(), frame);
+    }
+    lease.release();
 
-    logPerformance("Face Recognition", m_lastRecognitionTime);
+    QMutexLocker locker(&m_mutex);
+    const int maxAgeMs = m_qualityScorer.config().trackReuseMs;
+    for (FaceInfo& face : faces) {
+        FaceInfo previous;
+        if (m_trackCache.lookup(sourceId, face.bbox, maxAgeMs, previous)) {
+            previous.confidence = face.confidence;
+            face = previous;
+        }
+    }
 
-    qDebug() << QString("FaceRecognitionManager: Recognition completed - %1 faces, %2 recognized")
-                    .arg(recognizedFaces.size())
-                    .arg(std::count_if(recognizedFaces.begin(), recognizedFaces.end(),
-                                       [](const FaceInfo& f) { return f.isRecognized; }));
+    m_lastDetectionTime = timer.elapsed();
+    m_detectionCount++;
 
-    return recognizedFaces;
+    return faces;
 }
 
-// ========== 单个人脸识别处理 ==========
-FaceInfo FaceRecognitionManager::processRecognition(const FaceInfo& detectedFace, const QImage& originalImage)
+QVector<FaceInfo> FaceRecognitionManager::detectAndQueueFaces(const QImage& image, int sourceId, quint64 frameId,
+                                                              int* queuedCount)
 {
-    FaceInfo faceInfo = detectedFace;
+    if (queuedCount) {
+        *queuedCount = 0;
+    }
+
+    if (!m_initialized || image.isNull()) {
+        return QVector<FaceInfo>();
+    }
 
-    try {
-        qDebug() << "FaceRecognitionManager: Processing recognition for face at" << detectedFace.bbox;
+    InferencePool::Lease lease = m_pool.acquire();
+    if (!lease) {
+        return QVector<FaceInfo>();
+    }
 
-        // 提取特征
-        QByteArray feature = extractFaceFeatureFromDetectedFace(originalImage, detectedFace.bbox);
+    FaceBatch& batch = lease->scratch;
+    batch.clear();
+    QVector<FaceInfo> faces = detectAndAlign(lease.backend(), image, sourceId, frameId, batch);
+    m_batchScheduler.submit(batch);
 
-        if (feature.isEmpty()) {
-            qDebug() << "FaceRecognitionManager: Failed to extract face feature";
-            return faceInfo;
-        }
+    // 对齐失败的人脸不会入队，调用方按实际入队数等待结果
+    if (queuedCount) {
+        *queuedCount = batch.size();
+    }
 
-        qDebug() << "FaceRecognitionManager: Face feature extracted, size:" << feature.size();
+    return faces;
+}
 
-        // 在数据库中查找最佳匹配
-        float similarity = 0.0f;
-        int matchId = m_database->findBestMatch(feature, similarity, m_recognitionThreshold);
+QVector<QueuedFaceResult> FaceRecognitionManager::recognizeQueuedFaces(bool force)
+{
+    FaceBatch batch = m_batchScheduler.takeBatch(force);
+    if (batch.isEmpty()) {
+        return QVector<QueuedFaceResult>();
+    }
 
-        if (matchId > 0 && similarity >= m_recognitionThreshold) {
-            // 找到匹配的人脸
-            FaceRecord record = m_database->getFaceRecord(matchId);
-            if (record.id > 0) {
-                faceInfo.personName = record.name;
-                faceInfo.faceId = matchId;
-                faceInfo.similarity = similarity;
-                faceInfo.isRecognized = true;
+    QTime timer;
+    timer.start();
 
-                qDebug() << QString("FaceRecognitionManager: Face recognized as %1 (similarity: %2)")
-                                .arg(record.name).arg(similarity, 0, 'f', 3);
-            }
-        } else {
-            qDebug() << QString("FaceRecognitionManager: Unknown face (best similarity: %1, threshold: %2)")
-            .arg(similarity, 0, 'f', 3).arg(m_recognitionThreshold, 0, 'f', 3);
+    QVector<QueuedFaceResult> results;
+    {
+        InferencePool::Lease lease = m_pool.acquire();
+        if (!lease) {
+            return results;
         }
+        results = recognizeBatch(lease.backend(), batch);
+    }
 
-    } catch (const std::exception& e) {
-        qDebug() << "FaceRecognitionManager: Exception in processRecognition:" << e.what();
-    } catch (...) {
-        qDebug() << "FaceRecognitionManager: Unknown exception in processRecognition";
+    float elapsed = timer.elapsed();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_lastRecognitionTime = elapsed;
+        m_recognitionCount++;
     }
 
-    return faceInfo;
+    logPerformance(QString("Face Recognition (batch of %1)").arg(batch.size()), elapsed);
+
+    return results;
 }
-QByteArray FaceRecognitionManager::extractFaceFeatureFromDetectedFace(const QImage& originalImage, const QRect& faceRect)
+
+QVector<FaceInfo> FaceRecognitionManager::detectAndAlign(InferenceBackend* backend, const QImage& image,
+                                                         int sourceId, quint64 frameId, FaceBatch& batch)
 {
-    if (!m_initialized || originalImage.isNull() || faceRect.isEmpty()) {
-        qDebug() << "FaceRecognitionManager: Invalid parameters for feature extraction";
-        return QByteArray();
+    // 整帧只预处理/转换一次
+    PreparedFrame frame;
+    if (!prepareFrame(image, frame)) {
+        svWarningEvery(lcFaceRecognition, 5000) << "FaceRecognitionManager: Image preprocessing failed";
+        return QVector<FaceInfo>();
     }
 
-    qDebug() << "FaceRecognitionManager: Extracting feature from detected face...";
-    qDebug() << "Original image size:" << originalImage.size();
-    qDebug() << "Face rect:" << faceRect;
+    QVector<QRect> boxes;
+    QVector<FaceInfo> faces = detectOnFrame(backend, frame, &boxes);
+    if (faces.isEmpty()) {
+        return faces;
+    }
 
-    // 1. 预处理原始图像（确保与注册时使用相同的处理方式）
-    QImage processedImage = preprocessImage(originalImage);
-    if (processedImage.isNull()) {
-        qDebug() << "FaceRecognitionManager: Image preprocessing failed";
-        return QByteArray();
+    // 质量门限配置取一份副本，评分过程不持锁；统计最后一次性合并
+    FaceQualityScorer scorer;
+    {
+        QMutexLocker locker(&m_mutex);
+        scorer = m_qualityScorer;
     }
+    FaceQualityStats stats;
+
+    batch.reserve(faces.size());
+    for (int i = 0; i < faces.size(); ++i) {
+        // 🆕 低质量人脸不做对齐/特征提取；同一位置近期已识别过则沿用结果
+        if (!passesQualityGate(backend, scorer, frame, boxes[i], stats)) {
+            FaceInfo previous;
+            QMutexLocker locker(&m_mutex);
+            if (m_trackCache.lookup(sourceId, faces[i].bbox, scorer.config().trackReuseMs, previous)) {
+                previous.confidence = faces[i].confidence;
+                faces[i] = previous;
+                stats.reusedFromTrack++;
+            }
+            continue;
+        }
 
-    // 2. 转换为RockX图像格式
-    rockx_image_t inputImage = qImageToRockxImage(processedImage);
-    if (!inputImage.data || inputImage.size == 0) {
-        qDebug() << "FaceRecognitionManager: Failed to convert image format";
-        return QByteArray();
+        FaceCropTicket ticket;
+        ticket.sourceId = sourceId;
+        ticket.frameId = frameId;
+        ticket.faceIndex = i;
+        ticket.bbox = faces[i].bbox;
+        ticket.confidence = faces[i].confidence;
+
+        if (!alignFaceInto(backend, frame, boxes[i], ticket, batch)) {
+            svDebugEvery(lcFaceRecognition, 1000) << "FaceRecognitionManager: Failed to align face" << i << "- left unrecognized";
+        }
     }
 
-    // 3. 计算缩放比例（原始图像 -> 预处理图像）
-    float scaleX = float(processedImage.width()) / originalImage.width();
-    float scaleY = float(processedImage.height()) / originalImage.height();
+    if (stats.evaluated > 0) {
+        QMutexLocker locker(&m_mutex);
+        m_qualityStats.add(stats);
+    }
 
-    qDebug() << QString("FaceRecognitionManager: Scale factors - X: %1, Y: %2")
-                    .arg(scaleX, 0, 'f', 3).arg(scaleY, 0, 'f', 3);
+    return faces;
+}
+
+bool FaceRecognitionManager::alignFaceInto(InferenceBackend* backend, PreparedFrame& frame, const QRect& box,
+                                           const FaceCropTicket& ticket, FaceBatch& batch)
+{
+    SV_TRACE_SCOPE("ai", "align");
+    const int cropSize = FaceBatch::kCropSize;
+    const int stride = cropSize * FaceBatch::kChannels;
 
-    // 4. 调整人脸框到预处理后的图像坐标系
-    QRect scaledFaceRect(
-        int(faceRect.x() * scaleX),
-        int(faceRect.y() * scaleY),
-        int(faceRect.width() * scaleX),
-        int(faceRect.height() * scaleY)
-        );
+    // 1. 关键点对齐，直接写入批缓冲区
+    if (backend->align(frame.image, box, batch.appendSlot(ticket), stride)) {
+        return true;
+    }
+    batch.removeLast();
 
-    // 确保调整后的人脸框在图像边界内
-    scaledFaceRect = scaledFaceRect.intersected(QRect(0, 0, processedImage.width(), processedImage.height()));
+    // 2. 🔧 对齐失败时的备选方案：直接裁剪处理帧中的人脸区域
+    svDebugEvery(lcFaceRecognition, 1000) << "FaceRecognitionManager: Face align failed - using cropped face";
 
-    if (scaledFaceRect.isEmpty()) {
-        qDebug() << "FaceRecognitionManager: Scaled face rect is empty";
-        return QByteArray();
+    QRect faceRect = box.intersected(QRect(0, 0, frame.image.width(), frame.image.height()));
+    if (faceRect.isEmpty()) {
+        return false;
     }
 
-    qDebug() << "FaceRecognitionManager: Scaled face rect:" << scaledFaceRect;
+    QImage croppedFace = frame.image.copy(faceRect)
+                             .scaled(cropSize, cropSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    if (croppedFace.isNull()) {
+        return false;
+    }
 
-    // 5. 转换为RockX人脸框格式
-    rockx_rect_t rockxBox;
-    rockxBox.left = scaledFaceRect.x();
-    rockxBox.top = scaledFaceRect.y();
-    rockxBox.right = scaledFaceRect.right();
-    rockxBox.bottom = scaledFaceRect.bottom();
+    batch.append(ticket, croppedFace.constBits(), croppedFace.bytesPerLine());
+    return true;
+}
 
-    // 6. 进行人脸对齐（跳过重复检测步骤）
-    rockx_image_t alignedImage;
-    memset(&alignedImage, 0, sizeof(rockx_image_t));
+QVector<QByteArray> FaceRecognitionManager::embedBatch(InferenceBackend* backend, const FaceBatch& batch)
+{
+    SV_TRACE_SCOPE("ai", "recognize");
+    QVector<QByteArray> features;
+    backend->embedBatch(batch, features);
 
-    qDebug() << "FaceRecognitionManager: Starting face alignment with detected box...";
-    rockx_ret_t ret = rockx_face_align(m_faceLandmarkHandle, &inputImage, &rockxBox, nullptr, &alignedImage);
+    for (QByteArray& feature : features) {
+        if (!feature.isEmpty() && !validateFeatureQuality(feature)) {
+            feature.clear();
+        }
+    }
+
+    return features;
+}
+
+QVector<QueuedFaceResult> FaceRecognitionManager::recognizeBatch(InferenceBackend* backend, const FaceBatch& batch)
+{
+    QVector<QueuedFaceResult> results;
+    if (batch.isEmpty()) {
+        return results;
+    }
 
-    if (ret != ROCKX_RET_SUCCESS) {
-        qDebug() << "FaceRecognitionManager: Face align failed, error:" << ret;
+    const QVector<QByteArray> features = embedBatch(backend, batch);
 
-        // 🔧 RGA失败时的备选方案：直接使用裁剪的人脸区域
-        qDebug() << "FaceRecognitionManager: Using cropped face as fallback...";
+    results.reserve(batch.size());
+    for (int i = 0; i < batch.size(); ++i) {
+        const FaceCropTicket& ticket = batch.ticket(i);
 
-        QImage croppedFace = processedImage.copy(scaledFaceRect);
-        if (croppedFace.isNull()) {
-            qDebug() << "FaceRecognitionManager: Failed to crop face image";
-            return QByteArray();
+        FaceInfo face;
+        face.bbox = ticket.bbox;
+        face.confidence = ticket.confidence;
+        if (!features[i].isEmpty()) {
+            face = matchFace(face, features[i]);
         }
 
-        // 调整到标准人脸识别尺寸（通常为112x112）
-        croppedFace = croppedFace.scaled(112, 112, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-        alignedImage = qImageToRockxImage(croppedFace);
+        if (face.isRecognized) {
+            QMutexLocker locker(&m_mutex);
+            m_trackCache.update(ticket.sourceId, face);
+        }
 
-        if (!alignedImage.data) {
-            qDebug() << "FaceRecognitionManager: Failed to convert cropped face";
-            return QByteArray();
+        // 发出相应信号
+        if (face.isRecognized) {
+            emit faceRecognized(face.personName, face.similarity);
+        } else {
+            emit unknownFaceDetected(face.bbox);
         }
 
-        qDebug() << "FaceRecognitionManager: Using cropped face instead of aligned face";
-    } else {
-        qDebug() << "FaceRecognitionManager: Face aligned successfully";
+        QueuedFaceResult result;
+        result.ticket = ticket;
+        result.face = face;
+        results.append(result);
     }
 
-    // 7. 提取人脸特征
-    rockx_face_feature_t feature;
-    memset(&feature, 0, sizeof(rockx_face_feature_t));
+    return results;
+}
+
+bool FaceRecognitionManager::passesQualityGate(InferenceBackend* backend, const FaceQualityScorer& scorer,
+                                               PreparedFrame& frame, const QRect& box, FaceQualityStats& stats)
+{
+    if (!scorer.config().enabled) {
+        return true;
+    }
 
-    qDebug() << "FaceRecognitionManager: Extracting face features from aligned image...";
-    ret = rockx_face_recognize(m_faceRecognizeHandle, &alignedImage, &feature);
+    stats.evaluated++;
 
-    // 8. 安全释放对齐图像资源
-    if (alignedImage.data && alignedImage.size > 0) {
-        rockx_image_release(&alignedImage);
+    FaceQualityScore score = scorer.evaluate(frame.image, box);
+    if (score.passed() && scorer.needsLandmarks()) {
+        QPointF points[FaceQualityScorer::kLandmarkCount];
+        if (backend->landmarks(frame.image, box, points)) {
+            scorer.checkPose(score, points);
+        }
     }
 
-    if (ret != ROCKX_RET_SUCCESS) {
-        qDebug() << "FaceRecognitionManager: Face feature extraction failed, error:" << ret;
-        return QByteArray();
+    switch (score.verdict) {
+    case FaceQualityScore::Passed:
+        stats.passed++;
+        return true;
+    case FaceQualityScore::TooSmall:
+        stats.skippedTooSmall++;
+        break;
+    case FaceQualityScore::BadBrightness:
+        stats.skippedBrightness++;
+        break;
+    case FaceQualityScore::Blurry:
+        stats.skippedBlurry++;
+        break;
+    case FaceQualityScore::BadPose:
+        stats.skippedPose++;
+        break;
     }
+    return false;
+}
 
-    // 9. 转换为QByteArray格式
-    const int FEATURE_SIZE = 512 * sizeof(float);
-    QByteArray featureData(reinterpret_cast<const char*>(feature.feature), FEATURE_SIZE);
+void FaceRecognitionManager::setMaxImageSize(int width, int height)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxImageWidth = width;
+    m_maxImageHeight = height;
+}
 
-    // 10. 验证特征质量
-    if (!validateFeatureQuality(featureData)) {
-        qDebug() << "FaceRecognitionManager: Feature quality validation failed";
-        return QByteArray();
-    }
+void FaceRecognitionManager::setQualityConfig(const FaceQualityConfig& config)
+{
+    QMutexLocker locker(&m_mutex);
+    m_qualityScorer.setConfig(config);
+}
 
-    qDebug() << QString("FaceRecognitionManager: Feature extraction completed successfully - size: %1 bytes")
-                    .arg(featureData.size());
+FaceQualityStats FaceRecognitionManager::qualityStats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_qualityStats;
+}
 
-    return featureData;
+// ========== 单个人脸匹配 ==========
+FaceInfo FaceRecognitionManager::matchFace(const FaceInfo& face, const QByteArray& feature)
+{
+    FaceInfo faceInfo = face;
+
+    // 在数据库中查找最佳匹配（内存人脸库，按人员聚合）
+    // 所有推理线程共享同一份只读人脸库快照，人名直接取自快照，不再回查数据库
+    float similarity = 0.0f;
+    QString personName;
+    int matchId = m_database->findBestMatch(feature, similarity, m_recognitionThreshold, &personName);
+    faceInfo.similarity = similarity;
+
+    if (matchId > 0 && similarity >= m_recognitionThreshold) {
+        faceInfo.personName = personName;
+        faceInfo.faceId = matchId;
+        faceInfo.isRecognized = true;
+    }
+
+    return faceInfo;
 }
 
 bool FaceRecognitionManager::validateFeatureQuality(const QByteArray& feature)
 {
     if (feature.size() != 512 * sizeof(float)) {
-        qDebug() << "FaceRecognitionManager: Invalid feature size:" << feature.size();
+        svWarningEvery(lcFaceRecognition, 5000) << "FaceRecognitionManager: Invalid feature size:" << feature.size();
         return false;
     }
 
@@ -807,7 +902,7 @@ bool FaceRecognitionManager::validateFeatureQuality(const QByteArray& feature)
 
         // 检查是否包含无效值
         if (!std::isfinite(val)) {
-            qDebug() << "FaceRecognitionManager: Feature contains invalid value at index" << i;
+            svWarningEvery(lcFaceRecognition, 5000) << "FaceRecognitionManager: Feature contains invalid value at index" << i;
             return false;
         }
 
@@ -823,17 +918,17 @@ bool FaceRecognitionManager::validateFeatureQuality(const QByteArray& feature)
     float mean = sum / 512.0f;
     float variance = (sumSquares / 512.0f) - (mean * mean);
 
-    qDebug() << QString("FaceRecognitionManager: Feature statistics - Mean: %1, Variance: %2, NonZero: %3/512")
-                    .arg(mean, 0, 'f', 6).arg(variance, 0, 'f', 6).arg(nonZeroCount);
+    svDebug(lcFaceRecognition) << "FaceRecognitionManager: Feature statistics - Mean:" << mean
+                               << "Variance:" << variance << "NonZero:" << nonZeroCount << "/512";
 
     // 基本质量检查
     if (nonZeroCount < 100) {  // 至少20%的元素非零
-        qDebug() << "FaceRecognitionManager: Too few non-zero elements in feature";
+        svDebugEvery(lcFaceRecognition, 1000) << "FaceRecognitionManager: Too few non-zero elements in feature";
         return false;
     }
 
     if (variance < 1e-6) {  // 方差不能太小
-        qDebug() << "FaceRecognitionManager: Feature variance too small";
+        svDebugEvery(lcFaceRecognition, 1000) << "FaceRecognitionManager: Feature variance too small";
         return false;
     }
 
@@ -844,8 +939,6 @@ bool FaceRecognitionManager::validateFeatureQuality(const QByteArray& feature)
 // ========== 人脸注册功能 ==========
 bool FaceRecognitionManager::registerFace(const QString& name, const QImage& faceImage)
 {
-    QMutexLocker locker(&m_mutex);
-
     if (!m_initialized || name.trimmed().isEmpty() || faceImage.isNull()) {
         qDebug() << "FaceRecognitionManager: Invalid parameters for face registration";
         return false;
@@ -853,15 +946,23 @@ bool FaceRecognitionManager::registerFace(const QString& name, const QImage& fac
 
     qDebug() << "FaceRecognitionManager: Starting face registration for:" << name;
 
-    // 1. 检查是否已存在同名人脸
-    QStringList existingNames = getAllRegisteredNames();
-    if (existingNames.contains(name.trimmed(), Qt::CaseInsensitive)) {
-        qDebug() << "FaceRecognitionManager: Face with name already exists:" << name;
-        return false;
+    // 1. 同名人员已存在时作为新模板追加（不同姿态/光照）
+    if (m_database->faceExists(name.trimmed())) {
+        qDebug() << "FaceRecognitionManager: Adding another template for existing person:" << name;
     }
 
-    // 2. 提取人脸特征
-    QByteArray feature = extractFaceFeature(faceImage);
+    // 2. 提取人脸特征，检测置信度作为模板质量分
+    //    借用独立的推理上下文，注册不会阻塞其它线程的实时识别
+    float quality = 0.0f;
+    QByteArray feature;
+    {
+        InferencePool::Lease lease = m_pool.acquire();
+        if (!lease) {
+            qDebug() << "FaceRecognitionManager: No inference context available for registration";
+            return false;
+        }
+        feature = extractFaceFeature(lease.backend(), faceImage, &quality);
+    }
     if (feature.isEmpty()) {
         qDebug() << "FaceRecognitionManager: Failed to extract face feature for registration";
         return false;
@@ -876,27 +977,26 @@ bool FaceRecognitionManager::registerFace(const QString& name, const QImage& fac
 
     QString description = QString("Registered face for %1").arg(name);
 
-    if (!m_database->addFaceRecord(name.trimmed(), imagePath, feature, description)) {
+    if (!m_database->addFaceRecord(name.trimmed(), imagePath, feature, description, quality)) {
         qDebug() << "FaceRecognitionManager: Failed to add face record to database:" << name;
         return false;
     }
 
-    // 4. 保存图像文件 (可选)
-    QString fullImagePath = QCoreApplication::applicationDirPath() + "/data/" + imagePath;
-    QDir().mkpath(QFileInfo(fullImagePath).absolutePath());
-
-    if (!faceImage.save(fullImagePath)) {
-        qDebug() << "FaceRecognitionManager: Warning - failed to save face image:" << fullImagePath;
-        // 即使图像保存失败，数据库记录已添加，仍然返回成功
-    } else {
-        qDebug() << "FaceRecognitionManager: Face image saved:" << fullImagePath;
-    }
+    // 4. 🔧 保存图像文件（可选）：交给快照服务在后台编码写盘，注册线程不做 JPEG 编码与文件 I/O；
+    //    保存失败只在快照服务中记录警告，数据库记录已添加，仍然返回成功
+    //    图片与人脸库在同一数据目录下（setDataDirectory 指定时），否则为 <应用目录>/data
+    const QString dataRoot = m_dataDirectory.isEmpty() ? QCoreApplication::applicationDirPath() + "/data"
+                                                       : m_dataDirectory;
+    QString fullImagePath = dataRoot + "/" + imagePath;
+    SnapshotService::instance().saveImage(faceImage, fullImagePath);
+    qDebug() << "FaceRecognitionManager: Face image queued for saving:" << fullImagePath;
 
     qDebug() << "FaceRecognitionManager: Face registered successfully:" << name;
     return true;
 }
 
-QByteArray FaceRecognitionManager::extractFaceFeature(const QImage& faceImage)
+QByteArray FaceRecognitionManager::extractFaceFeature(InferenceBackend* backend, const QImage& faceImage,
+                                                      float* quality)
 {
     if (!m_initialized || faceImage.isNull()) {
         qDebug() << "FaceRecognitionManager: Cannot extract feature - not initialized or invalid image";
@@ -906,118 +1006,50 @@ QByteArray FaceRecognitionManager::extractFaceFeature(const QImage& faceImage)
     qDebug() << "FaceRecognitionManager: Starting feature extraction...";
     qDebug() << "Input image size:" << faceImage.size() << "format:" << faceImage.format();
 
-    // 🔧 1. 改进的图像预处理
-    QImage processedImage = preprocessImage(faceImage);
-    if (processedImage.isNull()) {
+    // 1. 预处理与检测（与识别路径共用同一套流程，保证注册/识别特征一致）
+    PreparedFrame frame;
+    if (!prepareFrame(faceImage, frame)) {
         qDebug() << "FaceRecognitionManager: Image preprocessing failed";
         return QByteArray();
     }
 
-    // 🔧 2. 安全的图像格式转换
-    rockx_image_t inputImage = qImageToRockxImage(processedImage);
-    if (!inputImage.data || inputImage.size == 0) {
-        qDebug() << "FaceRecognitionManager: Failed to convert image format";
-        return QByteArray();
-    }
-
-    // 3. 人脸检测 (确保有人脸)
-    rockx_object_array_t faceArray;
-    memset(&faceArray, 0, sizeof(rockx_object_array_t));
-
-    qDebug() << "FaceRecognitionManager: Starting face detection for feature extraction...";
-    rockx_ret_t ret = rockx_face_detect(m_faceDetHandle, &inputImage, &faceArray, nullptr);
-    if (ret != ROCKX_RET_SUCCESS) {
-        qDebug() << "FaceRecognitionManager: Face detection failed during feature extraction, error:" << ret;
-        return QByteArray();
-    }
-
-    if (faceArray.count == 0) {
+    QVector<QRect> boxes;
+    QVector<FaceInfo> faces = detectOnFrame(backend, frame, &boxes);
+    if (faces.isEmpty()) {
         qDebug() << "FaceRecognitionManager: No face found during feature extraction";
         return QByteArray();
     }
 
-    qDebug() << "FaceRecognitionManager: Found" << faceArray.count << "faces for feature extraction";
-
-    // 4. 选择最大的人脸
-    rockx_object_t* maxFace = getMaxFace(&faceArray);
-    if (!maxFace) {
-        qDebug() << "FaceRecognitionManager: Failed to get max face";
-        return QByteArray();
-    }
-
-    qDebug() << QString("FaceRecognitionManager: Max face selected - bbox=(%1,%2,%3,%4) score=%.3f")
-                    .arg(maxFace->box.left).arg(maxFace->box.top)
-                    .arg(maxFace->box.right).arg(maxFace->box.bottom)
-                    .arg(maxFace->score);
-
-    // 🔧 5. 改进的人脸对齐，增加错误处理
-    rockx_image_t alignedImage;
-    memset(&alignedImage, 0, sizeof(rockx_image_t));
-
-    qDebug() << "FaceRecognitionManager: Starting face alignment...";
-    ret = rockx_face_align(m_faceLandmarkHandle, &inputImage, &(maxFace->box), nullptr, &alignedImage);
-    if (ret != ROCKX_RET_SUCCESS) {
-        qDebug() << "FaceRecognitionManager: Face align failed, error:" << ret;
-        qDebug() << "This might be due to RGA hardware acceleration issues";
-
-        // 🔧 如果RGA失败，可以尝试跳过对齐直接进行识别
-        qDebug() << "FaceRecognitionManager: Attempting feature extraction without alignment...";
-
-        // 裁剪人脸区域作为替代方案
-        QRect faceRect(maxFace->box.left, maxFace->box.top,
-                       maxFace->box.right - maxFace->box.left,
-                       maxFace->box.bottom - maxFace->box.top);
-
-        // 确保裁剪区域在图像边界内
-        faceRect = faceRect.intersected(QRect(0, 0, processedImage.width(), processedImage.height()));
-
-        if (faceRect.isEmpty()) {
-            qDebug() << "FaceRecognitionManager: Invalid face rectangle";
-            return QByteArray();
-        }
-
-        QImage croppedFace = processedImage.copy(faceRect);
-        if (croppedFace.isNull()) {
-            qDebug() << "FaceRecognitionManager: Failed to crop face image";
-            return QByteArray();
-        }
-
-        // 重新转换裁剪后的图像
-        alignedImage = qImageToRockxImage(croppedFace);
-        if (!alignedImage.data) {
-            qDebug() << "FaceRecognitionManager: Failed to convert cropped face image";
-            return QByteArray();
+    // 2. 选择最大的人脸
+    int maxIndex = 0;
+    for (int i = 1; i < faces.size(); ++i) {
+        const QRect& cur = faces[i].bbox;
+        const QRect& best = faces[maxIndex].bbox;
+        if (cur.width() * cur.height() > best.width() * best.height()) {
+            maxIndex = i;
         }
-
-        qDebug() << "FaceRecognitionManager: Using cropped face instead of aligned face";
-    } else {
-        qDebug() << "FaceRecognitionManager: Face aligned successfully";
     }
 
-    // 6. 特征提取
-    rockx_face_feature_t feature;
-    memset(&feature, 0, sizeof(rockx_face_feature_t));
-
-    qDebug() << "FaceRecognitionManager: Extracting face features...";
-    ret = rockx_face_recognize(m_faceRecognizeHandle, &alignedImage, &feature);
+    // 3. 对齐并提取特征（单张人脸的批）
+    FaceCropTicket ticket;
+    ticket.bbox = faces[maxIndex].bbox;
+    ticket.confidence = faces[maxIndex].confidence;
 
-    // 🔧 7. 安全释放对齐图像资源
-    if (alignedImage.data && alignedImage.size > 0) {
-        // 只有当alignedImage是由RockX分配的才需要释放
-        // 如果是我们自己转换的图像，则不需要调用rockx_image_release
-        if (ret == ROCKX_RET_SUCCESS) {
-            rockx_image_release(&alignedImage);
-        }
+    FaceBatch batch;
+    if (!alignFaceInto(backend, frame, boxes[maxIndex], ticket, batch)) {
+        qDebug() << "FaceRecognitionManager: Failed to align face for feature extraction";
+        return QByteArray();
     }
 
-    if (ret != ROCKX_RET_SUCCESS) {
-        qDebug() << "FaceRecognitionManager: Face feature extraction failed, error:" << ret;
+    const QByteArray featureData = embedBatch(backend, batch).value(0);
+    if (featureData.isEmpty()) {
+        qDebug() << "FaceRecognitionManager: Face feature extraction failed";
         return QByteArray();
     }
 
-    // 8. 将特征数据转换为QByteArray
-    const int FEATURE_SIZE = 512 * sizeof(float);
-    QByteArray featureData(reinterpret_cast<const char*>(feature.feature), FEATURE_SIZE);
+    if (quality) {
+        *quality = ticket.confidence;
+    }
 
     qDebug() << QString("FaceRecognitionManager: Feature extraction completed successfully - size: %1 bytes")
                     .arg(featureData.size());
@@ -1041,10 +1073,8 @@ void FaceRecognitionManager::testBasicFunctionality()
     qDebug() << "✓ Detection threshold:" << m_detectionThreshold;
     qDebug() << "✓ Recognition threshold:" << m_recognitionThreshold;
 
-    // 测试句柄状态
-    qDebug() << "✓ Face detection handle:" << (m_faceDetHandle ? "OK" : "NULL");
-    qDebug() << "✓ Face landmark handle:" << (m_faceLandmarkHandle ? "OK" : "NULL");
-    qDebug() << "✓ Face recognition handle:" << (m_faceRecognizeHandle ? "OK" : "NULL");
+    // 测试后端状态
+    qDebug() << "✓ Inference backend:" << m_pool.backendName() << "-" << m_pool.summary();
 
     qDebug() << "========== Basic Test Completed ==========";
 }
@@ -7,9 +7,18 @@
 #include <QMutex>
 #include <QTimer>
 #include <QDebug>
-#include <rockx.h>
+#include <atomic>
 #include "aitypes.h"
 #include "facedatabase.h"
+#include "facebatchscheduler.h"
+#include "inferencepool.h"
+#include "facequality.h"
+
+// 🆕 攒批识别的单张人脸结果（ticket 指明所属来源/帧/下标）
+struct QueuedFaceResult {
+    FaceCropTicket ticket;
+    FaceInfo face;
+};
 
 class FaceRecognitionManager : public QObject
 {
@@ -24,10 +33,38 @@ public:
     bool isInitialized() const { return m_initialized; }
     void setDetectionThreshold(float threshold) { m_detectionThreshold = threshold; }
     void setRecognitionThreshold(float threshold) { m_recognitionThreshold = threshold; }
+    // 🆕 检测工作分辨率（等比缩放到该尺寸以内，<=0 表示不限制）
+    void setMaxImageSize(int width, int height);
+    void setTemplatePolicy(TemplateAggregation aggregation, int topN, int maxTemplatesPerPerson);
+    // 🆕 人脸库数据目录（数据库位于 <dir>/database，注册图片位于 <dir>/faces），需在 initialize 前设置；
+    //    为空时数据库自动探测可写目录，注册图片写到 <应用目录>/data/faces
+    void setDataDirectory(const QString& dir) { m_dataDirectory = dir; }
+
+    // 🆕 推理后端（"rockx" / "cpu"，见 InferenceBackendRegistry），已初始化时会立即切换；
+    //    切换在调用线程加载模型，期间检测继续使用旧上下文，失败时保持原后端
+    void setInferenceBackend(const QString& name);
+    QString inferenceBackendName() const;
+
+    // 🆕 推理上下文池：大小即可并行检测/提取特征的线程数，已初始化时会立即重建
+    void setInferencePoolSize(int size);
+    InferencePool* inferencePool() { return &m_pool; }
+
+    // 🆕 特征提取前的质量门限
+    void setQualityConfig(const FaceQualityConfig& config);
+    FaceQualityStats qualityStats() const;
 
     // 🎯 核心功能接口
     QVector<FaceInfo> detectFaces(const QImage& image);
-    QVector<FaceInfo> detectAndRecognizeFaces(const QImage& image);
+    QVector<FaceInfo> detectAndRecognizeFaces(const QImage& image, int sourceId = 0);
+    // 🆕 降级调度用：只检测，命中同来源近期轨迹的沿用其识别结果，不做特征提取
+    QVector<FaceInfo> detectAndReuseFaces(const QImage& image, int sourceId);
+
+    // 🆕 跨帧攒批识别：先检测并对齐入队（返回的人脸尚未识别），
+    // 到期（批满或超过截止时间）后由 recognizeQueuedFaces 统一提取特征并匹配
+    QVector<FaceInfo> detectAndQueueFaces(const QImage& image, int sourceId, quint64 frameId,
+                                          int* queuedCount = nullptr);
+    QVector<QueuedFaceResult> recognizeQueuedFaces(bool force = false);
+    FaceBatchScheduler* batchScheduler() { return &m_batchScheduler; }
 
     // 👤 人脸管理接口
     bool registerFace(const QString& name, const QImage& faceImage);
@@ -47,19 +84,26 @@ signals:
     void initializationFailed(const QString& reason);
 
 private:
-    // 🔧 RockX句柄（参考官方示例）
-    rockx_handle_t m_faceDetHandle;
-    rockx_handle_t m_faceLandmarkHandle;  // 5点关键点
-    rockx_handle_t m_faceRecognizeHandle;
+    void reconfigurePool(const QString& backendName, int size);
+
+    // 🆕 推理上下文池（检测/对齐/特征提取），推理期间不持有 m_mutex
+    InferencePool m_pool;
+    QMutex m_reconfigureMutex;          // 串行化推理池重建
+    QString m_backendName;
+    int m_poolSize;
+    QStringList m_requiredModelFiles;
 
     // 📊 状态管理
-    bool m_initialized;
-    mutable QMutex m_mutex;
+    std::atomic<bool> m_initialized;
+    mutable QMutex m_mutex;             // 保护配置、统计、质量门限与轨迹缓存，只做短暂持有
     QString m_modelPath;
+    QString m_dataDirectory;
 
     // ⚙️ 配置参数
     float m_detectionThreshold;
     float m_recognitionThreshold;
+    int m_maxImageWidth;
+    int m_maxImageHeight;
 
     // 🗄️ 数据库管理
     FaceDatabase* m_database;
@@ -70,30 +114,51 @@ private:
     int m_detectionCount;
     int m_recognitionCount;
 
-    mutable QImage m_imageBuffer;  // 图像缓存
-    mutable QByteArray m_dataBuffer; // 数据缓存
+    // 🆕 批量特征提取
+    FaceBatchScheduler m_batchScheduler;  // 跨帧待识别人脸（单帧对齐缓冲随推理上下文复用）
+
+    // 🆕 质量门限与轨迹沿用
+    FaceQualityScorer m_qualityScorer;
+    FaceQualityStats m_qualityStats;
+    FaceTrackCache m_trackCache;
+
+    // 🆕 每帧只预处理一次，检测与所有人脸对齐共用
+    struct PreparedFrame {
+        QImage image;               // RGB888 处理帧
+        float scaleX = 1.0f;        // 处理帧宽 / 原始帧宽
+        float scaleY = 1.0f;        // 处理帧高 / 原始帧高
+    };
 
     // 🔨 私有方法
-    bool initializeRockX();
+    bool probeBackend();
+    QString findModelPath(const QString& modelPath);
     void cleanup();
     bool validateModelFiles(const QString& modelPath);
 
     // 🖼️ 图像处理方法
-    rockx_image_t qImageToRockxImage(const QImage& image);
     QImage preprocessImage(const QImage& image);
+    bool prepareFrame(const QImage& image, PreparedFrame& frame);
 
     // 🎯 核心算法方法
-    QVector<FaceInfo> processDetection(const QImage& image);
-    FaceInfo processRecognition(const FaceInfo& detectedFace, const QImage& originalImage);
-    QByteArray extractFaceFeature(const QImage& faceImage);
-
-    QByteArray extractFaceFeatureFromDetectedFace(const QImage& originalImage, const QRect& faceRect);
+    // 检测结果的 bbox 已换算回原始帧坐标，boxes 保留处理帧坐标供对齐使用
+    // 🆕 以下方法使用调用方借出的推理上下文，不持有 m_mutex
+    QVector<FaceInfo> detectOnFrame(InferenceBackend* backend, PreparedFrame& frame,
+                                    QVector<QRect>* boxes = nullptr);
+    bool alignFaceInto(InferenceBackend* backend, PreparedFrame& frame, const QRect& box,
+                       const FaceCropTicket& ticket, FaceBatch& batch);
+    QVector<QByteArray> embedBatch(InferenceBackend* backend, const FaceBatch& batch);
+    FaceInfo matchFace(const FaceInfo& face, const QByteArray& feature);
+    QVector<FaceInfo> detectAndAlign(InferenceBackend* backend, const QImage& image,
+                                     int sourceId, quint64 frameId, FaceBatch& batch);
+    QVector<QueuedFaceResult> recognizeBatch(InferenceBackend* backend, const FaceBatch& batch);
+    bool passesQualityGate(InferenceBackend* backend, const FaceQualityScorer& scorer,
+                           PreparedFrame& frame, const QRect& box, FaceQualityStats& stats);
+    QByteArray extractFaceFeature(InferenceBackend* backend, const QImage& faceImage, float* quality = nullptr);
 
     // 新增：特征质量验证
     bool validateFeatureQuality(const QByteArray& feature);
 
     // 🛠️ 辅助方法
-    rockx_object_t* getMaxFace(rockx_object_array_t* faceArray);
     void logPerformance(const QString& operation, float timeMs);
 };
 
@@ -0,0 +1,114 @@
+// ai/framesignature.cpp
+#include "framesignature.h"
+#include <QVector>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// 每个块每个方向约采样 kSamplesPerBlock 个点
+const int kSamplesPerBlock = 12;
+
+// BT.601 近似亮度，8bit 定点
+inline int luma(int r, int g, int b)
+{
+    return (r * 77 + g * 150 + b * 29) >> 8;
+}
+
+} // namespace
+
+FrameSignature::FrameSignature()
+    : m_valid(false)
+{
+    memset(m_blocks, 0, sizeof(m_blocks));
+}
+
+FrameSignature FrameSignature::compute(const QImage& image)
+{
+    FrameSignature signature;
+    if (image.isNull() || image.width() < kGridWidth || image.height() < kGridHeight) {
+        return signature;
+    }
+
+    QImage source = image;
+    const QImage::Format format = source.format();
+    if (format != QImage::Format_RGB888 && format != QImage::Format_Grayscale8 &&
+        format != QImage::Format_RGB32 && format != QImage::Format_ARGB32) {
+        source = source.convertToFormat(QImage::Format_RGB888);
+    }
+
+    const int width = source.width();
+    const int height = source.height();
+    const int stepX = qMax(1, width / (kGridWidth * kSamplesPerBlock));
+    const int stepY = qMax(1, height / (kGridHeight * kSamplesPerBlock));
+
+    // 采样列所属的块号预先算好，内层循环只做累加
+    QVector<int> columnBlock;
+    columnBlock.reserve(width / stepX + 1);
+    for (int x = 0; x < width; x += stepX) {
+        columnBlock.append(x * kGridWidth / width);
+    }
+    const int columns = columnBlock.size();
+    const int* blockOf = columnBlock.constData();
+
+    quint32 sums[kBlockCount];
+    quint32 counts[kBlockCount];
+    memset(sums, 0, sizeof(sums));
+    memset(counts, 0, sizeof(counts));
+
+    for (int y = 0; y < height; y += stepY) {
+        const uchar* line = source.constScanLine(y);
+        const int rowBase = (y * kGridHeight / height) * kGridWidth;
+        quint32* rowSums = sums + rowBase;
+        quint32* rowCounts = counts + rowBase;
+
+        switch (source.format()) {
+        case QImage::Format_Grayscale8:
+            for (int i = 0; i < columns; ++i) {
+                rowSums[blockOf[i]] += line[i * stepX];
+                rowCounts[blockOf[i]]++;
+            }
+            break;
+        case QImage::Format_RGB888:
+            for (int i = 0; i < columns; ++i) {
+                const uchar* p = line + i * stepX * 3;
+                rowSums[blockOf[i]] += luma(p[0], p[1], p[2]);
+                rowCounts[blockOf[i]]++;
+            }
+            break;
+        default: {
+            // RGB32 / ARGB32：按 QRgb 读取，与字节序无关
+            const QRgb* pixels = reinterpret_cast<const QRgb*>(line);
+            for (int i = 0; i < columns; ++i) {
+                const QRgb p = pixels[i * stepX];
+                rowSums[blockOf[i]] += luma(qRed(p), qGreen(p), qBlue(p));
+                rowCounts[blockOf[i]]++;
+            }
+            break;
+        }
+        }
+    }
+
+    for (int i = 0; i < kBlockCount; ++i) {
+        signature.m_blocks[i] = counts[i] ? uchar((sums[i] + counts[i] / 2) / counts[i]) : 0;
+    }
+
+    signature.m_frameSize = image.size();
+    signature.m_valid = true;
+    return signature;
+}
+
+int FrameSignature::changedBlocks(const FrameSignature& other, int tolerance) const
+{
+    if (!m_valid || !other.m_valid || m_frameSize != other.m_frameSize) {
+        return kBlockCount;
+    }
+
+    int changed = 0;
+    for (int i = 0; i < kBlockCount; ++i) {
+        if (std::abs(int(m_blocks[i]) - int(other.m_blocks[i])) > tolerance) {
+            ++changed;
+        }
+    }
+    return changed;
+}
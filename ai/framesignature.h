@@ -0,0 +1,35 @@
+// ai/framesignature.h
+#ifndef FRAMESIGNATURE_H
+#define FRAMESIGNATURE_H
+
+#include <QImage>
+#include <QSize>
+
+// 🆕 帧签名：32x24 网格的亮度块均值（稀疏采样，1080p 每块约 12x12 个采样点）
+// 两帧比较时统计均值变化超过容差的块数，用于跳过静止画面的重复分析。
+// 与 64 位 dHash 相比，单块只覆盖画面的 1/768，小目标进入画面也能被发现，
+// 且容差可吸收传感器噪声
+class FrameSignature
+{
+public:
+    static const int kGridWidth = 32;
+    static const int kGridHeight = 24;
+    static const int kBlockCount = kGridWidth * kGridHeight;
+
+    FrameSignature();
+
+    static FrameSignature compute(const QImage& image);
+
+    bool isValid() const { return m_valid; }
+    QSize frameSize() const { return m_frameSize; }
+
+    // 均值变化超过 tolerance 的块数；任一签名无效或分辨率不同时返回 kBlockCount
+    int changedBlocks(const FrameSignature& other, int tolerance) const;
+
+private:
+    QSize m_frameSize;
+    bool m_valid;
+    uchar m_blocks[kBlockCount];
+};
+
+#endif // FRAMESIGNATURE_H
@@ -0,0 +1,248 @@
+// ai/gallerysnapshot.cpp
+#include "gallerysnapshot.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = { 'S', 'V', 'G', 'A', 'L', 'L', 'R', 'Y' };
+const quint32 kEndianTag = 0x01020304;
+const quint64 kSectionAlign = 64;
+
+struct SnapshotHeader {
+    char magic[8];
+    quint32 version;
+    quint32 headerSize;
+    quint32 endianTag;
+    quint32 featureDim;
+    quint32 personCount;
+    quint32 templateCount;
+    quint64 generation;
+    quint64 featureOffset;
+    quint64 templateIdOffset;
+    quint64 personOffset;
+    quint64 stringPoolOffset;
+    quint64 stringPoolSize;
+    quint64 fileSize;
+    quint32 metaChecksum;      // 模板ID表 + 人员表 + 字符串池
+    quint32 featureChecksum;   // 特征矩阵
+    quint32 headerChecksum;    // 本字段置0后的头部
+    quint32 reserved;
+};
+
+static_assert(sizeof(SnapshotHeader) == 104, "SnapshotHeader layout changed");
+static_assert(sizeof(FaceGallery::PersonRecord) == 20, "PersonRecord layout changed");
+
+quint64 alignUp(quint64 value)
+{
+    return (value + kSectionAlign - 1) & ~(kSectionAlign - 1);
+}
+
+quint32 headerChecksum(SnapshotHeader header)
+{
+    header.headerChecksum = 0;
+    return GallerySnapshot::crc32(&header, sizeof(header));
+}
+
+bool sectionInRange(quint64 offset, quint64 size, quint64 fileSize)
+{
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+bool writePadding(QSaveFile& file, quint64 target)
+{
+    static const char zeros[kSectionAlign] = {};
+    quint64 pos = quint64(file.pos());
+    if (pos > target) {
+        return false;
+    }
+    return file.write(zeros, qint64(target - pos)) == qint64(target - pos);
+}
+
+} // namespace
+
+quint32 GallerySnapshot::crc32(const void* data, size_t size, quint32 crc)
+{
+    static quint32 table[256];
+    static const bool tableReady = [] {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            table[i] = c;
+        }
+        return true;
+    }();
+    Q_UNUSED(tableReady);
+
+    const uchar* p = static_cast<const uchar*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+bool GallerySnapshot::save(const FaceGallery& gallery, const QString& path, quint64 generation)
+{
+    const quint64 featureBytes = quint64(gallery.templateCount()) * FaceGallery::kFeatureDim * sizeof(float);
+    const quint64 templateIdBytes = quint64(gallery.templateCount()) * sizeof(qint32);
+    const quint64 personBytes = quint64(gallery.personCount()) * sizeof(FaceGallery::PersonRecord);
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.endianTag = kEndianTag;
+    header.featureDim = FaceGallery::kFeatureDim;
+    header.personCount = gallery.personCount();
+    header.templateCount = gallery.templateCount();
+    header.generation = generation;
+    header.featureOffset = alignUp(sizeof(SnapshotHeader));
+    header.templateIdOffset = alignUp(header.featureOffset + featureBytes);
+    header.personOffset = alignUp(header.templateIdOffset + templateIdBytes);
+    header.stringPoolOffset = alignUp(header.personOffset + personBytes);
+    header.stringPoolSize = gallery.stringPoolSize();
+    header.fileSize = header.stringPoolOffset + header.stringPoolSize;
+
+    quint32 meta = crc32(gallery.templateIds(), templateIdBytes);
+    meta = crc32(gallery.personRecords(), personBytes, meta);
+    meta = crc32(gallery.stringPool(), header.stringPoolSize, meta);
+    header.metaChecksum = meta;
+    header.featureChecksum = crc32(gallery.featureData(), featureBytes);
+    header.headerChecksum = headerChecksum(header);
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "❌ 无法写入人脸库快照:" << path << file.errorString();
+        return false;
+    }
+
+    bool ok = file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == qint64(sizeof(header))
+              && writePadding(file, header.featureOffset)
+              && file.write(reinterpret_cast<const char*>(gallery.featureData()), featureBytes) == qint64(featureBytes)
+              && writePadding(file, header.templateIdOffset)
+              && file.write(reinterpret_cast<const char*>(gallery.templateIds()), templateIdBytes) == qint64(templateIdBytes)
+              && writePadding(file, header.personOffset)
+              && file.write(reinterpret_cast<const char*>(gallery.personRecords()), personBytes) == qint64(personBytes)
+              && writePadding(file, header.stringPoolOffset)
+              && file.write(gallery.stringPool(), header.stringPoolSize) == qint64(header.stringPoolSize);
+
+    if (!ok) {
+        qWarning() << "❌ 写入人脸库快照失败:" << path << file.errorString();
+        file.cancelWriting();
+        return false;
+    }
+
+    if (!file.commit()) {
+        qWarning() << "❌ 提交人脸库快照失败:" << path << file.errorString();
+        return false;
+    }
+
+    qDebug() << "💾 人脸库快照已更新:" << path
+             << "人员:" << header.personCount << "模板:" << header.templateCount
+             << "代数:" << generation;
+    return true;
+}
+
+QSharedPointer<const FaceGallery> GallerySnapshot::load(const QString& path, quint64 expectedGeneration,
+                                                        Verify verify)
+{
+    std::unique_ptr<QFile> file(new QFile(path));
+    if (!file->exists() || !file->open(QIODevice::ReadOnly)) {
+        return QSharedPointer<const FaceGallery>();
+    }
+
+    const quint64 fileSize = quint64(file->size());
+    if (fileSize < sizeof(SnapshotHeader)) {
+        qWarning() << "⚠️ 人脸库快照过短，忽略:" << path;
+        return QSharedPointer<const FaceGallery>();
+    }
+
+    // 只读映射：页面由内核按需换入，多个进程可共享同一份页缓存
+    const uchar* base = file->map(0, qint64(fileSize));
+    if (!base) {
+        qWarning() << "⚠️ 人脸库快照映射失败:" << path << file->errorString();
+        return QSharedPointer<const FaceGallery>();
+    }
+
+    SnapshotHeader header;
+    std::memcpy(&header, base, sizeof(header));
+
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0
+        || header.version != kFormatVersion
+        || header.headerSize != sizeof(SnapshotHeader)
+        || header.endianTag != kEndianTag
+        || header.featureDim != quint32(FaceGallery::kFeatureDim)
+        || header.fileSize != fileSize
+        || header.headerChecksum != headerChecksum(header)) {
+        qWarning() << "⚠️ 人脸库快照格式不兼容或头部损坏，忽略:" << path;
+        return QSharedPointer<const FaceGallery>();
+    }
+
+    if (header.generation != expectedGeneration) {
+        qDebug() << "ℹ️ 人脸库快照已过期，代数:" << header.generation << "期望:" << expectedGeneration;
+        return QSharedPointer<const FaceGallery>();
+    }
+
+    const quint64 featureBytes = quint64(header.templateCount) * header.featureDim * sizeof(float);
+    const quint64 templateIdBytes = quint64(header.templateCount) * sizeof(qint32);
+    const quint64 personBytes = quint64(header.personCount) * sizeof(FaceGallery::PersonRecord);
+
+    if (header.featureOffset % kSectionAlign != 0
+        || header.templateIdOffset % sizeof(qint32) != 0
+        || header.personOffset % sizeof(qint32) != 0
+        || !sectionInRange(header.featureOffset, featureBytes, fileSize)
+        || !sectionInRange(header.templateIdOffset, templateIdBytes, fileSize)
+        || !sectionInRange(header.personOffset, personBytes, fileSize)
+        || !sectionInRange(header.stringPoolOffset, header.stringPoolSize, fileSize)) {
+        qWarning() << "⚠️ 人脸库快照段越界，忽略:" << path;
+        return QSharedPointer<const FaceGallery>();
+    }
+
+    quint32 meta = crc32(base + header.templateIdOffset, templateIdBytes);
+    meta = crc32(base + header.personOffset, personBytes, meta);
+    meta = crc32(base + header.stringPoolOffset, header.stringPoolSize, meta);
+    if (meta != header.metaChecksum) {
+        qWarning() << "⚠️ 人脸库快照元数据校验失败，忽略:" << path;
+        return QSharedPointer<const FaceGallery>();
+    }
+
+    if (verify == Verify::Full
+        && crc32(base + header.featureOffset, featureBytes) != header.featureChecksum) {
+        qWarning() << "⚠️ 人脸库快照特征校验失败，忽略:" << path;
+        return QSharedPointer<const FaceGallery>();
+    }
+
+    // 人员表索引必须落在模板与字符串池范围内，避免比对时越界
+    const FaceGallery::PersonRecord* persons =
+        reinterpret_cast<const FaceGallery::PersonRecord*>(base + header.personOffset);
+    for (quint32 i = 0; i < header.personCount; ++i) {
+        const FaceGallery::PersonRecord& p = persons[i];
+        if (quint64(p.firstTemplate) + p.templateCount > header.templateCount
+            || quint64(p.nameOffset) + p.nameLength > header.stringPoolSize) {
+            qWarning() << "⚠️ 人脸库快照人员表损坏，忽略:" << path;
+            return QSharedPointer<const FaceGallery>();
+        }
+    }
+
+    QSharedPointer<FaceGallery> gallery(new FaceGallery);
+    gallery->m_mappedFeatures = reinterpret_cast<const float*>(base + header.featureOffset);
+    gallery->m_mappedTemplateIds = reinterpret_cast<const qint32*>(base + header.templateIdOffset);
+    gallery->m_mappedPersons = persons;
+    gallery->m_mappedStringPool = reinterpret_cast<const char*>(base + header.stringPoolOffset);
+    gallery->m_mappedStringPoolSize = int(header.stringPoolSize);
+    gallery->m_personCount = int(header.personCount);
+    gallery->m_templateCount = int(header.templateCount);
+    gallery->m_mappedFile = std::move(file);
+
+    return gallery;
+}
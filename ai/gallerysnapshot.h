@@ -0,0 +1,41 @@
+// ai/gallerysnapshot.h
+#ifndef GALLERYSNAPSHOT_H
+#define GALLERYSNAPSHOT_H
+
+#include <QString>
+#include <QSharedPointer>
+#include <QtGlobal>
+#include "facegallery.h"
+
+// 🆕 人脸库二进制快照
+// SQLite 仍是唯一可信数据源；快照只是 FaceGallery 的只读镜像，
+// 启动时直接 mmap 文件即可比对，无需逐行读取并反序列化 BLOB。
+//
+// 文件布局（本机字节序，各段按64字节对齐）：
+//   Header | 特征矩阵 float[templateCount][dim]（已归一化）
+//          | 模板ID表 int32[templateCount]
+//          | 人员表 PersonRecord[personCount]
+//          | 字符串池（UTF-8姓名）
+// Header 记录格式版本、数据库代数（generation）以及各段的 CRC32，
+// 代数与数据库不一致或校验失败时视为失效，由调用方从 SQLite 重建。
+class GallerySnapshot
+{
+public:
+    static const quint32 kFormatVersion = 1;
+
+    enum class Verify {
+        Metadata,   // 校验头部与ID/人员/字符串段（默认，开销与人数成正比）
+        Full        // 额外校验整个特征矩阵
+    };
+
+    // 原子写入（QSaveFile：写临时文件后 rename），失败时旧快照保持不变
+    static bool save(const FaceGallery& gallery, const QString& path, quint64 generation);
+
+    // 只读映射快照；expectedGeneration 与文件记录不一致时返回空指针
+    static QSharedPointer<const FaceGallery> load(const QString& path, quint64 expectedGeneration,
+                                                  Verify verify = Verify::Metadata);
+
+    static quint32 crc32(const void* data, size_t size, quint32 crc = 0);
+};
+
+#endif // GALLERYSNAPSHOT_H
@@ -0,0 +1,353 @@
+// ai/imageresampler.cpp
+#include "imageresampler.h"
+#include <QVector>
+#include <QtGlobal>
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SV_RESAMPLE_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SV_RESAMPLE_SSE2 1
+#endif
+
+namespace {
+
+// 双线性权重精度：水平/垂直各 7bit，行缓冲最大 255*128 = 32640（不超过 int16）
+const int kWeightBits = 7;
+const int kWeightOne = 1 << kWeightBits;
+const int kVerticalShift = kWeightBits * 2;
+
+// 面积插值的盒大小上限：16bit 累加器最多容纳 257 行；32bit 盒内求和最多容纳 65536 列
+//（255 * 257 * 65536 < 2^32）
+const int kAreaMaxRows = 257;
+const int kAreaMaxColumns = 65536;
+
+struct BilinearTap {
+    int offset0;    // 左侧像素字节偏移
+    int offset1;    // 右侧像素字节偏移
+    int weight;     // 右侧像素权重 [0, kWeightOne)
+};
+
+// 像素中心对齐的源坐标，返回整数部分与 7bit 小数权重
+inline void mapCoordinate(int dst, double scale, int srcSize, int* i0, int* i1, int* weight)
+{
+    double s = (dst + 0.5) * scale - 0.5;
+    if (s < 0.0) {
+        s = 0.0;
+    }
+
+    int base = int(s);
+    int w = int((s - base) * kWeightOne + 0.5);
+    if (w >= kWeightOne) {
+        ++base;
+        w = 0;
+    }
+
+    if (base >= srcSize - 1) {
+        base = srcSize - 1;
+        w = 0;
+    }
+
+    *i0 = base;
+    *i1 = qMin(base + 1, srcSize - 1);
+    *weight = w;
+}
+
+template <int CH>
+void horizontalBilinear(const uchar* src, const BilinearTap* taps, int dstWidth, quint16* out)
+{
+    for (int x = 0; x < dstWidth; ++x) {
+        const uchar* p0 = src + taps[x].offset0;
+        const uchar* p1 = src + taps[x].offset1;
+        const int w1 = taps[x].weight;
+        const int w0 = kWeightOne - w1;
+        for (int c = 0; c < CH; ++c) {
+            out[c] = quint16(p0[c] * w0 + p1[c] * w1);
+        }
+        out += CH;
+    }
+}
+
+void horizontalBilinear(const uchar* src, const BilinearTap* taps, int dstWidth, int channels, quint16* out)
+{
+    switch (channels) {
+    case 1: horizontalBilinear<1>(src, taps, dstWidth, out); break;
+    case 3: horizontalBilinear<3>(src, taps, dstWidth, out); break;
+    default: horizontalBilinear<4>(src, taps, dstWidth, out); break;
+    }
+}
+
+// dst[i] = (row0[i] * (128 - wy) + row1[i] * wy) >> 14（四舍五入）
+void verticalBilinear(const quint16* row0, const quint16* row1, int count, int wy, uchar* dst)
+{
+    const int w0 = kWeightOne - wy;
+    int i = 0;
+
+#if defined(SV_RESAMPLE_NEON)
+    for (; i + 8 <= count; i += 8) {
+        const uint16x8_t a = vld1q_u16(row0 + i);
+        const uint16x8_t b = vld1q_u16(row1 + i);
+        uint32x4_t lo = vmull_n_u16(vget_low_u16(a), quint16(w0));
+        uint32x4_t hi = vmull_n_u16(vget_high_u16(a), quint16(w0));
+        lo = vmlal_n_u16(lo, vget_low_u16(b), quint16(wy));
+        hi = vmlal_n_u16(hi, vget_high_u16(b), quint16(wy));
+        const uint16x8_t sum = vcombine_u16(vrshrn_n_u32(lo, kVerticalShift),
+                                            vrshrn_n_u32(hi, kVerticalShift));
+        vst1_u8(dst + i, vqmovn_u16(sum));
+    }
+#elif defined(SV_RESAMPLE_SSE2)
+    // 交错 (row0, row1) 后用 madd 一次完成两项乘加
+    const __m128i weights = _mm_set1_epi32((wy << 16) | w0);
+    const __m128i round = _mm_set1_epi32(1 << (kVerticalShift - 1));
+    for (; i + 8 <= count; i += 8) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i));
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(a, b), weights);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(a, b), weights);
+        lo = _mm_srai_epi32(_mm_add_epi32(lo, round), kVerticalShift);
+        hi = _mm_srai_epi32(_mm_add_epi32(hi, round), kVerticalShift);
+        const __m128i packed = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(packed, packed));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        dst[i] = uchar((row0[i] * w0 + row1[i] * wy + (1 << (kVerticalShift - 1))) >> kVerticalShift);
+    }
+}
+
+// acc[i] += src[i]
+void accumulateRow(const uchar* src, int count, quint16* acc)
+{
+    int i = 0;
+
+#if defined(SV_RESAMPLE_NEON)
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t s = vld1q_u8(src + i);
+        vst1q_u16(acc + i, vaddw_u8(vld1q_u16(acc + i), vget_low_u8(s)));
+        vst1q_u16(acc + i + 8, vaddw_u8(vld1q_u16(acc + i + 8), vget_high_u8(s)));
+    }
+#elif defined(SV_RESAMPLE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+        _mm_storeu_si128(a, _mm_add_epi16(_mm_loadu_si128(a), _mm_unpacklo_epi8(s, zero)));
+        _mm_storeu_si128(a + 1, _mm_add_epi16(_mm_loadu_si128(a + 1), _mm_unpackhi_epi8(s, zero)));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        acc[i] = quint16(acc[i] + src[i]);
+    }
+}
+
+bool resizeBilinear(const uchar* src, int srcWidth, int srcHeight, int srcStride,
+                    uchar* dst, int dstWidth, int dstHeight, int dstStride, int channels)
+{
+    const double scaleX = double(srcWidth) / dstWidth;
+    const double scaleY = double(srcHeight) / dstHeight;
+
+    QVector<BilinearTap> taps(dstWidth);
+    for (int x = 0; x < dstWidth; ++x) {
+        int x0, x1, w;
+        mapCoordinate(x, scaleX, srcWidth, &x0, &x1, &w);
+        taps[x].offset0 = x0 * channels;
+        taps[x].offset1 = x1 * channels;
+        taps[x].weight = w;
+    }
+
+    // 两行水平插值缓冲；相邻目标行常共用源行，按行号缓存
+    const int rowCount = dstWidth * channels;
+    QVector<quint16> buffer(rowCount * 2);
+    quint16* rows[2] = { buffer.data(), buffer.data() + rowCount };
+    int cached[2] = { -1, -1 };
+
+    for (int y = 0; y < dstHeight; ++y) {
+        int y0, y1, wy;
+        mapCoordinate(y, scaleY, srcHeight, &y0, &y1, &wy);
+
+        if (cached[0] != y0) {
+            if (cached[1] == y0) {
+                qSwap(rows[0], rows[1]);
+                qSwap(cached[0], cached[1]);
+            } else {
+                horizontalBilinear(src + size_t(y0) * srcStride, taps.constData(), dstWidth, channels, rows[0]);
+                cached[0] = y0;
+            }
+        }
+
+        if (wy == 0) {
+            verticalBilinear(rows[0], rows[0], rowCount, 0, dst + size_t(y) * dstStride);
+            continue;
+        }
+
+        if (cached[1] != y1) {
+            horizontalBilinear(src + size_t(y1) * srcStride, taps.constData(), dstWidth, channels, rows[1]);
+            cached[1] = y1;
+        }
+        verticalBilinear(rows[0], rows[1], rowCount, wy, dst + size_t(y) * dstStride);
+    }
+
+    return true;
+}
+
+bool resizeArea(const uchar* src, int srcWidth, int srcHeight, int srcStride,
+                uchar* dst, int dstWidth, int dstHeight, int dstStride, int channels)
+{
+    // 盒边界：[floor(i * src / dst), floor((i + 1) * src / dst))
+    QVector<int> xStart(dstWidth + 1);
+    for (int x = 0; x <= dstWidth; ++x) {
+        xStart[x] = int(qint64(x) * srcWidth / dstWidth);
+    }
+
+    const int rowCount = srcWidth * channels;
+    QVector<quint16> acc(rowCount);
+
+    int srcY = 0;
+    for (int y = 0; y < dstHeight; ++y) {
+        const int yEnd = int(qint64(y + 1) * srcHeight / dstHeight);
+        const int boxHeight = yEnd - srcY;
+
+        std::memset(acc.data(), 0, rowCount * sizeof(quint16));
+        for (; srcY < yEnd; ++srcY) {
+            accumulateRow(src + size_t(srcY) * srcStride, rowCount, acc.data());
+        }
+
+        uchar* out = dst + size_t(y) * dstStride;
+        const quint16* sums = acc.constData();
+        for (int x = 0; x < dstWidth; ++x) {
+            const int x0 = xStart[x];
+            const int x1 = xStart[x + 1];
+            // 🔧 直接按盒面积做四舍五入除法：定点倒数在大盒（上千像素）时偏差超过 1%，
+            //    超过 131072 像素时倒数为 0 输出全黑；每个输出像素只除一次，相对盒内求和可忽略
+            const quint32 area = quint32(x1 - x0) * quint32(boxHeight);
+            for (int c = 0; c < channels; ++c) {
+                quint32 sum = 0;
+                for (int sx = x0; sx < x1; ++sx) {
+                    sum += sums[sx * channels + c];
+                }
+                out[c] = uchar((sum + area / 2) / area);
+            }
+            out += channels;
+        }
+    }
+
+    return true;
+}
+
+int channelsOf(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_Grayscale8:
+        return 1;
+    case QImage::Format_RGB888:
+        return 3;
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+} // namespace
+
+QSize ImageResampler::fitWithin(const QSize& size, int maxWidth, int maxHeight)
+{
+    if (size.width() <= 0 || size.height() <= 0) {
+        return size;
+    }
+
+    double scale = 1.0;
+    if (maxWidth > 0) {
+        scale = qMin(scale, double(maxWidth) / size.width());
+    }
+    if (maxHeight > 0) {
+        scale = qMin(scale, double(maxHeight) / size.height());
+    }
+
+    if (scale >= 1.0) {
+        return size;
+    }
+
+    return QSize(qMax(1, int(size.width() * scale + 0.5)),
+                 qMax(1, int(size.height() * scale + 0.5)));
+}
+
+bool ImageResampler::resize(const uchar* src, int srcWidth, int srcHeight, int srcStride,
+                            uchar* dst, int dstWidth, int dstHeight, int dstStride,
+                            int channels, Filter filter)
+{
+    if (!src || !dst || srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0) {
+        return false;
+    }
+    if (channels != 1 && channels != 3 && channels != 4) {
+        return false;
+    }
+
+    if (filter == Filter::Auto) {
+        filter = (srcWidth >= dstWidth * 2 && srcHeight >= dstHeight * 2) ? Filter::Area : Filter::Bilinear;
+    }
+
+    // 面积插值只用于下采样；盒大小超出累加器范围（极端缩放比）时回退到双线性
+    if (filter == Filter::Area &&
+        (srcWidth < dstWidth || srcHeight < dstHeight ||
+         srcHeight / dstHeight + 1 > kAreaMaxRows || srcWidth / dstWidth + 1 > kAreaMaxColumns)) {
+        filter = Filter::Bilinear;
+    }
+
+    if (filter == Filter::Area) {
+        return resizeArea(src, srcWidth, srcHeight, srcStride, dst, dstWidth, dstHeight, dstStride, channels);
+    }
+    return resizeBilinear(src, srcWidth, srcHeight, srcStride, dst, dstWidth, dstHeight, dstStride, channels);
+}
+
+QImage ImageResampler::resized(const QImage& src, const QSize& size, Filter filter)
+{
+    if (src.isNull() || size.isEmpty()) {
+        return QImage();
+    }
+
+    QImage input = src;
+    int channels = channelsOf(input.format());
+    if (channels == 0) {
+        input = input.convertToFormat(QImage::Format_RGB888);
+        channels = 3;
+    }
+
+    if (input.size() == size) {
+        return input;
+    }
+
+    QImage output(size, input.format());
+    if (output.isNull()) {
+        return QImage();
+    }
+
+    if (!resize(input.constBits(), input.width(), input.height(), input.bytesPerLine(),
+                output.bits(), output.width(), output.height(), output.bytesPerLine(),
+                channels, filter)) {
+        return QImage();
+    }
+
+    return output;
+}
+
+const char* ImageResampler::simdPath()
+{
+#if defined(SV_RESAMPLE_NEON)
+    return "neon";
+#elif defined(SV_RESAMPLE_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,37 @@
+// ai/imageresampler.h
+#ifndef IMAGERESAMPLER_H
+#define IMAGERESAMPLER_H
+
+#include <QImage>
+#include <QSize>
+
+// 🆕 快速图像缩放（替代 QImage::scaled 的 SmoothTransformation）
+// - 支持 1/3/4 通道 8bit 图像（Grayscale8 / RGB888 / RGB32 系列）
+// - Bilinear：7bit 定点双线性，先水平插值到 16bit 行缓冲，再垂直混合（NEON / SSE2 向量化）
+// - Area：整数盒滤波下采样，逐行累加（向量化）后按盒面积求均值；
+//         缩放比非整数时盒边界取整，属于近似面积插值
+class ImageResampler
+{
+public:
+    enum class Filter {
+        Auto,       // 两个方向都缩小到1/2以下用 Area，否则 Bilinear
+        Bilinear,
+        Area
+    };
+
+    // 等比缩放到 maxWidth x maxHeight 以内（不放大），<=0 表示该方向不限制
+    static QSize fitWithin(const QSize& size, int maxWidth, int maxHeight);
+
+    // 按原格式缩放；不支持的格式先转换为 RGB888
+    static QImage resized(const QImage& src, const QSize& size, Filter filter = Filter::Auto);
+
+    // 原始缓冲区接口，channels 为 1/3/4，src 与 dst 不可重叠
+    static bool resize(const uchar* src, int srcWidth, int srcHeight, int srcStride,
+                       uchar* dst, int dstWidth, int dstHeight, int dstStride,
+                       int channels, Filter filter = Filter::Auto);
+
+    // 当前编译使用的向量化路径："neon" / "sse2" / "scalar"
+    static const char* simdPath();
+};
+
+#endif // IMAGERESAMPLER_H
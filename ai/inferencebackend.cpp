@@ -0,0 +1,72 @@
+// ai/inferencebackend.cpp
+#include "inferencebackend.h"
+#include "cpuinferencebackend.h"
+#ifdef SV_HAVE_ROCKX
+#include "rockxinferencebackend.h"
+#endif
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+
+int InferenceBackend::embedBatch(const FaceBatch& batch, QVector<QByteArray>& features)
+{
+    features.resize(batch.size());
+
+    int succeeded = 0;
+    for (int i = 0; i < batch.size(); ++i) {
+        QByteArray feature(kFeatureDim * sizeof(float), Qt::Uninitialized);
+        if (embed(batch.crop(i), reinterpret_cast<float*>(feature.data()))) {
+            features[i] = feature;
+            succeeded++;
+        } else {
+            features[i].clear();
+        }
+    }
+    return succeeded;
+}
+
+namespace {
+
+QMutex& registryMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+// 内置后端在首次访问时注册（静态库中的全局注册对象可能被链接器丢弃）
+QMap<QString, InferenceBackendRegistry::Factory>& registry()
+{
+    static QMap<QString, InferenceBackendRegistry::Factory> factories = [] {
+        QMap<QString, InferenceBackendRegistry::Factory> builtins;
+        builtins.insert("cpu", [] { return static_cast<InferenceBackend*>(new CpuInferenceBackend()); });
+#ifdef SV_HAVE_ROCKX
+        builtins.insert("rockx", [] { return static_cast<InferenceBackend*>(new RockxInferenceBackend()); });
+#endif
+        return builtins;
+    }();
+    return factories;
+}
+
+} // namespace
+
+void InferenceBackendRegistry::registerBackend(const QString& name, const Factory& factory)
+{
+    QMutexLocker locker(&registryMutex());
+    registry().insert(name.toLower(), factory);
+}
+
+QStringList InferenceBackendRegistry::availableBackends()
+{
+    QMutexLocker locker(&registryMutex());
+    return registry().keys();
+}
+
+InferenceBackend* InferenceBackendRegistry::create(const QString& name)
+{
+    QMutexLocker locker(&registryMutex());
+    auto it = registry().constFind(name.toLower());
+    if (it == registry().constEnd()) {
+        return nullptr;
+    }
+    return it.value()();
+}
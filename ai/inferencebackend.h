@@ -0,0 +1,71 @@
+// ai/inferencebackend.h
+#ifndef INFERENCEBACKEND_H
+#define INFERENCEBACKEND_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QImage>
+#include <QRect>
+#include <QPointF>
+#include <QByteArray>
+#include <functional>
+#include "facebatchscheduler.h"
+
+// 🆕 检测结果（坐标基于传入 detect() 的帧）
+struct DetectedFace {
+    QRect box;
+    float score = 0.0f;
+};
+
+// 🆕 人脸推理后端接口：检测 / 对齐 / 特征提取
+// FaceRecognitionManager 只依赖此接口，RockX 之外的实现（CPU参考实现等）
+// 使整条人脸流水线可以在任意 Linux 主机上运行和做性能分析。
+// 约定：输入帧均为 RGB888；对齐输出固定为 FaceBatch::kCropSize 见方的 RGB888；
+// 特征为 kFeatureDim 个 float。实现不要求线程安全，由调用方串行使用。
+class InferenceBackend
+{
+public:
+    static const int kFeatureDim = 512;
+
+    virtual ~InferenceBackend() {}
+
+    virtual QString name() const = 0;
+
+    // 需要的模型文件（相对模型目录），为空表示不依赖模型目录
+    virtual QStringList requiredModelFiles() const { return QStringList(); }
+    virtual bool initialize(const QString& modelPath) = 0;
+
+    virtual QVector<DetectedFace> detect(const QImage& frame) = 0;
+
+    // 5点关键点（左眼、右眼、鼻尖、左嘴角、右嘴角，frame 坐标），不支持时返回 false
+    virtual bool landmarks(const QImage& frame, const QRect& box, QPointF* points) {
+        Q_UNUSED(frame); Q_UNUSED(box); Q_UNUSED(points);
+        return false;
+    }
+
+    // 把 box 区域对齐到 dst（kCropSize × kCropSize RGB888，行字节数 dstStride）
+    virtual bool align(const QImage& frame, const QRect& box, uchar* dst, int dstStride) = 0;
+
+    // 从一张对齐人脸提取特征，feature 至少 kFeatureDim 个 float
+    virtual bool embed(const uchar* alignedRgb, float* feature) = 0;
+
+    // 整批提取；默认逐张调用 embed，支持批推理的后端可重写
+    // 失败的人脸在 features 中对应空 QByteArray，返回成功数量
+    virtual int embedBatch(const FaceBatch& batch, QVector<QByteArray>& features);
+};
+
+// 🆕 后端注册表：按名称创建（名称来自 AIConfig::inferenceBackend）
+class InferenceBackendRegistry
+{
+public:
+    typedef std::function<InferenceBackend*()> Factory;
+
+    static void registerBackend(const QString& name, const Factory& factory);
+    static QStringList availableBackends();
+
+    // 未知或未编译进来的名称返回 nullptr
+    static InferenceBackend* create(const QString& name);
+};
+
+#endif // INFERENCEBACKEND_H
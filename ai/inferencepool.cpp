@@ -0,0 +1,207 @@
+// ai/inferencepool.cpp
+#include "inferencepool.h"
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDebug>
+
+// ========== Lease ==========
+InferencePool::Lease::Lease(Lease&& other)
+    : m_pool(other.m_pool)
+    , m_context(other.m_context)
+{
+    other.m_pool = nullptr;
+    other.m_context = nullptr;
+}
+
+InferencePool::Lease& InferencePool::Lease::operator=(Lease&& other)
+{
+    if (this != &other) {
+        release();
+        m_pool = other.m_pool;
+        m_context = other.m_context;
+        other.m_pool = nullptr;
+        other.m_context = nullptr;
+    }
+    return *this;
+}
+
+InferencePool::Lease::~Lease()
+{
+    release();
+}
+
+void InferencePool::Lease::release()
+{
+    if (m_pool && m_context) {
+        m_pool->release(m_context);
+    }
+    m_pool = nullptr;
+    m_context = nullptr;
+}
+
+// ========== InferencePool ==========
+InferencePool::InferencePool() = default;
+
+InferencePool::~InferencePool()
+{
+    shutdown();
+}
+
+bool InferencePool::initialize(const QString& backendName, const QString& modelPath, int size)
+{
+    // 🔧 后端初始化可能较慢（加载模型），不持锁进行；期间旧上下文照常借出
+    QVector<InferenceContext*> contexts;
+    const int count = qMax(1, size);
+    for (int i = 0; i < count; ++i) {
+        InferenceContext* context = new InferenceContext;
+        context->index = i;
+        context->backend = InferenceBackendRegistry::create(backendName);
+
+        if (!context->backend || !context->backend->initialize(modelPath)) {
+            qDebug() << "InferencePool: Failed to initialize context" << i << "of backend" << backendName;
+            contexts.append(context);
+            destroy(contexts);
+            return false;
+        }
+        contexts.append(context);
+    }
+
+    // 新上下文一次性换入；空闲的旧上下文立即销毁，借出中的在归还时销毁
+    QVector<InferenceContext*> retired;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (InferenceContext* context : m_contexts) {
+            if (m_idle.contains(context)) {
+                retired.append(context);
+            } else {
+                m_retired.append(context);
+            }
+        }
+        m_contexts = contexts;
+        m_idle = contexts;
+        m_backendName = backendName;
+        m_open = true;
+        m_stats = Stats();
+        m_stats.size = contexts.size();
+        m_changed.wakeAll();
+    }
+    destroy(retired);
+
+    qDebug() << "InferencePool: Ready with" << contexts.size() << "contexts of backend" << backendName;
+    return true;
+}
+
+void InferencePool::shutdown()
+{
+    QVector<InferenceContext*> contexts;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_open = false;
+        m_changed.wakeAll();
+
+        // 等所有借出的上下文（包括重建前借出的旧上下文）归还后再销毁句柄
+        while (m_idle.size() < m_contexts.size() || !m_retired.isEmpty()) {
+            m_changed.wait(&m_mutex);
+        }
+
+        contexts = m_contexts;
+        m_contexts.clear();
+        m_idle.clear();
+        m_stats.size = 0;
+    }
+
+    destroy(contexts);
+}
+
+void InferencePool::destroy(const QVector<InferenceContext*>& contexts)
+{
+    for (InferenceContext* context : contexts) {
+        delete context->backend;
+        delete context;
+    }
+}
+
+int InferencePool::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_contexts.size();
+}
+
+QString InferencePool::backendName() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_backendName;
+}
+
+InferencePool::Lease InferencePool::acquire(int timeoutMs)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool contended = m_open && m_idle.isEmpty();
+
+    while (m_open && m_idle.isEmpty()) {
+        if (timeoutMs < 0) {
+            m_changed.wait(&m_mutex);
+            continue;
+        }
+
+        const qint64 remaining = timeoutMs - timer.elapsed();
+        if (remaining <= 0 || !m_changed.wait(&m_mutex, static_cast<unsigned long>(remaining))) {
+            break;
+        }
+    }
+
+    if (!m_open || m_idle.isEmpty()) {
+        m_stats.timeouts++;
+        return Lease();
+    }
+
+    const double waitMs = timer.nsecsElapsed() / 1e6;
+    m_stats.acquisitions++;
+    if (contended) {
+        m_stats.contended++;
+    }
+    m_stats.totalWaitMs += waitMs;
+    m_stats.maxWaitMs = qMax(m_stats.maxWaitMs, waitMs);
+
+    InferenceContext* context = m_idle.takeLast();
+    return Lease(this, context);
+}
+
+void InferencePool::release(InferenceContext* context)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_changed.wakeAll();
+        if (!m_retired.removeOne(context)) {
+            m_idle.append(context);
+            return;
+        }
+    }
+
+    // 重建前借出的旧上下文：归还即销毁
+    delete context->backend;
+    delete context;
+}
+
+InferencePool::Stats InferencePool::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    stats.inUse = m_contexts.size() - m_idle.size();
+    return stats;
+}
+
+QString InferencePool::summary() const
+{
+    const Stats s = stats();
+    return QString("Pool: %1/%2 busy, %3 leases, %4 waited (avg %5 ms, max %6 ms)")
+        .arg(s.inUse)
+        .arg(s.size)
+        .arg(s.acquisitions)
+        .arg(s.contended)
+        .arg(s.averageWaitMs(), 0, 'f', 2)
+        .arg(s.maxWaitMs, 0, 'f', 1);
+}
@@ -0,0 +1,95 @@
+// ai/inferencepool.h
+#ifndef INFERENCEPOOL_H
+#define INFERENCEPOOL_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QString>
+#include "inferencebackend.h"
+#include "facebatchscheduler.h"
+
+// 🆕 一个推理上下文：独立的后端句柄 + 该上下文专用的单帧对齐缓冲
+struct InferenceContext {
+    int index = 0;
+    InferenceBackend* backend = nullptr;
+    FaceBatch scratch;
+};
+
+// 🆕 推理上下文池：N 套后端句柄，借出/归还语义
+// 多个线程（每路摄像头、注册界面）可同时检测/提取特征；池空时阻塞等待并统计等待耗时
+class InferencePool
+{
+public:
+    // 借出的上下文，析构时自动归还（只可移动）
+    class Lease
+    {
+    public:
+        Lease() = default;
+        Lease(Lease&& other);
+        Lease& operator=(Lease&& other);
+        ~Lease();
+
+        InferenceContext* operator->() const { return m_context; }
+        InferenceContext* context() const { return m_context; }
+        InferenceBackend* backend() const { return m_context ? m_context->backend : nullptr; }
+        explicit operator bool() const { return m_context != nullptr; }
+
+        void release();
+
+    private:
+        friend class InferencePool;
+        Lease(InferencePool* pool, InferenceContext* context) : m_pool(pool), m_context(context) {}
+
+        InferencePool* m_pool = nullptr;
+        InferenceContext* m_context = nullptr;
+
+        Q_DISABLE_COPY(Lease)
+    };
+
+    struct Stats {
+        int size = 0;
+        int inUse = 0;
+        quint64 acquisitions = 0;   // 成功借出次数
+        quint64 contended = 0;      // 需要等待的借出次数
+        quint64 timeouts = 0;       // 超时/关闭导致的失败次数
+        double totalWaitMs = 0.0;
+        double maxWaitMs = 0.0;
+
+        double averageWaitMs() const { return acquisitions ? totalWaitMs / acquisitions : 0.0; }
+    };
+
+    InferencePool();
+    ~InferencePool();
+
+    // 创建 size 套后端并逐一初始化，成功后一次性换入；创建期间旧上下文照常借出，
+    // 换下的旧上下文空闲的立即销毁、借出中的在归还时销毁。失败时保留原有上下文
+    bool initialize(const QString& backendName, const QString& modelPath, int size);
+    void shutdown();
+
+    int size() const;
+    QString backendName() const;
+
+    // timeoutMs < 0 表示一直等待；池已关闭或超时返回空 Lease
+    Lease acquire(int timeoutMs = -1);
+
+    Stats stats() const;
+    QString summary() const;
+
+private:
+    void release(InferenceContext* context);
+    static void destroy(const QVector<InferenceContext*>& contexts);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_changed;       // 有上下文归还或池状态变化
+    QVector<InferenceContext*> m_contexts;
+    QVector<InferenceContext*> m_idle;
+    QVector<InferenceContext*> m_retired;   // 已被换下但仍借出的旧上下文
+    QString m_backendName;
+    bool m_open = false;
+    Stats m_stats;
+
+    Q_DISABLE_COPY(InferencePool)
+};
+
+#endif // INFERENCEPOOL_H
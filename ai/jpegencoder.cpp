@@ -0,0 +1,69 @@
+// ai/jpegencoder.cpp
+#include "jpegencoder.h"
+#include "imageresampler.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <QDebug>
+
+bool JpegEncoder::encode(const QImage& image, int quality, const QRect& crop, int maxEdge)
+{
+    if (image.isNull()) {
+        return false;
+    }
+
+    // 采集线程产出的格式直接引用像素；其它格式才转换一次
+    const QImage* source = &image;
+    int channels = 3;
+    switch (image.format()) {
+    case QImage::Format_RGB888:
+        channels = 3;
+        break;
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        channels = 4;       // 小端下字节序为 BGRA
+        break;
+    case QImage::Format_Grayscale8:
+        channels = 1;
+        break;
+    default:
+        m_converted = image.convertToFormat(QImage::Format_RGB888);
+        source = &m_converted;
+        channels = 3;
+        break;
+    }
+
+    const QRect area = crop.isNull() ? source->rect() : crop.intersected(source->rect());
+    if (area.isEmpty()) {
+        return false;
+    }
+
+    const cv::Mat full(source->height(), source->width(), CV_8UC(channels),
+                       const_cast<uchar*>(source->constBits()), size_t(source->bytesPerLine()));
+    cv::Mat view = full(cv::Rect(area.x(), area.y(), area.width(), area.height()));
+
+    const QSize target = maxEdge > 0 ? ImageResampler::fitWithin(area.size(), maxEdge, maxEdge) : area.size();
+    if (target != area.size()) {
+        m_resized.create(target.height(), target.width(), view.type());
+        ImageResampler::resize(view.data, view.cols, view.rows, int(view.step),
+                               m_resized.data, m_resized.cols, m_resized.rows, int(m_resized.step), channels);
+        view = m_resized;
+    }
+
+    try {
+        const cv::Mat* encoded = &view;
+        if (channels == 3) {
+            cv::cvtColor(view, m_bgr, cv::COLOR_RGB2BGR);
+            encoded = &m_bgr;
+        } else if (channels == 4) {
+            cv::cvtColor(view, m_bgr, cv::COLOR_BGRA2BGR);
+            encoded = &m_bgr;
+        }
+
+        m_params.assign({cv::IMWRITE_JPEG_QUALITY, qBound(1, quality, 100)});
+        return cv::imencode(".jpg", *encoded, m_output, m_params);
+    } catch (const cv::Exception& e) {
+        qWarning() << "JpegEncoder: Encoding failed:" << e.what();
+        return false;
+    }
+}
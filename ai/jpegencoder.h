@@ -0,0 +1,30 @@
+// ai/jpegencoder.h
+#ifndef JPEGENCODER_H
+#define JPEGENCODER_H
+
+#include <QImage>
+#include <QRect>
+#include <opencv2/core.hpp>
+#include <vector>
+
+// 🆕 JPEG 编码器：直接在 QImage 像素上建 cv::Mat（不拷贝），裁剪为 ROI 视图，
+// 缩放/颜色转换/输出缓冲都复用成员，稳定运行后每次编码不再分配堆内存
+// 底层为 OpenCV imencode（libjpeg-turbo）。非线程安全，每个线程一个实例
+class JpegEncoder
+{
+public:
+    // crop 为空时编码整幅图；maxEdge > 0 时等比缩小到长边不超过 maxEdge（不放大）
+    bool encode(const QImage& image, int quality, const QRect& crop = QRect(), int maxEdge = 0);
+
+    // 最近一次编码结果，下次 encode 前有效
+    const std::vector<uchar>& data() const { return m_output; }
+
+private:
+    cv::Mat m_resized;
+    cv::Mat m_bgr;
+    std::vector<uchar> m_output;
+    std::vector<int> m_params;
+    QImage m_converted;             // 罕见格式的转换缓冲
+};
+
+#endif // JPEGENCODER_H
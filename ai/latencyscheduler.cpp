@@ -0,0 +1,221 @@
+// ai/latencyscheduler.cpp
+#include "latencyscheduler.h"
+#include <QMutexLocker>
+#include <QStringList>
+#include <QDebug>
+
+namespace {
+const float kAverageAlpha = 0.2f;       // 滑动平均权重
+const qint64 kWindowMs = 1000;          // 忙碌占比统计窗口
+const qint64 kDegradeCooldownMs = 1000; // 两次降级的最小间隔，给新级别生效的时间
+const qint64 kRecoverHoldMs = 3000;     // 持续富余多久才恢复一级
+const float kRecoverLatencyRatio = 0.6f;
+const float kRecoverBudgetRatio = 0.75f;
+} // namespace
+
+const LatencyScheduler::LevelPolicy LatencyScheduler::kPolicies[LatencyScheduler::kLevelCount] = {
+    { 1, 1.0f,  1 },   // Full
+    { 2, 1.0f,  1 },   // ReducedCadence
+    { 2, 0.75f, 1 },   // ReducedResolution
+    { 2, 0.5f,  2 },   // ReducedRecognition
+    { 4, 0.5f,  4 }    // Minimal
+};
+
+void LatencyScheduler::MovingAverage::add(float sample)
+{
+    value = valid ? value + kAverageAlpha * (sample - value) : sample;
+    valid = true;
+}
+
+LatencyScheduler::LatencyScheduler()
+    : m_windowStartMs(0)
+    , m_windowBusyMs(0.0f)
+{
+    m_clock.start();
+}
+
+void LatencyScheduler::setBudget(const Budget& budget)
+{
+    QMutexLocker locker(&m_mutex);
+    m_budget = budget;
+    m_budget.baseInterval = qMax(1, budget.baseInterval);
+    m_budget.targetLatencyMs = qMax(1, budget.targetLatencyMs);
+
+    if (!m_budget.adaptive) {
+        for (SourceState& state : m_sources) {
+            state.level = Level::Full;
+        }
+    }
+}
+
+LatencyScheduler::Budget LatencyScheduler::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_budget;
+}
+
+LatencyScheduler::Plan LatencyScheduler::plan(int sourceId, bool hasMotion)
+{
+    QMutexLocker locker(&m_mutex);
+
+    SourceState& state = m_sources[sourceId];
+    const LevelPolicy& policy = kPolicies[int(state.level)];
+
+    // 无运动时间隔放宽到 2n+1（基准间隔2时即原先的每5帧一次）
+    int interval = m_budget.baseInterval * policy.cadenceMultiplier;
+    if (!hasMotion) {
+        interval = interval * 2 + 1;
+    }
+
+    Plan plan;
+    plan.level = state.level;
+    plan.runFaceDetection = (++state.frameCounter % interval) == 0;
+    if (plan.runFaceDetection) {
+        plan.runRecognition = (state.detectionCounter++ % policy.recognitionEvery) == 0;
+    }
+
+    // 保持偶数尺寸，便于后端按 2x2 对齐
+    const QSize& base = m_budget.baseResolution;
+    plan.workingSize = QSize(qMax(2, int(base.width() * policy.resolutionScale) & ~1),
+                             qMax(2, int(base.height() * policy.resolutionScale) & ~1));
+    return plan;
+}
+
+void LatencyScheduler::recordMotion(int sourceId, float ms)
+{
+    QMutexLocker locker(&m_mutex);
+    m_sources[sourceId].motionMs.add(ms);
+    addBusyLocked(ms);
+}
+
+void LatencyScheduler::recordDetection(int sourceId, float ms)
+{
+    QMutexLocker locker(&m_mutex);
+    m_sources[sourceId].detectionMs.add(ms);
+    addBusyLocked(ms);
+}
+
+void LatencyScheduler::recordRecognition(float ms, int faceCount)
+{
+    QMutexLocker locker(&m_mutex);
+    if (faceCount > 0) {
+        m_recognitionMsPerFace.add(ms / faceCount);
+    }
+    addBusyLocked(ms);
+}
+
+bool LatencyScheduler::recordFrameDone(int sourceId, float endToEndMs)
+{
+    QMutexLocker locker(&m_mutex);
+
+    SourceState& state = m_sources[sourceId];
+    state.latencyMs.add(endToEndMs);
+
+    return updateLevelLocked(sourceId, state);
+}
+
+void LatencyScheduler::addBusyLocked(float ms)
+{
+    m_windowBusyMs += ms;
+
+    const qint64 now = m_clock.elapsed();
+    const qint64 windowMs = now - m_windowStartMs;
+    if (windowMs >= kWindowMs) {
+        m_utilisation.add(qMin(1.0f, m_windowBusyMs / windowMs));
+        m_windowStartMs = now;
+        m_windowBusyMs = 0.0f;
+    }
+}
+
+bool LatencyScheduler::updateLevelLocked(int sourceId, SourceState& state)
+{
+    if (!m_budget.adaptive) {
+        return false;
+    }
+
+    const qint64 now = m_clock.elapsed();
+    const float latency = state.latencyMs.value;
+    const float utilisation = m_utilisation.valid ? m_utilisation.value : 0.0f;
+
+    const bool overBudget = latency > m_budget.targetLatencyMs || utilisation > m_budget.cpuBudget;
+    const bool comfortable = latency < m_budget.targetLatencyMs * kRecoverLatencyRatio &&
+                             utilisation < m_budget.cpuBudget * kRecoverBudgetRatio;
+
+    const Level previous = state.level;
+
+    if (overBudget) {
+        state.healthySinceMs = -1;
+        if (state.level != Level::Minimal && now - state.lastChangeMs >= kDegradeCooldownMs) {
+            state.level = Level(int(state.level) + 1);
+        }
+    } else if (comfortable) {
+        if (state.healthySinceMs < 0) {
+            state.healthySinceMs = now;
+        }
+        if (state.level != Level::Full && now - state.healthySinceMs >= kRecoverHoldMs) {
+            state.level = Level(int(state.level) - 1);
+            state.healthySinceMs = now;
+        }
+    } else {
+        state.healthySinceMs = -1;
+    }
+
+    if (state.level == previous) {
+        return false;
+    }
+
+    state.lastChangeMs = now;
+    qDebug() << QString("LatencyScheduler: source %1 %2 -> %3 (latency %4 ms, busy %5%)")
+                    .arg(sourceId)
+                    .arg(levelName(previous))
+                    .arg(levelName(state.level))
+                    .arg(latency, 0, 'f', 1)
+                    .arg(utilisation * 100.0f, 0, 'f', 0);
+    return true;
+}
+
+LatencyScheduler::Level LatencyScheduler::level(int sourceId) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_sources.constFind(sourceId);
+    return it == m_sources.constEnd() ? Level::Full : it.value().level;
+}
+
+float LatencyScheduler::utilisation() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_utilisation.valid ? m_utilisation.value : 0.0f;
+}
+
+const char* LatencyScheduler::levelName(Level level)
+{
+    switch (level) {
+    case Level::Full:               return "full";
+    case Level::ReducedCadence:     return "reduced-cadence";
+    case Level::ReducedResolution:  return "reduced-resolution";
+    case Level::ReducedRecognition: return "reduced-recognition";
+    case Level::Minimal:            return "minimal";
+    }
+    return "unknown";
+}
+
+QString LatencyScheduler::summary() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QStringList parts;
+    for (auto it = m_sources.constBegin(); it != m_sources.constEnd(); ++it) {
+        const SourceState& state = it.value();
+        parts << QString("src%1 %2 (e2e %3ms, motion %4ms, detect %5ms)")
+                     .arg(it.key())
+                     .arg(levelName(state.level))
+                     .arg(state.latencyMs.value, 0, 'f', 0)
+                     .arg(state.motionMs.value, 0, 'f', 1)
+                     .arg(state.detectionMs.value, 0, 'f', 1);
+    }
+
+    return QString("Scheduler: busy %1%, recognize %2ms/face, %3")
+        .arg((m_utilisation.valid ? m_utilisation.value : 0.0f) * 100.0f, 0, 'f', 0)
+        .arg(m_recognitionMsPerFace.value, 0, 'f', 1)
+        .arg(parts.isEmpty() ? QString("no sources") : parts.join(", "));
+}
@@ -0,0 +1,103 @@
+// ai/latencyscheduler.h
+#ifndef LATENCYSCHEDULER_H
+#define LATENCYSCHEDULER_H
+
+#include <QMap>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QSize>
+#include <QString>
+
+// 🆕 延迟预算调度器（替代固定的"有运动隔2帧/无运动隔5帧"人脸调度）
+// 以目标端到端延迟（入队到结果发出）和 AI 线程忙碌占比为预算，
+// 按来源逐级降级/恢复：检测间隔 → 工作分辨率 → 识别频率
+class LatencyScheduler
+{
+public:
+    // 降级级别，数值越大越省
+    enum class Level {
+        Full = 0,               // 基准间隔、基准分辨率、每次检测都识别
+        ReducedCadence,         // 检测间隔加倍
+        ReducedResolution,      // 再把工作分辨率降到 3/4
+        ReducedRecognition,     // 再把分辨率降到 1/2，隔一次检测才识别
+        Minimal                 // 间隔x4、分辨率 1/2、每4次检测识别一次
+    };
+    static const int kLevelCount = 5;
+
+    struct Budget {
+        bool adaptive = true;                   // false 时固定 Full 级别
+        int targetLatencyMs = 200;              // 目标端到端延迟
+        float cpuBudget = 0.7f;                 // AI 线程忙碌占比上限（0~1）
+        int baseInterval = 2;                   // Full 级别有运动时的检测间隔（帧）
+        QSize baseResolution = QSize(640, 480); // Full 级别的工作分辨率
+    };
+
+    // 单帧的调度决定
+    struct Plan {
+        bool runFaceDetection = false;
+        bool runRecognition = false;    // false 时只检测并沿用轨迹识别结果
+        QSize workingSize;
+        Level level = Level::Full;
+    };
+
+    LatencyScheduler();
+
+    void setBudget(const Budget& budget);
+    Budget budget() const;
+
+    Plan plan(int sourceId, bool hasMotion);
+
+    // 各阶段实测耗时（毫秒），用于滑动平均和忙碌占比
+    void recordMotion(int sourceId, float ms);
+    void recordDetection(int sourceId, float ms);
+    void recordRecognition(float ms, int faceCount);    // 批识别跨来源，按人脸均摊
+
+    // 一帧结果发出；返回 true 表示该来源的降级级别发生了变化
+    bool recordFrameDone(int sourceId, float endToEndMs);
+
+    Level level(int sourceId) const;
+    float utilisation() const;
+    static const char* levelName(Level level);
+    QString summary() const;
+
+private:
+    struct LevelPolicy {
+        int cadenceMultiplier;      // 检测间隔倍数
+        float resolutionScale;      // 工作分辨率缩放
+        int recognitionEvery;       // 每几次检测做一次识别
+    };
+    static const LevelPolicy kPolicies[kLevelCount];
+
+    struct MovingAverage {
+        float value = 0.0f;
+        bool valid = false;
+        void add(float sample);
+    };
+
+    struct SourceState {
+        Level level = Level::Full;
+        quint64 frameCounter = 0;
+        quint64 detectionCounter = 0;
+        MovingAverage motionMs;
+        MovingAverage detectionMs;
+        MovingAverage latencyMs;
+        qint64 lastChangeMs = 0;
+        qint64 healthySinceMs = -1;
+    };
+
+    void addBusyLocked(float ms);
+    bool updateLevelLocked(int sourceId, SourceState& state);
+
+    mutable QMutex m_mutex;
+    Budget m_budget;
+    QMap<int, SourceState> m_sources;
+    MovingAverage m_recognitionMsPerFace;
+
+    // 忙碌占比：按 1 秒窗口统计，再做滑动平均
+    QElapsedTimer m_clock;
+    qint64 m_windowStartMs;
+    float m_windowBusyMs;
+    MovingAverage m_utilisation;
+};
+
+#endif // LATENCYSCHEDULER_H
@@ -1,4 +1,6 @@
 #include "motiondetector.h"
+#include "../core/Logging.h"
+#include "../core/TraceRecorder.h"
 #include <QDebug>
 
 MotionDetector::MotionDetector(QObject *parent)
@@ -8,14 +10,15 @@ MotionDetector::MotionDetector(QObject *parent)
 
 bool MotionDetector::detectMotion(const QImage& currentFrame, QRect& motionArea)
 {
+    SV_TRACE_SCOPE("ai", "motion");
     if (currentFrame.isNull()) {
-        qDebug() << "MotionDetector: Received null image";
+        svWarningEvery(lcMotion, 5000) << "MotionDetector: Received null image";
         return false;
     }
 
     cv::Mat frame = qImageToCvMat(currentFrame);
     if (frame.empty()) {
-        qDebug() << "MotionDetector: Failed to convert QImage to cv::Mat";
+        svWarningEvery(lcMotion, 5000) << "MotionDetector: Failed to convert QImage to cv::Mat";
         return false;
     }
 
@@ -72,7 +75,7 @@ bool MotionDetector::detectMotion(const QImage& currentFrame, QRect& motionArea)
 
     if (hasMotion) {
         motionArea = cvRectToQRect(maxRect);
-        qDebug() << "MotionDetector: Motion detected! Area:" << maxArea
+        svDebug(lcMotion) << "MotionDetector: Motion detected! Area:" << maxArea
                  << "Valid contours:" << validContours
                  << "Motion rect:" << motionArea;
     }
@@ -91,6 +94,7 @@ void MotionDetector::reset()
 
 cv::Mat MotionDetector::qImageToCvMat(const QImage& qImage)
 {
+    SV_TRACE_SCOPE("ai", "convert");
     QImage image = qImage;
 
     // 确保图像格式为RGB888
@@ -23,6 +23,9 @@ public:
     // 重置背景模型
     void reset();
 
+    // 🔧 QImage 转 BGR cv::Mat（深拷贝），无状态，公开以便基准测试
+    static cv::Mat qImageToCvMat(const QImage& qImage);
+
 private:
     cv::Mat m_background;           // 背景模型
     cv::Mat m_previousFrame;        // 上一帧
@@ -31,7 +34,6 @@ private:
     bool m_initialized = false;     // 是否已初始化
 
     // 辅助函数
-    cv::Mat qImageToCvMat(const QImage& qImage);
     QRect cvRectToQRect(const cv::Rect& cvRect);
 };
 
@@ -0,0 +1,75 @@
+// ai/pendingfaceresults.h
+#ifndef PENDINGFACERESULTS_H
+#define PENDINGFACERESULTS_H
+
+#include <QVector>
+#include "aitypes.h"
+#include "detectionresultpool.h"
+
+// 🆕 攒批识别中等待回填的帧：结果借自 DetectionResultPool，人脸全部回填后按入队顺序交出并归还
+// Frame 为随结果保存的帧信息（AI 线程保存 QueuedFrame）
+// 条目数组按池容量预留，稳态下入队、回填、交出都不触发堆分配；仅供单个线程使用，不加锁
+template <typename Frame>
+class PendingFaceResults
+{
+public:
+    struct Entry {
+        quint64 frameId;
+        Frame frame;
+        DetectionResult* result;
+        int remaining;          // 尚未返回识别结果的人脸数
+    };
+
+    explicit PendingFaceResults(DetectionResultPool& pool)
+        : m_pool(pool)
+    {
+        m_entries.reserve(pool.capacity());
+    }
+
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    int size() const { return m_entries.size(); }
+
+    // result 借自构造时的池，所有权转交本队列
+    void add(quint64 frameId, const Frame& frame, DetectionResult* result, int queuedFaces)
+    {
+        m_entries.append(Entry{ frameId, frame, result, queuedFaces });
+    }
+
+    // 按识别票据回填一张人脸；票据不属于任何等待中的帧时返回 false
+    bool fill(quint64 frameId, int faceIndex, const FaceInfo& face)
+    {
+        for (Entry& entry : m_entries) {
+            if (entry.frameId == frameId) {
+                entry.result->setFace(faceIndex, face);
+                entry.remaining--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 人脸全部返回的帧按入队顺序交给 handler(Frame&, DetectionResult&)，随后把结果归还到池
+    template <typename Handler>
+    void takeCompleted(Handler handler)
+    {
+        for (int i = 0; i < m_entries.size();) {
+            Entry& entry = m_entries[i];
+            if (entry.remaining > 0) {
+                ++i;
+                continue;
+            }
+
+            handler(entry.frame, *entry.result);
+            m_pool.release(entry.result);
+            m_entries.removeAt(i);
+        }
+    }
+
+private:
+    DetectionResultPool& m_pool;
+    QVector<Entry> m_entries;
+
+    Q_DISABLE_COPY(PendingFaceResults)
+};
+
+#endif // PENDINGFACERESULTS_H
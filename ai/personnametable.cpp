@@ -0,0 +1,64 @@
+// ai/personnametable.cpp
+#include "personnametable.h"
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QDebug>
+
+PersonNameTable& PersonNameTable::instance()
+{
+    static PersonNameTable table;
+    return table;
+}
+
+PersonNameTable::PersonNameTable()
+{
+    m_names.reserve(256);
+    m_names.append(QString());
+}
+
+quint16 PersonNameTable::intern(const QString& name)
+{
+    if (name.isEmpty()) {
+        return kNoName;
+    }
+
+    // 常见路径：已驻留的名字只取读锁查表
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_ids.constFind(name);
+        if (it != m_ids.constEnd()) {
+            return it.value();
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    auto it = m_ids.constFind(name);
+    if (it != m_ids.constEnd()) {
+        return it.value();
+    }
+
+    if (m_names.size() > kMaxNames) {
+        if (!m_fullWarned) {
+            qWarning() << "PersonNameTable: Table full, further names are reported as unknown";
+            m_fullWarned = true;
+        }
+        return kNoName;
+    }
+
+    const quint16 id = static_cast<quint16>(m_names.size());
+    m_names.append(name);
+    m_ids.insert(name, id);
+    return id;
+}
+
+QString PersonNameTable::name(quint16 id) const
+{
+    QReadLocker locker(&m_lock);
+    return id < m_names.size() ? m_names.at(id) : QString();
+}
+
+int PersonNameTable::size() const
+{
+    QReadLocker locker(&m_lock);
+    return m_names.size() - 1;
+}
@@ -0,0 +1,36 @@
+// ai/personnametable.h
+#ifndef PERSONNAMETABLE_H
+#define PERSONNAMETABLE_H
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <QReadWriteLock>
+
+// 🆕 人名驻留表：识别结果里只保存 16 位 id，界面显示时再查表取名
+// 名字首次出现时分配一次，之后同名查找不再分配；id 在进程生命周期内稳定，从不回收
+class PersonNameTable
+{
+public:
+    static const quint16 kNoName = 0;
+    static const int kMaxNames = 65535;
+
+    static PersonNameTable& instance();
+
+    // 空名返回 kNoName；表满时返回 kNoName 并打印一次警告
+    quint16 intern(const QString& name);
+    QString name(quint16 id) const;
+    int size() const;
+
+private:
+    PersonNameTable();
+
+    mutable QReadWriteLock m_lock;
+    QHash<QString, quint16> m_ids;
+    QVector<QString> m_names;       // 下标即 id，0 号为空名
+    bool m_fullWarned = false;
+
+    Q_DISABLE_COPY(PersonNameTable)
+};
+
+#endif // PERSONNAMETABLE_H
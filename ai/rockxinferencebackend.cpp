@@ -0,0 +1,225 @@
+// ai/rockxinferencebackend.cpp
+#include "rockxinferencebackend.h"
+#include <QDir>
+#include <QDebug>
+#include <cstring>
+
+RockxInferenceBackend::RockxInferenceBackend()
+    : m_faceDetHandle(nullptr)
+    , m_faceLandmarkHandle(nullptr)
+    , m_faceRecognizeHandle(nullptr)
+{
+}
+
+RockxInferenceBackend::~RockxInferenceBackend()
+{
+    cleanup();
+}
+
+QStringList RockxInferenceBackend::requiredModelFiles() const
+{
+    // 🔧 仅检查人脸识别必需的模型文件
+    return QStringList {
+        "face_detection_v3_fast.data",  // 人脸检测模型
+        "face_landmark5.data",          // 5点关键点模型
+        "face_recognition.data"         // 人脸识别模型
+    };
+}
+
+bool RockxInferenceBackend::initialize(const QString& modelPath)
+{
+    qDebug() << "========== RockX Initialization Debug ==========";
+    qDebug() << "RockX model directory:" << modelPath;
+
+    // 🔧 模型目录通过 rockx_config_t 显式传给每个句柄，不再修改工作目录和环境变量（进程全局状态），
+    //    推理池在运行时重建时不会影响其它线程
+    if (!createHandle(&m_faceDetHandle, ROCKX_MODULE_FACE_DETECTION, modelPath, "face detection")
+        || !createHandle(&m_faceLandmarkHandle, ROCKX_MODULE_FACE_LANDMARK_5, modelPath, "face landmark")
+        || !createHandle(&m_faceRecognizeHandle, ROCKX_MODULE_FACE_RECOGNIZE, modelPath, "face recognition")) {
+        cleanup();
+        return false;
+    }
+
+    qDebug() << "========== RockX Initialization Successful! ==========";
+    return true;
+}
+
+bool RockxInferenceBackend::createHandle(rockx_handle_t* handle, rockx_module_t module,
+                                         const QString& modelPath, const char* what)
+{
+    // RockX 要求数据目录以 / 结尾
+    QByteArray dataPath = QDir(modelPath).absolutePath().toLocal8Bit();
+    if (!dataPath.endsWith('/')) {
+        dataPath.append('/');
+    }
+
+    rockx_config_t* config = rockx_create_config();
+    rockx_add_config(config, const_cast<char*>(ROCKX_CONFIG_DATA_PATH), dataPath.data());
+    const rockx_ret_t ret = rockx_create(handle, module, config, sizeof(rockx_config_t));
+    rockx_release_config(config);
+
+    if (ret != ROCKX_RET_SUCCESS) {
+        qDebug() << " Failed to create" << what << "handle!";
+        qDebug() << "   Error code:" << ret;
+        switch (ret) {
+        case -1:
+            qDebug() << "     ROCKX_RET_FAIL (-1): General error";
+            break;
+        case -2:
+            qDebug() << "     Possible model file not found";
+            break;
+        case -3:
+            qDebug() << "     Possible memory allocation failure";
+            break;
+        default:
+            qDebug() << "     Unknown error code:" << ret;
+        }
+        *handle = nullptr;
+        return false;
+    }
+
+    qDebug() << "✓" << what << "handle created successfully";
+    return true;
+}
+
+void RockxInferenceBackend::cleanup()
+{
+    if (m_faceDetHandle) {
+        rockx_destroy(m_faceDetHandle);
+        m_faceDetHandle = nullptr;
+    }
+
+    if (m_faceLandmarkHandle) {
+        rockx_destroy(m_faceLandmarkHandle);
+        m_faceLandmarkHandle = nullptr;
+    }
+
+    if (m_faceRecognizeHandle) {
+        rockx_destroy(m_faceRecognizeHandle);
+        m_faceRecognizeHandle = nullptr;
+    }
+}
+
+rockx_image_t RockxInferenceBackend::wrapImage(const QImage& rgb)
+{
+    // 只读访问像素，避免 bits() 触发隐式共享的深拷贝
+    rockx_image_t image;
+    memset(&image, 0, sizeof(rockx_image_t));
+    image.width = rgb.width();
+    image.height = rgb.height();
+    image.pixel_format = ROCKX_PIXEL_FORMAT_RGB888;
+    image.data = const_cast<uint8_t*>(rgb.constBits());
+    image.size = rgb.sizeInBytes();
+    return image;
+}
+
+QVector<DetectedFace> RockxInferenceBackend::detect(const QImage& frame)
+{
+    QVector<DetectedFace> faces;
+
+    rockx_image_t input = wrapImage(frame);
+    rockx_object_array_t faceArray;
+    memset(&faceArray, 0, sizeof(rockx_object_array_t));
+
+    rockx_ret_t ret = rockx_face_detect(m_faceDetHandle, &input, &faceArray, nullptr);
+    if (ret != ROCKX_RET_SUCCESS) {
+        qDebug() << "RockxInferenceBackend: Face detection failed, error:" << ret;
+        return faces;
+    }
+
+    faces.reserve(faceArray.count);
+    for (int i = 0; i < faceArray.count; ++i) {
+        const rockx_object_t& obj = faceArray.object[i];
+
+        DetectedFace face;
+        face.box = QRect(obj.box.left, obj.box.top,
+                         obj.box.right - obj.box.left,
+                         obj.box.bottom - obj.box.top);
+        face.score = obj.score;
+        faces.append(face);
+    }
+
+    return faces;
+}
+
+bool RockxInferenceBackend::landmarks(const QImage& frame, const QRect& box, QPointF* points)
+{
+    rockx_image_t input = wrapImage(frame);
+    rockx_rect_t rockxBox;
+    rockxBox.left = box.left();
+    rockxBox.top = box.top();
+    rockxBox.right = box.left() + box.width();
+    rockxBox.bottom = box.top() + box.height();
+
+    rockx_face_landmark_t landmark;
+    memset(&landmark, 0, sizeof(rockx_face_landmark_t));
+
+    rockx_ret_t ret = rockx_face_landmark(m_faceLandmarkHandle, &input, &rockxBox, &landmark);
+    if (ret != ROCKX_RET_SUCCESS || landmark.landmarks_count < 5) {
+        return false;
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        points[i] = QPointF(landmark.landmarks[i].x, landmark.landmarks[i].y);
+    }
+    return true;
+}
+
+bool RockxInferenceBackend::align(const QImage& frame, const QRect& box, uchar* dst, int dstStride)
+{
+    const int cropSize = FaceBatch::kCropSize;
+
+    rockx_image_t input = wrapImage(frame);
+    rockx_rect_t rockxBox;
+    rockxBox.left = box.left();
+    rockxBox.top = box.top();
+    rockxBox.right = box.left() + box.width();
+    rockxBox.bottom = box.top() + box.height();
+
+    rockx_image_t alignedImage;
+    memset(&alignedImage, 0, sizeof(rockx_image_t));
+
+    rockx_ret_t ret = rockx_face_align(m_faceLandmarkHandle, &input, &rockxBox, nullptr, &alignedImage);
+    if (ret != ROCKX_RET_SUCCESS || !alignedImage.data) {
+        qDebug() << "RockxInferenceBackend: Face align failed, error:" << ret;
+        return false;
+    }
+
+    // RockX 输出由其分配，拷入调用方缓冲后立即释放
+    QImage aligned(alignedImage.data, alignedImage.width, alignedImage.height,
+                   alignedImage.width * FaceBatch::kChannels, QImage::Format_RGB888);
+    if (aligned.width() != cropSize || aligned.height() != cropSize) {
+        aligned = aligned.scaled(cropSize, cropSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    const int rowBytes = cropSize * FaceBatch::kChannels;
+    for (int y = 0; y < cropSize; ++y) {
+        memcpy(dst + y * dstStride, aligned.constScanLine(y), rowBytes);
+    }
+
+    rockx_image_release(&alignedImage);
+    return true;
+}
+
+bool RockxInferenceBackend::embed(const uchar* alignedRgb, float* feature)
+{
+    rockx_image_t faceImage;
+    memset(&faceImage, 0, sizeof(rockx_image_t));
+    faceImage.width = FaceBatch::kCropSize;
+    faceImage.height = FaceBatch::kCropSize;
+    faceImage.pixel_format = ROCKX_PIXEL_FORMAT_RGB888;
+    faceImage.data = const_cast<uint8_t*>(alignedRgb);
+    faceImage.size = FaceBatch::kCropBytes;
+
+    rockx_face_feature_t result;
+    memset(&result, 0, sizeof(rockx_face_feature_t));
+
+    rockx_ret_t ret = rockx_face_recognize(m_faceRecognizeHandle, &faceImage, &result);
+    if (ret != ROCKX_RET_SUCCESS) {
+        qDebug() << "RockxInferenceBackend: Face feature extraction failed, error:" << ret;
+        return false;
+    }
+
+    memcpy(feature, result.feature, kFeatureDim * sizeof(float));
+    return true;
+}
@@ -0,0 +1,36 @@
+// ai/rockxinferencebackend.h
+#ifndef ROCKXINFERENCEBACKEND_H
+#define ROCKXINFERENCEBACKEND_H
+
+#include <rockx.h>
+#include "inferencebackend.h"
+
+// 🆕 RockX (RV1126 NPU) 推理后端，仅在找到 RockX 库时编译（SV_HAVE_ROCKX）
+class RockxInferenceBackend : public InferenceBackend
+{
+public:
+    RockxInferenceBackend();
+    ~RockxInferenceBackend() override;
+
+    QString name() const override { return "rockx"; }
+    QStringList requiredModelFiles() const override;
+    bool initialize(const QString& modelPath) override;
+
+    QVector<DetectedFace> detect(const QImage& frame) override;
+    bool landmarks(const QImage& frame, const QRect& box, QPointF* points) override;
+    bool align(const QImage& frame, const QRect& box, uchar* dst, int dstStride) override;
+    bool embed(const uchar* alignedRgb, float* feature) override;
+
+private:
+    // 🔧 RockX句柄（参考官方示例）
+    rockx_handle_t m_faceDetHandle;
+    rockx_handle_t m_faceLandmarkHandle;  // 5点关键点
+    rockx_handle_t m_faceRecognizeHandle;
+
+    void cleanup();
+    static bool createHandle(rockx_handle_t* handle, rockx_module_t module,
+                             const QString& modelPath, const char* what);
+    static rockx_image_t wrapImage(const QImage& rgb);
+};
+
+#endif // ROCKXINFERENCEBACKEND_H
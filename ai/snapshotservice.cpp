@@ -0,0 +1,340 @@
+// ai/snapshotservice.cpp
+#include "snapshotservice.h"
+#include "jpegencoder.h"
+#include "../core/MetricsRegistry.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QThread>
+#include <QDebug>
+
+class SnapshotService::Worker : public QThread
+{
+public:
+    explicit Worker(SnapshotService* owner)
+        : m_owner(owner)
+    {
+        setObjectName("sv-snapshot");
+    }
+
+    // 以下只在工作线程中使用
+    JpegEncoder encoder;
+    QString lastDirectory;              // 最近确认存在的目录，连续写同一目录时不再 mkpath
+    QDate lastPruneDay;
+
+protected:
+    void run() override
+    {
+        Request request;
+        while (m_owner->takeRequest(&request)) {
+            m_owner->process(request, this);
+            request = Request();        // 尽快释放帧
+        }
+    }
+
+private:
+    SnapshotService* m_owner;
+};
+
+namespace {
+
+bool writeFile(const QString& path, const std::vector<uchar>& data, QString* lastDirectory)
+{
+    const QString dir = QFileInfo(path).absolutePath();
+    if (dir != *lastDirectory) {
+        QDir().mkpath(dir);
+        *lastDirectory = dir;
+    }
+
+    // 先写临时文件再改名：掉电或磁盘满时不会留下半张图片
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(reinterpret_cast<const char*>(data.data()), qint64(data.size())) != qint64(data.size())
+        || !file.commit()) {
+        qWarning() << "SnapshotService: Failed to write" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+SnapshotService& SnapshotService::instance()
+{
+    static SnapshotService service;
+    return service;
+}
+
+SnapshotService::SnapshotService()
+    : m_queueDepth(MetricsRegistry::instance().gauge("snapshot.queue.depth"))
+    , m_written(MetricsRegistry::instance().counter("snapshot.files.written"))
+    , m_dropped(MetricsRegistry::instance().counter("snapshot.dropped"))
+    , m_encodeMs(MetricsRegistry::instance().histogram("snapshot.encode_ms"))
+{
+}
+
+SnapshotService::~SnapshotService()
+{
+    stop();
+}
+
+void SnapshotService::start(const QString& rootDir)
+{
+    QMutexLocker controlLocker(&m_controlMutex);
+    if (m_worker) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_rootDir = rootDir.isEmpty() ? QCoreApplication::applicationDirPath() + "/data/snapshots" : rootDir;
+        m_stopping = false;
+    }
+
+    m_worker = new Worker(this);
+    m_worker->start(QThread::LowPriority);
+    qDebug() << "SnapshotService: Started, output:" << m_rootDir;
+}
+
+void SnapshotService::stop()
+{
+    QMutexLocker controlLocker(&m_controlMutex);
+    if (!m_worker) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    m_worker->wait();
+    delete m_worker;
+    m_worker = nullptr;
+}
+
+bool SnapshotService::isRunning() const
+{
+    QMutexLocker controlLocker(&m_controlMutex);
+    return m_worker != nullptr;
+}
+
+void SnapshotService::setOptions(const Options& options)
+{
+    QMutexLocker locker(&m_mutex);
+    m_options = options;
+    m_options.maxPendingEvents = qMax(1, options.maxPendingEvents);
+}
+
+SnapshotService::Options SnapshotService::options() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_options;
+}
+
+QString SnapshotService::rootDirectory() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_rootDir;
+}
+
+bool SnapshotService::submitEvent(const DetectionResult& result, const QImage& frame)
+{
+    if (frame.isNull() || !isRunning()) {
+        return false;
+    }
+
+    int coalesceMs = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        coalesceMs = m_options.coalesceMs;
+    }
+
+    EventCoalescer::Event event;
+    if (!m_coalescer.accept(result, coalesceMs, &event)) {
+        return false;
+    }
+
+    Request request;
+    request.event = true;
+    request.image = frame;
+    request.sourceId = result.sourceId;
+    request.timeMs = event.timeMs;
+    const int faces = qMin(result.faceCount, int(DetectionResult::kMaxFaces));
+    request.faces.reserve(faces);
+    for (int i = 0; i < faces; ++i) {
+        request.faces.append(result.faces[i].bbox);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_pendingEvents >= m_options.maxPendingEvents) {
+        // 磁盘跟不上时保留最新的事件，丢掉最旧的一条
+        for (auto it = m_queue.begin(); it != m_queue.end(); ++it) {
+            if (it->event) {
+                m_queue.erase(it);
+                --m_pendingEvents;
+                m_dropped->add();
+                break;
+            }
+        }
+    }
+    m_queue.enqueue(request);
+    ++m_pendingEvents;
+    m_queueDepth->set(m_queue.size());
+    m_wake.wakeOne();
+    return true;
+}
+
+void SnapshotService::saveImage(const QImage& image, const QString& path, int quality)
+{
+    if (image.isNull() || path.isEmpty()) {
+        return;
+    }
+    if (!isRunning()) {
+        start();
+    }
+
+    Request request;
+    request.image = image;
+    request.path = path;
+    request.quality = quality;
+
+    QMutexLocker locker(&m_mutex);
+    m_queue.enqueue(request);
+    m_queueDepth->set(m_queue.size());
+    m_wake.wakeOne();
+}
+
+void SnapshotService::flush()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    while (!m_queue.isEmpty() || m_busy) {
+        m_idle.wait(&m_mutex, 100);
+    }
+}
+
+bool SnapshotService::takeRequest(Request* request)
+{
+    QMutexLocker locker(&m_mutex);
+    m_busy = false;
+    while (m_queue.isEmpty()) {
+        m_idle.wakeAll();
+        if (m_stopping) {
+            return false;
+        }
+        m_wake.wait(&m_mutex);
+    }
+
+    *request = m_queue.dequeue();
+    if (request->event) {
+        --m_pendingEvents;
+    }
+    m_busy = true;
+    m_queueDepth->set(m_queue.size());
+    return true;
+}
+
+QString SnapshotService::basePath(int sourceId, qint64 timeMs) const
+{
+    const QDateTime time = QDateTime::fromMSecsSinceEpoch(timeMs);
+    QMutexLocker locker(&m_mutex);
+    return QString("%1/cam%2/%3/%4")
+        .arg(m_rootDir).arg(sourceId).arg(time.toString("yyyyMMdd"), time.toString("hhmmss_zzz"));
+}
+
+QString SnapshotService::framePath(int sourceId, qint64 timeMs) const
+{
+    return basePath(sourceId, timeMs) + ".jpg";
+}
+
+QString SnapshotService::thumbnailPath(int sourceId, qint64 timeMs) const
+{
+    return basePath(sourceId, timeMs) + "_thumb.jpg";
+}
+
+QString SnapshotService::facePath(int sourceId, qint64 timeMs, int faceIndex) const
+{
+    return QString("%1_face%2.jpg").arg(basePath(sourceId, timeMs)).arg(faceIndex);
+}
+
+void SnapshotService::process(const Request& request, Worker* worker)
+{
+    const Options options = this->options();
+    JpegEncoder& encoder = worker->encoder;
+    int files = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!request.event) {
+        if (encoder.encode(request.image, request.quality)
+            && writeFile(request.path, encoder.data(), &worker->lastDirectory)) {
+            ++files;
+        }
+    } else {
+        const QString base = basePath(request.sourceId, request.timeMs);
+        if (encoder.encode(request.image, options.frameQuality, QRect(), options.frameMaxEdge)
+            && writeFile(base + ".jpg", encoder.data(), &worker->lastDirectory)) {
+            ++files;
+        }
+        if (encoder.encode(request.image, options.thumbnailQuality, QRect(), options.thumbnailMaxEdge)
+            && writeFile(base + "_thumb.jpg", encoder.data(), &worker->lastDirectory)) {
+            ++files;
+        }
+
+        for (int i = 0; i < request.faces.size(); ++i) {
+            const QRect& box = request.faces[i];
+            const int dx = box.width() * options.faceMarginPercent / 100;
+            const int dy = box.height() * options.faceMarginPercent / 100;
+            const QRect crop = box.adjusted(-dx, -dy, dx, dy);
+            if (encoder.encode(request.image, options.faceQuality, crop, options.faceMaxEdge)
+                && writeFile(QString("%1_face%2.jpg").arg(base).arg(i), encoder.data(), &worker->lastDirectory)) {
+                ++files;
+            }
+        }
+    }
+
+    m_encodeMs->record(timer.nsecsElapsed() / 1e6);
+    m_written->add(quint64(files));
+
+    // 过期清理每天最多一次
+    const QDate today = QDate::currentDate();
+    if (options.retentionDays > 0 && worker->lastPruneDay != today) {
+        worker->lastPruneDay = today;
+        pruneExpired(options.retentionDays);
+    }
+}
+
+// 删除 <root>/cam*/<yyyyMMdd> 中早于保留期的日期目录
+void SnapshotService::pruneExpired(int retentionDays)
+{
+    const QDate cutoff = QDate::currentDate().addDays(-retentionDays);
+    const QDir root(rootDirectory());
+    int removed = 0;
+
+    const QStringList cameras = root.entryList(QStringList() << "cam*", QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& camera : cameras) {
+        QDir cameraDir(root.filePath(camera));
+        const QStringList days = cameraDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+        for (const QString& day : days) {
+            const QDate date = QDate::fromString(day, "yyyyMMdd");
+            if (!date.isValid() || date >= cutoff) {
+                continue;
+            }
+            if (QDir(cameraDir.filePath(day)).removeRecursively()) {
+                ++removed;
+            }
+        }
+    }
+
+    if (removed > 0) {
+        qDebug() << "SnapshotService: Removed" << removed << "day directories older than" << cutoff.toString(Qt::ISODate);
+    }
+}
@@ -0,0 +1,109 @@
+// ai/snapshotservice.h
+#ifndef SNAPSHOTSERVICE_H
+#define SNAPSHOTSERVICE_H
+
+#include <QImage>
+#include <QMutex>
+#include <QQueue>
+#include <QRect>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include "aitypes.h"
+#include "eventstore.h"
+
+class MetricCounter;
+class MetricGauge;
+class MetricHistogram;
+
+// 🆕 快照服务：JPEG 编码与写文件全部在后台线程完成，检测线程/界面线程只做入队
+// - submitEvent：事件快照（整帧 + 缩略图 + 每张人脸的裁剪图）。按 EventCoalescer 规则合并连拍，
+//   同一场景只在事件开始时截一次；文件名取事件时刻，与 EventStore 中的事件一一对应
+// - saveImage：任意图像异步存为 JPEG（人脸注册原图），不合并、不丢弃
+// - 事件快照队列有上限，满时丢弃最旧的一条；帧只做 QImage 引用计数拷贝
+// - 按 retentionDays 清理过期的日期目录（每天一次）
+// 文件：<root>/cam<N>/<yyyyMMdd>/<hhmmss_zzz>.jpg、_thumb.jpg、_face<i>.jpg
+// 指标：snapshot.queue.depth / snapshot.files.written / snapshot.dropped / snapshot.encode_ms
+class SnapshotService
+{
+public:
+    struct Options {
+        int maxPendingEvents = 8;
+        int coalesceMs = 2000;          // 与 EventStore::Options::coalesceMs 保持一致
+        int frameMaxEdge = 1280;        // 整帧快照长边上限
+        int frameQuality = 80;
+        int thumbnailMaxEdge = 160;
+        int thumbnailQuality = 70;
+        int faceMaxEdge = 224;
+        int faceQuality = 85;
+        int faceMarginPercent = 20;     // 人脸框向外扩展的比例
+        int retentionDays = 30;         // 0 为不清理
+    };
+
+    static SnapshotService& instance();
+
+    // rootDir 为空时使用 <应用目录>/data/snapshots；重复调用无效
+    void start(const QString& rootDir = QString());
+    void stop();                        // 写完队列后停止
+    bool isRunning() const;
+
+    void setOptions(const Options& options);
+    Options options() const;
+    QString rootDirectory() const;
+
+    // 检测线程调用，只入队；不是新事件或服务未启动时返回 false
+    bool submitEvent(const DetectionResult& result, const QImage& frame);
+    // 服务未启动时自动以默认目录启动
+    void saveImage(const QImage& image, const QString& path, int quality = 95);
+
+    // 阻塞直到此前入队的请求都已写盘
+    void flush();
+
+    QString framePath(int sourceId, qint64 timeMs) const;
+    QString thumbnailPath(int sourceId, qint64 timeMs) const;
+    QString facePath(int sourceId, qint64 timeMs, int faceIndex) const;
+
+private:
+    SnapshotService();
+    ~SnapshotService();
+
+    class Worker;
+    friend class Worker;
+
+    struct Request {
+        bool event = false;
+        QImage image;
+        QString path;                   // saveImage 的目标路径
+        int quality = 95;
+        int sourceId = 0;
+        qint64 timeMs = 0;
+        QVector<QRect> faces;
+    };
+
+    bool takeRequest(Request* request);
+    void process(const Request& request, Worker* worker);
+    void pruneExpired(int retentionDays);
+    QString basePath(int sourceId, qint64 timeMs) const;
+
+    mutable QMutex m_controlMutex;      // 保护 m_worker 的创建与销毁
+    Worker* m_worker = nullptr;
+
+    mutable QMutex m_mutex;             // 保护以下队列、配置与状态
+    QWaitCondition m_wake;
+    QWaitCondition m_idle;
+    QQueue<Request> m_queue;
+    int m_pendingEvents = 0;
+    bool m_busy = false;
+    bool m_stopping = false;
+    Options m_options;
+    QString m_rootDir;
+
+    EventCoalescer m_coalescer;
+
+    MetricGauge* m_queueDepth;
+    MetricCounter* m_written;
+    MetricCounter* m_dropped;
+    MetricHistogram* m_encodeMs;
+};
+
+#endif // SNAPSHOTSERVICE_H
@@ -0,0 +1,185 @@
+// benchmarks/bench_facedatabase.cpp
+// FaceDatabase 存储层基准：旧版(默认pragma、逐条事务、每次prepare) vs 调优版(WAL、语句缓存、批量事务)
+// 以及人脸库冷启动耗时（SQLite加载 vs 映射快照）
+//
+// 用法: bench_facedatabase [注册数量=2000] [查询次数=2000] [数据库目录=临时目录]
+
+#include "facedatabase.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDebug>
+#include <QVector>
+#include <random>
+
+namespace {
+
+struct BenchResult {
+    double enrollMs = 0.0;          // 注册总耗时
+    double enrollPerSec = 0.0;      // 注册吞吐
+    double recordLookupUs = 0.0;    // getFaceRecord 平均耗时
+    double featureLookupUs = 0.0;   // getFaceFeature 平均耗时
+    double updateLastSeenUs = 0.0;  // updateLastSeen 平均耗时
+};
+
+QByteArray createMockFeature(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    QByteArray feature(512 * sizeof(float), Qt::Uninitialized);
+    float* data = reinterpret_cast<float*>(feature.data());
+    for (int i = 0; i < 512; ++i) {
+        data[i] = dist(rng);
+    }
+    return feature;
+}
+
+QVector<FaceEnrollment> createEnrollments(int count)
+{
+    std::mt19937 rng(42);
+    QVector<FaceEnrollment> batch;
+    batch.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        FaceEnrollment enrollment;
+        enrollment.name = QString("Person_%1").arg(i, 6, 10, QChar('0'));
+        enrollment.imagePath = QString("faces/%1.jpg").arg(enrollment.name);
+        enrollment.feature = createMockFeature(rng);
+        enrollment.description = "benchmark";
+        batch.append(enrollment);
+    }
+    return batch;
+}
+
+template <typename Fn>
+double averageMicros(int iterations, Fn fn)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        fn(i);
+    }
+    return timer.nsecsElapsed() / 1000.0 / qMax(1, iterations);
+}
+
+BenchResult runBenchmark(const QString& dbPath, const FaceDatabase::StorageOptions& options,
+                         const QVector<FaceEnrollment>& batch, bool useBulkApi, int queries)
+{
+    BenchResult result;
+    QFile::remove(dbPath);
+
+    FaceDatabase db;
+    db.setStorageOptions(options);
+    if (!db.initialize(dbPath)) {
+        qWarning() << "Failed to initialize benchmark database:" << dbPath;
+        return result;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    if (useBulkApi) {
+        db.addFaceRecords(batch);
+    } else {
+        for (const FaceEnrollment& enrollment : batch) {
+            db.addFaceRecord(enrollment.name, enrollment.imagePath,
+                             enrollment.feature, enrollment.description);
+        }
+    }
+    result.enrollMs = timer.nsecsElapsed() / 1e6;
+    result.enrollPerSec = batch.size() / qMax(1e-3, result.enrollMs / 1000.0);
+
+    const int total = db.getTotalFaceCount();
+    if (total != batch.size()) {
+        qWarning() << "Unexpected record count:" << total << "expected:" << batch.size();
+    }
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> pick(1, qMax(1, total));
+    QVector<int> ids(queries);
+    for (int& id : ids) {
+        id = pick(rng);
+    }
+
+    result.recordLookupUs = averageMicros(queries, [&](int i) { db.getFaceRecord(ids[i]); });
+    result.featureLookupUs = averageMicros(queries, [&](int i) { db.getFaceFeature(ids[i]); });
+    result.updateLastSeenUs = averageMicros(queries, [&](int i) { db.updateLastSeen(ids[i]); });
+
+    return result;
+}
+
+// 冷启动：新连接打开数据库并发布人脸库的耗时（SQLite逐行加载 vs 映射快照）
+double coldGalleryMs(const QString& dbPath, const FaceDatabase::StorageOptions& options)
+{
+    FaceDatabase db;
+    db.setStorageOptions(options);
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!db.initialize(dbPath)) {
+        return -1.0;
+    }
+    QSharedPointer<const FaceGallery> gallery = db.gallery();
+    const double ms = timer.nsecsElapsed() / 1e6;
+
+    if (!gallery || gallery->personCount() == 0) {
+        qWarning() << "Cold start produced an empty gallery:" << dbPath;
+    }
+    return ms;
+}
+
+void printResult(const char* label, const BenchResult& r)
+{
+    printf("%-28s %10.1f %12.0f %14.1f %14.1f %14.1f\n", label,
+           r.enrollMs, r.enrollPerSec, r.recordLookupUs, r.featureLookupUs, r.updateLastSeenUs);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = app.arguments();
+    const int enrollCount = args.size() > 1 ? args.at(1).toInt() : 2000;
+    const int queryCount = args.size() > 2 ? args.at(2).toInt() : 2000;
+
+    QTemporaryDir tempDir;
+    const QString dbDir = args.size() > 3 ? args.at(3) : tempDir.path();
+
+    // 基准期间屏蔽qDebug输出，避免日志淹没计时
+    qInstallMessageHandler([](QtMsgType type, const QMessageLogContext&, const QString& msg) {
+        if (type != QtDebugMsg) {
+            fprintf(stderr, "%s\n", qPrintable(msg));
+        }
+    });
+
+    const QVector<FaceEnrollment> batch = createEnrollments(enrollCount);
+
+    printf("FaceDatabase benchmark: %d enrollments, %d queries, db dir %s\n",
+           enrollCount, queryCount, qPrintable(dbDir));
+    printf("%-28s %10s %12s %14s %14s %14s\n", "configuration",
+           "enroll ms", "enroll/s", "record us", "feature us", "lastSeen us");
+
+    printResult("legacy (per-row, no tuning)",
+                runBenchmark(dbDir + "/bench_legacy.db", FaceDatabase::StorageOptions::legacy(),
+                             batch, false, queryCount));
+    printResult("tuned (per-row)",
+                runBenchmark(dbDir + "/bench_tuned_rows.db", FaceDatabase::StorageOptions(),
+                             batch, false, queryCount));
+    printResult("tuned (addFaceRecords)",
+                runBenchmark(dbDir + "/bench_tuned_bulk.db", FaceDatabase::StorageOptions(),
+                             batch, true, queryCount));
+
+    // 人脸库冷启动：同一数据库分别以 无快照 / 首次生成快照 / 映射已有快照 打开
+    const QString coldDb = dbDir + "/bench_tuned_bulk.db";
+    FaceDatabase::StorageOptions noSnapshot;
+    noSnapshot.enableGallerySnapshot = false;
+
+    printf("\nGallery cold start (%d persons)\n", enrollCount);
+    printf("%-28s %10.2f ms\n", "sqlite load", coldGalleryMs(coldDb, noSnapshot));
+    // 注册时已生成快照，删掉后测首次生成
+    QFile::remove(dbDir + "/bench_tuned_bulk.gallery");
+    printf("%-28s %10.2f ms\n", "sqlite load + write snapshot", coldGalleryMs(coldDb, FaceDatabase::StorageOptions()));
+    printf("%-28s %10.2f ms\n", "mapped snapshot", coldGalleryMs(coldDb, FaceDatabase::StorageOptions()));
+
+    return 0;
+}
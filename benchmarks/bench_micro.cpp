@@ -0,0 +1,372 @@
+// benchmarks/bench_micro.cpp
+// 热点原语微基准：特征相似度、人脸库匹配（1k ~ 1M 模板）、QImage/cv::Mat 转换与颜色空间转换、
+// 采集旋转、缩放、检测结果叠加绘制，每个用例自动确定迭代次数，报告每次调用的 real/cpu 时间
+// JSON 输出与 Google Benchmark 格式兼容，可用其 tools/compare.py 对比两次提交：
+//   bench_micro --json before.json   ...   compare.py benchmarks before.json after.json
+//
+// 用法: bench_micro [--filter 正则] [--min-time 秒=0.5] [--repetitions n] [--json 路径|-]
+//                   [--max-gallery 模板数=100000] [--list]
+// 1M 模板的人脸库约占 2GB 内存，需显式 --max-gallery 1000000
+
+#include "microbench.h"
+#include "facedatabase.h"
+#include "facegallery.h"
+#include "motiondetector.h"
+#include "detectionvisualizer.h"
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QTransform>
+#include <QImage>
+#include <QDebug>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <memory>
+#include <random>
+
+namespace {
+
+const int kFeatureBytes = FaceGallery::kFeatureDim * sizeof(float);
+
+// 与 CaptureThread 输出一致：MIPI 竖屏 720x1280 RGB888，旋转后为 1280x720
+const QSize kCaptureSize(720, 1280);
+const QSize kFrameSize(1280, 720);
+
+QByteArray createMockFeature(std::mt19937& rng)
+{
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    QByteArray feature(kFeatureBytes, Qt::Uninitialized);
+    float* data = reinterpret_cast<float*>(feature.data());
+    for (int i = 0; i < FaceGallery::kFeatureDim; ++i) {
+        data[i] = dist(rng);
+    }
+    return feature;
+}
+
+// 带纹理的合成帧：渐变 + 噪声，避免纯色让转换/缩放路径走捷径
+QImage createFrame(const QSize& size, QImage::Format format)
+{
+    QImage image(size, QImage::Format_RGB888);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> noise(-24, 24);
+    for (int y = 0; y < size.height(); ++y) {
+        uchar* line = image.scanLine(y);
+        for (int x = 0; x < size.width(); ++x) {
+            for (int c = 0; c < 3; ++c) {
+                int v = (x * 255 / size.width() + y * 255 / size.height() + c * 40) / 2 + noise(rng);
+                line[x * 3 + c] = uchar(qBound(0, v, 255));
+            }
+        }
+    }
+    return format == QImage::Format_RGB888 ? image : image.convertToFormat(format);
+}
+
+qint64 imageBytes(const QImage& image)
+{
+    return qint64(image.bytesPerLine()) * image.height();
+}
+
+// 人脸库夹具按规模缓存，跨多次校准运行复用；同一时间只保留一个规模，避免 1M 与 100k 同时驻留
+struct Fixtures {
+    std::unique_ptr<FaceGallery> gallery;
+    int gallerySize = 0;
+
+    std::unique_ptr<QTemporaryDir> databaseDir;
+    std::unique_ptr<FaceDatabase> database;
+    int databaseSize = 0;
+
+    std::unique_ptr<DetectionVisualizer> visualizer;
+};
+
+Fixtures& fixtures()
+{
+    static Fixtures instance;
+    return instance;
+}
+
+// 在应用对象析构前释放（FaceDatabase 持有 SQLite 连接，DetectionVisualizer 是 QObject）
+void releaseFixtures()
+{
+    Fixtures& f = fixtures();
+    f.gallery.reset();
+    f.database.reset();
+    f.databaseDir.reset();
+    f.visualizer.reset();
+    f.gallerySize = 0;
+    f.databaseSize = 0;
+}
+
+// 合成人脸库，每人一个模板
+const FaceGallery& syntheticGallery(int templates)
+{
+    Fixtures& f = fixtures();
+    if (f.gallerySize != templates) {
+        f.gallery.reset();
+        f.gallery.reset(new FaceGallery);
+        f.gallery->reserve(templates, templates);
+
+        std::mt19937 rng(42);
+        for (int i = 0; i < templates; ++i) {
+            const QByteArray feature = createMockFeature(rng);
+            f.gallery->beginPerson(i + 1, QString("Person_%1").arg(i, 7, 10, QChar('0')));
+            f.gallery->addTemplate(i + 1, reinterpret_cast<const float*>(feature.constData()));
+        }
+        f.gallerySize = templates;
+    }
+    return *f.gallery;
+}
+
+// 完整 FaceDatabase 路径（加锁取快照 + 聚合打分），SQLite 放在临时目录
+FaceDatabase* syntheticDatabase(int templates)
+{
+    Fixtures& f = fixtures();
+    if (f.databaseSize != templates) {
+        f.database.reset();
+        f.databaseSize = 0;
+        f.databaseDir.reset(new QTemporaryDir);
+        std::unique_ptr<FaceDatabase> database(new FaceDatabase);
+        if (!f.databaseDir->isValid() || !database->initialize(f.databaseDir->filePath("bench_micro.db"))) {
+            return nullptr;
+        }
+
+        std::mt19937 rng(42);
+        QVector<FaceEnrollment> batch;
+        batch.reserve(templates);
+        for (int i = 0; i < templates; ++i) {
+            FaceEnrollment enrollment;
+            enrollment.name = QString("Person_%1").arg(i, 7, 10, QChar('0'));
+            enrollment.feature = createMockFeature(rng);
+            batch.append(enrollment);
+        }
+        if (database->addFaceRecords(batch) != templates) {
+            return nullptr;
+        }
+        f.database = std::move(database);
+        f.databaseSize = templates;
+    }
+    return f.database.get();
+}
+
+DetectionResult createDetectionResult()
+{
+    DetectionResult result;
+    result.timestampNs = monotonicNowNs();
+    result.hasMotion = true;
+    result.motionArea = QRect(320, 120, 640, 480);
+    result.hasFaceDetection = true;
+    result.motionProcessTime = 3.2f;
+    result.faceDetectionTime = 18.5f;
+    result.faceRecognitionTime = 6.1f;
+
+    for (int i = 0; i < 4; ++i) {
+        FaceInfo face;
+        face.bbox = QRect(360 + i * 150, 200 + (i % 2) * 60, 120, 140);
+        face.confidence = 0.9f;
+        face.isRecognized = (i % 2 == 0);
+        face.personName = face.isRecognized ? QString("Person_%1").arg(i) : QString();
+        face.faceId = face.isRecognized ? i + 1 : -1;
+        face.similarity = face.isRecognized ? 0.82f : 0.0f;
+        result.appendFace(face);
+    }
+    result.recognizedFaceCount = 2;
+    result.unknownFaceCount = 2;
+    return result;
+}
+
+// ---- 特征匹配 ----
+
+void registerMatching(int maxGallery)
+{
+    MicroBench::registerBenchmark("similarity/calculateFeatureSimilarity", [](MicroBench::State& state) {
+        std::mt19937 rng(1);
+        const QByteArray a = createMockFeature(rng);
+        const QByteArray b = createMockFeature(rng);
+        while (state.keepRunning()) {
+            MicroBench::doNotOptimize(FaceDatabase::calculateFeatureSimilarity(a, b));
+        }
+        state.setItemsProcessed(state.iterations());
+    });
+
+    for (int templates = 1000; templates <= maxGallery; templates *= 10) {
+        MicroBench::registerBenchmark(QString("gallery/bestMatch/%1").arg(templates), [templates](MicroBench::State& state) {
+            const FaceGallery& gallery = syntheticGallery(templates);
+            std::mt19937 rng(7);
+            const QByteArray query = createMockFeature(rng);
+            const float* queryData = reinterpret_cast<const float*>(query.constData());
+            while (state.keepRunning()) {
+                MicroBench::doNotOptimize(gallery.bestMatch(queryData));
+            }
+            state.setItemsProcessed(state.iterations() * templates);
+            state.setBytesProcessed(state.iterations() * templates * qint64(kFeatureBytes));
+        });
+    }
+
+    // 经 SQLite 批量写入后走完整 findBestMatch；规模受写库耗时限制在 10k 以内
+    for (int templates = 1000; templates <= qMin(maxGallery, 10000); templates *= 10) {
+        MicroBench::registerBenchmark(QString("facedb/findBestMatch/%1").arg(templates), [templates](MicroBench::State& state) {
+            FaceDatabase* database = syntheticDatabase(templates);
+            if (!database) {
+                state.skipWithError("failed to build synthetic face database");
+                return;
+            }
+            std::mt19937 rng(7);
+            const QByteArray query = createMockFeature(rng);
+            float similarity = 0.0f;
+            while (state.keepRunning()) {
+                MicroBench::doNotOptimize(database->findBestMatch(query, similarity, 0.0f));
+            }
+            state.setItemsProcessed(state.iterations() * templates);
+        });
+    }
+}
+
+// ---- 图像转换 ----
+
+void registerConversions()
+{
+    MicroBench::registerBenchmark("convert/qImageToCvMat/RGB888_720p", [](MicroBench::State& state) {
+        const QImage frame = createFrame(kFrameSize, QImage::Format_RGB888);
+        while (state.keepRunning()) {
+            MicroBench::doNotOptimize(MotionDetector::qImageToCvMat(frame));
+        }
+        state.setBytesProcessed(state.iterations() * imageBytes(frame));
+    });
+
+    MicroBench::registerBenchmark("convert/qImageToCvMat/RGB32_720p", [](MicroBench::State& state) {
+        const QImage frame = createFrame(kFrameSize, QImage::Format_RGB32);
+        while (state.keepRunning()) {
+            MicroBench::doNotOptimize(MotionDetector::qImageToCvMat(frame));
+        }
+        state.setBytesProcessed(state.iterations() * imageBytes(frame));
+    });
+
+    MicroBench::registerBenchmark("convert/rgbSwapped/RGB888_720p", [](MicroBench::State& state) {
+        const QImage frame = createFrame(kFrameSize, QImage::Format_RGB888);
+        while (state.keepRunning()) {
+            MicroBench::doNotOptimize(frame.rgbSwapped());
+        }
+        state.setBytesProcessed(state.iterations() * imageBytes(frame));
+    });
+
+    MicroBench::registerBenchmark("convert/convertToFormat/RGB32_to_RGB888_720p", [](MicroBench::State& state) {
+        const QImage frame = createFrame(kFrameSize, QImage::Format_RGB32);
+        while (state.keepRunning()) {
+            MicroBench::doNotOptimize(frame.convertToFormat(QImage::Format_RGB888));
+        }
+        state.setBytesProcessed(state.iterations() * imageBytes(frame));
+    });
+
+    MicroBench::registerBenchmark("convert/convertToFormat/RGB888_to_Grayscale8_720p", [](MicroBench::State& state) {
+        const QImage frame = createFrame(kFrameSize, QImage::Format_RGB888);
+        while (state.keepRunning()) {
+            MicroBench::doNotOptimize(frame.convertToFormat(QImage::Format_Grayscale8));
+        }
+        state.setBytesProcessed(state.iterations() * imageBytes(frame));
+    });
+
+    MicroBench::registerBenchmark("convert/cvtColor/BGR2GRAY_720p", [](MicroBench::State& state) {
+        const cv::Mat bgr = MotionDetector::qImageToCvMat(createFrame(kFrameSize, QImage::Format_RGB888));
+        cv::Mat gray;
+        while (state.keepRunning()) {
+            cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+            MicroBench::doNotOptimize(gray.data);
+        }
+        state.setBytesProcessed(state.iterations() * qint64(bgr.total() * bgr.elemSize()));
+    });
+
+    // 解码器/ISP 常见输出格式 NV12 → BGR
+    MicroBench::registerBenchmark("convert/cvtColor/NV12_to_BGR_720p", [](MicroBench::State& state) {
+        cv::Mat nv12(kFrameSize.height() * 3 / 2, kFrameSize.width(), CV_8UC1);
+        cv::randu(nv12, 0, 256);
+        cv::Mat bgr;
+        while (state.keepRunning()) {
+            cv::cvtColor(nv12, bgr, cv::COLOR_YUV2BGR_NV12);
+            MicroBench::doNotOptimize(bgr.data);
+        }
+        state.setBytesProcessed(state.iterations() * qint64(nv12.total()));
+    });
+}
+
+// ---- 旋转 / 缩放 / 绘制 ----
+
+void registerTransforms()
+{
+    // 与 CaptureThread 相同：QTransform::rotate(-270)，720x1280 → 1280x720
+    MicroBench::registerBenchmark("transform/rotate90/QImage_720x1280", [](MicroBench::State& state) {
+        const QImage frame = createFrame(kCaptureSize, QImage::Format_RGB888);
+        QTransform transform;
+        transform.rotate(-270);
+        while (state.keepRunning()) {
+            MicroBench::doNotOptimize(frame.transformed(transform));
+        }
+        state.setBytesProcessed(state.iterations() * imageBytes(frame));
+    });
+
+    MicroBench::registerBenchmark("transform/rotate90/cvRotate_720x1280", [](MicroBench::State& state) {
+        const QImage frame = createFrame(kCaptureSize, QImage::Format_RGB888);
+        const cv::Mat src(frame.height(), frame.width(), CV_8UC3,
+                          const_cast<uchar*>(frame.constBits()), frame.bytesPerLine());
+        cv::Mat dst;
+        while (state.keepRunning()) {
+            cv::rotate(src, dst, cv::ROTATE_90_CLOCKWISE);
+            MicroBench::doNotOptimize(dst.data);
+        }
+        state.setBytesProcessed(state.iterations() * imageBytes(frame));
+    });
+
+    MicroBench::registerBenchmark("scale/smooth/720p_to_640x360", [](MicroBench::State& state) {
+        const QImage frame = createFrame(kFrameSize, QImage::Format_RGB888);
+        while (state.keepRunning()) {
+            MicroBench::doNotOptimize(frame.scaled(640, 360, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+        }
+        state.setBytesProcessed(state.iterations() * imageBytes(frame));
+    });
+
+    MicroBench::registerBenchmark("scale/fast/720p_to_640x360", [](MicroBench::State& state) {
+        const QImage frame = createFrame(kFrameSize, QImage::Format_RGB888);
+        while (state.keepRunning()) {
+            MicroBench::doNotOptimize(frame.scaled(640, 360, Qt::IgnoreAspectRatio, Qt::FastTransformation));
+        }
+        state.setBytesProcessed(state.iterations() * imageBytes(frame));
+    });
+
+    MicroBench::registerBenchmark("draw/drawDetections/720p_motion_4faces", [](MicroBench::State& state) {
+        Fixtures& f = fixtures();
+        if (!f.visualizer) {
+            f.visualizer.reset(new DetectionVisualizer);
+        }
+        const QImage frame = createFrame(kFrameSize, QImage::Format_RGB888);
+        const DetectionResult result = createDetectionResult();
+        while (state.keepRunning()) {
+            MicroBench::doNotOptimize(f.visualizer->drawDetections(frame, result));
+        }
+        state.setItemsProcessed(state.iterations());
+    });
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // drawDetections 需要字体，无显示环境时使用 offscreen 平台
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("SecureVision micro benchmarks");
+    parser.addHelpOption();
+    MicroBench::addOptions(parser);
+    QCommandLineOption maxGalleryOption("max-gallery", "Largest synthetic gallery size (1000 x 10^k).", "templates", "100000");
+    parser.addOption(maxGalleryOption);
+    parser.process(app);
+
+    registerMatching(qMax(1000, parser.value(maxGalleryOption).toInt()));
+    registerConversions();
+    registerTransforms();
+
+    const int exitCode = MicroBench::runRegistered(parser);
+    releaseFixtures();
+    return exitCode;
+}
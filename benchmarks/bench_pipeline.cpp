@@ -0,0 +1,424 @@
+// benchmarks/bench_pipeline.cpp
+// 离线流水线基准：解码录像文件，逐帧走 运动检测 → 人脸检测/对齐 → 特征提取 → 人脸库匹配，
+// 使用与设备相同的 AIConfig（默认值），输出吞吐与各阶段 p50/p95/p99（文本 + 可选 JSON）
+// 推理后端默认 cpu（不依赖模型与 NPU），可在普通 Linux 主机上对比 MotionDetector /
+// FaceRecognitionManager 改动前后的性能
+//
+// 与 AIDetectionThread 的差异（为了让每帧耗时可归因、结果可复现）：
+// - 不跳帧、不经过延迟预算调度器，每帧都做运动与人脸检测
+// - 识别逐帧完成（detectAndRecognizeFaces），不跨帧攒批
+// 人脸子阶段（face_detect / align / recognize / db_match 等）取自 TraceRecorder 作用域，按帧求和
+//
+// 用法: bench_pipeline [选项] [视频文件...]   未指定视频时使用 Resource/videoDefault/*.mp4
+
+#include "aitypes.h"
+#include "motiondetector.h"
+#include "facerecognitionmanager.h"
+#include "snapshotservice.h"
+#include "../core/TraceRecorder.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QDebug>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/videoio/videoio.hpp>
+#include <algorithm>
+#include <cstdio>
+
+#ifndef SV_DEFAULT_VIDEO_DIR
+#define SV_DEFAULT_VIDEO_DIR "Resource/videoDefault"
+#endif
+
+namespace {
+
+// 阶段名 -> 每帧耗时样本（毫秒），按首次出现顺序输出
+class StageSamples {
+public:
+    void add(const QString& stage, double ms) {
+        if (!m_samples.contains(stage)) {
+            m_order.append(stage);
+        }
+        m_samples[stage].append(ms);
+    }
+
+    const QStringList& stages() const { return m_order; }
+    QVector<double> sorted(const QString& stage) const {
+        QVector<double> values = m_samples.value(stage);
+        std::sort(values.begin(), values.end());
+        return values;
+    }
+
+private:
+    QStringList m_order;
+    QHash<QString, QVector<double>> m_samples;
+};
+
+// 线性插值分位数（values 已排序）
+double percentile(const QVector<double>& values, double q)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    const double position = q * (values.size() - 1);
+    const int lower = static_cast<int>(position);
+    const int upper = qMin(lower + 1, values.size() - 1);
+    return values[lower] + (values[upper] - values[lower]) * (position - lower);
+}
+
+double mean(const QVector<double>& values)
+{
+    double sum = 0.0;
+    for (double v : values) {
+        sum += v;
+    }
+    return values.isEmpty() ? 0.0 : sum / values.size();
+}
+
+struct BenchTotals {
+    int frames = 0;
+    int framesWithMotion = 0;
+    int faces = 0;
+    int recognizedFaces = 0;
+    int lateFrames = 0;         // 按帧率送帧时处理超过帧间隔的帧数
+    double wallMs = 0.0;
+};
+
+double elapsedMs(const QElapsedTimer& timer)
+{
+    return timer.nsecsElapsed() / 1e6;
+}
+
+// 与 USBCaptureThread 相同的转换：BGR Mat -> RGB888 QImage（深拷贝）
+QImage toRgbImage(const cv::Mat& bgr)
+{
+    cv::Mat rgb;
+    cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+    return QImage(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888).copy();
+}
+
+QStringList defaultVideos()
+{
+    QDir dir(SV_DEFAULT_VIDEO_DIR);
+    QStringList videos;
+    for (const QString& name : dir.entryList(QStringList() << "*.mp4", QDir::Files, QDir::Name)) {
+        videos.append(dir.filePath(name));
+    }
+    return videos;
+}
+
+// 目录下全部文件（递归，相对路径）；目录不存在时为空
+QStringList listFiles(const QString& dir)
+{
+    QStringList files;
+    QDirIterator it(dir, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        files.append(QDir(dir).relativeFilePath(it.next()));
+    }
+    files.sort();
+    return files;
+}
+
+// 从第一个视频均匀抽取 count 帧注册为人员，使匹配阶段面对非空人脸库
+int enrollFromVideo(FaceRecognitionManager& faces, const QString& video, int count)
+{
+    cv::VideoCapture capture(video.toStdString());
+    if (!capture.isOpened() || count <= 0) {
+        return 0;
+    }
+
+    const int frameCount = qMax(1, static_cast<int>(capture.get(cv::CAP_PROP_FRAME_COUNT)));
+    const int step = qMax(1, frameCount / count);
+    int enrolled = 0;
+    cv::Mat bgr;
+    for (int index = 0; enrolled < count && capture.read(bgr); ++index) {
+        if (index % step != 0 || bgr.empty()) {
+            continue;
+        }
+        if (faces.registerFace(QString("bench_%1").arg(enrolled), toRgbImage(bgr))) {
+            ++enrolled;
+        }
+    }
+    return enrolled;
+}
+
+void runVideo(const QString& video, const AIConfig& config, MotionDetector& motion,
+              FaceRecognitionManager& faces, int maxFrames, bool paced,
+              StageSamples& samples, BenchTotals& totals)
+{
+    cv::VideoCapture capture(video.toStdString());
+    if (!capture.isOpened()) {
+        qWarning() << "Failed to open video:" << video;
+        return;
+    }
+
+    const double fps = capture.get(cv::CAP_PROP_FPS);
+    const double frameIntervalMs = fps > 0.0 ? 1000.0 / fps : 0.0;
+    qDebug().noquote() << QString("Video %1: %2x%3 @ %4 fps")
+                              .arg(video)
+                              .arg(static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH)))
+                              .arg(static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT)))
+                              .arg(fps, 0, 'f', 2);
+
+    TraceRecorder& tracer = TraceRecorder::instance();
+    QElapsedTimer videoClock;
+    videoClock.start();
+
+    for (int index = 0; maxFrames <= 0 || index < maxFrames; ++index) {
+        // 按帧率送帧：等到该帧的到达时刻
+        if (paced && frameIntervalMs > 0.0) {
+            const double dueMs = index * frameIntervalMs;
+            const double waitMs = dueMs - elapsedMs(videoClock);
+            if (waitMs > 0.0) {
+                QThread::usleep(static_cast<unsigned long>(waitMs * 1000.0));
+            } else if (waitMs < -frameIntervalMs) {
+                ++totals.lateFrames;
+            }
+        }
+
+        QElapsedTimer frameTimer;
+        frameTimer.start();
+
+        QElapsedTimer stageTimer;
+        stageTimer.start();
+        cv::Mat bgr;
+        if (!capture.read(bgr) || bgr.empty()) {
+            break;
+        }
+        samples.add("decode", elapsedMs(stageTimer));
+
+        stageTimer.restart();
+        const QImage image = toRgbImage(bgr);
+        samples.add("to_qimage", elapsedMs(stageTimer));
+
+        tracer.start();
+
+        if (config.enableMotionDetect) {
+            stageTimer.restart();
+            QRect motionArea;
+            if (motion.detectMotion(image, motionArea)) {
+                ++totals.framesWithMotion;
+            }
+            samples.add("motion", elapsedMs(stageTimer));
+        }
+
+        if (config.enableFaceDetect) {
+            stageTimer.restart();
+            const QVector<FaceInfo> detected = config.enableFaceRecognition
+                                                   ? faces.detectAndRecognizeFaces(image, 0)
+                                                   : faces.detectFaces(image);
+            samples.add("face", elapsedMs(stageTimer));
+
+            totals.faces += detected.size();
+            for (const FaceInfo& face : detected) {
+                totals.recognizedFaces += face.isRecognized ? 1 : 0;
+            }
+        }
+
+        // 追踪作用域按帧求和（同一帧内多张人脸的 align 等合计）
+        QHash<QString, double> scopeMs;
+        QStringList scopeOrder;
+        for (const TraceRecorder::Event& event : tracer.collect()) {
+            const QString key = QString("%1.%2").arg(event.category).arg(event.name);
+            if (!scopeMs.contains(key)) {
+                scopeOrder.append(key);
+            }
+            scopeMs[key] += event.durationNs / 1e6;
+        }
+        for (const QString& key : scopeOrder) {
+            samples.add(key, scopeMs.value(key));
+        }
+
+        samples.add("frame_total", elapsedMs(frameTimer));
+        ++totals.frames;
+    }
+
+    totals.wallMs += elapsedMs(videoClock);
+}
+
+QJsonObject stageJson(const QVector<double>& values)
+{
+    QJsonObject stage;
+    stage["count"] = values.size();
+    stage["meanMs"] = mean(values);
+    stage["p50Ms"] = percentile(values, 0.50);
+    stage["p95Ms"] = percentile(values, 0.95);
+    stage["p99Ms"] = percentile(values, 0.99);
+    stage["maxMs"] = values.isEmpty() ? 0.0 : values.last();
+    return stage;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("SecureVision offline pipeline benchmark");
+    parser.addHelpOption();
+    parser.addPositionalArgument("videos", "Video files (default: Resource/videoDefault/*.mp4)", "[videos...]");
+    QCommandLineOption backendOption("backend", "Inference backend (default: cpu).", "name", "cpu");
+    QCommandLineOption framesOption("frames", "Max frames per video, 0 = all.", "n", "0");
+    QCommandLineOption pacedOption("paced", "Feed frames at the video frame rate instead of as fast as possible.");
+    QCommandLineOption enrollOption("enroll", "Persons to enroll from the first video before timing.", "n", "8");
+    QCommandLineOption jsonOption("json", "Write a JSON report to this path ('-' for stdout).", "path");
+    QCommandLineOption noMotionOption("no-motion", "Disable motion detection.");
+    QCommandLineOption noRecognitionOption("no-recognition", "Detect faces only.");
+    parser.addOptions({backendOption, framesOption, pacedOption, enrollOption, jsonOption,
+                       noMotionOption, noRecognitionOption});
+    parser.process(app);
+
+    QStringList videos = parser.positionalArguments();
+    if (videos.isEmpty()) {
+        videos = defaultVideos();
+    }
+    if (videos.isEmpty()) {
+        qWarning() << "No input videos found (looked in" << SV_DEFAULT_VIDEO_DIR << ")";
+        return 1;
+    }
+
+    // 与设备同一份默认配置，只覆盖命令行指定的项
+    AIConfig config;
+    config.inferenceBackend = parser.value(backendOption);
+    config.enableMotionDetect = !parser.isSet(noMotionOption);
+    config.enableFaceRecognition = !parser.isSet(noRecognitionOption);
+    const int maxFrames = parser.value(framesOption).toInt();
+    const bool paced = parser.isSet(pacedOption);
+
+    MotionDetector motion;
+    motion.setThreshold(config.motionThreshold);
+    motion.setROI(config.roiArea);
+
+    // 人脸库、注册图片与快照都放在临时目录，不影响设备/开发机上的真实数据
+    QTemporaryDir dataDir;
+    const QString realDataDir = QCoreApplication::applicationDirPath() + "/data";
+    const QStringList realDataBefore = listFiles(realDataDir);
+    SnapshotService::instance().start(dataDir.path() + "/snapshots");
+    FaceRecognitionManager faces;
+    faces.setDataDirectory(dataDir.path());
+    faces.setInferenceBackend(config.inferenceBackend);
+    faces.setInferencePoolSize(config.inferencePoolSize);
+    faces.setMaxImageSize(config.maxImageWidth, config.maxImageHeight);
+    faces.setDetectionThreshold(config.faceThreshold);
+    faces.setRecognitionThreshold(config.faceRecognitionThreshold);
+    faces.setTemplatePolicy(config.templateAggregation, config.templateTopN, config.maxTemplatesPerPerson);
+
+    FaceQualityConfig quality;
+    quality.enabled = config.enableFaceQualityGate;
+    quality.minFaceSize = config.minFaceSize;
+    quality.minSharpness = config.minFaceSharpness;
+    quality.maxYaw = config.maxFaceYaw;
+    quality.minBrightness = config.minFaceBrightness;
+    quality.maxBrightness = config.maxFaceBrightness;
+    quality.trackReuseMs = config.faceTrackReuseMs;
+    faces.setQualityConfig(quality);
+
+    if (config.enableFaceDetect && !faces.initialize(config.faceModelPath)) {
+        qWarning() << "Failed to initialize face pipeline with backend" << config.inferenceBackend;
+        return 1;
+    }
+
+    const int enrolled = config.enableFaceRecognition
+                             ? enrollFromVideo(faces, videos.first(), parser.value(enrollOption).toInt())
+                             : 0;
+
+    // 注册图片由快照服务异步写出：写完后确认都落在临时目录，真实数据目录没有新增或改动
+    SnapshotService::instance().flush();
+    SnapshotService::instance().stop();
+    if (listFiles(realDataDir) != realDataBefore) {
+        qWarning() << "Enrollment wrote outside the temporary data directory:" << realDataDir;
+        return 1;
+    }
+    if (enrolled > 0 && listFiles(dataDir.path() + "/faces").size() < enrolled) {
+        qWarning() << "Enrollment images missing from" << dataDir.path() + "/faces";
+        return 1;
+    }
+
+    StageSamples samples;
+    BenchTotals totals;
+    for (const QString& video : videos) {
+        runVideo(video, config, motion, faces, maxFrames, paced, samples, totals);
+    }
+
+    if (totals.frames == 0) {
+        qWarning() << "No frames decoded";
+        return 1;
+    }
+
+    const double fps = totals.frames * 1000.0 / qMax(1.0, totals.wallMs);
+
+    // ---- 文本报告 ----
+    qDebug().noquote() << QString("Backend: %1, mode: %2, enrolled persons: %3")
+                              .arg(config.inferenceBackend)
+                              .arg(paced ? "paced" : "as-fast-as-possible")
+                              .arg(enrolled);
+    qDebug().noquote() << QString("Frames: %1 in %2 ms -> %3 fps | motion frames: %4 | faces: %5 (recognized %6)%7")
+                              .arg(totals.frames)
+                              .arg(totals.wallMs, 0, 'f', 1)
+                              .arg(fps, 0, 'f', 2)
+                              .arg(totals.framesWithMotion)
+                              .arg(totals.faces)
+                              .arg(totals.recognizedFaces)
+                              .arg(paced ? QString(" | late frames: %1").arg(totals.lateFrames) : QString());
+    qDebug().noquote() << QString("%1 %2 %3 %4 %5 %6 %7")
+                              .arg("stage", -20).arg("count", 7).arg("mean", 9)
+                              .arg("p50", 9).arg("p95", 9).arg("p99", 9).arg("max", 9);
+
+    QJsonObject stagesJson;
+    for (const QString& stage : samples.stages()) {
+        const QVector<double> values = samples.sorted(stage);
+        qDebug().noquote() << QString("%1 %2 %3 %4 %5 %6 %7")
+                                  .arg(stage, -20)
+                                  .arg(values.size(), 7)
+                                  .arg(mean(values), 9, 'f', 3)
+                                  .arg(percentile(values, 0.50), 9, 'f', 3)
+                                  .arg(percentile(values, 0.95), 9, 'f', 3)
+                                  .arg(percentile(values, 0.99), 9, 'f', 3)
+                                  .arg(values.last(), 9, 'f', 3);
+        stagesJson[stage] = stageJson(values);
+    }
+
+    // ---- JSON 报告 ----
+    if (parser.isSet(jsonOption)) {
+        QJsonObject report;
+        report["benchmark"] = "pipeline";
+        report["backend"] = config.inferenceBackend;
+        report["paced"] = paced;
+        report["videos"] = QJsonArray::fromStringList(videos);
+        report["enrolledPersons"] = enrolled;
+        report["frames"] = totals.frames;
+        report["wallMs"] = totals.wallMs;
+        report["fps"] = fps;
+        report["framesWithMotion"] = totals.framesWithMotion;
+        report["faces"] = totals.faces;
+        report["recognizedFaces"] = totals.recognizedFaces;
+        report["lateFrames"] = totals.lateFrames;
+        report["stages"] = stagesJson;
+
+        const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+        const QString path = parser.value(jsonOption);
+        if (path == "-") {
+            fwrite(json.constData(), 1, json.size(), stdout);
+        } else {
+            QFile file(path);
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+                qWarning() << "Failed to write JSON report:" << path;
+                return 1;
+            }
+            qDebug() << "JSON report written to" << path;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+// benchmarks/bench_resample.cpp
+// 检测前缩放基准：ImageResampler（双线性/面积）vs QImage::scaled vs cv::resize
+// 同时输出与 cv::resize 相同插值方式结果的平均/最大绝对误差；
+// 另外校验大盒（每个输出像素覆盖上万源像素）的面积插值与 cv::resize AREA 一致，不一致时返回 1
+//
+// 用法: bench_resample [迭代次数=50] [源宽=1920] [源高=1080] [目标宽=640] [目标高=480]
+
+#include "imageresampler.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QDebug>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <cmath>
+#include <functional>
+#include <random>
+
+namespace {
+
+// 带纹理的合成帧：渐变 + 噪声，避免全零/纯色让缩放路径走捷径
+QImage createFrame(int width, int height, QImage::Format format)
+{
+    QImage image(width, height, format);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> noise(-24, 24);
+
+    const int channels = (format == QImage::Format_Grayscale8) ? 1 : 3;
+    for (int y = 0; y < height; ++y) {
+        uchar* line = image.scanLine(y);
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < channels; ++c) {
+                int v = (x * 255 / width + y * 255 / height + c * 40) / 2 + noise(rng);
+                line[x * channels + c] = uchar(qBound(0, v, 255));
+            }
+        }
+    }
+    return image;
+}
+
+double timeMs(int iterations, const std::function<void()>& fn)
+{
+    fn();  // 预热（分配输出缓冲、加载代码页）
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    return timer.nsecsElapsed() / 1e6 / iterations;
+}
+
+cv::Mat wrap(const QImage& image)
+{
+    const int type = (image.format() == QImage::Format_Grayscale8) ? CV_8UC1 : CV_8UC3;
+    return cv::Mat(image.height(), image.width(), type,
+                   const_cast<uchar*>(image.constBits()), image.bytesPerLine());
+}
+
+void compare(const QImage& ours, const cv::Mat& reference, double* meanError, int* maxError)
+{
+    const int rowBytes = reference.cols * reference.channels();
+    double sum = 0.0;
+    int worst = 0;
+    for (int y = 0; y < reference.rows; ++y) {
+        const uchar* a = ours.constScanLine(y);
+        const uchar* b = reference.ptr<uchar>(y);
+        for (int i = 0; i < rowBytes; ++i) {
+            const int diff = std::abs(int(a[i]) - int(b[i]));
+            sum += diff;
+            worst = qMax(worst, diff);
+        }
+    }
+    *meanError = sum / (double(rowBytes) * reference.rows);
+    *maxError = worst;
+}
+
+void runFormat(const char* label, QImage::Format format, int iterations,
+               const QSize& srcSize, const QSize& dstSize)
+{
+    const QImage src = createFrame(srcSize.width(), srcSize.height(), format);
+    const cv::Mat srcMat = wrap(src);
+
+    QImage out;
+    cv::Mat cvLinear, cvArea;
+    const cv::Size cvSize(dstSize.width(), dstSize.height());
+
+    const double qtSmooth = timeMs(iterations, [&]() {
+        out = src.scaled(dstSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    });
+    const double qtFast = timeMs(iterations, [&]() {
+        out = src.scaled(dstSize, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+    });
+    const double cvLinearMs = timeMs(iterations, [&]() {
+        cv::resize(srcMat, cvLinear, cvSize, 0, 0, cv::INTER_LINEAR);
+    });
+    const double cvAreaMs = timeMs(iterations, [&]() {
+        cv::resize(srcMat, cvArea, cvSize, 0, 0, cv::INTER_AREA);
+    });
+
+    QImage bilinear, area;
+    const double oursBilinear = timeMs(iterations, [&]() {
+        bilinear = ImageResampler::resized(src, dstSize, ImageResampler::Filter::Bilinear);
+    });
+    const double oursArea = timeMs(iterations, [&]() {
+        area = ImageResampler::resized(src, dstSize, ImageResampler::Filter::Area);
+    });
+
+    double bilinearMean = 0.0, areaMean = 0.0;
+    int bilinearMax = 0, areaMax = 0;
+    compare(bilinear, cvLinear, &bilinearMean, &bilinearMax);
+    compare(area, cvArea, &areaMean, &areaMax);
+
+    qDebug().noquote() << QString("[%1] %2x%3 -> %4x%5")
+                              .arg(label)
+                              .arg(srcSize.width()).arg(srcSize.height())
+                              .arg(dstSize.width()).arg(dstSize.height());
+    qDebug().noquote() << QString("  QImage::scaled smooth : %1 ms").arg(qtSmooth, 0, 'f', 3);
+    qDebug().noquote() << QString("  QImage::scaled fast   : %1 ms").arg(qtFast, 0, 'f', 3);
+    qDebug().noquote() << QString("  cv::resize LINEAR     : %1 ms").arg(cvLinearMs, 0, 'f', 3);
+    qDebug().noquote() << QString("  cv::resize AREA       : %1 ms").arg(cvAreaMs, 0, 'f', 3);
+    qDebug().noquote() << QString("  ImageResampler bilin. : %1 ms  (vs cv LINEAR mean %2, max %3)")
+                              .arg(oursBilinear, 0, 'f', 3).arg(bilinearMean, 0, 'f', 3).arg(bilinearMax);
+    qDebug().noquote() << QString("  ImageResampler area   : %1 ms  (vs cv AREA mean %2, max %3)")
+                              .arg(oursArea, 0, 'f', 3).arg(areaMean, 0, 'f', 3).arg(areaMax);
+}
+
+// 整数缩放比下盒边界与 cv::resize AREA 完全一致，均值只允许 ±1 的舍入差
+bool checkLargeBoxes()
+{
+    const QSize cases[][2] = {
+        { QSize(4096, 256), QSize(4, 1) },     // 每盒 262144 像素
+        { QSize(2048, 64), QSize(2, 1) },      // 每盒 65536 像素
+        { QSize(1920, 1080), QSize(30, 20) },  // 每盒 3456 像素
+    };
+
+    bool ok = true;
+    for (const auto& sizes : cases) {
+        for (QImage::Format format : { QImage::Format_RGB888, QImage::Format_Grayscale8 }) {
+            const QImage src = createFrame(sizes[0].width(), sizes[0].height(), format);
+            const QImage area = ImageResampler::resized(src, sizes[1], ImageResampler::Filter::Area);
+            cv::Mat cvArea;
+            cv::resize(wrap(src), cvArea, cv::Size(sizes[1].width(), sizes[1].height()), 0, 0, cv::INTER_AREA);
+
+            double mean = 0.0;
+            int worst = 0;
+            compare(area, cvArea, &mean, &worst);
+            if (worst > 1) {
+                qWarning().noquote() << QString("Area %1x%2 -> %3x%4 differs from cv AREA by %5")
+                                            .arg(sizes[0].width()).arg(sizes[0].height())
+                                            .arg(sizes[1].width()).arg(sizes[1].height()).arg(worst);
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = app.arguments();
+    const int iterations = args.size() > 1 ? args.at(1).toInt() : 50;
+    const QSize srcSize(args.size() > 2 ? args.at(2).toInt() : 1920,
+                        args.size() > 3 ? args.at(3).toInt() : 1080);
+    const QSize maxSize(args.size() > 4 ? args.at(4).toInt() : 640,
+                        args.size() > 5 ? args.at(5).toInt() : 480);
+
+    // 与 FaceRecognitionManager::preprocessImage 一致：等比缩放到工作分辨率以内
+    const QSize dstSize = ImageResampler::fitWithin(srcSize, maxSize.width(), maxSize.height());
+
+    qDebug().noquote() << QString("ImageResampler SIMD path: %1, iterations: %2")
+                              .arg(ImageResampler::simdPath()).arg(iterations);
+
+    runFormat("RGB888", QImage::Format_RGB888, iterations, srcSize, dstSize);
+    runFormat("Gray8", QImage::Format_Grayscale8, iterations, srcSize, dstSize);
+
+    return checkLargeBoxes() ? 0 : 1;
+}
@@ -0,0 +1,412 @@
+// benchmarks/microbench.cpp
+#include "microbench.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSysInfo>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <time.h>
+
+namespace MicroBench {
+
+namespace {
+
+const qint64 kMaxIterations = 1000000000;
+
+struct Entry {
+    QString name;
+    Function function;
+};
+
+QVector<Entry>& registry()
+{
+    static QVector<Entry> entries;
+    return entries;
+}
+
+qint64 clockNs(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// 单次运行的结果（每迭代耗时）
+struct Run {
+    QString name;
+    QString runName;
+    QString aggregate;          // 空表示单次运行，否则为 mean / median / stddev
+    int repetitions = 1;
+    int repetitionIndex = 0;
+    qint64 iterations = 0;
+    double realNs = 0.0;
+    double cpuNs = 0.0;
+    double itemsPerSecond = 0.0;
+    double bytesPerSecond = 0.0;
+    QString label;
+    QString error;
+};
+
+QCommandLineOption filterOption()
+{
+    return QCommandLineOption("filter", "Run benchmarks whose name matches this regex.", "regex", ".");
+}
+
+QCommandLineOption minTimeOption()
+{
+    return QCommandLineOption("min-time", "Minimum timed seconds per benchmark run.", "seconds", "0.5");
+}
+
+QCommandLineOption repetitionsOption()
+{
+    return QCommandLineOption("repetitions", "Repeat each benchmark and report mean/median/stddev.", "n", "1");
+}
+
+QCommandLineOption jsonOption()
+{
+    return QCommandLineOption("json", "Write a Google-Benchmark-compatible JSON report ('-' for stdout).", "path");
+}
+
+QCommandLineOption listOption()
+{
+    return QCommandLineOption("list", "List registered benchmarks and exit.");
+}
+
+QString formatTime(double ns)
+{
+    if (ns >= 1e6) {
+        return QString::number(ns / 1e6, 'f', 3) + " ms";
+    }
+    if (ns >= 1e3) {
+        return QString::number(ns / 1e3, 'f', 3) + " us";
+    }
+    return QString::number(ns, 'f', 1) + " ns";
+}
+
+QString formatRate(double perSecond, const char* unit)
+{
+    if (perSecond >= 1e9) {
+        return QString::number(perSecond / 1e9, 'f', 2) + "G" + unit + "/s";
+    }
+    if (perSecond >= 1e6) {
+        return QString::number(perSecond / 1e6, 'f', 2) + "M" + unit + "/s";
+    }
+    if (perSecond >= 1e3) {
+        return QString::number(perSecond / 1e3, 'f', 2) + "k" + unit + "/s";
+    }
+    return QString::number(perSecond, 'f', 2) + unit + "/s";
+}
+
+QJsonObject runJson(const Run& run)
+{
+    QJsonObject object;
+    object["name"] = run.aggregate.isEmpty() ? run.name : run.name + "_" + run.aggregate;
+    object["run_name"] = run.runName;
+    object["run_type"] = run.aggregate.isEmpty() ? "iteration" : "aggregate";
+    object["repetitions"] = run.repetitions;
+    object["threads"] = 1;
+    if (run.aggregate.isEmpty()) {
+        object["repetition_index"] = run.repetitionIndex;
+    } else {
+        object["aggregate_name"] = run.aggregate;
+    }
+    if (!run.error.isEmpty()) {
+        object["error_occurred"] = true;
+        object["error_message"] = run.error;
+        return object;
+    }
+    object["iterations"] = double(run.iterations);
+    object["real_time"] = run.realNs;
+    object["cpu_time"] = run.cpuNs;
+    object["time_unit"] = "ns";
+    if (run.itemsPerSecond > 0.0) {
+        object["items_per_second"] = run.itemsPerSecond;
+    }
+    if (run.bytesPerSecond > 0.0) {
+        object["bytes_per_second"] = run.bytesPerSecond;
+    }
+    if (!run.label.isEmpty()) {
+        object["label"] = run.label;
+    }
+    return object;
+}
+
+QJsonObject contextJson()
+{
+    QJsonObject context;
+    context["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    context["host_name"] = QSysInfo::machineHostName();
+    context["executable"] = QCoreApplication::applicationFilePath();
+    context["num_cpus"] = QThread::idealThreadCount();
+    context["cpu_arch"] = QSysInfo::currentCpuArchitecture();
+    context["qt_version"] = QString(qVersion());
+#ifdef NDEBUG
+    context["library_build_type"] = "release";
+#else
+    context["library_build_type"] = "debug";
+#endif
+    return context;
+}
+
+} // namespace
+
+bool State::keepRunning()
+{
+    if (!m_started) {
+        m_started = true;
+        m_realStartNs = clockNs(CLOCK_MONOTONIC);
+        m_cpuStartNs = clockNs(CLOCK_PROCESS_CPUTIME_ID);
+    }
+    if (m_remaining > 0) {
+        --m_remaining;
+        return true;
+    }
+    if (!m_paused) {
+        pauseTiming();
+    }
+    return false;
+}
+
+void State::pauseTiming()
+{
+    m_realNs += clockNs(CLOCK_MONOTONIC) - m_realStartNs;
+    m_cpuNs += clockNs(CLOCK_PROCESS_CPUTIME_ID) - m_cpuStartNs;
+    m_paused = true;
+}
+
+void State::resumeTiming()
+{
+    m_paused = false;
+    m_realStartNs = clockNs(CLOCK_MONOTONIC);
+    m_cpuStartNs = clockNs(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+// 运行调度：先以递增的迭代次数试跑到满足最短时长，再按该次数重复
+class Runner {
+public:
+    explicit Runner(double minTimeSeconds) : m_minTimeNs(minTimeSeconds * 1e9) {}
+
+    QVector<Run> run(const Entry& entry, int repetitions) const {
+        QVector<Run> runs;
+        Run first = calibrate(entry);
+        first.repetitions = repetitions;
+        runs.append(first);
+
+        for (int i = 1; i < repetitions && first.error.isEmpty(); ++i) {
+            Run run = runOnce(entry, first.iterations);
+            run.repetitions = repetitions;
+            run.repetitionIndex = i;
+            runs.append(run);
+        }
+        return runs;
+    }
+
+private:
+    double m_minTimeNs;
+
+    Run runOnce(const Entry& entry, qint64 iterations) const {
+        State state(iterations);
+        entry.function(state);
+
+        Run run;
+        run.name = entry.name;
+        run.runName = entry.name;
+        run.iterations = iterations;
+        run.label = state.m_label;
+        run.error = state.m_error;
+        if (run.error.isEmpty() && state.m_remaining > 0) {
+            run.error = "benchmark returned before finishing its keepRunning() loop";
+        }
+        if (!run.error.isEmpty()) {
+            return run;
+        }
+
+        run.realNs = double(state.m_realNs) / iterations;
+        run.cpuNs = double(state.m_cpuNs) / iterations;
+        const double seconds = state.m_realNs / 1e9;
+        if (seconds > 0.0) {
+            run.itemsPerSecond = state.m_itemsProcessed / seconds;
+            run.bytesPerSecond = state.m_bytesProcessed / seconds;
+        }
+        return run;
+    }
+
+    Run calibrate(const Entry& entry) const {
+        qint64 iterations = 1;
+        while (true) {
+            const Run run = runOnce(entry, iterations);
+            if (!run.error.isEmpty()) {
+                return run;
+            }
+
+            const double totalNs = run.realNs * iterations;
+            if (totalNs >= m_minTimeNs || iterations >= kMaxIterations) {
+                return run;
+            }
+
+            // 与 Google Benchmark 相同的增长策略：按比例外推并留 40% 余量，
+            // 耗时太短（不足目标的 10%）时单次最多放大 10 倍
+            double multiplier = m_minTimeNs * 1.4 / qMax(totalNs, 1.0);
+            if (totalNs / m_minTimeNs <= 0.1) {
+                multiplier = qMin(multiplier, 10.0);
+            }
+            if (multiplier <= 1.0) {
+                multiplier = 2.0;
+            }
+            iterations = qMin(kMaxIterations, qMax(qint64(iterations * multiplier), iterations + 1));
+        }
+    }
+};
+
+void registerBenchmark(const QString& name, const Function& function)
+{
+    registry().append(Entry{name, function});
+}
+
+void addOptions(QCommandLineParser& parser)
+{
+    parser.addOptions({filterOption(), minTimeOption(), repetitionsOption(), jsonOption(), listOption()});
+}
+
+int runRegistered(const QCommandLineParser& parser)
+{
+    const QRegularExpression filter(parser.value(filterOption()));
+    if (!filter.isValid()) {
+        qWarning() << "Invalid --filter regex:" << filter.errorString();
+        return 1;
+    }
+
+    QVector<Entry> selected;
+    for (const Entry& entry : registry()) {
+        if (filter.match(entry.name).hasMatch()) {
+            selected.append(entry);
+        }
+    }
+
+    if (parser.isSet(listOption())) {
+        for (const Entry& entry : selected) {
+            qDebug().noquote() << entry.name;
+        }
+        return 0;
+    }
+    if (selected.isEmpty()) {
+        qWarning() << "No benchmark matches filter" << filter.pattern();
+        return 1;
+    }
+
+    const Runner runner(qMax(0.001, parser.value(minTimeOption()).toDouble()));
+    const int repetitions = qMax(1, parser.value(repetitionsOption()).toInt());
+
+    int nameWidth = 10;
+    for (const Entry& entry : selected) {
+        nameWidth = qMax(nameWidth, entry.name.size() + (repetitions > 1 ? 7 : 0));
+    }
+
+    qDebug().noquote() << QString("%1 %2 %3 %4  %5")
+                              .arg("Benchmark", -nameWidth).arg("Time", 13).arg("CPU", 13)
+                              .arg("Iterations", 11).arg("Rate");
+    qDebug().noquote() << QString(nameWidth + 46, QChar('-'));
+
+    QJsonArray benchmarksJson;
+    int errors = 0;
+    for (const Entry& entry : selected) {
+        QVector<Run> runs = runner.run(entry, repetitions);
+
+        // 多次重复时追加 mean / median / stddev 聚合行
+        if (runs.size() > 1) {
+            QVector<double> real, cpu;
+            for (const Run& run : runs) {
+                real.append(run.realNs);
+                cpu.append(run.cpuNs);
+            }
+            auto meanOf = [](const QVector<double>& v) {
+                double sum = 0.0;
+                for (double x : v) sum += x;
+                return sum / v.size();
+            };
+            auto medianOf = [](QVector<double> v) {
+                std::sort(v.begin(), v.end());
+                const int mid = v.size() / 2;
+                return (v.size() % 2) ? v[mid] : (v[mid - 1] + v[mid]) / 2.0;
+            };
+            auto stddevOf = [&meanOf](const QVector<double>& v) {
+                const double m = meanOf(v);
+                double sum = 0.0;
+                for (double x : v) sum += (x - m) * (x - m);
+                return std::sqrt(sum / (v.size() - 1));
+            };
+
+            const Run base = runs.first();
+            const char* names[] = {"mean", "median", "stddev"};
+            const double reals[] = {meanOf(real), medianOf(real), stddevOf(real)};
+            const double cpus[] = {meanOf(cpu), medianOf(cpu), stddevOf(cpu)};
+            for (int i = 0; i < 3; ++i) {
+                Run aggregate = base;
+                aggregate.aggregate = names[i];
+                aggregate.realNs = reals[i];
+                aggregate.cpuNs = cpus[i];
+                aggregate.itemsPerSecond = i < 2 && base.realNs > 0.0 ? base.itemsPerSecond * base.realNs / reals[i] : 0.0;
+                aggregate.bytesPerSecond = i < 2 && base.realNs > 0.0 ? base.bytesPerSecond * base.realNs / reals[i] : 0.0;
+                runs.append(aggregate);
+            }
+        }
+
+        for (const Run& run : runs) {
+            const QString name = run.aggregate.isEmpty() ? run.name : run.name + "_" + run.aggregate;
+            if (!run.error.isEmpty()) {
+                ++errors;
+                qDebug().noquote() << QString("%1 ERROR: %2").arg(name, -nameWidth).arg(run.error);
+            } else {
+                QStringList rates;
+                if (run.itemsPerSecond > 0.0) {
+                    rates << formatRate(run.itemsPerSecond, "items");
+                }
+                if (run.bytesPerSecond > 0.0) {
+                    rates << formatRate(run.bytesPerSecond, "B");
+                }
+                if (!run.label.isEmpty()) {
+                    rates << run.label;
+                }
+                qDebug().noquote() << QString("%1 %2 %3 %4  %5")
+                                          .arg(name, -nameWidth)
+                                          .arg(formatTime(run.realNs), 13)
+                                          .arg(formatTime(run.cpuNs), 13)
+                                          .arg(run.aggregate.isEmpty() ? QString::number(run.iterations) : QString(), 11)
+                                          .arg(rates.join(" "));
+            }
+            benchmarksJson.append(runJson(run));
+        }
+    }
+
+    if (parser.isSet(jsonOption())) {
+        QJsonObject report;
+        report["context"] = contextJson();
+        report["benchmarks"] = benchmarksJson;
+
+        const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+        const QString path = parser.value(jsonOption());
+        if (path == "-") {
+            fwrite(json.constData(), 1, json.size(), stdout);
+        } else {
+            QFile file(path);
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+                qWarning() << "Failed to write JSON report:" << path;
+                return 1;
+            }
+            qDebug() << "JSON report written to" << path;
+        }
+    }
+
+    return errors == 0 ? 0 : 1;
+}
+
+} // namespace MicroBench
@@ -0,0 +1,79 @@
+// benchmarks/microbench.h
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <functional>
+
+class QCommandLineParser;
+
+// 🆕 轻量微基准框架（接口与输出格式仿照 Google Benchmark，不引入外部依赖）
+// - 每个用例是一个 void(MicroBench::State&) 函数，计时循环写成 while (state.keepRunning()) { ... }
+// - 迭代次数自动增长，直到一次运行耗时达到 --min-time；循环外的准备工作不计时
+// - JSON 报告与 Google Benchmark 的 --benchmark_format=json 字段一致，可直接用其 compare.py 对比两次提交
+namespace MicroBench {
+
+class State {
+public:
+    explicit State(qint64 iterations) : m_iterations(iterations), m_remaining(iterations) {}
+
+    // 首次调用开始计时，跑满迭代次数后停止计时并返回 false
+    bool keepRunning();
+
+    // 循环内不计时的部分（如重置输入），成对调用
+    void pauseTiming();
+    void resumeTiming();
+
+    qint64 iterations() const { return m_iterations; }
+    void setItemsProcessed(qint64 items) { m_itemsProcessed = items; }
+    void setBytesProcessed(qint64 bytes) { m_bytesProcessed = bytes; }
+    void setLabel(const QString& label) { m_label = label; }
+    void skipWithError(const QString& message) { m_error = message; m_remaining = 0; }
+
+private:
+    friend class Runner;
+
+    qint64 m_iterations;
+    qint64 m_remaining;
+    bool m_started = false;
+    bool m_paused = false;
+
+    qint64 m_realStartNs = 0;
+    qint64 m_cpuStartNs = 0;
+    qint64 m_realNs = 0;        // 已累计的计时区间
+    qint64 m_cpuNs = 0;
+
+    qint64 m_itemsProcessed = 0;
+    qint64 m_bytesProcessed = 0;
+    QString m_label;
+    QString m_error;
+};
+
+using Function = std::function<void(State&)>;
+
+// 注册用例（按注册顺序运行）；name 建议用 "组/对象/参数" 形式，便于 --filter
+void registerBenchmark(const QString& name, const Function& function);
+
+// 阻止编译器把基准结果当作无用计算消除
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// 向命令行解析器添加通用选项：--filter --min-time --repetitions --json --list
+void addOptions(QCommandLineParser& parser);
+
+// 按解析结果运行已注册的用例，输出文本表格（以及 JSON），返回进程退出码
+int runRegistered(const QCommandLineParser& parser);
+
+} // namespace MicroBench
+
+#endif // MICROBENCH_H
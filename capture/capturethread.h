@@ -10,6 +10,9 @@ Copyright © Deng Zhimao Co., Ltd. 2021-2030. All rights reserved.
 #ifndef CAPTURE_THREAD_H
 #define CAPTURE_THREAD_H
 #include "camerathread.h"
+#include "../core/FrameMeta.h"
+#include "../core/TraceRecorder.h"
+#include "../core/FlightRecorder.h"
 
 #include <QThread>
 #include <QDebug>
@@ -23,7 +26,7 @@ class CaptureThread : public QThread
     Q_OBJECT
 
 signals:
-    void resultReady(QImage);
+    void resultReady(QImage, FrameMeta);
     void sendImage(QImage);
     void cameraIdChanged(int);
 
@@ -33,6 +36,8 @@ public:
 private:
     bool photoGraphFlag = false;
     CameraThread *m_CameraThread;
+    int m_sourceId = FrameSource::Mipi;
+    quint64 m_sequence = 0;     // 🆕 来源内帧序号
 
 public:
     CaptureThread(QObject *parent = nullptr) {
@@ -62,21 +67,36 @@ public:
         startFlag = start;
     }
 
+    void setSourceId(int sourceId) {
+        m_sourceId = sourceId;
+    }
+
     void run() override {
         msleep(800);
 #ifdef __arm__
         while (startFlag && m_CameraThread->camera_init_success) {
             msleep(33);
-            CameraFrame *frame = GetCameraMediaBuffer();
+            CameraFrame *frame = nullptr;
+            {
+                SV_TRACE_SCOPE("capture", "capture");
+                frame = GetCameraMediaBuffer();
+            }
             if (frame) {
+                FlightRecorder::instance().heartbeat(m_sourceId);
+                FrameMeta meta = FrameMeta::begin(m_sourceId, ++m_sequence);
                 QImage qImage((unsigned char *)frame->file, 720, 1280, QImage::Format_RGB888);
                 
                 // 添加旋转逻辑
-                QTransform transform;
-                transform.rotate(-270);  // 逆时针旋转90°
-                QImage rotatedImage = qImage.transformed(transform);
+                QImage rotatedImage;
+                {
+                    SV_TRACE_SCOPE_ARG("capture", "rotate", meta.sequence);
+                    QTransform transform;
+                    transform.rotate(-270);  // 逆时针旋转90°
+                    rotatedImage = qImage.transformed(transform);
+                }
 
-                emit resultReady(rotatedImage);
+                meta.stamp(FrameMeta::Decode);
+                emit resultReady(rotatedImage, meta);
 
                 if (photoGraphFlag) {
                     if (rotatedImage.isNull()) {
@@ -89,6 +109,7 @@ public:
             }
             delete frame;
         }
+        FlightRecorder::instance().endHeartbeat(m_sourceId);
 #endif
     }
 
@@ -0,0 +1,354 @@
+#include "ffmpegvideoencoder.h"
+#include <QDebug>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/opt.h>
+}
+
+namespace {
+
+AVPixelFormat sourcePixelFormat(const QImage& image)
+{
+    switch (image.format()) {
+    case QImage::Format_RGB888:
+        return AV_PIX_FMT_RGB24;
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return AV_PIX_FMT_BGRA;     // 小端下 0xAARRGGBB 的字节序
+    case QImage::Format_Grayscale8:
+        return AV_PIX_FMT_GRAY8;
+    default:
+        return AV_PIX_FMT_NONE;
+    }
+}
+
+// 优先 YUV420P，其次 NV12（MPP 硬件编码器），否则取编码器支持的第一个格式
+AVPixelFormat choosePixelFormat(const AVCodec* codec)
+{
+    if (!codec->pix_fmts) {
+        return AV_PIX_FMT_YUV420P;
+    }
+    const AVPixelFormat preferred[] = {AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12};
+    for (AVPixelFormat want : preferred) {
+        for (const AVPixelFormat* fmt = codec->pix_fmts; *fmt != AV_PIX_FMT_NONE; ++fmt) {
+            if (*fmt == want) {
+                return want;
+            }
+        }
+    }
+    return codec->pix_fmts[0];
+}
+
+QString averror(int error)
+{
+    char buffer[AV_ERROR_MAX_STRING_SIZE] = {0};
+    av_strerror(error, buffer, sizeof(buffer));
+    return QString::fromUtf8(buffer);
+}
+
+} // namespace
+
+FfmpegVideoEncoder::FfmpegVideoEncoder(const QString& codecName)
+    : m_codecName(codecName)
+{
+}
+
+FfmpegVideoEncoder::~FfmpegVideoEncoder()
+{
+    close();
+}
+
+bool FfmpegVideoEncoder::isAvailable(const QString& codecName)
+{
+    return avcodec_find_encoder_by_name(codecName.toUtf8().constData()) != nullptr;
+}
+
+bool FfmpegVideoEncoder::fail(const QString& message, int error)
+{
+    m_lastError = error ? QString("%1: %2").arg(message, averror(error)) : message;
+    qWarning() << "FfmpegVideoEncoder[" << m_codecName << "]" << m_lastError << m_path;
+    release();
+    return false;
+}
+
+bool FfmpegVideoEncoder::open(const QString& path, const VideoEncoderConfig& config)
+{
+    close();
+    m_path = path;
+    m_lastError.clear();
+    m_lastPts = -1;
+    m_keyframes.clear();
+
+    const AVCodec* codec = avcodec_find_encoder_by_name(m_codecName.toUtf8().constData());
+    if (!codec) {
+        return fail("encoder not available in this FFmpeg build");
+    }
+
+    const QByteArray pathUtf8 = path.toUtf8();
+    int ret = avformat_alloc_output_context2(&m_format, nullptr, nullptr, pathUtf8.constData());
+    if (ret < 0 || !m_format) {
+        ret = avformat_alloc_output_context2(&m_format, nullptr, "mp4", pathUtf8.constData());
+        if (ret < 0 || !m_format) {
+            return fail("cannot create muxer", ret);
+        }
+    }
+
+    m_stream = avformat_new_stream(m_format, nullptr);
+    m_codec = avcodec_alloc_context3(codec);
+    if (!m_stream || !m_codec) {
+        return fail("out of memory");
+    }
+
+    // 时间基 1ms：时间戳直接取采集时间差，丢帧或帧率波动时播放速度仍然正确
+    const int fps = qMax(1, config.fps);
+    m_codec->width = config.size.width() & ~1;
+    m_codec->height = config.size.height() & ~1;
+    m_codec->pix_fmt = choosePixelFormat(codec);
+    m_codec->time_base = AVRational{1, 1000};
+    m_codec->framerate = AVRational{fps, 1};
+    m_codec->bit_rate = qint64(config.bitrateKbps) * 1000;
+    m_codec->gop_size = fps * qMax(1, config.gopSeconds);
+    m_codec->max_b_frames = 0;      // 无 B 帧：编码延迟低，停止录制时冲刷更快
+    if (m_format->oformat->flags & AVFMT_GLOBALHEADER) {
+        m_codec->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    // 软件编码器使用快速预设，避免与 AI 线程争抢 CPU
+    if (m_codecName == "libx264" || m_codecName == "libx265") {
+        av_opt_set(m_codec->priv_data, "preset", "veryfast", 0);
+    }
+
+    ret = avcodec_open2(m_codec, codec, nullptr);
+    if (ret < 0) {
+        return fail("cannot open encoder", ret);
+    }
+
+    ret = avcodec_parameters_from_context(m_stream->codecpar, m_codec);
+    if (ret < 0) {
+        return fail("cannot copy codec parameters", ret);
+    }
+    m_stream->time_base = m_codec->time_base;
+
+    if (!(m_format->oformat->flags & AVFMT_NOFILE) && !openOutput(config)) {
+        return fail(QString("cannot open output file: %1").arg(m_file.lastError()));
+    }
+
+    // 分片 MP4：每个关键帧开一个 moof/mdat 分片，文件无需 moov 尾部即可播放和定位
+    AVDictionary* muxerOptions = nullptr;
+    m_offsetAfterWrite = false;
+    if (config.fragmented && strcmp(m_format->oformat->name, "mp4") == 0) {
+        av_dict_set(&muxerOptions, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+        m_offsetAfterWrite = true;
+    }
+    ret = avformat_write_header(m_format, &muxerOptions);
+    av_dict_free(&muxerOptions);
+    if (ret < 0) {
+        return fail("cannot write header", ret);
+    }
+    m_headerWritten = true;
+
+    m_frame = av_frame_alloc();
+    m_packet = av_packet_alloc();
+    if (!m_frame || !m_packet) {
+        return fail("out of memory");
+    }
+    m_frame->format = m_codec->pix_fmt;
+    m_frame->width = m_codec->width;
+    m_frame->height = m_codec->height;
+    ret = av_frame_get_buffer(m_frame, 32);
+    if (ret < 0) {
+        return fail("cannot allocate frame", ret);
+    }
+
+    qDebug() << "FfmpegVideoEncoder: Opened" << path << "with" << m_codecName
+             << QString("%1x%2").arg(m_codec->width).arg(m_codec->height)
+             << av_get_pix_fmt_name(m_codec->pix_fmt);
+    return true;
+}
+
+bool FfmpegVideoEncoder::encode(const QImage& frame, qint64 ptsMs)
+{
+    if (!m_codec || frame.isNull()) {
+        return false;
+    }
+
+    QImage source = frame;
+    AVPixelFormat sourceFormat = sourcePixelFormat(source);
+    if (sourceFormat == AV_PIX_FMT_NONE) {
+        source = source.convertToFormat(QImage::Format_RGB888);
+        sourceFormat = AV_PIX_FMT_RGB24;
+    }
+
+    // 源尺寸变化时（如切换分辨率）同一个上下文负责缩放
+    m_sws = sws_getCachedContext(m_sws, source.width(), source.height(), sourceFormat,
+                                 m_codec->width, m_codec->height, m_codec->pix_fmt,
+                                 SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!m_sws) {
+        m_lastError = "cannot create pixel format converter";
+        return false;
+    }
+
+    int ret = av_frame_make_writable(m_frame);
+    if (ret < 0) {
+        m_lastError = QString("frame not writable: %1").arg(averror(ret));
+        return false;
+    }
+
+    const uint8_t* srcData[1] = {source.constBits()};
+    const int srcStride[1] = {source.bytesPerLine()};
+    sws_scale(m_sws, srcData, srcStride, 0, source.height(), m_frame->data, m_frame->linesize);
+
+    m_frame->pts = qMax(ptsMs, m_lastPts + 1);
+    m_lastPts = m_frame->pts;
+
+    ret = avcodec_send_frame(m_codec, m_frame);
+    if (ret < 0) {
+        m_lastError = QString("send frame failed: %1").arg(averror(ret));
+        return false;
+    }
+    return drainPackets();
+}
+
+bool FfmpegVideoEncoder::drainPackets()
+{
+    while (true) {
+        const int ret = avcodec_receive_packet(m_codec, m_packet);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            return true;
+        }
+        if (ret < 0) {
+            m_lastError = QString("receive packet failed: %1").arg(averror(ret));
+            return false;
+        }
+
+        // 编码器时间基为 1ms，换算前的 pts 就是片段内毫秒数
+        const bool keyframe = (m_packet->flags & AV_PKT_FLAG_KEY) != 0;
+        const qint64 keyframePtsMs = m_packet->pts;
+
+        av_packet_rescale_ts(m_packet, m_codec->time_base, m_stream->time_base);
+        m_packet->stream_index = m_stream->index;
+
+        // 单路流时交织队列直接透传：MPEG-TS 在写入前取偏移即关键帧起点；
+        // 分片 MP4 写入关键帧时才把上一个分片落盘，写入后的偏移即新分片起点
+        const qint64 offsetBefore = m_format->pb ? avio_tell(m_format->pb) : -1;
+
+        // av_interleaved_write_frame 接管并清空 packet
+        const int written = av_interleaved_write_frame(m_format, m_packet);
+        if (written < 0) {
+            m_lastError = QString("write failed: %1").arg(averror(written));
+            return false;
+        }
+
+        if (keyframe && offsetBefore >= 0) {
+            VideoKeyframe info;
+            info.ptsMs = keyframePtsMs;
+            info.byteOffset = m_offsetAfterWrite ? avio_tell(m_format->pb) : offsetBefore;
+            m_keyframes.append(info);
+        }
+    }
+}
+
+QVector<VideoKeyframe> FfmpegVideoEncoder::takeKeyframes()
+{
+    QVector<VideoKeyframe> keyframes;
+    keyframes.swap(m_keyframes);
+    return keyframes;
+}
+
+bool FfmpegVideoEncoder::close()
+{
+    if (!m_format) {
+        return true;
+    }
+
+    bool ok = true;
+    if (m_codec && m_headerWritten && m_packet) {
+        // 冲刷编码器内缓存的帧
+        if (avcodec_send_frame(m_codec, nullptr) >= 0) {
+            ok = drainPackets();
+        }
+        ok = av_write_trailer(m_format) >= 0 && ok;
+    }
+
+    ok = closeOutput() && ok;
+    release();
+    return ok;
+}
+
+// 🆕 输出不走 avio_open：文件由 SegmentFile 持有，以便预分配空间并控制回写节奏
+bool FfmpegVideoEncoder::openOutput(const VideoEncoderConfig& config)
+{
+    SegmentFile::Options options;
+    options.preallocateBytes = config.preallocateBytes;
+    options.syncBytes = config.syncBytes;
+    if (!m_file.open(m_path, options)) {
+        return false;
+    }
+
+    const int bufferSize = 64 * 1024;
+    unsigned char* buffer = static_cast<unsigned char*>(av_malloc(bufferSize));
+    m_format->pb = buffer ? avio_alloc_context(buffer, bufferSize, 1, this, nullptr,
+                                               &FfmpegVideoEncoder::writePacket,
+                                               &FfmpegVideoEncoder::seekPacket)
+                          : nullptr;
+    if (!m_format->pb) {
+        av_free(buffer);
+        m_file.close();
+        return false;
+    }
+    m_format->flags |= AVFMT_FLAG_CUSTOM_IO;
+    return true;
+}
+
+bool FfmpegVideoEncoder::closeOutput()
+{
+    if (m_format && m_format->pb) {
+        avio_flush(m_format->pb);
+        av_freep(&m_format->pb->buffer);
+        avio_context_free(&m_format->pb);
+    }
+    if (!m_file.close()) {
+        m_lastError = m_file.lastError();
+        return false;
+    }
+    return true;
+}
+
+int FfmpegVideoEncoder::writePacket(void* opaque, uint8_t* buffer, int size)
+{
+    FfmpegVideoEncoder* self = static_cast<FfmpegVideoEncoder*>(opaque);
+    const qint64 written = self->m_file.write(reinterpret_cast<const char*>(buffer), size);
+    return written < 0 ? AVERROR(EIO) : int(written);
+}
+
+int64_t FfmpegVideoEncoder::seekPacket(void* opaque, int64_t offset, int whence)
+{
+    FfmpegVideoEncoder* self = static_cast<FfmpegVideoEncoder*>(opaque);
+    if (whence & AVSEEK_SIZE) {
+        return self->m_file.size();
+    }
+    const qint64 position = self->m_file.seek(offset, whence & ~AVSEEK_FORCE);
+    return position < 0 ? AVERROR(EIO) : position;
+}
+
+void FfmpegVideoEncoder::release()
+{
+    closeOutput();
+    if (m_format) {
+        avformat_free_context(m_format);
+        m_format = nullptr;
+    }
+    m_stream = nullptr;
+
+    avcodec_free_context(&m_codec);
+    av_frame_free(&m_frame);
+    av_packet_free(&m_packet);
+    if (m_sws) {
+        sws_freeContext(m_sws);
+        m_sws = nullptr;
+    }
+    m_headerWritten = false;
+}
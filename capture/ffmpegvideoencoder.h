@@ -0,0 +1,64 @@
+#ifndef FFMPEGVIDEOENCODER_H
+#define FFMPEGVIDEOENCODER_H
+
+#include "videoencoder.h"
+#include "segmentfile.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+
+// 🆕 基于 libavcodec/libavformat 的编码器，codecName 为 FFmpeg 编码器名：
+// 主机上用 libx264 / libx265，板端用 Rockchip FFmpeg 构建提供的 h264_rkmpp（MPP 硬件编码）
+class FfmpegVideoEncoder : public VideoEncoder
+{
+public:
+    explicit FfmpegVideoEncoder(const QString& codecName);
+    ~FfmpegVideoEncoder() override;
+
+    // 当前 FFmpeg 构建是否包含该编码器
+    static bool isAvailable(const QString& codecName);
+
+    QString name() const override { return m_codecName; }
+    bool open(const QString& path, const VideoEncoderConfig& config) override;
+    bool encode(const QImage& frame, qint64 ptsMs) override;
+    bool close() override;
+
+    // 🔧 文件的实际字节数（含 TS/MP4 容器开销），关闭后仍有效，直到下次 open
+    qint64 bytesWritten() const override { return m_file.size(); }
+    QString lastError() const override { return m_lastError; }
+    QVector<VideoKeyframe> takeKeyframes() override;
+
+private:
+    Q_DISABLE_COPY(FfmpegVideoEncoder)
+
+    bool fail(const QString& message, int error = 0);
+    bool openOutput(const VideoEncoderConfig& config);
+    bool closeOutput();
+    static int writePacket(void* opaque, uint8_t* buffer, int size);
+    static int64_t seekPacket(void* opaque, int64_t offset, int whence);
+    bool drainPackets();
+    void release();
+
+    QString m_codecName;
+    QString m_path;
+    QString m_lastError;
+
+    AVFormatContext* m_format = nullptr;
+    AVCodecContext* m_codec = nullptr;
+    AVStream* m_stream = nullptr;
+    AVFrame* m_frame = nullptr;          // 复用的 YUV 帧缓冲
+    AVPacket* m_packet = nullptr;
+    SwsContext* m_sws = nullptr;
+
+    SegmentFile m_file;                  // 🆕 输出文件（预分配 + 回写节奏），经自定义 AVIOContext 写入
+    QVector<VideoKeyframe> m_keyframes;
+    bool m_offsetAfterWrite = false;     // 分片 MP4：关键帧所在分片在写入该帧时才开始落盘
+
+    qint64 m_lastPts = -1;
+    bool m_headerWritten = false;
+};
+
+#endif // FFMPEGVIDEOENCODER_H
@@ -0,0 +1,507 @@
+#include "recordingsink.h"
+#include "../core/MetricsRegistry.h"
+#include "../core/FlightRecorder.h"
+#include "../core/TraceRecorder.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QDebug>
+
+namespace {
+
+// 分段录制写入失败后的重试间隔：给存储配额清理留出时间，也避免磁盘满时每帧都尝试建文件
+const qint64 kRetryIntervalNs = 5000000000LL;
+
+} // namespace
+
+RecordingSink::RecordingSink(int sourceId, QObject* parent)
+    : QThread(parent)
+    , m_sourceId(sourceId)
+    , m_queueDepthGauge(MetricsRegistry::instance().gauge("record.queue.depth", sourceId))
+    , m_encodeFpsGauge(MetricsRegistry::instance().gauge("record.encode.fps", sourceId))
+    , m_encodedCounter(MetricsRegistry::instance().counter("record.frames.encoded", sourceId))
+    , m_droppedCounter(MetricsRegistry::instance().counter("record.frames.dropped", sourceId))
+    , m_encodeMs(MetricsRegistry::instance().histogram("record.encode_ms", sourceId))
+    , m_bytesCounter(MetricsRegistry::instance().counter("storage.bytes.written", sourceId))
+{
+    setObjectName(QString("sv-record-%1").arg(sourceId));
+}
+
+RecordingSink::~RecordingSink()
+{
+    shutdown();
+}
+
+void RecordingSink::setEncoder(const QString& name)
+{
+    QMutexLocker locker(&m_mutex);
+    m_encoderName = name;
+}
+
+void RecordingSink::setFrameRate(int fps)
+{
+    QMutexLocker locker(&m_mutex);
+    m_fps = qBound(1, fps, 60);
+}
+
+void RecordingSink::setBitrateKbps(int kbps)
+{
+    QMutexLocker locker(&m_mutex);
+    m_bitrateKbps = qMax(100, kbps);
+}
+
+void RecordingSink::setPreRollMs(int ms)
+{
+    QMutexLocker locker(&m_mutex);
+    m_preRollMs = qMax(0, ms);
+}
+
+void RecordingSink::setPreRollCapacity(int frames)
+{
+    QMutexLocker locker(&m_mutex);
+    m_preRollCapacity = qMax(1, frames);
+}
+
+void RecordingSink::setQueueCapacity(int frames)
+{
+    QMutexLocker locker(&m_mutex);
+    m_queueCapacity = qMax(1, frames);
+}
+
+void RecordingSink::setSegmentation(SegmentIndex* index, int segmentSeconds, SegmentIndex::Container container)
+{
+    QMutexLocker locker(&m_mutex);
+    m_index = index;
+    m_segmentSeconds = qMax(1, segmentSeconds);
+    m_container = container;
+}
+
+SegmentIndex* RecordingSink::segmentIndex() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_index;
+}
+
+void RecordingSink::setSyncBytes(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_syncBytes = qMax<qint64>(0, bytes);
+}
+
+void RecordingSink::pushFrame(const QImage& frame, const FrameMeta& meta)
+{
+    if (frame.isNull()) {
+        return;
+    }
+
+    const qint64 captureNs = meta.hasStage(FrameMeta::Capture) ? meta.stampNs[FrameMeta::Capture]
+                                                                : frameClockNs();
+
+    QMutexLocker locker(&m_mutex);
+    if (m_stopping) {
+        return;
+    }
+
+    // 帧率上限（允许 10% 抖动），多余的帧既不预录也不编码
+    const qint64 intervalNs = 1000000000LL / m_fps;
+    if (m_lastAcceptedNs > 0 && captureNs - m_lastAcceptedNs < intervalNs * 9 / 10) {
+        return;
+    }
+    m_lastAcceptedNs = captureNs;
+
+    Item item;
+    item.type = Frame;
+    item.image = frame;
+    item.captureNs = captureNs;
+
+    if (m_recording) {
+        enqueueLocked(item);
+        return;
+    }
+
+    if (m_preRollMs > 0) {
+        // 🔧 预录帧数有上限：帧率 × 时长超过上限时按 preRollMs / preRollCapacity 的间隔抽帧，
+        //    时长不变、常驻内存封顶
+        const qint64 keepNs = qint64(m_preRollMs) * 1000000;
+        const qint64 preRollIntervalNs = keepNs / m_preRollCapacity;
+        if (m_lastPreRollNs > 0 && captureNs - m_lastPreRollNs < preRollIntervalNs * 9 / 10) {
+            return;
+        }
+        m_lastPreRollNs = captureNs;
+
+        item.preRoll = true;
+        m_preRoll.enqueue(item);
+        while (!m_preRoll.isEmpty()
+               && (captureNs - m_preRoll.head().captureNs > keepNs || m_preRoll.size() > m_preRollCapacity)) {
+            m_preRoll.dequeue();
+        }
+    }
+}
+
+void RecordingSink::enqueueLocked(const Item& item)
+{
+    if (item.type == Frame && item.preRoll) {
+        // 预录帧只在开始录制时入队，数量受 preRollCapacity 限制，不占实时帧容量
+        ++m_queuedPreRoll;
+    } else if (item.type == Frame) {
+        if (m_queuedFrames >= m_queueCapacity) {
+            // 磁盘或编码跟不上：丢弃新帧，绝不阻塞采集线程
+            ++m_framesDropped;
+            m_droppedCounter->add();
+            FlightRecorder::instance().recordEvent(FlightRecorder::FrameDrop, m_sourceId,
+                                                   static_cast<qint64>(m_framesDropped), "record_queue_full");
+            return;
+        }
+        ++m_queuedFrames;
+    }
+    m_queue.enqueue(item);
+    publishQueueDepthLocked();
+    m_wake.wakeOne();
+}
+
+void RecordingSink::publishQueueDepthLocked()
+{
+    m_queueDepthGauge->set(m_queuedFrames + m_queuedPreRoll);
+}
+
+void RecordingSink::startRecording(const QString& path)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_stopping) {
+        return;
+    }
+
+    if (m_recording) {
+        Item stop;
+        stop.type = Stop;
+        enqueueLocked(stop);
+    }
+
+    Item start;
+    start.type = Start;
+    start.path = path;
+    enqueueLocked(start);
+
+    // 预录帧按时间先后写在片段开头；上一次录制的预录帧尚未编码完时，舍弃最早的使总数不超上限
+    while (!m_preRoll.isEmpty() && m_queuedPreRoll + m_preRoll.size() > m_preRollCapacity) {
+        m_preRoll.dequeue();
+    }
+    while (!m_preRoll.isEmpty()) {
+        enqueueLocked(m_preRoll.dequeue());
+    }
+    m_lastPreRollNs = 0;
+    m_recording = true;
+}
+
+void RecordingSink::stopRecording()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_recording) {
+        return;
+    }
+
+    Item stop;
+    stop.type = Stop;
+    enqueueLocked(stop);
+    m_recording = false;
+}
+
+bool RecordingSink::isRecording() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_recording;
+}
+
+void RecordingSink::shutdown()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_recording) {
+            Item stop;
+            stop.type = Stop;
+            enqueueLocked(stop);
+            m_recording = false;
+        }
+        m_stopping = true;
+        m_preRoll.clear();
+        m_wake.wakeAll();
+    }
+    wait();
+}
+
+RecordingSink::Stats RecordingSink::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats;
+    stats.recording = m_recording;
+    stats.queueDepth = m_queuedFrames + m_queuedPreRoll;
+    stats.encodeFps = m_encodeFps;
+    stats.framesEncoded = m_framesEncoded;
+    stats.framesDropped = m_framesDropped;
+    stats.encoderName = m_activeEncoderName;
+    return stats;
+}
+
+void RecordingSink::run()
+{
+    qDebug() << "RecordingSink: Encoder thread started for source" << m_sourceId;
+
+    while (true) {
+        Item item;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue.isEmpty() && !m_stopping) {
+                m_wake.wait(&m_mutex, 1000);
+                if (m_queue.isEmpty() && !m_stopping) {
+                    locker.unlock();
+                    updateFps(frameClockNs());   // 空闲时让帧率回落到 0
+                    continue;
+                }
+            }
+            if (m_queue.isEmpty()) {
+                break;      // 停止且队列已排空
+            }
+
+            item = m_queue.dequeue();
+            if (item.type == Frame) {
+                if (item.preRoll) {
+                    --m_queuedPreRoll;
+                } else {
+                    --m_queuedFrames;
+                }
+                publishQueueDepthLocked();
+            }
+        }
+
+        switch (item.type) {
+        case Start:
+            beginSegment(item.path);
+            break;
+        case Frame:
+            encodeFrame(item);
+            break;
+        case Stop:
+            endSegment();
+            break;
+        }
+    }
+
+    endSegment();
+    qDebug() << "RecordingSink: Encoder thread stopped for source" << m_sourceId;
+}
+
+void RecordingSink::beginSegment(const QString& path)
+{
+    endSegment();
+    m_segment = Segment();
+    m_segment.active = true;
+    m_segment.path = path;
+
+    QMutexLocker locker(&m_mutex);
+    m_segment.index = m_index;
+    m_segment.segmentSeconds = m_segmentSeconds;
+    m_segment.container = m_container;
+}
+
+void RecordingSink::encodeFrame(const Item& item)
+{
+    if (!m_segment.active) {
+        return;
+    }
+    if (m_segment.failed) {
+        // 单文件录制失败即结束；分段录制到退避时间后在当前帧处打开新分段
+        if (!m_segment.index || item.captureNs < m_segment.retryNs) {
+            return;
+        }
+        m_segment.failed = false;
+        qDebug() << "RecordingSink: Retrying recording for source" << m_sourceId;
+    }
+
+    // 分段录制：到达分段时长后在当前帧处换新文件，新文件的第一帧必然是关键帧
+    if (m_segment.encoder && m_segment.index
+        && item.captureNs - m_segment.firstNs >= qint64(m_segment.segmentSeconds) * 1000000000LL) {
+        finishFile();
+    }
+
+    if (!m_segment.encoder && !openFile(item)) {
+        return;
+    }
+
+    SV_TRACE_SCOPE("record", "encode");
+    const qint64 startNs = frameClockNs();
+    const qint64 ptsMs = (item.captureNs - m_segment.firstNs) / 1000000;
+    if (!m_segment.encoder->encode(item.image, ptsMs)) {
+        failFile(m_segment.encoder->lastError(), item.captureNs);
+        return;
+    }
+    const qint64 endNs = frameClockNs();
+
+    m_segment.frames++;
+    m_segment.lastNs = item.captureNs;
+    indexKeyframes();
+    const qint64 bytes = m_segment.encoder->bytesWritten();
+    m_bytesCounter->add(quint64(bytes - m_segment.bytesCounted));
+    m_segment.bytesCounted = bytes;
+    m_encodeMs->record((endNs - startNs) / 1e6);
+    m_encodedCounter->add();
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_framesEncoded;
+    }
+
+    ++m_fpsWindowFrames;
+    updateFps(endNs);
+}
+
+// 编码器在每个文件的第一帧到达时创建：输出分辨率取该帧尺寸
+bool RecordingSink::openFile(const Item& item)
+{
+    VideoEncoderConfig config;
+    config.size = item.image.size();
+    QString encoderName;
+    {
+        QMutexLocker locker(&m_mutex);
+        encoderName = m_encoderName;
+        config.fps = m_fps;
+        config.bitrateKbps = m_bitrateKbps;
+        config.syncBytes = m_syncBytes;
+    }
+
+    if (m_segment.wallOffsetMs == 0) {
+        m_segment.wallOffsetMs = QDateTime::currentMSecsSinceEpoch() - frameClockNs() / 1000000;
+    }
+    m_segment.firstNs = item.captureNs;
+    m_segment.lastNs = item.captureNs;
+    m_segment.frames = 0;
+    m_segment.bytesCounted = 0;
+
+    if (m_segment.index) {
+        const qint64 startMs = m_segment.wallOffsetMs + item.captureNs / 1000000;
+        // 索引写不进去也照常录像，只是这个分段无法按时间定位
+        const qint64 fileStartMs = m_segment.index->beginSegment(startMs, m_segment.container)
+            ? m_segment.index->segmentStartMs() : startMs;
+        m_segment.path = m_segment.index->segmentPath(fileStartMs, m_segment.container);
+        config.fragmented = m_segment.container == SegmentIndex::FragmentedMp4;
+        // 分段时长已知：按码率预留一个分段的空间（留 25% 余量给码控波动与容器开销）
+        config.preallocateBytes = qint64(config.bitrateKbps) * 1000 / 8 * m_segment.segmentSeconds * 5 / 4;
+    }
+
+    QDir().mkpath(QFileInfo(m_segment.path).absolutePath());
+    m_segment.encoder = VideoEncoderRegistry::create(encoderName);
+    if (!m_segment.encoder || !m_segment.encoder->open(m_segment.path, config)) {
+        const QString error = m_segment.encoder ? m_segment.encoder->lastError()
+                                                : QString("no video encoder available for '%1'").arg(encoderName);
+        delete m_segment.encoder;
+        m_segment.encoder = nullptr;
+        if (m_segment.index) {
+            m_segment.index->endSegment(m_segment.index->segmentStartMs(), 0);
+        }
+        qWarning() << "RecordingSink: Cannot start" << m_segment.path << "-" << error;
+        m_segment.failed = true;
+        m_segment.retryNs = item.captureNs + kRetryIntervalNs;
+        emit recordingFailed(m_segment.path, error);
+        if (m_segment.index) {
+            m_segment.path.clear();
+        }
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_activeEncoderName = m_segment.encoder->name();
+    }
+    FlightRecorder::instance().recordEvent(FlightRecorder::Note, m_sourceId, 0, "record_start");
+    return true;
+}
+
+void RecordingSink::indexKeyframes()
+{
+    if (!m_segment.encoder) {
+        return;
+    }
+
+    const QVector<VideoKeyframe> keyframes = m_segment.encoder->takeKeyframes();
+    if (!m_segment.index) {
+        return;
+    }
+    const qint64 startMs = m_segment.index->segmentStartMs();
+    for (const VideoKeyframe& keyframe : keyframes) {
+        m_segment.index->addKeyframe(startMs + keyframe.ptsMs, keyframe.byteOffset);
+    }
+}
+
+// 🆕 写入失败：关闭编码器与文件，按实际写入的字节写入分段结束；分段录制退避后重试
+void RecordingSink::failFile(const QString& error, qint64 captureNs)
+{
+    qWarning() << "RecordingSink: Encoding failed for" << m_segment.path << "-" << error;
+    m_segment.failed = true;
+    m_segment.retryNs = captureNs + kRetryIntervalNs;
+    emit recordingFailed(m_segment.path, error);
+    finishFile();
+}
+
+// 关闭当前文件；分段录制时录制本身继续，下一帧打开新的分段
+void RecordingSink::finishFile()
+{
+    if (m_segment.path.isEmpty()) {
+        return;
+    }
+
+    bool ok = !m_segment.failed && m_segment.frames > 0;
+    qint64 bytes = 0;
+    if (m_segment.encoder) {
+        ok = m_segment.encoder->close() && ok;
+        bytes = m_segment.encoder->bytesWritten();
+        m_bytesCounter->add(quint64(qMax<qint64>(0, bytes - m_segment.bytesCounted)));
+        m_segment.bytesCounted = bytes;
+        indexKeyframes();       // 冲刷编码器时可能还有关键帧写出
+        delete m_segment.encoder;
+        m_segment.encoder = nullptr;
+
+        if (m_segment.index) {
+            const qint64 startMs = m_segment.index->segmentStartMs();
+            m_segment.index->endSegment(startMs + (m_segment.lastNs - m_segment.firstNs) / 1000000, bytes);
+        }
+    }
+
+    const qint64 durationMs = m_segment.frames > 0 ? (m_segment.lastNs - m_segment.firstNs) / 1000000 : 0;
+    qDebug() << "RecordingSink: Finished" << m_segment.path << "frames:" << m_segment.frames
+             << "duration:" << durationMs << "ms" << (ok ? "" : "(failed)");
+    FlightRecorder::instance().recordEvent(FlightRecorder::Note, m_sourceId, m_segment.frames, "record_stop");
+    emit recordingFinished(m_segment.path, durationMs, m_segment.frames, ok);
+
+    // 单文件录制只会结束一次（失败后不再重开），分段录制的下一个文件路径由开始时间决定
+    m_segment.path.clear();
+    m_segment.frames = 0;
+}
+
+void RecordingSink::endSegment()
+{
+    if (!m_segment.active) {
+        return;
+    }
+
+    finishFile();
+    m_segment = Segment();
+}
+
+void RecordingSink::updateFps(qint64 nowNs)
+{
+    if (m_fpsWindowStartNs == 0) {
+        m_fpsWindowStartNs = nowNs;
+        return;
+    }
+
+    const qint64 elapsedNs = nowNs - m_fpsWindowStartNs;
+    if (elapsedNs < 1000000000LL) {
+        return;
+    }
+
+    const double fps = m_fpsWindowFrames * 1e9 / elapsedNs;
+    m_fpsWindowStartNs = nowNs;
+    m_fpsWindowFrames = 0;
+    m_encodeFpsGauge->set(fps);
+
+    QMutexLocker locker(&m_mutex);
+    m_encodeFps = fps;
+}
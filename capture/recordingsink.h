@@ -0,0 +1,164 @@
+#ifndef RECORDINGSINK_H
+#define RECORDINGSINK_H
+
+#include <QThread>
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QString>
+#include "videoencoder.h"
+#include "segmentindex.h"
+#include "../core/FrameMeta.h"
+
+class MetricCounter;
+class MetricGauge;
+class MetricHistogram;
+
+// 🆕 录像输出端：采集线程投递帧，独立编码线程消费有界队列并编码封装
+// - pushFrame 只在锁内做 QImage 引用计数拷贝，从不阻塞；队列满时丢弃新帧并计数
+// - 未录制时帧进入预录缓冲（保留最近 preRollMs，最多 preRollCapacity 帧，帧数不够时均匀抽帧），
+//   开始录制时先写入；预录帧单独计数，不占用 queueCapacity，编码稍有滞后时触发事件的实时帧不会被预录挤掉
+// - 帧率上限之外的帧在入队前丢弃，降低编码与内存压力
+//   （720x1280 RGB888 每帧约 2.6MB，内存上限 = (preRollCapacity + queueCapacity) 帧）
+// - 🆕 设置分段索引后按固定时长切成 MPEG-TS / 分片 MP4 分段，片段开始、关键帧偏移
+//   与片段结束写入 SegmentIndex；startRecording 的路径此时被忽略，文件名由开始时间决定
+// - 🆕 写入/打开失败（如磁盘满）时关闭文件并写入分段结束，分段录制在退避后换新分段重试，
+//   配额清理腾出空间后录像自动恢复；单文件录制失败即结束本次录制
+// 指标（按来源）：record.queue.depth / record.encode.fps / record.frames.encoded /
+// record.frames.dropped / record.encode_ms / storage.bytes.written
+class RecordingSink : public QThread
+{
+    Q_OBJECT
+
+public:
+    struct Stats {
+        bool recording = false;
+        int queueDepth = 0;
+        double encodeFps = 0.0;         // 最近一秒的编码帧率
+        quint64 framesEncoded = 0;      // 累计
+        quint64 framesDropped = 0;      // 累计（队列满）
+        QString encoderName;            // 当前/上一个片段使用的编码器
+    };
+
+    explicit RecordingSink(int sourceId, QObject* parent = nullptr);
+    ~RecordingSink() override;
+
+    // 配置（下一个片段生效）
+    void setEncoder(const QString& name);           // 见 VideoEncoderRegistry，默认 "auto"
+    void setFrameRate(int fps);                     // 录制帧率上限，默认 15
+    void setBitrateKbps(int kbps);                  // 默认 2000
+    void setPreRollMs(int ms);                      // 预录时长，默认 2000
+    void setPreRollCapacity(int frames);            // 🆕 预录帧数上限，默认 15（约 40MB）
+    void setQueueCapacity(int frames);              // 编码队列容量，默认 45（3 秒）
+    // 🆕 分段录制：index 由调用方持有且生命周期长于编码线程；传 nullptr 恢复单文件录制
+    void setSegmentation(SegmentIndex* index, int segmentSeconds = 60,
+                         SegmentIndex::Container container = SegmentIndex::TransportStream);
+    SegmentIndex* segmentIndex() const;
+    // 🆕 每写入多少字节发起一次回写（见 SegmentFile），默认 1MB；0 为只在关闭文件时同步
+    void setSyncBytes(qint64 bytes);
+
+    int sourceId() const { return m_sourceId; }
+
+    // 任意线程调用，不阻塞
+    void pushFrame(const QImage& frame, const FrameMeta& meta);
+
+    // 开始一个新片段（预录缓冲先写入）/ 结束当前片段；任意线程调用，立即返回
+    void startRecording(const QString& path);
+    void stopRecording();
+    bool isRecording() const;
+
+    // 结束当前片段并停止编码线程
+    void shutdown();
+
+    Stats stats() const;
+
+signals:
+    // 在编码线程发出
+    void recordingFinished(const QString& path, qint64 durationMs, qint64 frames, bool ok);
+    void recordingFailed(const QString& path, const QString& error);
+
+protected:
+    void run() override;
+
+private:
+    enum ItemType { Frame, Start, Stop };
+
+    struct Item {
+        ItemType type = Frame;
+        QImage image;
+        qint64 captureNs = 0;
+        bool preRoll = false;           // 预录帧：不计入 m_queuedFrames
+        QString path;
+    };
+
+    // 一次 startRecording..stopRecording；分段录制时其中会依次打开多个文件
+    struct Segment {
+        bool active = false;
+        QString path;                   // 单文件录制为请求的路径，分段录制为当前分段文件
+        VideoEncoder* encoder = nullptr;
+        bool failed = false;
+        qint64 retryNs = 0;             // 分段录制失败后，采集时间到此才重新打开分段
+        qint64 firstNs = 0;             // 当前文件第一帧的采集时间
+        qint64 lastNs = 0;
+        qint64 frames = 0;
+        qint64 bytesCounted = 0;        // 当前文件已计入 storage.bytes.written 的字节数
+        qint64 wallOffsetMs = 0;        // 采集时钟 → 墙钟，整段录制只取一次，分段边界不抖动
+        SegmentIndex* index = nullptr;  // 开始录制时的分段配置
+        int segmentSeconds = 0;
+        SegmentIndex::Container container = SegmentIndex::TransportStream;
+    };
+
+    void enqueueLocked(const Item& item);
+    void publishQueueDepthLocked();
+    void beginSegment(const QString& path);
+    void encodeFrame(const Item& item);
+    bool openFile(const Item& item);
+    void failFile(const QString& error, qint64 captureNs);
+    void finishFile();
+    void indexKeyframes();
+    void endSegment();
+    void updateFps(qint64 nowNs);
+
+    const int m_sourceId;
+
+    mutable QMutex m_mutex;         // 保护以下队列与配置
+    QWaitCondition m_wake;
+    QQueue<Item> m_queue;           // 编码队列（帧 + 控制命令）
+    QQueue<Item> m_preRoll;         // 预录缓冲，只含帧
+    int m_queuedFrames = 0;         // 队列中的实时帧
+    int m_queuedPreRoll = 0;        // 队列中的预录帧
+    bool m_recording = false;
+    bool m_stopping = false;
+    qint64 m_lastAcceptedNs = 0;
+    qint64 m_lastPreRollNs = 0;
+
+    QString m_encoderName = "auto";
+    int m_fps = 15;
+    int m_bitrateKbps = 2000;
+    int m_preRollMs = 2000;
+    int m_preRollCapacity = 15;
+    int m_queueCapacity = 45;
+    SegmentIndex* m_index = nullptr;
+    int m_segmentSeconds = 60;
+    SegmentIndex::Container m_container = SegmentIndex::TransportStream;
+    qint64 m_syncBytes = 1 << 20;
+    QString m_activeEncoderName;
+    quint64 m_framesDropped = 0;
+
+    // 以下只在编码线程访问（fps 结果除外）
+    Segment m_segment;
+    qint64 m_fpsWindowStartNs = 0;
+    int m_fpsWindowFrames = 0;
+    double m_encodeFps = 0.0;       // 受 m_mutex 保护
+    quint64 m_framesEncoded = 0;    // 受 m_mutex 保护
+
+    MetricGauge* m_queueDepthGauge;
+    MetricGauge* m_encodeFpsGauge;
+    MetricCounter* m_encodedCounter;
+    MetricCounter* m_droppedCounter;
+    MetricHistogram* m_encodeMs;
+    MetricCounter* m_bytesCounter;
+};
+
+#endif // RECORDINGSINK_H
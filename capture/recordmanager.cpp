@@ -1,4 +1,7 @@
 #include "recordmanager.h"
+#include "recordingsink.h"
+#include <QCoreApplication>
+#include <QDir>
 
 RecordManager::RecordManager(QObject *parent)
     : QObject(parent)
@@ -10,11 +13,18 @@ RecordManager::RecordManager(QObject *parent)
     m_cooldownTimer = new QTimer(this);
     m_cooldownTimer->setSingleShot(true);
     connect(m_cooldownTimer, &QTimer::timeout, this, &RecordManager::onCooldownTimer);
+
+    // 🆕 最大录制时长：持续触发时也会在此切断片段
+    m_maxDurationTimer = new QTimer(this);
+    m_maxDurationTimer->setSingleShot(true);
+    connect(m_maxDurationTimer, &QTimer::timeout, this, &RecordManager::onMaxDurationTimer);
+
+    m_outputDirectory = QCoreApplication::applicationDirPath() + "/data/records";
 }
 
 RecordManager::~RecordManager()
 {
-    if (m_state == Recording) {
+    if (m_state == Recording || m_state == PostRecord) {
         stopActualRecording();
     }
 }
@@ -27,6 +37,8 @@ void RecordManager::onMotionDetected()
 
     switch (m_state) {
     case Idle:
+        m_triggerKind = SegmentIndex::MotionEvent;
+        m_triggerTime = m_lastMotionTime;
         changeState(PreRecord);
         m_recordTimer->start(m_preRecordDelay);
         qDebug() << "RecordManager: Motion detected - Starting pre-record timer";
@@ -85,35 +97,107 @@ void RecordManager::onRecordTimer()
     }
 }
 
+void RecordManager::onMaxDurationTimer()
+{
+    if (m_state != Recording && m_state != PostRecord) {
+        return;
+    }
+
+    m_recordTimer->stop();
+    stopActualRecording();
+    changeState(Cooldown);
+    m_cooldownTimer->start(m_cooldownPeriod);
+    qDebug() << "RecordManager: Maximum duration reached - Entering cooldown";
+}
+
 void RecordManager::onCooldownTimer()
 {
     changeState(Idle);
     qDebug() << "RecordManager: Cooldown finished - Ready for next recording";
 }
 
+qint64 RecordManager::recordingStartMs() const
+{
+    if (m_state != Recording && m_state != PostRecord) {
+        return 0;
+    }
+    return m_recordStartTime.toMSecsSinceEpoch();
+}
+
+qint64 RecordManager::triggerTimeMs() const
+{
+    if (m_state != Recording && m_state != PostRecord) {
+        return 0;
+    }
+    return m_triggerTime.toMSecsSinceEpoch();
+}
+
 void RecordManager::startActualRecording()
 {
     m_recordStartTime = QDateTime::currentDateTime();
     m_currentRecordFile = generateRecordFilename();
+    m_maxDurationTimer->start(m_maxRecordDuration);
+    markEvent(m_triggerKind);
 
-    // TODO: 实际启动视频录制
-    // 这里需要集成实际的视频编码器
+    // 🆕 sink 在编码线程中打开文件，这里只投递命令，不阻塞 GUI 线程
+    // 分段录制时文件按开始时间命名，路径参数被忽略；连续录制时 sink 已在录
+    if (m_sink && !m_continuous) {
+        m_sink->startRecording(QDir(m_outputDirectory).filePath(m_currentRecordFile));
+    }
 
     emit recordingStarted(m_currentRecordFile);
 }
 
 void RecordManager::stopActualRecording()
 {
-    if (m_state == Recording) {
+    if (m_state == Recording || m_state == PostRecord) {
         int duration = m_recordStartTime.msecsTo(QDateTime::currentDateTime());
 
-        // TODO: 停止实际的视频录制
+        m_maxDurationTimer->stop();
+        markEvent(SegmentIndex::ClipEnd, duration);
+        if (m_sink && !m_continuous) {
+            m_sink->stopRecording();
+        }
 
         emit recordingStopped(m_currentRecordFile, duration);
         m_currentRecordFile.clear();
     }
 }
 
+void RecordManager::setSink(RecordingSink* sink)
+{
+    m_sink = sink;
+    if (m_sink) {
+        // 预录缓冲覆盖触发前的等待期，片段从首次检测到运动之前开始
+        m_sink->setPreRollMs(m_preRecordDelay + 1000);
+    }
+}
+
+void RecordManager::setContinuousRecording(bool continuous)
+{
+    if (m_continuous == continuous) {
+        return;
+    }
+    m_continuous = continuous;
+
+    if (m_sink) {
+        if (m_continuous && !m_sink->isRecording()) {
+            m_sink->startRecording(QDir(m_outputDirectory).filePath(generateRecordFilename()));
+        } else if (m_state != Recording && m_state != PostRecord) {
+            m_sink->stopRecording();
+        }
+    }
+    qDebug() << "RecordManager: Continuous recording" << (m_continuous ? "enabled" : "disabled");
+}
+
+void RecordManager::markEvent(int kind, qint64 value)
+{
+    SegmentIndex* index = m_sink ? m_sink->segmentIndex() : nullptr;
+    if (index && kind != 0) {
+        index->addEvent(QDateTime::currentMSecsSinceEpoch(), SegmentIndex::EventKind(kind), value);
+    }
+}
+
 QString RecordManager::generateRecordFilename()
 {
     return QString("motion_%1.mp4").arg(
@@ -135,6 +219,7 @@ void RecordManager::onFaceDetected()
     // 人脸检测触发录制的逻辑与运动检测相同
     // 因为人脸检测通常比运动检测更精确
     onMotionDetected();
+    m_triggerKind = SegmentIndex::FaceEvent;
 
     qDebug() << "RecordManager: Face detected - triggering recording";
 }
@@ -145,6 +230,9 @@ void RecordManager::onManualTrigger()
 
     // 手动触发立即开始录制，跳过预录制阶段
     if (m_state == Idle || m_state == Cooldown) {
+        m_cooldownTimer->stop();
+        m_triggerKind = SegmentIndex::ManualEvent;
+        m_triggerTime = QDateTime::currentDateTime();
         changeState(Recording);
         startActualRecording();
         m_recordTimer->start(m_minRecordDuration); // 手动录制使用最小时长
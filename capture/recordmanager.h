@@ -8,6 +8,8 @@
 #include <QDebug>
 #include "../ai/aitypes.h"
 
+class RecordingSink;
+
 class RecordManager : public QObject
 {
     Q_OBJECT
@@ -29,6 +31,10 @@ public:
     bool isEnabled() const { return m_enabled; }
     bool isRecording() const { return m_state == Recording; }
     RecordState currentState() const { return m_state; }
+    // 🆕 当前录像的开始时间（墙钟毫秒，供事件库关联录像）；未在录制时为 0
+    qint64 recordingStartMs() const;
+    // 🆕 当前录像的触发时刻（进入预录或手动开始，墙钟毫秒）；未在录制时为 0
+    qint64 triggerTimeMs() const;
 
     // 配置接口
     void setPreRecordDelay(int ms) { m_preRecordDelay = ms; }
@@ -37,6 +43,17 @@ public:
     void setCooldownPeriod(int ms) { m_cooldownPeriod = ms; }
     void setMaxRecordDuration(int ms) { m_maxRecordDuration = ms; }
 
+    // 🆕 录像输出：sink 负责编码与写盘，RecordManager 只驱动片段的开始与结束
+    // 未设置 sink 时仅维护状态与信号（与之前行为一致）
+    void setSink(RecordingSink* sink);
+    RecordingSink* sink() const { return m_sink; }
+    void setOutputDirectory(const QString& dir) { m_outputDirectory = dir; }
+    QString outputDirectory() const { return m_outputDirectory; }
+
+    // 🆕 连续录制：sink 一直录（需配合分段索引），触发只在索引里打事件标记
+    void setContinuousRecording(bool continuous);
+    bool isContinuousRecording() const { return m_continuous; }
+
 public slots:
     void onMotionDetected();
     void onFaceDetected();
@@ -51,6 +68,7 @@ signals:
 private slots:
     void onRecordTimer();
     void onCooldownTimer();
+    void onMaxDurationTimer();      // 🆕 单个片段达到最大时长
 
 private:
     bool m_enabled = true;
@@ -58,7 +76,13 @@ private:
 
     QTimer* m_recordTimer;
     QTimer* m_cooldownTimer;
+    QTimer* m_maxDurationTimer;
+    RecordingSink* m_sink = nullptr;
+    QString m_outputDirectory;
+    bool m_continuous = false;
+    int m_triggerKind = 0;            // SegmentIndex::EventKind，本次录制的触发来源
     QDateTime m_lastMotionTime;
+    QDateTime m_triggerTime;          // 🆕 本次录制的触发时刻
     QDateTime m_recordStartTime;
     QString m_currentRecordFile;
 
@@ -72,6 +96,7 @@ private:
     void startActualRecording();
     void stopActualRecording();
     QString generateRecordFilename();
+    void markEvent(int kind, qint64 value = 0);
     void changeState(RecordState newState);
 };
 
@@ -1,4 +1,6 @@
 #include "rtspthread.h"
+#include "../core/TraceRecorder.h"
+#include "../core/FlightRecorder.h"
 #include <QDebug>
 
 RtspThread::RtspThread(QObject *parent)
@@ -17,6 +19,10 @@ void RtspThread::setThreadStart(bool start) {
     m_running = start;
 }
 
+void RtspThread::setSourceId(int sourceId) {
+    m_sourceId = sourceId;
+}
+
 void RtspThread::run() {
     AVFormatContext *fmt_ctx = nullptr;
     AVCodecContext *codec_ctx = nullptr;
@@ -33,6 +39,7 @@ void RtspThread::run() {
 
     if (avformat_open_input(&fmt_ctx, m_url.toStdString().c_str(), nullptr, &opts) != 0) {
         qDebug() << "cant open rtSP" << m_url;
+        FlightRecorder::instance().recordEvent(FlightRecorder::StreamLost, m_sourceId, 0, "rtsp_open_failed");
         return;
     }
 
@@ -83,6 +90,9 @@ void RtspThread::run() {
         pix_fmt = AV_PIX_FMT_YUV420P;
     }
 
+    FlightRecorder& flightRecorder = FlightRecorder::instance();
+    flightRecorder.recordEvent(FlightRecorder::StreamOpened, m_sourceId, 0, "rtsp");
+
     int target_width = 1280;
     int target_height = 720;
     sws_ctx = sws_getContext(codec_ctx->width, codec_ctx->height, pix_fmt,
@@ -98,30 +108,58 @@ void RtspThread::run() {
     int rgb_linesize[4];
     av_image_alloc(rgb_data, rgb_linesize, target_width, target_height, AV_PIX_FMT_RGB24, 1);
 
-    while (m_running && av_read_frame(fmt_ctx, pkt) >= 0) {
+    while (m_running) {
+        int readResult;
+        {
+            SV_TRACE_SCOPE("capture", "av_read_frame");
+            readResult = av_read_frame(fmt_ctx, pkt);
+        }
+        if (readResult < 0) {
+            // 读流出错或对端断开（正常停止时 m_running 已为 false，不会走到这里）
+            flightRecorder.recordEvent(FlightRecorder::StreamLost, m_sourceId, readResult, "rtsp_read");
+            break;
+        }
+        flightRecorder.heartbeat(m_sourceId);
+
         if (pkt->stream_index == video_stream_index) {
-            if (avcodec_send_packet(codec_ctx, pkt) == 0) {
+            // 🆕 以收到数据包的时刻作为采集时间；一个包解出的各帧共用
+            const FrameMeta packetMeta = FrameMeta::begin(m_sourceId, 0);
+            bool packetAccepted;
+            {
+                SV_TRACE_SCOPE("capture", "decode");
+                packetAccepted = avcodec_send_packet(codec_ctx, pkt) == 0;
+            }
+            if (packetAccepted) {
                 while (avcodec_receive_frame(codec_ctx, frame) == 0) {
 
                     if (frame->format != AV_PIX_FMT_YUV420P && frame->format != AV_PIX_FMT_YUVJ420P && frame->format != AV_PIX_FMT_NV12) {
                         continue;
                     }
 
-                    sws_scale(sws_ctx, frame->data, frame->linesize, 0, codec_ctx->height,
-                              rgb_data, rgb_linesize);
-                    QImage image(rgb_data[0], target_width, target_height, rgb_linesize[0], QImage::Format_RGB888);
+                    FrameMeta meta = packetMeta;
+                    meta.sequence = ++m_sequence;
+
+                    QImage image;
+                    {
+                        SV_TRACE_SCOPE_ARG("capture", "convert", meta.sequence);
+                        sws_scale(sws_ctx, frame->data, frame->linesize, 0, codec_ctx->height,
+                                  rgb_data, rgb_linesize);
+                        image = QImage(rgb_data[0], target_width, target_height, rgb_linesize[0], QImage::Format_RGB888).copy();
+                    }
                     // 添加旋转逻辑
 //                    QTransform transform;
 //                    transform.rotate(-270);  // 逆时针旋转90°
 //                    QImage rotatedImage = image.transformed(transform);
 
-                    emit resultReady(image.copy());
+                    meta.stamp(FrameMeta::Decode);
+                    emit resultReady(image, meta);
                 }
             }
         }
         av_packet_unref(pkt);
     }
 
+    flightRecorder.endHeartbeat(m_sourceId);
     av_freep(&rgb_data[0]);
     sws_freeContext(sws_ctx);
     av_frame_free(&frame);
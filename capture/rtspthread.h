@@ -6,6 +6,7 @@
 #include <QMutex>
 #include <QWaitCondition>
 #include <atomic>
+#include "../core/FrameMeta.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -22,9 +23,10 @@ public:
 
     void setRtspUrl(const QString &url);
     void setThreadStart(bool start);
+    void setSourceId(int sourceId);
 
 signals:
-    void resultReady(const QImage &image);
+    void resultReady(const QImage &image, const FrameMeta &meta);
 
 protected:
     void run() override;
@@ -32,6 +34,8 @@ protected:
 private:
     QString m_url;
     std::atomic<bool> m_running;
+    int m_sourceId = FrameSource::Rtsp1;
+    quint64 m_sequence = 0;     // 🆕 来源内帧序号
 };
 
 #endif // RTSPTHREAD_H
@@ -0,0 +1,152 @@
+#include "segmentfile.h"
+#include "../core/MetricsRegistry.h"
+#include "../core/FrameMeta.h"
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+SegmentFile::SegmentFile()
+    : m_syncMs(MetricsRegistry::instance().histogram("storage.sync_ms"))
+{
+}
+
+SegmentFile::~SegmentFile()
+{
+    close();
+}
+
+bool SegmentFile::fail(const QString& what)
+{
+    m_lastError = QString("%1: %2").arg(what, QString::fromLocal8Bit(strerror(errno)));
+    qWarning() << "SegmentFile:" << m_lastError << m_path;
+    return false;
+}
+
+bool SegmentFile::open(const QString& path, const Options& options)
+{
+    close();
+    m_path = path;
+    m_options = options;
+    m_lastError.clear();
+    m_position = 0;
+    m_size = 0;
+    m_preallocated = false;
+    m_syncedUpTo = 0;
+    m_previousStart = 0;
+    m_previousLength = 0;
+
+    const QByteArray pathBytes = path.toLocal8Bit();
+    do {
+        m_fd = ::open(pathBytes.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    } while (m_fd < 0 && errno == EINTR);
+    if (m_fd < 0) {
+        return fail("open failed");
+    }
+
+#ifdef __linux__
+    // KEEP_SIZE：只预留块，不改变文件长度，播放器与索引看到的仍是实际写入的大小
+    if (m_options.preallocateBytes > 0) {
+        if (fallocate(m_fd, FALLOC_FL_KEEP_SIZE, 0, m_options.preallocateBytes) == 0) {
+            m_preallocated = true;
+        } else if (errno != EOPNOTSUPP && errno != ENOSYS) {
+            qWarning() << "SegmentFile: fallocate failed for" << path << strerror(errno);
+        }
+    }
+#endif
+    return true;
+}
+
+qint64 SegmentFile::write(const char* data, qint64 size)
+{
+    if (m_fd < 0) {
+        return -1;
+    }
+
+    qint64 done = 0;
+    while (done < size) {
+        const ssize_t n = ::write(m_fd, data + done, size_t(size - done));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fail("write failed");
+            return -1;
+        }
+        done += n;
+    }
+
+    m_position += done;
+    m_size = qMax(m_size, m_position);
+    if (m_options.syncBytes > 0 && m_position - m_syncedUpTo >= m_options.syncBytes) {
+        writeback();
+    }
+    return done;
+}
+
+qint64 SegmentFile::seek(qint64 offset, int whence)
+{
+    if (m_fd < 0) {
+        return -1;
+    }
+    const off_t position = ::lseek(m_fd, off_t(offset), whence);
+    if (position < 0) {
+        fail("seek failed");
+        return -1;
+    }
+    m_position = position;
+    return position;
+}
+
+// 发起 [m_syncedUpTo, m_position) 的回写，并等待上一段完成；
+// 回写在后台进行，这里只在磁盘跟不上码率时才会等待
+void SegmentFile::writeback()
+{
+    const qint64 start = m_syncedUpTo;
+    const qint64 length = m_position - start;
+    if (length <= 0) {
+        return;
+    }
+
+    const qint64 startNs = frameClockNs();
+#ifdef __linux__
+    if (m_previousLength > 0) {
+        sync_file_range(m_fd, m_previousStart, m_previousLength,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+    }
+    sync_file_range(m_fd, start, length, SYNC_FILE_RANGE_WRITE);
+#else
+    fdatasync(m_fd);
+#endif
+    m_syncMs->record((frameClockNs() - startNs) / 1e6);
+
+    m_previousStart = start;
+    m_previousLength = length;
+    m_syncedUpTo = m_position;
+}
+
+bool SegmentFile::close()
+{
+    if (m_fd < 0) {
+        return true;
+    }
+
+    bool ok = true;
+    // 归还预留但未用到的块
+    if (m_preallocated && ftruncate(m_fd, off_t(m_size)) != 0) {
+        ok = fail("truncate failed");
+    }
+
+    const qint64 startNs = frameClockNs();
+    if (fdatasync(m_fd) != 0) {
+        ok = fail("fdatasync failed");
+    }
+    m_syncMs->record((frameClockNs() - startNs) / 1e6);
+
+    if (::close(m_fd) != 0) {
+        ok = fail("close failed");
+    }
+    m_fd = -1;
+    return ok;
+}
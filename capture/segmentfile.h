@@ -0,0 +1,58 @@
+#ifndef SEGMENTFILE_H
+#define SEGMENTFILE_H
+
+#include <QString>
+
+class MetricHistogram;
+
+// 🆕 录像分段文件的写入端（POSIX fd），供编码器的自定义 AVIOContext 使用
+// - 打开时按预计大小 fallocate(FALLOC_FL_KEEP_SIZE) 预留空间：文件连续、写入时不再临时分配块，
+//   关闭时截到实际大小归还多余部分；文件系统不支持时照常写
+// - 每写满 syncBytes 发起一次异步回写（sync_file_range），并等待上一段回写完成，
+//   脏页始终不超过两段，避免内核攒到阈值后一次性刷盘造成的写入长尾
+// - 关闭时 fdatasync，分段结束（索引写入 SegmentEnd）时文件已落盘
+// 只在编码线程中使用
+class SegmentFile
+{
+public:
+    struct Options {
+        qint64 preallocateBytes = 0;    // 0 表示不预分配
+        qint64 syncBytes = 0;           // 0 表示只在关闭时同步
+    };
+
+    SegmentFile();
+    ~SegmentFile();
+
+    bool open(const QString& path, const Options& options);
+    bool isOpen() const { return m_fd >= 0; }
+
+    // 返回写入字节数，出错返回 -1
+    qint64 write(const char* data, qint64 size);
+    // whence 为 SEEK_SET/SEEK_CUR/SEEK_END，返回新位置，出错返回 -1
+    qint64 seek(qint64 offset, int whence);
+    qint64 size() const { return m_size; }
+
+    bool close();
+    QString lastError() const { return m_lastError; }
+
+private:
+    Q_DISABLE_COPY(SegmentFile)
+
+    bool fail(const QString& what);
+    void writeback();
+
+    QString m_path;
+    QString m_lastError;
+    Options m_options;
+    int m_fd = -1;
+    qint64 m_position = 0;
+    qint64 m_size = 0;
+    bool m_preallocated = false;
+    qint64 m_syncedUpTo = 0;        // 已发起回写的位置
+    qint64 m_previousStart = 0;     // 上一段回写区间，下一次先等它完成
+    qint64 m_previousLength = 0;
+
+    MetricHistogram* m_syncMs;
+};
+
+#endif // SEGMENTFILE_H
@@ -0,0 +1,411 @@
+#include "segmentindex.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const char kMagic[4] = {'S', 'V', 'I', 'X'};
+const quint16 kVersion = 1;
+const quint32 kSegmentIndexKind = 0;
+const quint32 kEventIndexKind = 1;
+
+QDate dayOf(qint64 timeMs)
+{
+    return QDateTime::fromMSecsSinceEpoch(timeMs).date();
+}
+
+void encodeRecord(const SegmentIndex::Record& record, uchar* out)
+{
+    qToLittleEndian<qint64>(record.timeMs, out);
+    qToLittleEndian<qint64>(record.value, out + 8);
+    qToLittleEndian<qint64>(record.aux, out + 16);
+    qToLittleEndian<quint32>(record.type, out + 24);
+    qToLittleEndian<quint32>(record.flags, out + 28);
+}
+
+SegmentIndex::Record decodeRecord(const uchar* in)
+{
+    SegmentIndex::Record record;
+    record.timeMs = qFromLittleEndian<qint64>(in);
+    record.value = qFromLittleEndian<qint64>(in + 8);
+    record.aux = qFromLittleEndian<qint64>(in + 16);
+    record.type = qFromLittleEndian<quint32>(in + 24);
+    record.flags = qFromLittleEndian<quint32>(in + 28);
+    return record;
+}
+
+bool headerValid(const uchar* header)
+{
+    return memcmp(header, kMagic, 4) == 0
+        && qFromLittleEndian<quint16>(header + 4) == kVersion
+        && qFromLittleEndian<quint16>(header + 6) == SegmentIndex::kRecordSize;
+}
+
+// 只读访问一个索引文件：记录定长且按时间有序，按下标随机读取即可二分
+class IndexReader
+{
+public:
+    bool open(const QString& path)
+    {
+        m_file.setFileName(path);
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+        uchar header[SegmentIndex::kHeaderSize];
+        if (m_file.read(reinterpret_cast<char*>(header), sizeof(header)) != sizeof(header) || !headerValid(header)) {
+            qWarning() << "SegmentIndex: Invalid index file" << path;
+            return false;
+        }
+        // 正在追加的文件末尾可能有半条记录，按整条计数即可忽略
+        m_count = int((m_file.size() - SegmentIndex::kHeaderSize) / SegmentIndex::kRecordSize);
+        return true;
+    }
+
+    int count() const { return m_count; }
+
+    bool read(int index, SegmentIndex::Record* record)
+    {
+        if (index < 0 || index >= m_count
+            || !m_file.seek(SegmentIndex::kHeaderSize + qint64(index) * SegmentIndex::kRecordSize)) {
+            return false;
+        }
+        uchar buffer[SegmentIndex::kRecordSize];
+        if (m_file.read(reinterpret_cast<char*>(buffer), sizeof(buffer)) != sizeof(buffer)) {
+            return false;
+        }
+        *record = decodeRecord(buffer);
+        return true;
+    }
+
+    // 第一条 timeMs > t 的记录下标
+    int upperBound(qint64 timeMs)
+    {
+        int low = 0;
+        int high = m_count;
+        SegmentIndex::Record record;
+        while (low < high) {
+            const int mid = low + (high - low) / 2;
+            if (!read(mid, &record)) {
+                return mid;
+            }
+            if (record.timeMs <= timeMs) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    // 第一条 timeMs >= t 的记录下标
+    int lowerBound(qint64 timeMs)
+    {
+        return timeMs == std::numeric_limits<qint64>::min() ? 0 : upperBound(timeMs - 1);
+    }
+
+private:
+    QFile m_file;
+    int m_count = 0;
+};
+
+} // namespace
+
+SegmentIndex::SegmentIndex(const QString& rootDir, int sourceId)
+    : m_rootDir(rootDir)
+    , m_sourceId(sourceId)
+{
+}
+
+SegmentIndex::~SegmentIndex()
+{
+    m_segmentFile.close();
+    QMutexLocker locker(&m_eventMutex);
+    m_eventFile.close();
+}
+
+QString SegmentIndex::cameraDirectory() const
+{
+    return QString("%1/cam%2").arg(m_rootDir).arg(m_sourceId);
+}
+
+QString SegmentIndex::segmentPath(qint64 startMs, Container container) const
+{
+    const QDateTime start = QDateTime::fromMSecsSinceEpoch(startMs);
+    return QString("%1/%2/%3.%4")
+        .arg(cameraDirectory(), start.toString("yyyyMMdd"), start.toString("hhmmss_zzz"),
+             container == FragmentedMp4 ? "mp4" : "ts");
+}
+
+QString SegmentIndex::indexPath(const QDate& day) const
+{
+    return QString("%1/index/%2.svi").arg(cameraDirectory(), day.toString("yyyyMMdd"));
+}
+
+QString SegmentIndex::eventPath(const QDate& day) const
+{
+    return QString("%1/index/%2.sve").arg(cameraDirectory(), day.toString("yyyyMMdd"));
+}
+
+bool SegmentIndex::openForAppend(QFile& file, const QString& path, quint32 kind, qint64* lastTimeMs)
+{
+    file.close();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        qWarning() << "SegmentIndex: Cannot open" << path << file.errorString();
+        return false;
+    }
+
+    if (file.size() < kHeaderSize) {
+        uchar header[kHeaderSize] = {0};
+        memcpy(header, kMagic, 4);
+        qToLittleEndian<quint16>(kVersion, header + 4);
+        qToLittleEndian<quint16>(quint16(kRecordSize), header + 6);
+        qToLittleEndian<qint32>(m_sourceId, header + 8);
+        qToLittleEndian<quint32>(kind, header + 12);
+        file.resize(0);
+        if (file.write(reinterpret_cast<const char*>(header), kHeaderSize) != kHeaderSize) {
+            qWarning() << "SegmentIndex: Cannot write header" << path;
+            file.close();
+            return false;
+        }
+        return file.flush();
+    }
+
+    uchar header[kHeaderSize];
+    if (file.read(reinterpret_cast<char*>(header), kHeaderSize) != kHeaderSize || !headerValid(header)) {
+        qWarning() << "SegmentIndex: Refusing to append to invalid index" << path;
+        file.close();
+        return false;
+    }
+
+    // 上次断电时写到一半的记录直接截掉
+    const qint64 records = (file.size() - kHeaderSize) / kRecordSize;
+    const qint64 validSize = kHeaderSize + records * kRecordSize;
+    if (file.size() != validSize) {
+        qWarning() << "SegmentIndex: Truncating partial record in" << path;
+        file.resize(validSize);
+    }
+
+    // 续写时接着文件里最后一条记录的时间，重启后墙钟回拨也不会破坏有序性
+    if (records > 0 && file.seek(validSize - kRecordSize)) {
+        uchar buffer[kRecordSize];
+        if (file.read(reinterpret_cast<char*>(buffer), kRecordSize) == kRecordSize) {
+            *lastTimeMs = qMax(*lastTimeMs, decodeRecord(buffer).timeMs);
+        }
+    }
+    return file.seek(validSize);
+}
+
+bool SegmentIndex::append(QFile& file, const Record& record)
+{
+    uchar buffer[kRecordSize];
+    encodeRecord(record, buffer);
+    if (file.write(reinterpret_cast<const char*>(buffer), kRecordSize) != kRecordSize) {
+        qWarning() << "SegmentIndex: Write failed" << file.fileName() << file.errorString();
+        return false;
+    }
+    // 只推到内核缓冲；落盘节奏由存储层决定
+    return file.flush();
+}
+
+bool SegmentIndex::beginSegment(qint64 startMs, Container container)
+{
+    const QDate day = dayOf(startMs);
+    if (!m_segmentFile.isOpen() || day != m_segmentDay) {
+        if (!openForAppend(m_segmentFile, indexPath(day), kSegmentIndexKind, &m_lastSegmentTimeMs)) {
+            m_segmentOpen = false;
+            return false;
+        }
+        m_segmentDay = day;
+    }
+
+    // 墙钟回拨时钳住，保证文件内时间单调（二分查找的前提）
+    m_segmentStartMs = qMax(startMs, m_lastSegmentTimeMs);
+    m_lastSegmentTimeMs = m_segmentStartMs;
+    m_container = container;
+    m_segmentOpen = true;
+
+    Record record;
+    record.timeMs = m_segmentStartMs;
+    record.aux = m_segmentStartMs;
+    record.type = SegmentStart;
+    record.flags = m_container;
+    return append(m_segmentFile, record);
+}
+
+bool SegmentIndex::addKeyframe(qint64 timeMs, qint64 byteOffset)
+{
+    if (!m_segmentOpen) {
+        return false;
+    }
+
+    m_lastSegmentTimeMs = qMax(timeMs, m_lastSegmentTimeMs);
+
+    Record record;
+    record.timeMs = m_lastSegmentTimeMs;
+    record.value = byteOffset;
+    record.aux = m_segmentStartMs;
+    record.type = Keyframe;
+    record.flags = m_container;
+    return append(m_segmentFile, record);
+}
+
+bool SegmentIndex::endSegment(qint64 endMs, qint64 bytes)
+{
+    if (!m_segmentOpen) {
+        return false;
+    }
+
+    m_lastSegmentTimeMs = qMax(endMs, m_lastSegmentTimeMs);
+    m_segmentOpen = false;
+
+    Record record;
+    record.timeMs = m_lastSegmentTimeMs;
+    record.value = bytes;
+    record.aux = m_segmentStartMs;
+    record.type = SegmentEnd;
+    record.flags = m_container;
+    return append(m_segmentFile, record);
+}
+
+bool SegmentIndex::addEvent(qint64 timeMs, EventKind kind, qint64 value)
+{
+    QMutexLocker locker(&m_eventMutex);
+
+    const QDate day = dayOf(timeMs);
+    if (!m_eventFile.isOpen() || day != m_eventDay) {
+        if (!openForAppend(m_eventFile, eventPath(day), kEventIndexKind, &m_lastEventTimeMs)) {
+            return false;
+        }
+        m_eventDay = day;
+    }
+
+    m_lastEventTimeMs = qMax(timeMs, m_lastEventTimeMs);
+
+    Record record;
+    record.timeMs = m_lastEventTimeMs;
+    record.value = value;
+    record.type = EventMarker;
+    record.flags = kind;
+    return append(m_eventFile, record);
+}
+
+// 从下标 from 开始向后找第一个片段开始（只用于空档时返回“之后的第一个片段”）
+bool SegmentIndex::firstSegmentFrom(const QDate& day, int from, Location* location) const
+{
+    IndexReader reader;
+    if (!reader.open(indexPath(day))) {
+        return false;
+    }
+
+    Record record;
+    for (int i = qMax(0, from); reader.read(i, &record); ++i) {
+        if (record.type == SegmentStart) {
+            location->found = true;
+            location->exact = false;
+            location->segmentStartMs = record.aux;
+            location->keyframeMs = record.aux;
+            location->byteOffset = 0;
+            location->path = segmentPath(record.aux, Container(record.flags));
+            return true;
+        }
+    }
+    return false;
+}
+
+SegmentIndex::Location SegmentIndex::locate(qint64 timeMs) const
+{
+    const QDate day = dayOf(timeMs);
+
+    // 当天索引里没有不晚于 timeMs 的记录时，再看前一天（跨零点的片段记在开始那天）
+    int todayLast = -1;
+    for (int back = 0; back <= 1; ++back) {
+        IndexReader reader;
+        if (!reader.open(indexPath(day.addDays(-back)))) {
+            continue;
+        }
+
+        const int last = reader.upperBound(timeMs) - 1;
+        if (back == 0) {
+            todayLast = last;
+        }
+
+        // 向前找最近的关键帧；先遇到片段结束说明 timeMs 落在空档里。
+        // 扫描长度不超过一个片段内的关键帧数
+        Record record;
+        bool gap = false;
+        for (int i = last; !gap && reader.read(i, &record); --i) {
+            if (record.type == SegmentEnd) {
+                gap = true;
+            } else if (record.type == Keyframe || record.type == SegmentStart) {
+                Location location;
+                location.found = true;
+                location.exact = true;
+                location.segmentStartMs = record.aux;
+                location.keyframeMs = record.timeMs;
+                location.byteOffset = record.type == Keyframe ? record.value : 0;
+                location.path = segmentPath(record.aux, Container(record.flags));
+                return location;
+            }
+        }
+
+        if (last >= 0) {
+            break;
+        }
+    }
+
+    // 处于空档：返回之后的第一个片段（当天或次日）
+    Location next;
+    if (!firstSegmentFrom(day, todayLast + 1, &next)) {
+        firstSegmentFrom(day.addDays(1), 0, &next);
+    }
+    return next;
+}
+
+QVector<SegmentIndex::Record> SegmentIndex::events(qint64 fromMs, qint64 toMs) const
+{
+    QVector<Record> result;
+    if (toMs < fromMs) {
+        return result;
+    }
+
+    const QDate lastDay = dayOf(toMs);
+    for (QDate day = dayOf(fromMs); day <= lastDay; day = day.addDays(1)) {
+        IndexReader reader;
+        if (!reader.open(eventPath(day))) {
+            continue;
+        }
+
+        Record record;
+        for (int i = reader.lowerBound(fromMs); reader.read(i, &record); ++i) {
+            if (record.timeMs > toMs) {
+                break;
+            }
+            result.append(record);
+        }
+    }
+    return result;
+}
+
+QVector<SegmentIndex::Record> SegmentIndex::readAll(const QString& path)
+{
+    QVector<Record> result;
+    IndexReader reader;
+    if (!reader.open(path)) {
+        return result;
+    }
+
+    result.reserve(reader.count());
+    Record record;
+    for (int i = 0; reader.read(i, &record); ++i) {
+        result.append(record);
+    }
+    return result;
+}
@@ -0,0 +1,110 @@
+#ifndef SEGMENTINDEX_H
+#define SEGMENTINDEX_H
+
+#include <QString>
+#include <QDate>
+#include <QFile>
+#include <QMutex>
+#include <QVector>
+
+// 🆕 分段录像索引：每路摄像头每天一个定长记录的二进制文件，按时间追加、天然有序
+//   <root>/cam<N>/<yyyyMMdd>/<hhmmss_zzz>.ts|.mp4     分段文件（文件名由片段开始时间推出）
+//   <root>/cam<N>/index/<yyyyMMdd>.svi                片段开始/关键帧/片段结束
+//   <root>/cam<N>/index/<yyyyMMdd>.sve                事件标记（运动、人脸、手动）
+// 定位某一时刻 = 对当天索引文件做二分查找（O(log n) 次定长读取）+ 打开一个分段文件，
+// 不需要遍历目录或探测 MP4
+// 时间均为墙钟毫秒（UTC epoch），跨零点的片段记录在开始那天的索引里
+class SegmentIndex
+{
+public:
+    enum RecordType {
+        SegmentStart = 1,   // value = 0，aux = 片段开始时间
+        Keyframe = 2,       // value = 关键帧在分段文件中的字节偏移，aux = 片段开始时间
+        SegmentEnd = 3,     // value = 文件字节数，aux = 片段开始时间
+        EventMarker = 4     // value = 事件附加值，aux = 0，flags = EventKind
+    };
+
+    enum EventKind {
+        MotionEvent = 1,
+        FaceEvent = 2,
+        ManualEvent = 3,
+        ClipEnd = 4         // 事件录像结束，value = 时长（毫秒）
+    };
+
+    enum Container {
+        TransportStream = 0,    // .ts
+        FragmentedMp4 = 1       // .mp4（moof 按关键帧切分）
+    };
+
+    // 磁盘上每条记录 32 字节（小端）
+    struct Record {
+        qint64 timeMs = 0;
+        qint64 value = 0;
+        qint64 aux = 0;
+        quint32 type = 0;
+        quint32 flags = 0;      // 片段记录为 Container，事件记录为 EventKind
+    };
+
+    struct Location {
+        bool found = false;
+        bool exact = false;         // false：请求时刻处于录像空档，返回的是其后的第一个片段
+        QString path;               // 分段文件
+        qint64 segmentStartMs = 0;
+        qint64 keyframeMs = 0;      // 不晚于请求时刻的最近关键帧（墙钟）
+        qint64 byteOffset = 0;      // 该关键帧在文件中的偏移（fMP4 为所在分片 moof 的偏移）
+        qint64 ptsMs() const { return keyframeMs - segmentStartMs; }
+    };
+
+    static const int kHeaderSize = 16;
+    static const int kRecordSize = 32;
+
+    SegmentIndex(const QString& rootDir, int sourceId);
+    ~SegmentIndex();
+
+    int sourceId() const { return m_sourceId; }
+    QString cameraDirectory() const;
+    QString segmentPath(qint64 startMs, Container container) const;
+    QString indexPath(const QDate& day) const;
+    QString eventPath(const QDate& day) const;
+
+    // 写入：片段记录只由一个线程（编码线程）写，事件可在任意线程写
+    // 墙钟回拨时片段开始时间会被钳到上一条记录之后，分段文件名以 segmentStartMs() 为准
+    bool beginSegment(qint64 startMs, Container container);
+    qint64 segmentStartMs() const { return m_segmentStartMs; }
+    bool addKeyframe(qint64 timeMs, qint64 byteOffset);
+    bool endSegment(qint64 endMs, qint64 bytes);
+    bool addEvent(qint64 timeMs, EventKind kind, qint64 value = 0);
+
+    // 查询：任意线程，只读打开索引文件
+    Location locate(qint64 timeMs) const;
+    QVector<Record> events(qint64 fromMs, qint64 toMs) const;
+
+    // 读取整个索引文件（校验文件头，截掉写到一半的尾部记录）
+    static QVector<Record> readAll(const QString& path);
+
+private:
+    Q_DISABLE_COPY(SegmentIndex)
+
+    bool openForAppend(QFile& file, const QString& path, quint32 kind, qint64* lastTimeMs);
+    bool append(QFile& file, const Record& record);
+    bool firstSegmentFrom(const QDate& day, int from, Location* location) const;
+
+    const QString m_rootDir;
+    const int m_sourceId;
+
+    // 片段索引（编码线程）
+    QFile m_segmentFile;
+    QDate m_segmentDay;
+    qint64 m_segmentStartMs = 0;
+    quint32 m_container = TransportStream;
+    qint64 m_lastSegmentTimeMs = 0;
+    bool m_segmentOpen = false;
+
+    // 事件索引
+    QMutex m_eventMutex;
+    QFile m_eventFile;
+    QDate m_eventDay;
+    qint64 m_lastEventTimeMs = 0;
+};
+
+#endif // SEGMENTINDEX_H
@@ -0,0 +1,332 @@
+#include "storagemanager.h"
+#include "segmentindex.h"
+#include "../core/MetricsRegistry.h"
+#include "../core/FrameMeta.h"
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSet>
+#include <QStorageInfo>
+#include <QDebug>
+#include <algorithm>
+#include <numeric>
+
+StorageManager::StorageManager(const QString& recordRoot, QObject* parent)
+    : QThread(parent)
+    , m_recordRoot(recordRoot)
+    , m_recordBytesGauge(MetricsRegistry::instance().gauge("storage.used_bytes"))
+    , m_accountedBytesGauge(MetricsRegistry::instance().gauge("storage.faces.used_bytes"))
+    , m_freeBytesGauge(MetricsRegistry::instance().gauge("storage.free_bytes"))
+    , m_writeRateGauge(MetricsRegistry::instance().gauge("storage.write_bytes_per_sec"))
+    , m_deletedSegments(MetricsRegistry::instance().counter("storage.segments.deleted"))
+    , m_deletedBytes(MetricsRegistry::instance().counter("storage.bytes.deleted"))
+    , m_scanMs(MetricsRegistry::instance().histogram("storage.scan_ms"))
+{
+    setObjectName("sv-storage");
+}
+
+StorageManager::~StorageManager()
+{
+    shutdown();
+}
+
+void StorageManager::setOptions(const Options& options)
+{
+    QMutexLocker locker(&m_mutex);
+    m_options = options;
+    m_options.scanIntervalMs = qMax(100, options.scanIntervalMs);
+}
+
+StorageManager::Options StorageManager::options() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_options;
+}
+
+void StorageManager::setCameraQuota(int sourceId, qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cameraQuotas.insert(sourceId, bytes);
+}
+
+void StorageManager::addAccountedDirectory(const QString& dir)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_accountedDirs.contains(dir)) {
+        m_accountedDirs.append(dir);
+    }
+}
+
+void StorageManager::requestScan()
+{
+    QMutexLocker locker(&m_mutex);
+    m_scanRequested = true;
+    m_wake.wakeOne();
+}
+
+void StorageManager::shutdown()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    wait();
+}
+
+StorageManager::Usage StorageManager::lastUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastUsage;
+}
+
+void StorageManager::run()
+{
+    while (true) {
+        enforceNow();
+
+        QMutexLocker locker(&m_mutex);
+        if (!m_stopping && !m_scanRequested) {
+            m_wake.wait(&m_mutex, m_options.scanIntervalMs);
+        }
+        if (m_stopping) {
+            break;
+        }
+        m_scanRequested = false;
+    }
+}
+
+qint64 StorageManager::directorySize(const QString& dir)
+{
+    qint64 bytes = 0;
+    QDirIterator it(dir, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        bytes += it.fileInfo().size();
+    }
+    return bytes;
+}
+
+// 按 摄像头 → 日期目录 → 文件名 的顺序列出分段，每路内部即按开始时间升序
+QVector<StorageManager::SegmentEntry> StorageManager::scanSegments() const
+{
+    QVector<SegmentEntry> segments;
+
+    const QDir root(m_recordRoot);
+    const QStringList cameras = root.entryList(QStringList() << "cam*", QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    for (const QString& camera : cameras) {
+        bool ok = false;
+        const int sourceId = camera.mid(3).toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+
+        const int firstOfCamera = segments.size();
+        const QDir cameraDir(root.filePath(camera));
+        const QStringList days = cameraDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+        for (const QString& day : days) {
+            const QDate date = QDate::fromString(day, "yyyyMMdd");
+            if (!date.isValid()) {
+                continue;   // index 目录
+            }
+
+            const QFileInfoList files = QDir(cameraDir.filePath(day))
+                .entryInfoList(QStringList() << "*.ts" << "*.mp4", QDir::Files, QDir::Name);
+            for (const QFileInfo& file : files) {
+                const QTime time = QTime::fromString(file.completeBaseName(), "hhmmss_zzz");
+                SegmentEntry entry;
+                entry.path = file.absoluteFilePath();
+                entry.sourceId = sourceId;
+                entry.startMs = time.isValid() ? QDateTime(date, time).toMSecsSinceEpoch()
+                                               : file.lastModified().toMSecsSinceEpoch();
+                entry.bytes = file.size();
+                segments.append(entry);
+            }
+        }
+
+        if (segments.size() > firstOfCamera) {
+            segments.last().protectedEntry = true;
+        }
+    }
+    return segments;
+}
+
+bool StorageManager::removeSegment(const SegmentEntry& entry)
+{
+    if (!QFile::remove(entry.path)) {
+        qWarning() << "StorageManager: Failed to delete" << entry.path;
+        return false;
+    }
+    return true;
+}
+
+// 某天的分段全部删除后，当天的分段索引与事件索引也不再有意义
+void StorageManager::removeEmptyDay(const SegmentEntry& entry)
+{
+    QDir dayDir = QFileInfo(entry.path).absoluteDir();
+    if (!dayDir.entryList(QDir::AllEntries | QDir::NoDotAndDotDot).isEmpty()) {
+        return;
+    }
+
+    const QDate date = QDate::fromString(dayDir.dirName(), "yyyyMMdd");
+    const QString dayPath = dayDir.absolutePath();
+    if (!dayDir.rmdir(dayPath)) {
+        qWarning() << "StorageManager: Failed to remove" << dayPath;
+        return;
+    }
+
+    const SegmentIndex index(m_recordRoot, entry.sourceId);
+    QFile::remove(index.indexPath(date));
+    QFile::remove(index.eventPath(date));
+}
+
+StorageManager::Usage StorageManager::enforceNow()
+{
+    QMutexLocker enforceLocker(&m_enforceMutex);
+    const qint64 startNs = frameClockNs();
+
+    Options options;
+    QHash<int, qint64> quotas;
+    QStringList accountedDirs;
+    {
+        QMutexLocker locker(&m_mutex);
+        options = m_options;
+        quotas = m_cameraQuotas;
+        accountedDirs = m_accountedDirs;
+    }
+
+    Usage usage;
+    for (const QString& dir : accountedDirs) {
+        usage.accountedBytes += directorySize(dir);
+    }
+
+    QStorageInfo storage(m_recordRoot);
+    storage.refresh();
+    if (storage.isValid() && storage.isReady()) {
+        usage.freeBytes = storage.bytesAvailable();
+        usage.totalBytes = storage.bytesTotal();
+    }
+
+    const QVector<SegmentEntry> segments = scanSegments();
+    QHash<int, qint64> usedBytes;
+    for (const SegmentEntry& entry : segments) {
+        usedBytes[entry.sourceId] += entry.bytes;
+        usage.recordBytes += entry.bytes;
+    }
+
+    QVector<bool> deleted(segments.size(), false);
+    QHash<int, int> deletedCount;
+    QHash<int, qint64> deletedBytes;
+    auto remove = [&](int i) {
+        const SegmentEntry& entry = segments[i];
+        if (entry.protectedEntry || deleted[i] || !removeSegment(entry)) {
+            return;
+        }
+        deleted[i] = true;
+        usedBytes[entry.sourceId] -= entry.bytes;
+        usage.recordBytes -= entry.bytes;
+        if (usage.freeBytes >= 0) {
+            usage.freeBytes += entry.bytes;
+        }
+        deletedCount[entry.sourceId]++;
+        deletedBytes[entry.sourceId] += entry.bytes;
+        usage.deletedSegments++;
+        usage.deletedBytes += entry.bytes;
+    };
+
+    // 1. 每路配额：各路内部已按时间升序，从最旧的开始删到配额以内
+    for (int i = 0; i < segments.size(); ++i) {
+        const int sourceId = segments[i].sourceId;
+        const qint64 quota = quotas.value(sourceId, options.cameraQuotaBytes);
+        if (quota > 0 && usedBytes.value(sourceId) > quota) {
+            remove(i);
+        }
+    }
+
+    // 2. 总配额与剩余空间：所有路合在一起按开始时间，从全局最旧的开始删
+    auto overGlobal = [&]() {
+        return (options.globalQuotaBytes > 0 && usage.recordBytes + usage.accountedBytes > options.globalQuotaBytes)
+            || (options.minFreeBytes > 0 && usage.freeBytes >= 0 && usage.freeBytes < options.minFreeBytes);
+    };
+    if (overGlobal()) {
+        QVector<int> order(segments.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&segments](int a, int b) {
+            return segments[a].startMs < segments[b].startMs;
+        });
+        for (int i : order) {
+            if (!overGlobal()) {
+                break;
+            }
+            remove(i);
+        }
+        if (overGlobal()) {
+            qWarning() << "StorageManager: Still over quota after deleting all closed segments, records:"
+                       << usage.recordBytes << "accounted:" << usage.accountedBytes << "free:" << usage.freeBytes;
+        }
+    }
+
+    // 清理删空的日期目录，并汇总每路剩余的用量
+    QSet<QString> visitedDays;
+    QHash<int, int> cameraIndex;
+    for (int i = 0; i < segments.size(); ++i) {
+        const SegmentEntry& entry = segments[i];
+        if (deleted[i]) {
+            const QString dayPath = QFileInfo(entry.path).absolutePath();
+            if (!visitedDays.contains(dayPath)) {
+                visitedDays.insert(dayPath);
+                removeEmptyDay(entry);
+            }
+            continue;
+        }
+
+        if (!cameraIndex.contains(entry.sourceId)) {
+            cameraIndex.insert(entry.sourceId, usage.cameras.size());
+            CameraUsage camera;
+            camera.sourceId = entry.sourceId;
+            camera.oldestMs = entry.startMs;
+            usage.cameras.append(camera);
+        }
+        CameraUsage& camera = usage.cameras[cameraIndex.value(entry.sourceId)];
+        camera.usedBytes += entry.bytes;
+        camera.segments++;
+    }
+
+    // 写入速率：各路 RecordingSink 累计写入字节的差分
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    qint64 writtenBytes = 0;
+    for (auto it = usedBytes.constBegin(); it != usedBytes.constEnd(); ++it) {
+        writtenBytes += qint64(registry.counter("storage.bytes.written", it.key())->value());
+        registry.gauge("storage.used_bytes", it.key())->set(double(it.value()));
+    }
+    if (m_lastWrittenBytes >= 0 && startNs > m_lastScanNs && writtenBytes >= m_lastWrittenBytes) {
+        usage.writeBytesPerSec = (writtenBytes - m_lastWrittenBytes) * 1e9 / (startNs - m_lastScanNs);
+    }
+    m_lastWrittenBytes = writtenBytes;
+    m_lastScanNs = startNs;
+
+    m_recordBytesGauge->set(double(usage.recordBytes));
+    m_accountedBytesGauge->set(double(usage.accountedBytes));
+    m_freeBytesGauge->set(double(usage.freeBytes));
+    m_writeRateGauge->set(usage.writeBytesPerSec);
+    m_deletedSegments->add(quint64(usage.deletedSegments));
+    m_deletedBytes->add(quint64(usage.deletedBytes));
+    m_scanMs->record((frameClockNs() - startNs) / 1e6);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_lastUsage = usage;
+    }
+
+    for (auto it = deletedCount.constBegin(); it != deletedCount.constEnd(); ++it) {
+        const int index = cameraIndex.value(it.key(), -1);
+        const qint64 retainedFromMs = index >= 0 ? usage.cameras[index].oldestMs : 0;
+        qDebug() << "StorageManager: Deleted" << it.value() << "segments of cam" << it.key()
+                 << QString("(%1 MB)").arg(deletedBytes.value(it.key()) / (1024.0 * 1024.0), 0, 'f', 1)
+                 << "retained from" << QDateTime::fromMSecsSinceEpoch(retainedFromMs).toString(Qt::ISODate);
+        emit segmentsDeleted(it.key(), it.value(), deletedBytes.value(it.key()), retainedFromMs);
+    }
+
+    return usage;
+}
@@ -0,0 +1,113 @@
+#ifndef STORAGEMANAGER_H
+#define STORAGEMANAGER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+class MetricCounter;
+class MetricGauge;
+class MetricHistogram;
+
+// 🆕 存储配额管理：后台线程定期扫描录像目录，按配额循环覆盖（从最旧的分段开始删除）
+// - 每路摄像头配额、录像 + 人脸图片的总配额、磁盘最少剩余空间，三者任一超出即删除
+// - 分段文件名由开始时间决定（见 SegmentIndex），按 日期目录/文件名 排序即时间顺序，不需要打开文件
+// - 每路最新的分段可能正在写入，从不删除；某天的分段删空后连同当天的索引文件一起删除
+// - 人脸注册图片等目录只计入用量、从不删除（删掉会让数据库记录失去原图）
+// 指标：storage.used_bytes（按来源；总计为全部录像）/ storage.faces.used_bytes / storage.free_bytes /
+// storage.write_bytes_per_sec / storage.segments.deleted / storage.bytes.deleted / storage.scan_ms
+class StorageManager : public QThread
+{
+    Q_OBJECT
+
+public:
+    struct Options {
+        qint64 cameraQuotaBytes = 0;            // 每路默认配额，0 为不限
+        qint64 globalQuotaBytes = 0;            // 录像与计入目录的总配额，0 为不限
+        qint64 minFreeBytes = 512LL << 20;      // 磁盘至少保留的剩余空间，0 为不检查
+        int scanIntervalMs = 10000;
+    };
+
+    struct CameraUsage {
+        int sourceId = 0;
+        qint64 usedBytes = 0;
+        int segments = 0;
+        qint64 oldestMs = 0;                    // 最旧分段的开始时间（墙钟毫秒），无分段为 0
+    };
+
+    struct Usage {
+        QVector<CameraUsage> cameras;
+        qint64 recordBytes = 0;                 // 全部录像分段
+        qint64 accountedBytes = 0;              // 只计入、不删除的目录
+        qint64 freeBytes = -1;                  // 录像所在文件系统的剩余空间，未知为 -1
+        qint64 totalBytes = -1;
+        double writeBytesPerSec = 0.0;          // 两次扫描之间的录像写入速率
+        int deletedSegments = 0;                // 本次扫描删除的分段
+        qint64 deletedBytes = 0;
+    };
+
+    explicit StorageManager(const QString& recordRoot, QObject* parent = nullptr);
+    ~StorageManager() override;
+
+    void setOptions(const Options& options);
+    Options options() const;
+    void setCameraQuota(int sourceId, qint64 bytes);    // 覆盖某一路的默认配额
+    void addAccountedDirectory(const QString& dir);
+
+    // 扫描一次并执行配额（在调用线程同步执行；后台线程也调用它）
+    Usage enforceNow();
+    // 唤醒后台线程立即扫描（例如写入失败后），不阻塞
+    void requestScan();
+    void shutdown();
+
+    Usage lastUsage() const;
+
+signals:
+    // 在执行扫描的线程发出；retainedFromMs 为该路剩余最旧分段的开始时间
+    void segmentsDeleted(int sourceId, int count, qint64 bytes, qint64 retainedFromMs);
+
+protected:
+    void run() override;
+
+private:
+    struct SegmentEntry {
+        QString path;
+        int sourceId = 0;
+        qint64 startMs = 0;
+        qint64 bytes = 0;
+        bool protectedEntry = false;            // 该路最新的分段（可能正在写入）
+    };
+
+    QVector<SegmentEntry> scanSegments() const;
+    static qint64 directorySize(const QString& dir);
+    bool removeSegment(const SegmentEntry& entry);
+    void removeEmptyDay(const SegmentEntry& entry);
+
+    const QString m_recordRoot;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    Options m_options;
+    QHash<int, qint64> m_cameraQuotas;
+    QStringList m_accountedDirs;
+    Usage m_lastUsage;
+    bool m_scanRequested = false;
+    bool m_stopping = false;
+
+    QMutex m_enforceMutex;                      // 后台扫描与 enforceNow 串行
+    qint64 m_lastWrittenBytes = -1;
+    qint64 m_lastScanNs = 0;
+
+    MetricGauge* m_recordBytesGauge;
+    MetricGauge* m_accountedBytesGauge;
+    MetricGauge* m_freeBytesGauge;
+    MetricGauge* m_writeRateGauge;
+    MetricCounter* m_deletedSegments;
+    MetricCounter* m_deletedBytes;
+    MetricHistogram* m_scanMs;
+};
+
+#endif // STORAGEMANAGER_H
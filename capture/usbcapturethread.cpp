@@ -1,4 +1,6 @@
 #include "usbcapturethread.h"
+#include "../core/TraceRecorder.h"
+#include "../core/FlightRecorder.h"
 #include <opencv2/opencv.hpp>
 
 #include<QDebug>
@@ -24,41 +26,63 @@ void USBCaptureThread::setThreadStart(bool start)
     m_start = start;
 }
 
+void USBCaptureThread::setSourceId(int sourceId)
+{
+    m_sourceId = sourceId;
+}
+
 void USBCaptureThread::run()
 {
     cv::VideoCapture cap(m_device.toStdString());
     if (!cap.isOpened()) {
         qDebug() << "Failed to open USB camera:" << m_device;
+        FlightRecorder::instance().recordEvent(FlightRecorder::StreamLost, m_sourceId, 0, "usb_open_failed");
         return;
     }
+    FlightRecorder::instance().recordEvent(FlightRecorder::StreamOpened, m_sourceId, 0, "usb");
 
     cap.set(cv::CAP_PROP_FRAME_WIDTH, 1280);
     cap.set(cv::CAP_PROP_FRAME_HEIGHT, 720);
 
     while (m_start) {
         cv::Mat frame;
-        if (!cap.read(frame)) {
+        bool frameRead;
+        {
+            SV_TRACE_SCOPE("capture", "read");
+            frameRead = cap.read(frame);
+        }
+        if (!frameRead) {
             qDebug() << "Failed to read frame from USB camera";
+            FlightRecorder::instance().recordEvent(FlightRecorder::StreamLost, m_sourceId, 0, "usb_read");
             break;
         }
+        FlightRecorder::instance().heartbeat(m_sourceId);
 
         if (!frame.empty()) {
-            cv::Mat rgbFrame;
-            cv::cvtColor(frame, rgbFrame, cv::COLOR_BGR2RGB);
+            FrameMeta meta = FrameMeta::begin(m_sourceId, ++m_sequence);
+            QImage copy;
+            {
+                SV_TRACE_SCOPE_ARG("capture", "convert", meta.sequence);
+                cv::Mat rgbFrame;
+                cv::cvtColor(frame, rgbFrame, cv::COLOR_BGR2RGB);
 
-            QImage image(
-                rgbFrame.data,
-                rgbFrame.cols,
-                rgbFrame.rows,
-                rgbFrame.step,
-                QImage::Format_RGB888
-                );
-            emit resultReady(image.copy());
+                QImage image(
+                    rgbFrame.data,
+                    rgbFrame.cols,
+                    rgbFrame.rows,
+                    rgbFrame.step,
+                    QImage::Format_RGB888
+                    );
+                copy = image.copy();
+            }
+            meta.stamp(FrameMeta::Decode);
+            emit resultReady(copy, meta);
 
         }
 
         QThread::msleep(30); // 控制帧率
     }
 
+    FlightRecorder::instance().endHeartbeat(m_sourceId);
     cap.release();
 }
@@ -3,6 +3,7 @@
 
 #include <QThread>
 #include <QImage>
+#include "../core/FrameMeta.h"
 
 class USBCaptureThread : public QThread
 {
@@ -14,9 +15,10 @@ public:
 
     void setDevice(const QString &device);
     void setThreadStart(bool start);
+    void setSourceId(int sourceId);
 
 signals:
-    void resultReady(const QImage &image);
+    void resultReady(const QImage &image, const FrameMeta &meta);
 
 protected:
     void run() override;
@@ -24,6 +26,8 @@ protected:
 private:
     QString m_device;
     bool m_start = false;
+    int m_sourceId = FrameSource::Usb;
+    quint64 m_sequence = 0;     // 🆕 来源内帧序号
 };
 
 #endif // USBCAPTURETHREAD_H
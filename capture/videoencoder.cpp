@@ -0,0 +1,78 @@
+#include "videoencoder.h"
+#include "ffmpegvideoencoder.h"
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace {
+
+QMutex& registryMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+VideoEncoderRegistry::Factory ffmpegFactory(const QString& codecName)
+{
+    return [codecName] { return static_cast<VideoEncoder*>(new FfmpegVideoEncoder(codecName)); };
+}
+
+// 内置编码器在首次访问时注册（静态库中的全局注册对象可能被链接器丢弃）
+QMap<QString, VideoEncoderRegistry::Factory>& registry()
+{
+    static QMap<QString, VideoEncoderRegistry::Factory> factories = [] {
+        QMap<QString, VideoEncoderRegistry::Factory> builtins;
+        builtins.insert("rkmpp", ffmpegFactory("h264_rkmpp"));
+        builtins.insert("x264", ffmpegFactory("libx264"));
+        builtins.insert("x265", ffmpegFactory("libx265"));
+        builtins.insert("mpeg4", ffmpegFactory("mpeg4"));
+        return builtins;
+    }();
+    return factories;
+}
+
+// "auto" 的选择顺序：硬件编码优先，其次软件 H.264/H.265，最后是 FFmpeg 内置的 MPEG-4
+const char* const kAutoOrder[][2] = {
+    {"rkmpp", "h264_rkmpp"},
+    {"x264", "libx264"},
+    {"x265", "libx265"},
+    {"mpeg4", "mpeg4"},
+};
+
+} // namespace
+
+void VideoEncoderRegistry::registerEncoder(const QString& name, const Factory& factory)
+{
+    QMutexLocker locker(&registryMutex());
+    registry().insert(name.toLower(), factory);
+}
+
+QStringList VideoEncoderRegistry::availableEncoders()
+{
+    QMutexLocker locker(&registryMutex());
+    return registry().keys();
+}
+
+VideoEncoder* VideoEncoderRegistry::create(const QString& name)
+{
+    QString key = name.toLower();
+    if (key.isEmpty() || key == "auto") {
+        key.clear();
+        for (const auto& entry : kAutoOrder) {
+            if (FfmpegVideoEncoder::isAvailable(entry[1])) {
+                key = entry[0];
+                break;
+            }
+        }
+        if (key.isEmpty()) {
+            return nullptr;
+        }
+    }
+
+    QMutexLocker locker(&registryMutex());
+    auto it = registry().constFind(key);
+    if (it == registry().constEnd()) {
+        return nullptr;
+    }
+    return it.value()();
+}
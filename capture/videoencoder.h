@@ -0,0 +1,64 @@
+#ifndef VIDEOENCODER_H
+#define VIDEOENCODER_H
+
+#include <QString>
+#include <QStringList>
+#include <QSize>
+#include <QImage>
+#include <QVector>
+#include <functional>
+
+// 🆕 录像编码参数
+struct VideoEncoderConfig {
+    QSize size;                 // 输出分辨率（宽高向下取偶数）
+    int fps = 15;               // 标称帧率（时间戳按实际采集时间，帧率只影响码控与 GOP）
+    int bitrateKbps = 2000;
+    int gopSeconds = 2;         // 关键帧间隔
+    bool fragmented = false;    // 🆕 MP4 容器写成分片 MP4（moof 按关键帧切分，中途断电已写部分仍可播放）
+    qint64 preallocateBytes = 0;    // 🆕 打开文件时预留的磁盘空间（见 SegmentFile），0 为不预留
+    qint64 syncBytes = 0;           // 🆕 每写入多少字节发起一次回写，0 为只在关闭时同步
+};
+
+// 🆕 已写入文件的关键帧：片段内时间戳与在文件中的字节偏移（分段索引用）
+struct VideoKeyframe {
+    qint64 ptsMs = 0;
+    qint64 byteOffset = 0;
+};
+
+// 🆕 录像编码器接口：编码并封装到文件（容器由扩展名决定：.ts 为 MPEG-TS，默认 MP4）
+// 只在 RecordingSink 的编码线程中使用，实现不要求线程安全
+class VideoEncoder
+{
+public:
+    virtual ~VideoEncoder() {}
+
+    virtual QString name() const = 0;
+
+    virtual bool open(const QString& path, const VideoEncoderConfig& config) = 0;
+    // frame 为任意格式 QImage，ptsMs 为相对片段起点的毫秒数（必须递增）
+    virtual bool encode(const QImage& frame, qint64 ptsMs) = 0;
+    // 冲刷编码器缓存、写文件尾并关闭；未打开时直接返回 true
+    virtual bool close() = 0;
+
+    // 已写入文件的字节数（含容器开销），即分段索引中的文件大小
+    virtual qint64 bytesWritten() const = 0;
+    virtual QString lastError() const = 0;
+
+    // 🆕 取走上次调用以来写入文件的关键帧；不支持的实现返回空
+    virtual QVector<VideoKeyframe> takeKeyframes() { return QVector<VideoKeyframe>(); }
+};
+
+// 🆕 编码器注册表：按名称创建（"auto" 按 硬件 → x264 → x265 → mpeg4 顺序取第一个可用的）
+class VideoEncoderRegistry
+{
+public:
+    typedef std::function<VideoEncoder*()> Factory;
+
+    static void registerEncoder(const QString& name, const Factory& factory);
+    static QStringList availableEncoders();
+
+    // 未知名称返回 nullptr；"auto" 返回当前 FFmpeg 构建中第一个可用的编码器
+    static VideoEncoder* create(const QString& name);
+};
+
+#endif // VIDEOENCODER_H
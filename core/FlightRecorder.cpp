@@ -0,0 +1,378 @@
+#include "FlightRecorder.h"
+#include "MetricsRegistry.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+#include <QDebug>
+#include <csignal>
+#include <cstdio>
+
+namespace {
+
+// SIGUSR1 处理函数只置位，由看门狗线程落盘
+std::atomic<bool> g_signalDumpRequested{false};
+
+void onDumpSignal(int) {
+    g_signalDumpRequested.store(true);
+}
+
+const char* eventName(quint8 kind) {
+    switch (kind) {
+    case FlightRecorder::StreamOpened: return "stream_opened";
+    case FlightRecorder::StreamLost: return "stream_lost";
+    case FlightRecorder::FrameDrop: return "frame_drop";
+    case FlightRecorder::DbWrite: return "db_write";
+    case FlightRecorder::CaptureStall: return "capture_stall";
+    case FlightRecorder::SloViolation: return "slo_violation";
+    case FlightRecorder::Note: return "note";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+// ========== Watchdog ==========
+class FlightRecorder::Watchdog : public QThread {
+public:
+    static const int kTickMs = 200;
+    static const int kQueueSampleMs = 1000;
+
+    explicit Watchdog(FlightRecorder* owner) : m_owner(owner) {
+        setObjectName("sv-flightrec");
+    }
+
+    void requestStop() {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+
+protected:
+    void run() override {
+        qint64 nextQueueSampleNs = 0;
+
+        QMutexLocker locker(&m_mutex);
+        while (!m_stopping) {
+            locker.unlock();
+
+            const qint64 nowNs = frameClockNs();
+            if (g_signalDumpRequested.exchange(false)) {
+                m_owner->dumpNow("signal");
+            }
+
+            m_owner->checkStalls(nowNs);
+
+            if (nowNs >= nextQueueSampleNs) {
+                m_owner->sampleQueues();
+                nextQueueSampleNs = nowNs + qint64(kQueueSampleMs) * 1000000;
+            }
+
+            const char* pending = m_owner->m_pendingReason.load();
+            if (pending && nowNs >= m_owner->m_pendingDueNs.load()) {
+                m_owner->m_pendingReason.store(nullptr);
+                m_owner->dumpNow(pending);
+            }
+
+            locker.relock();
+            if (!m_stopping) {
+                m_wake.wait(&m_mutex, kTickMs);
+            }
+        }
+    }
+
+private:
+    FlightRecorder* m_owner;
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    bool m_stopping = false;
+};
+
+// ========== FlightRecorder ==========
+FlightRecorder& FlightRecorder::instance() {
+    static FlightRecorder recorder;
+    return recorder;
+}
+
+FlightRecorder::FlightRecorder() {
+    for (int stage = 0; stage < FrameMeta::StageCount; ++stage) {
+        m_sloUs[stage].store(0, std::memory_order_relaxed);
+    }
+    // 默认 SLO：采集到显示 300ms，采集到 AI 结果 1000ms
+    m_sloUs[FrameMeta::Display].store(300000, std::memory_order_relaxed);
+    m_sloUs[FrameMeta::AIDone].store(1000000, std::memory_order_relaxed);
+
+    for (int source = 0; source < kMaxSources; ++source) {
+        m_heartbeatNs[source].store(0, std::memory_order_relaxed);
+        m_stalled[source] = false;
+    }
+}
+
+FlightRecorder::~FlightRecorder() {
+    stop();
+}
+
+void FlightRecorder::start(const QString& dumpDir) {
+    QMutexLocker controlLocker(&m_controlMutex);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_dumpDir = dumpDir.isEmpty() ? QCoreApplication::applicationDirPath() + "/data/flight" : dumpDir;
+    }
+    if (m_watchdog) {
+        return;
+    }
+
+    struct sigaction action = {};
+    action.sa_handler = onDumpSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+
+    m_watchdog = new Watchdog(this);
+    m_watchdog->start(QThread::LowPriority);
+    qDebug() << "FlightRecorder: started, capacity" << kCapacity << "records";
+}
+
+void FlightRecorder::stop() {
+    QMutexLocker locker(&m_controlMutex);
+    if (!m_watchdog) {
+        return;
+    }
+
+    m_watchdog->requestStop();
+    m_watchdog->wait();
+    delete m_watchdog;
+    m_watchdog = nullptr;
+    signal(SIGUSR1, SIG_DFL);
+}
+
+void FlightRecorder::append(const Record& record) {
+    QMutexLocker locker(&m_mutex);
+    m_records[m_written % kCapacity] = record;
+    ++m_written;
+}
+
+void FlightRecorder::recordFrame(const FrameMeta& meta) {
+    if (!meta.isTraced()) {
+        return;
+    }
+
+    Record record;
+    record.timeNs = frameClockNs();
+    record.type = FrameTiming;
+    record.sourceId = static_cast<qint16>(meta.sourceId);
+    record.sequence = meta.sequence;
+    record.stageUs[FrameMeta::Capture] = 0;
+    for (int stage = FrameMeta::Capture + 1; stage < FrameMeta::StageCount; ++stage) {
+        const FrameMeta::Stage s = static_cast<FrameMeta::Stage>(stage);
+        record.stageUs[stage] = meta.hasStage(s) ? static_cast<qint32>(meta.sinceCaptureMs(s) * 1000.0) : -1;
+    }
+    append(record);
+
+    // SLO 检查：只在本条记录已走到的阶段上比较
+    for (int stage = FrameMeta::Capture + 1; stage < FrameMeta::StageCount; ++stage) {
+        const qint64 sloUs = m_sloUs[stage].load(std::memory_order_relaxed);
+        if (sloUs > 0 && record.stageUs[stage] > sloUs) {
+            if (requestDump("slo")) {
+                recordEvent(SloViolation, meta.sourceId, record.stageUs[stage],
+                            FrameMeta::stageName(static_cast<FrameMeta::Stage>(stage)));
+            }
+            break;
+        }
+    }
+}
+
+void FlightRecorder::recordQueueDepth(const char* name, int sourceId, qint64 depth) {
+    Record record;
+    record.timeNs = frameClockNs();
+    record.type = QueueDepth;
+    record.sourceId = static_cast<qint16>(sourceId);
+    record.name = name;
+    record.value = depth;
+    append(record);
+}
+
+void FlightRecorder::recordEvent(EventKind kind, int sourceId, qint64 value, const char* detail) {
+    Record record;
+    record.timeNs = frameClockNs();
+    record.type = Event;
+    record.kind = kind;
+    record.sourceId = static_cast<qint16>(sourceId);
+    record.name = detail;
+    record.value = value;
+    append(record);
+}
+
+void FlightRecorder::heartbeat(int sourceId) {
+    if (sourceId >= 0 && sourceId < kMaxSources) {
+        m_heartbeatNs[sourceId].store(frameClockNs(), std::memory_order_relaxed);
+    }
+}
+
+void FlightRecorder::endHeartbeat(int sourceId) {
+    if (sourceId >= 0 && sourceId < kMaxSources) {
+        m_heartbeatNs[sourceId].store(0, std::memory_order_relaxed);
+    }
+}
+
+void FlightRecorder::setLatencySlo(FrameMeta::Stage stage, double ms) {
+    if (stage > FrameMeta::Capture && stage < FrameMeta::StageCount) {
+        m_sloUs[stage].store(ms > 0.0 ? static_cast<qint64>(ms * 1000.0) : 0, std::memory_order_relaxed);
+    }
+}
+
+void FlightRecorder::setStallThresholdMs(int ms) {
+    m_stallMs.store(qMax(100, ms), std::memory_order_relaxed);
+}
+
+void FlightRecorder::setAutoDumpCooldownMs(int ms) {
+    m_cooldownMs.store(qMax(0, ms), std::memory_order_relaxed);
+}
+
+void FlightRecorder::checkStalls(qint64 nowNs) {
+    const qint64 stallNs = qint64(m_stallMs.load(std::memory_order_relaxed)) * 1000000;
+    for (int source = 0; source < kMaxSources; ++source) {
+        const qint64 lastNs = m_heartbeatNs[source].load(std::memory_order_relaxed);
+        if (lastNs == 0 || nowNs - lastNs <= stallNs) {
+            m_stalled[source] = false;
+            continue;
+        }
+        if (!m_stalled[source]) {
+            // 每次卡顿只记一次，心跳恢复后重新布防
+            m_stalled[source] = true;
+            recordEvent(CaptureStall, source, (nowNs - lastNs) / 1000000);
+            requestDump("stall");
+            qDebug() << "FlightRecorder: capture source" << source << "stalled for"
+                     << (nowNs - lastNs) / 1000000 << "ms";
+        }
+    }
+}
+
+void FlightRecorder::sampleQueues() {
+    static MetricGauge* aiQueueDepth = MetricsRegistry::instance().gauge("ai.queue.depth");
+    static MetricGauge* batchPending = MetricsRegistry::instance().gauge("ai.batch.pending_frames");
+    static MetricGauge* recordQueue = MetricsRegistry::instance().gauge("record.queue.depth", FrameSource::Mipi);
+
+    recordQueueDepth("ai.queue.depth", -1, static_cast<qint64>(aiQueueDepth->value()));
+    recordQueueDepth("ai.batch.pending_frames", -1, static_cast<qint64>(batchPending->value()));
+    recordQueueDepth("record.queue.depth", FrameSource::Mipi, static_cast<qint64>(recordQueue->value()));
+}
+
+bool FlightRecorder::requestDump(const char* reason) {
+    const qint64 nowNs = frameClockNs();
+    const qint64 lastNs = m_lastAutoDumpNs.load();
+    if (lastNs > 0 && nowNs - lastNs < qint64(m_cooldownMs.load(std::memory_order_relaxed)) * 1000000) {
+        return false;
+    }
+
+    if (m_pendingReason.load()) {
+        return false;
+    }
+    const char* expected = nullptr;
+    m_pendingDueNs.store(nowNs + qint64(kPostTriggerMs) * 1000000);
+    if (!m_pendingReason.compare_exchange_strong(expected, reason)) {
+        return false;
+    }
+    m_lastAutoDumpNs.store(nowNs);
+    return true;
+}
+
+QVector<FlightRecorder::Record> FlightRecorder::snapshot() const {
+    QMutexLocker locker(&m_mutex);
+    const quint64 count = qMin<quint64>(m_written, kCapacity);
+    QVector<Record> records;
+    records.reserve(static_cast<int>(count));
+    for (quint64 i = m_written - count; i < m_written; ++i) {
+        records.append(m_records[i % kCapacity]);
+    }
+    return records;
+}
+
+quint64 FlightRecorder::totalRecorded() const {
+    QMutexLocker locker(&m_mutex);
+    return m_written;
+}
+
+QString FlightRecorder::dumpNow(const QString& reason) {
+    const QVector<Record> records = snapshot();
+    QString dir;
+    {
+        QMutexLocker locker(&m_mutex);
+        dir = m_dumpDir.isEmpty() ? QCoreApplication::applicationDirPath() + "/data/flight" : m_dumpDir;
+    }
+
+    const QDateTime now = QDateTime::currentDateTime();
+    const QString path = dir + "/flight-" + now.toString("yyyyMMdd-hhmmss-zzz") + "-" + reason + ".json";
+    const qint64 anchorMs = frameClockWallAnchorMs();
+
+    QByteArray out;
+    out.reserve(records.size() * 160 + 256);
+    out.append("{\"reason\":\"");
+    out.append(reason.toUtf8());
+    out.append("\",\"dumpedAtMs\":");
+    out.append(QByteArray::number(now.toMSecsSinceEpoch()));
+    out.append(",\"capacity\":");
+    out.append(QByteArray::number(kCapacity));
+    out.append(",\"records\":[");
+
+    char line[160];
+    for (int i = 0; i < records.size(); ++i) {
+        const Record& record = records[i];
+        snprintf(line, sizeof(line), "%s\n{\"t\":%.3f,\"src\":%d,", i == 0 ? "" : ",",
+                 anchorMs + record.timeNs / 1e6, record.sourceId);
+        out.append(line);
+
+        if (record.type == FrameTiming) {
+            snprintf(line, sizeof(line), "\"type\":\"frame\",\"seq\":%llu,\"stagesMs\":{",
+                     static_cast<unsigned long long>(record.sequence));
+            out.append(line);
+            bool first = true;
+            for (int stage = FrameMeta::Capture + 1; stage < FrameMeta::StageCount; ++stage) {
+                if (record.stageUs[stage] < 0) {
+                    continue;
+                }
+                snprintf(line, sizeof(line), "%s\"%s\":%.3f", first ? "" : ",",
+                         FrameMeta::stageName(static_cast<FrameMeta::Stage>(stage)),
+                         record.stageUs[stage] / 1000.0);
+                out.append(line);
+                first = false;
+            }
+            out.append("}}");
+        } else if (record.type == QueueDepth) {
+            snprintf(line, sizeof(line), "\"type\":\"queue\",\"name\":\"%s\",\"value\":%lld}",
+                     record.name ? record.name : "", static_cast<long long>(record.value));
+            out.append(line);
+        } else {
+            snprintf(line, sizeof(line), "\"type\":\"event\",\"event\":\"%s\",\"detail\":\"%s\",\"value\":%lld}",
+                     eventName(record.kind), record.name ? record.name : "",
+                     static_cast<long long>(record.value));
+            out.append(line);
+        }
+    }
+    out.append("\n]}\n");
+
+    QDir().mkpath(dir);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(out.constData(), out.size()) != out.size() || !file.commit()) {
+        qDebug() << "FlightRecorder: Failed to write" << path << file.errorString();
+        return QString();
+    }
+
+    m_dumpCount.fetch_add(1, std::memory_order_relaxed);
+    qDebug() << "FlightRecorder:" << records.size() << "records dumped to" << path << "reason:" << reason;
+    pruneDumps(dir);
+    return path;
+}
+
+void FlightRecorder::pruneDumps(const QString& dir) {
+    // 文件名带时间戳，按名称排序即按时间排序；只保留最近 kMaxDumpFiles 份
+    QDir dumpDir(dir);
+    const QStringList files = dumpDir.entryList(QStringList() << "flight-*.json", QDir::Files, QDir::Name);
+    for (int i = 0; i + kMaxDumpFiles < files.size(); ++i) {
+        dumpDir.remove(files[i]);
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include "FrameMeta.h"
+#include <QString>
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+
+// 🆕 常开的飞行记录器：定长环形缓冲保存最近一段流水线历史，异常时自动落盘
+// - 记录：每帧各阶段耗时（采集起算）、队列深度采样、关键事件（断流/重连、丢帧、数据库写入、卡顿、超时）
+// - 触发落盘：帧延迟超过 SLO、采集线程心跳停止超过 stallMs、收到 SIGUSR1、或手动 dumpNow()
+// - 写入只在锁内拷贝一条定长记录（约 80 字节），无分配；落盘在看门狗线程完成，不占用热路径
+// 容量 kCapacity 条，按 3 路 30fps 约覆盖最近 40 秒
+class FlightRecorder {
+public:
+    static const int kCapacity = 4096;
+    static const int kMaxSources = 8;
+
+    enum RecordType : quint8 {
+        FrameTiming,
+        QueueDepth,
+        Event
+    };
+
+    enum EventKind : quint8 {
+        StreamOpened,       // 采集流打开（含重连成功）
+        StreamLost,         // 打开失败或读流中断
+        FrameDrop,          // 队列满丢帧，value 为累计丢帧数
+        DbWrite,            // 人脸库写入提交，value 为记录数
+        CaptureStall,       // 采集心跳停止，value 为停顿毫秒数
+        SloViolation,       // 帧延迟超过 SLO，value 为延迟微秒数
+        Note
+    };
+
+    struct Record {
+        qint64 timeNs = 0;                      // frameClockNs 时间基准
+        quint8 type = FrameTiming;
+        quint8 kind = 0;                        // Event 时为 EventKind
+        qint16 sourceId = -1;
+        qint32 stageUs[FrameMeta::StageCount];  // FrameTiming：采集到各阶段的微秒数，-1 表示未经过
+        quint64 sequence = 0;
+        const char* name = nullptr;             // 队列名或事件说明，必须是静态字符串
+        qint64 value = 0;
+    };
+
+    static FlightRecorder& instance();
+
+    // 启动看门狗线程（卡顿检测、信号与自动落盘），并安装 SIGUSR1 处理；dumpDir 为空时用 <应用目录>/data/flight
+    void start(const QString& dumpDir = QString());
+    void stop();
+
+    // ---- 热路径写入 ----
+    // 帧走完一段流水线时调用（AI 结果发出、显示），同时检查 SLO
+    void recordFrame(const FrameMeta& meta);
+    void recordQueueDepth(const char* name, int sourceId, qint64 depth);
+    void recordEvent(EventKind kind, int sourceId, qint64 value = 0, const char* detail = nullptr);
+
+    // 采集线程每帧调用；endHeartbeat 在线程正常退出时调用，避免被当成卡顿
+    void heartbeat(int sourceId);
+    void endHeartbeat(int sourceId);
+
+    // ---- 配置 ----
+    // 采集到指定阶段（AIDone / Display）的延迟上限，<= 0 关闭
+    void setLatencySlo(FrameMeta::Stage stage, double ms);
+    void setStallThresholdMs(int ms);
+    void setAutoDumpCooldownMs(int ms);     // 两次自动落盘的最小间隔
+
+    // ---- 导出 ----
+    // 立即写出当前缓冲，返回文件路径（失败为空）；可在任意线程调用
+    QString dumpNow(const QString& reason);
+    // 请求看门狗线程延迟 kPostTriggerMs 后落盘（保留触发之后的一小段），受冷却间隔限制
+    // 返回 false 表示冷却中或已有待落盘请求
+    bool requestDump(const char* reason);
+    // 等待落盘的触发原因（同一时刻至多一个），没有时为 nullptr
+    const char* pendingDumpReason() const { return m_pendingReason.load(); }
+
+    QVector<Record> snapshot() const;      // 按时间先后
+    quint64 totalRecorded() const;
+    int dumpCount() const { return m_dumpCount.load(std::memory_order_relaxed); }
+
+private:
+    FlightRecorder();
+    ~FlightRecorder();
+
+    static const int kPostTriggerMs = 1000;
+    static const int kMaxDumpFiles = 10;
+
+    class Watchdog;
+    friend class Watchdog;
+
+    void append(const Record& record);
+    void checkStalls(qint64 nowNs);
+    void sampleQueues();
+    void pruneDumps(const QString& dir);
+
+    mutable QMutex m_mutex;                 // 保护环形缓冲与 m_dumpDir
+    Record m_records[kCapacity];
+    quint64 m_written = 0;
+    QString m_dumpDir;
+
+    std::atomic<qint64> m_sloUs[FrameMeta::StageCount];
+    std::atomic<int> m_stallMs{2000};
+    std::atomic<int> m_cooldownMs{30000};
+
+    std::atomic<qint64> m_heartbeatNs[kMaxSources];     // 0 表示未在采集
+    bool m_stalled[kMaxSources];                        // 只在看门狗线程访问
+
+    std::atomic<const char*> m_pendingReason{nullptr};  // 等待落盘的触发原因
+    std::atomic<qint64> m_pendingDueNs{0};
+    std::atomic<qint64> m_lastAutoDumpNs{0};
+    std::atomic<int> m_dumpCount{0};
+
+    QMutex m_controlMutex;                  // 保护 start/stop
+    Watchdog* m_watchdog = nullptr;
+
+    Q_DISABLE_COPY(FlightRecorder)
+};
+
+#endif // FLIGHTRECORDER_H
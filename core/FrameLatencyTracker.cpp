@@ -0,0 +1,119 @@
+#include "FrameLatencyTracker.h"
+#include <QMutexLocker>
+
+FrameLatencyTracker& FrameLatencyTracker::instance() {
+    static FrameLatencyTracker tracker;
+    return tracker;
+}
+
+FrameLatencyTracker::FrameLatencyTracker() {
+    for (int source = 0; source < kMaxSources; ++source) {
+        for (int stage = 0; stage < FrameMeta::StageCount; ++stage) {
+            m_slots[source][stage].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+}
+
+FrameLatencyTracker::~FrameLatencyTracker() {
+    for (int source = 0; source < kMaxSources; ++source) {
+        for (int stage = 0; stage < FrameMeta::StageCount; ++stage) {
+            delete m_slots[source][stage].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+FrameLatencyTracker::Slot* FrameLatencyTracker::slot(int sourceId, FrameMeta::Stage stage) const {
+    if (sourceId < 0 || sourceId >= kMaxSources || stage < 0 || stage >= FrameMeta::StageCount) {
+        return nullptr;
+    }
+    return m_slots[sourceId][stage].load(std::memory_order_acquire);
+}
+
+FrameLatencyTracker::Slot* FrameLatencyTracker::ensureSlot(int sourceId, FrameMeta::Stage stage) {
+    if (sourceId < 0 || sourceId >= kMaxSources || stage < 0 || stage >= FrameMeta::StageCount) {
+        return nullptr;
+    }
+    if (Slot* existing = slot(sourceId, stage)) {
+        return existing;
+    }
+
+    QMutexLocker locker(&m_registerMutex);
+    if (Slot* existing = slot(sourceId, stage)) {
+        return existing;
+    }
+
+    const QString stageName = QString::fromLatin1(FrameMeta::stageName(stage));
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    Slot* created = new Slot;
+    created->seen = metrics.counter("frame.seen." + stageName, sourceId);
+    created->lostGauge = metrics.gauge("frame.lost." + stageName, sourceId);
+    created->latencyMs = metrics.histogram("frame.glass_to_" + stageName + "_ms", sourceId);
+    m_slots[sourceId][stage].store(created, std::memory_order_release);
+    return created;
+}
+
+void FrameLatencyTracker::mark(FrameMeta& meta, FrameMeta::Stage stage) {
+    if (!meta.isTraced()) {
+        return;
+    }
+    meta.stamp(stage);
+    record(meta, stage);
+}
+
+void FrameLatencyTracker::record(const FrameMeta& meta, FrameMeta::Stage stage) {
+    if (!meta.isTraced()) {
+        return;
+    }
+    Slot* s = ensureSlot(meta.sourceId, stage);
+    if (!s) {
+        return;
+    }
+
+    s->seen->add();
+    if (stage != FrameMeta::Capture) {
+        const double latencyMs = meta.sinceCaptureMs(stage);
+        if (latencyMs >= 0.0) {
+            s->latencyMs->record(latencyMs);
+        }
+    }
+
+    // 序号前进时断档计为丢帧；比已见序号小的晚到帧说明之前多计了一帧，扣回
+    quint64 last = s->lastSequence.load(std::memory_order_relaxed);
+    while (meta.sequence > last) {
+        if (s->lastSequence.compare_exchange_weak(last, meta.sequence, std::memory_order_relaxed)) {
+            if (last > 0 && meta.sequence > last + 1) {
+                s->lost.fetch_add(static_cast<qint64>(meta.sequence - last - 1), std::memory_order_relaxed);
+                s->lostGauge->set(s->lost.load(std::memory_order_relaxed));
+            }
+            return;
+        }
+    }
+    if (meta.sequence < last && s->lost.load(std::memory_order_relaxed) > 0) {
+        s->lost.fetch_sub(1, std::memory_order_relaxed);
+        s->lostGauge->set(s->lost.load(std::memory_order_relaxed));
+    }
+}
+
+void FrameLatencyTracker::resync(int sourceId, FrameMeta::Stage stage) {
+    Slot* s = slot(sourceId, stage);
+    if (s) {
+        s->lastSequence.store(0, std::memory_order_relaxed);
+    }
+}
+
+FrameLatencyTracker::StageStats FrameLatencyTracker::stats(int sourceId, FrameMeta::Stage stage) const {
+    StageStats result;
+    const Slot* s = slot(sourceId, stage);
+    if (!s) {
+        return result;
+    }
+
+    result.seen = s->seen->value();
+    result.lost = s->lost.load(std::memory_order_relaxed);
+    result.lastSequence = s->lastSequence.load(std::memory_order_relaxed);
+    result.p50Ms = s->latencyMs->percentile(0.50);
+    result.p95Ms = s->latencyMs->percentile(0.95);
+    result.p99Ms = s->latencyMs->percentile(0.99);
+    result.maxMs = s->latencyMs->max();
+    return result;
+}
@@ -0,0 +1,63 @@
+#ifndef FRAMELATENCYTRACKER_H
+#define FRAMELATENCYTRACKER_H
+
+#include "FrameMeta.h"
+#include "MetricsRegistry.h"
+#include <atomic>
+
+// 🆕 全链路帧延迟与丢帧统计
+// 每个阶段调用 mark()/record()：
+// - 延迟：采集时间戳到该阶段的耗时写入 "frame.glass_to_<stage>_ms" 直方图（按来源）
+// - 丢帧：按来源内序号的断档计数，即采集之后、到达该阶段之前丢失的帧
+//   （"frame.lost.<stage>"，相邻阶段相减得到单个阶段的丢帧；乱序晚到的帧会从计数中扣回）
+// 注意 ai_enqueue 的断档包含按 skipFrames 配置主动跳过的帧
+// 热路径只做数组下标和几次原子操作；每个（来源，阶段）首次出现时注册指标
+class FrameLatencyTracker {
+public:
+    static const int kMaxSources = 8;
+
+    struct StageStats {
+        quint64 seen = 0;           // 到达该阶段的帧数
+        qint64 lost = 0;            // 采集后、到达该阶段前丢失的帧数
+        quint64 lastSequence = 0;
+        double p50Ms = 0.0;         // 采集到该阶段
+        double p95Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
+
+    static FrameLatencyTracker& instance();
+
+    // 打时间戳并记录
+    void mark(FrameMeta& meta, FrameMeta::Stage stage);
+    // 记录已打过时间戳的阶段；未追踪的帧或超出来源上限时忽略
+    void record(const FrameMeta& meta, FrameMeta::Stage stage);
+
+    StageStats stats(int sourceId, FrameMeta::Stage stage) const;
+
+    // 该阶段的消费者重新接入来源时调用（如界面切回某一路）：下一帧重新作为序号起点，
+    // 不在此之前的断档计入丢帧；已累计的丢帧数保留
+    void resync(int sourceId, FrameMeta::Stage stage);
+
+private:
+    FrameLatencyTracker();
+    ~FrameLatencyTracker();
+
+    struct Slot {
+        std::atomic<quint64> lastSequence{0};
+        std::atomic<qint64> lost{0};
+        MetricCounter* seen = nullptr;
+        MetricGauge* lostGauge = nullptr;
+        MetricHistogram* latencyMs = nullptr;
+    };
+
+    Slot* slot(int sourceId, FrameMeta::Stage stage) const;
+    Slot* ensureSlot(int sourceId, FrameMeta::Stage stage);
+
+    std::atomic<Slot*> m_slots[kMaxSources][FrameMeta::StageCount];
+    QMutex m_registerMutex;
+
+    Q_DISABLE_COPY(FrameLatencyTracker)
+};
+
+#endif // FRAMELATENCYTRACKER_H
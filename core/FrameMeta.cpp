@@ -0,0 +1,63 @@
+#include "FrameMeta.h"
+#include <QElapsedTimer>
+#include <QDateTime>
+
+namespace {
+
+struct FrameClock {
+    QElapsedTimer clock;
+    qint64 wallAnchorMs;
+
+    FrameClock() {
+        clock.start();
+        wallAnchorMs = QDateTime::currentMSecsSinceEpoch();
+    }
+};
+
+FrameClock& frameClock() {
+    static FrameClock instance;
+    return instance;
+}
+
+} // namespace
+
+qint64 frameClockNs() {
+    // 加 1 保证有效时间戳始终大于 0（0 表示未打点）
+    return frameClock().clock.nsecsElapsed() + 1;
+}
+
+qint64 frameClockWallAnchorMs() {
+    return frameClock().wallAnchorMs;
+}
+
+double FrameMeta::sinceCaptureMs(Stage stage) const {
+    if (!hasStage(Capture) || !hasStage(stage)) {
+        return -1.0;
+    }
+    return (stampNs[stage] - stampNs[Capture]) / 1e6;
+}
+
+FrameMeta FrameMeta::begin(int sourceId, quint64 sequence) {
+    FrameMeta meta;
+    meta.sourceId = sourceId;
+    meta.sequence = sequence;
+    meta.stamp(Capture);
+    return meta;
+}
+
+const char* FrameMeta::stageName(Stage stage) {
+    switch (stage) {
+    case Capture: return "capture";
+    case Decode: return "decode";
+    case AIEnqueue: return "ai_enqueue";
+    case AIStart: return "ai_start";
+    case Motion: return "motion";
+    case Detection: return "detection";
+    case Recognition: return "recognition";
+    case AIDone: return "ai_done";
+    case Overlay: return "overlay";
+    case Display: return "display";
+    case StageCount: break;
+    }
+    return "unknown";
+}
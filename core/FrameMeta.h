@@ -0,0 +1,55 @@
+#ifndef FRAMEMETA_H
+#define FRAMEMETA_H
+
+#include <QtGlobal>
+#include <QMetaType>
+
+// 🆕 进程内统一的单调时钟（纳秒，始终大于 0），采集、AI、显示各阶段的时间戳共用
+qint64 frameClockNs();
+// 单调时钟起点对应的墙上时间（毫秒），只在显示时换算
+qint64 frameClockWallAnchorMs();
+
+// 帧来源编号（采集线程与 AIDetectionThread::addFrame 共用）
+namespace FrameSource {
+const int Mipi = 0;
+const int Rtsp1 = 1;
+const int Rtsp2 = 2;
+const int Usb = 3;
+}
+
+// 🆕 随帧传递的追踪信息：采集线程分配来源内递增序号并打采集时间戳，
+// 之后每个阶段在同一结构上补打时间戳。结构可平凡拷贝，随 Qt 排队信号按值传递
+struct FrameMeta {
+    enum Stage {
+        Capture = 0,    // 拿到原始帧（MIPI 缓冲 / RTSP 数据包 / USB read 返回）
+        Decode,         // 解码/颜色转换完成，准备发出
+        AIEnqueue,      // 进入 AI 待分析队列
+        AIStart,        // AI 线程取出
+        Motion,         // 运动检测完成
+        Detection,      // 人脸检测完成
+        Recognition,    // 人脸识别结果回填完成
+        AIDone,         // 检测结果发出
+        Overlay,        // 检测框叠加完成
+        Display,        // 交给界面显示
+        StageCount
+    };
+
+    int sourceId = -1;
+    quint64 sequence = 0;               // 来源内从 1 递增，0 表示未追踪
+    qint64 stampNs[StageCount] = {};    // 0 表示未经过该阶段
+
+    bool isTraced() const { return sequence > 0; }
+    bool hasStage(Stage stage) const { return stampNs[stage] > 0; }
+    void stamp(Stage stage) { stampNs[stage] = frameClockNs(); }
+
+    // 采集到该阶段的耗时（毫秒），任一端缺失时返回 -1
+    double sinceCaptureMs(Stage stage) const;
+
+    // 采集线程调用：分配序号并打上采集时间戳
+    static FrameMeta begin(int sourceId, quint64 sequence);
+    static const char* stageName(Stage stage);
+};
+
+Q_DECLARE_METATYPE(FrameMeta)
+
+#endif // FRAMEMETA_H
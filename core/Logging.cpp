@@ -0,0 +1,341 @@
+#include "Logging.h"
+#include "MetricsRegistry.h"
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QDateTime>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+Q_LOGGING_CATEGORY(lcAI, "sv.ai", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcFaceRecognition, "sv.ai.face", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcFaceDatabase, "sv.ai.facedb", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcMotion, "sv.ai.motion", QtInfoMsg)
+
+namespace {
+
+inline qint64 steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline qint64 steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 限频器放行时把此前被抑制的条数交给同线程紧接着的消息处理
+thread_local quint32 t_pendingSuppressed = 0;
+
+// UTF-16 → UTF-8，写满即截断；不分配内存
+int encodeUtf8(const QString& text, char* out, int capacity, bool* truncated) {
+    const ushort* p = text.utf16();
+    const int n = text.size();
+    int length = 0;
+    *truncated = false;
+
+    for (int i = 0; i < n; ++i) {
+        uint code = p[i];
+        if (code >= 0xD800 && code < 0xDC00 && i + 1 < n && p[i + 1] >= 0xDC00 && p[i + 1] < 0xE000) {
+            code = 0x10000 + ((code - 0xD800) << 10) + (p[i + 1] - 0xDC00);
+            ++i;
+        }
+
+        char bytes[4];
+        int count;
+        if (code < 0x80) {
+            bytes[0] = char(code);
+            count = 1;
+        } else if (code < 0x800) {
+            bytes[0] = char(0xC0 | (code >> 6));
+            bytes[1] = char(0x80 | (code & 0x3F));
+            count = 2;
+        } else if (code < 0x10000) {
+            bytes[0] = char(0xE0 | (code >> 12));
+            bytes[1] = char(0x80 | ((code >> 6) & 0x3F));
+            bytes[2] = char(0x80 | (code & 0x3F));
+            count = 3;
+        } else {
+            bytes[0] = char(0xF0 | (code >> 18));
+            bytes[1] = char(0x80 | ((code >> 12) & 0x3F));
+            bytes[2] = char(0x80 | ((code >> 6) & 0x3F));
+            bytes[3] = char(0x80 | (code & 0x3F));
+            count = 4;
+        }
+
+        if (length + count > capacity) {
+            *truncated = true;
+            break;
+        }
+        memcpy(out + length, bytes, count);
+        length += count;
+    }
+    return length;
+}
+
+// 定长槽位的有界多生产者环形缓冲（Vyukov 序号法），单个消费者
+class LogRing {
+public:
+    static const int kCapacity = 1024;      // 2 的幂
+    static const int kTextBytes = 400;
+
+    struct Slot {
+        std::atomic<quint64> sequence;
+        QtMsgType type;
+        const char* category;               // 指向静态分类名
+        qint64 wallMs;
+        quint32 suppressed;
+        int length;
+        bool truncated;
+        char text[kTextBytes];
+    };
+
+    LogRing() {
+        for (int i = 0; i < kCapacity; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // 缓冲满返回 nullptr；成功时调用方填写后必须 commit
+    Slot* claim() {
+        quint64 position = m_head.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = m_slots[position & (kCapacity - 1)];
+            const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+            const qint64 diff = qint64(sequence) - qint64(position);
+            if (diff == 0) {
+                if (m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    return &slot;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                position = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void commit(Slot* slot, quint64 position) {
+        slot->sequence.store(position + 1, std::memory_order_release);
+    }
+
+    // 仅消费者线程调用
+    Slot* peek() {
+        Slot& slot = m_slots[m_tail & (kCapacity - 1)];
+        const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+        return sequence == m_tail + 1 ? &slot : nullptr;
+    }
+
+    void pop(Slot* slot) {
+        slot->sequence.store(m_tail + kCapacity, std::memory_order_release);
+        ++m_tail;
+    }
+
+    quint64 positionOf(const Slot* slot) const {
+        // claim 成功后槽位序号仍等于其位置
+        return slot->sequence.load(std::memory_order_relaxed);
+    }
+
+private:
+    Slot m_slots[kCapacity];
+    alignas(64) std::atomic<quint64> m_head{0};
+    alignas(64) quint64 m_tail = 0;
+};
+
+const char* typeTag(QtMsgType type) {
+    switch (type) {
+    case QtDebugMsg: return "D";
+    case QtInfoMsg: return "I";
+    case QtWarningMsg: return "W";
+    case QtCriticalMsg: return "C";
+    case QtFatalMsg: return "F";
+    }
+    return "?";
+}
+
+void writeLine(QtMsgType type, const char* category, qint64 wallMs, const char* text, int length,
+               bool truncated, quint32 suppressed) {
+    const QString time = QDateTime::fromMSecsSinceEpoch(wallMs).toString("hh:mm:ss.zzz");
+    fprintf(stderr, "%s %s", time.toLatin1().constData(), typeTag(type));
+    if (category && strcmp(category, "default") != 0) {
+        fprintf(stderr, " [%s]", category);
+    }
+    fprintf(stderr, " %.*s%s", length, text, truncated ? "..." : "");
+    if (suppressed > 0) {
+        fprintf(stderr, " (+%u similar suppressed)", suppressed);
+    }
+    fputc('\n', stderr);
+}
+
+class AsyncLogSink;
+std::atomic<AsyncLogSink*> g_sink{nullptr};
+std::atomic<int> g_handlersInFlight{0};     // shutdown 等正在写入的处理器退出后再销毁 sink
+QMutex g_installMutex;
+
+// 后台写线程：批量取出并写 stderr，空闲时短暂休眠
+class AsyncLogSink : public QThread {
+public:
+    AsyncLogSink() {
+        setObjectName("sv-log");
+        MetricsRegistry& metrics = MetricsRegistry::instance();
+        m_enqueued = metrics.counter("log.enqueued");
+        m_dropped = metrics.counter("log.dropped");
+        m_written = metrics.counter("log.written");
+        m_enqueueUs = metrics.histogram("log.enqueue_us", MetricsRegistry::kAllSources,
+                                        { 0.25, 0.5, 1, 2, 5, 10, 20, 50, 100 });
+    }
+
+    void stop() {
+        m_running.store(false, std::memory_order_release);
+        wait();
+        drain();
+    }
+
+    // 调用线程：只做一次 UTF-8 拷贝和几次原子操作
+    void enqueue(QtMsgType type, const QMessageLogContext& context, const QString& message) {
+        const qint64 startNs = steadyNowNs();
+        const quint32 suppressed = t_pendingSuppressed;
+        t_pendingSuppressed = 0;
+
+        LogRing::Slot* slot = m_ring.claim();
+        if (!slot) {
+            m_dropped->add();
+            m_droppedSinceReport.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const quint64 position = m_ring.positionOf(slot);
+        slot->type = type;
+        slot->category = context.category;
+        slot->wallMs = QDateTime::currentMSecsSinceEpoch();
+        slot->suppressed = suppressed;
+        slot->length = encodeUtf8(message, slot->text, LogRing::kTextBytes, &slot->truncated);
+        m_ring.commit(slot, position);
+
+        m_enqueued->add();
+        m_enqueueUs->record((steadyNowNs() - startNs) / 1000.0);
+    }
+
+    // 消费者：后台线程或（致命消息时）调用线程，互斥保证单消费者
+    void drain() {
+        QMutexLocker locker(&m_consumerMutex);
+        int written = 0;
+        while (LogRing::Slot* slot = m_ring.peek()) {
+            writeLine(slot->type, slot->category, slot->wallMs, slot->text, slot->length,
+                      slot->truncated, slot->suppressed);
+            m_ring.pop(slot);
+            ++written;
+        }
+
+        const quint64 dropped = m_droppedSinceReport.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            fprintf(stderr, "%llu log messages dropped (ring buffer full)\n",
+                    static_cast<unsigned long long>(dropped));
+        }
+        if (written > 0 || dropped > 0) {
+            fflush(stderr);
+            m_written->add(written);
+        }
+    }
+
+protected:
+    void run() override {
+        while (m_running.load(std::memory_order_acquire)) {
+            drain();
+            msleep(5);
+        }
+    }
+
+private:
+    LogRing m_ring;
+    QMutex m_consumerMutex;
+    std::atomic<bool> m_running{true};
+    std::atomic<quint64> m_droppedSinceReport{0};
+
+    MetricCounter* m_enqueued;
+    MetricCounter* m_dropped;
+    MetricCounter* m_written;
+    MetricHistogram* m_enqueueUs;
+};
+
+void asyncMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& message) {
+    g_handlersInFlight.fetch_add(1, std::memory_order_acquire);
+    AsyncLogSink* sink = g_sink.load(std::memory_order_acquire);
+    if (!sink) {
+        g_handlersInFlight.fetch_sub(1, std::memory_order_release);
+        const QByteArray text = message.toUtf8();
+        writeLine(type, context.category, QDateTime::currentMSecsSinceEpoch(),
+                  text.constData(), text.size(), false, 0);
+        return;
+    }
+
+    sink->enqueue(type, context, message);
+
+    // 严重/致命消息同步落盘：Qt 在处理器返回后对致命消息调用 abort()
+    if (type == QtCriticalMsg || type == QtFatalMsg) {
+        sink->drain();
+    }
+    g_handlersInFlight.fetch_sub(1, std::memory_order_release);
+}
+
+} // namespace
+
+bool LogRateLimiter::allow(int intervalMs) {
+    const qint64 now = steadyNowMs();
+    qint64 next = m_nextAllowedMs.load(std::memory_order_relaxed);
+    if (now < next || !m_nextAllowedMs.compare_exchange_strong(next, now + intervalMs, std::memory_order_relaxed)) {
+        static MetricCounter* const suppressedTotal = MetricsRegistry::instance().counter("log.suppressed");
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        suppressedTotal->add();
+        return false;
+    }
+
+    t_pendingSuppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+namespace Logging {
+
+void install() {
+    QMutexLocker locker(&g_installMutex);
+    if (g_sink) {
+        return;
+    }
+
+    AsyncLogSink* sink = new AsyncLogSink;
+    sink->start(QThread::LowPriority);
+    g_sink.store(sink, std::memory_order_release);
+    qInstallMessageHandler(asyncMessageHandler);
+}
+
+void shutdown() {
+    QMutexLocker locker(&g_installMutex);
+    if (!g_sink) {
+        return;
+    }
+
+    AsyncLogSink* sink = g_sink.exchange(nullptr, std::memory_order_acq_rel);
+    qInstallMessageHandler(nullptr);
+    while (g_handlersInFlight.load(std::memory_order_acquire) > 0) {
+        QThread::yieldCurrentThread();
+    }
+    sink->stop();
+    delete sink;
+}
+
+void setFilterRules(const QString& rules) {
+    QLoggingCategory::setFilterRules(rules);
+}
+
+Stats stats() {
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    Stats s;
+    s.enqueued = metrics.counter("log.enqueued")->value();
+    s.dropped = metrics.counter("log.dropped")->value();
+    s.suppressed = metrics.counter("log.suppressed")->value();
+    s.written = metrics.counter("log.written")->value();
+    return s;
+}
+
+} // namespace Logging
@@ -0,0 +1,76 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <QLoggingCategory>
+#include <QString>
+#include <atomic>
+
+// 🆕 日志子系统
+// - 分类：每个模块一个 QLoggingCategory，热路径分类默认只开 info 及以上，
+//   运行时用 QT_LOGGING_RULES（如 "sv.ai.face.debug=true"）或 Logging::setFilterRules 打开
+// - 编译期级别：SV_LOG_MIN_LEVEL（0=debug 1=info 2=warning 3=critical），低于该级别的调用整段编译掉
+// - 惰性格式化：svDebug(lc) << ... 在分类关闭时只有一次分支判断，流式参数不求值
+// - 调用点限频：svDebugEvery(lc, ms) 同一调用点 ms 内只输出一次，被抑制的条数附在下一条后面
+// - 异步输出：Logging::install() 接管 Qt 消息处理，消息写入无锁环形缓冲，由后台线程写 stderr；
+//   缓冲满时丢弃并计数，绝不阻塞调用线程
+#ifndef SV_LOG_MIN_LEVEL
+#define SV_LOG_MIN_LEVEL 0
+#endif
+
+Q_DECLARE_LOGGING_CATEGORY(lcAI)                // sv.ai        AIDetectionThread
+Q_DECLARE_LOGGING_CATEGORY(lcFaceRecognition)   // sv.ai.face   FaceRecognitionManager
+Q_DECLARE_LOGGING_CATEGORY(lcFaceDatabase)      // sv.ai.facedb FaceDatabase
+Q_DECLARE_LOGGING_CATEGORY(lcMotion)            // sv.ai.motion MotionDetector
+
+// 调用点限频器：每个 svXxxEvery 调用点持有一个静态实例
+class LogRateLimiter {
+public:
+    // 距上次放行不足 intervalMs 时返回 false 并计数
+    bool allow(int intervalMs);
+
+private:
+    std::atomic<qint64> m_nextAllowedMs{0};
+    std::atomic<quint32> m_suppressed{0};
+};
+
+namespace Logging {
+
+struct Stats {
+    quint64 enqueued = 0;       // 进入环形缓冲的消息数
+    quint64 dropped = 0;        // 缓冲满丢弃数
+    quint64 suppressed = 0;     // 被调用点限频抑制的消息数
+    quint64 written = 0;        // 后台线程已写出的消息数
+};
+
+// 安装异步消息处理器并启动后台写线程（重复调用无副作用）
+void install();
+// 写完缓冲中剩余消息后停止后台线程，恢复同步输出
+void shutdown();
+
+void setFilterRules(const QString& rules);
+Stats stats();
+
+} // namespace Logging
+
+// 分类开关是 QLoggingCategory 内联的原子布尔读取；编译期级别不满足时整个条件为常量 false
+#define SV_LOG_CALL_SITE_LIMITER() \
+    ([]() -> LogRateLimiter& { static LogRateLimiter limiter; return limiter; }())
+
+#define SV_LOG_STREAM(category, level, isEnabled, method, condition) \
+    for (bool sv_log_enabled = SV_LOG_MIN_LEVEL <= (level) && category().isEnabled() && (condition); \
+         sv_log_enabled; sv_log_enabled = false) \
+        QMessageLogger(QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC, \
+                       category().categoryName()).method()
+
+#define svDebug(category)   SV_LOG_STREAM(category, 0, isDebugEnabled, debug, true)
+#define svInfo(category)    SV_LOG_STREAM(category, 1, isInfoEnabled, info, true)
+#define svWarning(category) SV_LOG_STREAM(category, 2, isWarningEnabled, warning, true)
+
+#define svDebugEvery(category, intervalMs) \
+    SV_LOG_STREAM(category, 0, isDebugEnabled, debug, SV_LOG_CALL_SITE_LIMITER().allow(intervalMs))
+#define svInfoEvery(category, intervalMs) \
+    SV_LOG_STREAM(category, 1, isInfoEnabled, info, SV_LOG_CALL_SITE_LIMITER().allow(intervalMs))
+#define svWarningEvery(category, intervalMs) \
+    SV_LOG_STREAM(category, 2, isWarningEnabled, warning, SV_LOG_CALL_SITE_LIMITER().allow(intervalMs))
+
+#endif // LOGGING_H
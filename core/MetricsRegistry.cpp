@@ -0,0 +1,232 @@
+#include "MetricsRegistry.h"
+#include <QMutexLocker>
+#include <QDebug>
+#include <cstring>
+#include <cmath>
+
+namespace {
+
+inline qint64 toMicros(double value) {
+    return static_cast<qint64>(std::llround(value * 1e6));
+}
+
+inline double fromMicros(qint64 micros) {
+    return micros / 1e6;
+}
+
+} // namespace
+
+// ========== MetricGauge ==========
+void MetricGauge::set(double value) {
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    m_bits.store(bits, std::memory_order_relaxed);
+}
+
+double MetricGauge::value() const {
+    const quint64 bits = m_bits.load(std::memory_order_relaxed);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// ========== MetricHistogram ==========
+MetricHistogram::MetricHistogram(const QVector<double>& bounds) {
+    m_boundCount = qMin(bounds.size(), static_cast<int>(kMaxBuckets));
+    for (int i = 0; i < m_boundCount; ++i) {
+        m_bounds[i] = bounds[i];
+    }
+    for (int i = 0; i <= kMaxBuckets; ++i) {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricHistogram::record(double value) {
+    int bucket = 0;
+    while (bucket < m_boundCount && value > m_bounds[bucket]) {
+        ++bucket;
+    }
+
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+
+    const qint64 micros = toMicros(value);
+    m_sumMicros.fetch_add(micros, std::memory_order_relaxed);
+
+    qint64 current = m_maxMicros.load(std::memory_order_relaxed);
+    while (micros > current &&
+           !m_maxMicros.compare_exchange_weak(current, micros, std::memory_order_relaxed)) {
+    }
+}
+
+double MetricHistogram::sum() const {
+    return fromMicros(m_sumMicros.load(std::memory_order_relaxed));
+}
+
+double MetricHistogram::max() const {
+    return fromMicros(m_maxMicros.load(std::memory_order_relaxed));
+}
+
+double MetricHistogram::mean() const {
+    const quint64 n = count();
+    return n ? sum() / n : 0.0;
+}
+
+double MetricHistogram::bucketBound(int index) const {
+    return index < m_boundCount ? m_bounds[index] : max();
+}
+
+quint64 MetricHistogram::bucketValue(int index) const {
+    return (index >= 0 && index <= m_boundCount) ? m_buckets[index].load(std::memory_order_relaxed) : 0;
+}
+
+double MetricHistogram::percentile(double q) const {
+    // 先拷出桶计数，避免与并发记录交错导致累计值不单调
+    quint64 buckets[kMaxBuckets + 1];
+    quint64 total = 0;
+    for (int i = 0; i <= m_boundCount; ++i) {
+        buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += buckets[i];
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+
+    const double target = qBound(0.0, q, 1.0) * total;
+    quint64 cumulative = 0;
+    for (int i = 0; i <= m_boundCount; ++i) {
+        if (buckets[i] == 0) {
+            continue;
+        }
+        if (cumulative + buckets[i] >= target) {
+            const double lower = i > 0 ? m_bounds[i - 1] : 0.0;
+            const double upper = qMax(lower, bucketBound(i));
+            const double fraction = (target - cumulative) / buckets[i];
+            return qMin(lower + (upper - lower) * fraction, max());
+        }
+        cumulative += buckets[i];
+    }
+    return max();
+}
+
+// ========== MetricsRegistry ==========
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::MetricsRegistry() {
+    m_entries.reserve(128);
+}
+
+MetricsRegistry::~MetricsRegistry() {
+    for (const Entry& entry : m_entries) {
+        switch (entry.kind) {
+        case Kind::Counter:
+            delete static_cast<MetricCounter*>(entry.metric);
+            break;
+        case Kind::Gauge:
+            delete static_cast<MetricGauge*>(entry.metric);
+            break;
+        case Kind::Histogram:
+            delete static_cast<MetricHistogram*>(entry.metric);
+            break;
+        }
+    }
+}
+
+QVector<double> MetricsRegistry::latencyBoundsMs() {
+    return { 0.5, 1, 2, 5, 10, 20, 35, 50, 75, 100, 150, 200, 300, 500, 750, 1000, 2000, 5000 };
+}
+
+MetricsRegistry::Entry* MetricsRegistry::find(const QString& name, int sourceId) const {
+    for (const Entry& entry : m_entries) {
+        if (entry.sourceId == sourceId && entry.name == name) {
+            return const_cast<Entry*>(&entry);
+        }
+    }
+    return nullptr;
+}
+
+MetricCounter* MetricsRegistry::counter(const QString& name, int sourceId) {
+    QMutexLocker locker(&m_mutex);
+    if (Entry* entry = find(name, sourceId)) {
+        return entry->kind == Kind::Counter ? static_cast<MetricCounter*>(entry->metric) : nullptr;
+    }
+
+    MetricCounter* metric = new MetricCounter;
+    m_entries.append({ name, sourceId, Kind::Counter, metric });
+    return metric;
+}
+
+MetricGauge* MetricsRegistry::gauge(const QString& name, int sourceId) {
+    QMutexLocker locker(&m_mutex);
+    if (Entry* entry = find(name, sourceId)) {
+        return entry->kind == Kind::Gauge ? static_cast<MetricGauge*>(entry->metric) : nullptr;
+    }
+
+    MetricGauge* metric = new MetricGauge;
+    m_entries.append({ name, sourceId, Kind::Gauge, metric });
+    return metric;
+}
+
+MetricHistogram* MetricsRegistry::histogram(const QString& name, int sourceId,
+                                            const QVector<double>& bounds) {
+    QMutexLocker locker(&m_mutex);
+    if (Entry* entry = find(name, sourceId)) {
+        return entry->kind == Kind::Histogram ? static_cast<MetricHistogram*>(entry->metric) : nullptr;
+    }
+
+    if (bounds.size() > MetricHistogram::kMaxBuckets) {
+        qDebug() << "MetricsRegistry: Histogram" << name << "truncated to"
+                 << MetricHistogram::kMaxBuckets << "buckets";
+    }
+
+    MetricHistogram* metric = new MetricHistogram(bounds);
+    m_entries.append({ name, sourceId, Kind::Histogram, metric });
+    return metric;
+}
+
+MetricsRegistry::Sample MetricsRegistry::sample(const Entry& entry) {
+    Sample s;
+    s.name = entry.name;
+    s.sourceId = entry.sourceId;
+    s.kind = entry.kind;
+
+    switch (entry.kind) {
+    case Kind::Counter:
+        s.value = static_cast<const MetricCounter*>(entry.metric)->value();
+        break;
+    case Kind::Gauge:
+        s.value = static_cast<const MetricGauge*>(entry.metric)->value();
+        break;
+    case Kind::Histogram: {
+        const MetricHistogram* h = static_cast<const MetricHistogram*>(entry.metric);
+        s.count = h->count();
+        s.value = h->mean();
+        s.p50 = h->percentile(0.50);
+        s.p95 = h->percentile(0.95);
+        s.p99 = h->percentile(0.99);
+        s.max = h->max();
+        break;
+    }
+    }
+    return s;
+}
+
+QVector<MetricsRegistry::Sample> MetricsRegistry::snapshot() const {
+    return snapshot(QString());
+}
+
+QVector<MetricsRegistry::Sample> MetricsRegistry::snapshot(const QString& prefix) const {
+    QMutexLocker locker(&m_mutex);
+
+    QVector<Sample> samples;
+    samples.reserve(m_entries.size());
+    for (const Entry& entry : m_entries) {
+        if (prefix.isEmpty() || entry.name.startsWith(prefix)) {
+            samples.append(sample(entry));
+        }
+    }
+    return samples;
+}
@@ -0,0 +1,120 @@
+#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <atomic>
+
+// 计数器：单调递增（帧数、人脸数等）
+class MetricCounter {
+public:
+    void add(quint64 n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> m_value{0};
+};
+
+// 仪表：最近一次设置的值（降级级别、池占用等）
+class MetricGauge {
+public:
+    void set(double value);
+    double value() const;
+
+private:
+    std::atomic<quint64> m_bits{0};   // double 按位存放，保证无锁读写
+};
+
+// 直方图：固定桶边界，记录只做一次桶查找和几次原子加
+// 桶边界在注册时给定（升序），最后一个桶收纳超出上界的值
+class MetricHistogram {
+public:
+    static const int kMaxBuckets = 24;
+
+    explicit MetricHistogram(const QVector<double>& bounds);
+
+    void record(double value);
+
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    double sum() const;
+    double max() const;
+    double mean() const;
+    // 按桶线性插值的分位数近似（q 取 0~1），精度受桶宽限制
+    double percentile(double q) const;
+
+    int bucketCount() const { return m_boundCount + 1; }
+    double bucketBound(int index) const;     // 最后一个桶返回 max()
+    quint64 bucketValue(int index) const;
+
+private:
+    double m_bounds[kMaxBuckets];
+    int m_boundCount = 0;
+    std::atomic<quint64> m_buckets[kMaxBuckets + 1];
+    std::atomic<quint64> m_count{0};
+    std::atomic<qint64> m_sumMicros{0};     // 以 1e-6 为单位累加，避免浮点原子
+    std::atomic<qint64> m_maxMicros{0};
+};
+
+// 🆕 指标注册表：按（名称，来源）注册类型化指标，热路径只持有指标指针做原子更新
+// 注册（首次出现的名称/来源组合）会分配，之后的更新不加锁、不分配；
+// 界面按自己的节奏调用 snapshot() 采样，取代逐帧格式化字符串的信号
+class MetricsRegistry {
+public:
+    enum class Kind {
+        Counter,
+        Gauge,
+        Histogram
+    };
+
+    // 全局来源（不区分摄像头）
+    static const int kAllSources = -1;
+
+    struct Sample {
+        QString name;
+        int sourceId = kAllSources;
+        Kind kind = Kind::Counter;
+        double value = 0.0;     // 计数器/仪表的当前值；直方图为均值
+        quint64 count = 0;      // 直方图样本数
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    static MetricsRegistry& instance();
+
+    // 同名同来源重复注册返回同一指标；名称已注册为其他类型时返回 nullptr
+    MetricCounter* counter(const QString& name, int sourceId = kAllSources);
+    MetricGauge* gauge(const QString& name, int sourceId = kAllSources);
+    MetricHistogram* histogram(const QString& name, int sourceId = kAllSources,
+                               const QVector<double>& bounds = latencyBoundsMs());
+
+    // 默认延迟桶（毫秒）：0.5ms ~ 5s 近似对数分布
+    static QVector<double> latencyBoundsMs();
+
+    QVector<Sample> snapshot() const;
+    // 取名称前缀匹配的指标（如 "ai."），按注册顺序
+    QVector<Sample> snapshot(const QString& prefix) const;
+
+private:
+    MetricsRegistry();
+    ~MetricsRegistry();
+
+    struct Entry {
+        QString name;
+        int sourceId;
+        Kind kind;
+        void* metric;
+    };
+
+    Entry* find(const QString& name, int sourceId) const;
+    static Sample sample(const Entry& entry);
+
+    mutable QMutex m_mutex;
+    QVector<Entry> m_entries;
+
+    Q_DISABLE_COPY(MetricsRegistry)
+};
+
+#endif // METRICSREGISTRY_H
@@ -0,0 +1,425 @@
+#include "SystemMetrics.h"
+#include "MetricsRegistry.h"
+#include <QThread>
+#include <QWaitCondition>
+#include <QMutexLocker>
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+inline qint64 steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// /proc 文件大小报告为 0，只能读到 EOF；读入调用方的栈缓冲，不分配内存
+int readProcFile(const char* path, char* buffer, int capacity) {
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int length = 0;
+    while (length < capacity - 1) {
+        const ssize_t n = ::read(fd, buffer + length, capacity - 1 - length);
+        if (n <= 0) {
+            break;
+        }
+        length += static_cast<int>(n);
+    }
+    ::close(fd);
+    buffer[length] = '\0';
+    return length;
+}
+
+// 读取单个整数值（cgroup 文件），"max" 等非数字返回 -1
+qint64 readProcValue(const QByteArray& path) {
+    if (path.isEmpty()) {
+        return -1;
+    }
+    char buffer[64];
+    if (readProcFile(path.constData(), buffer, sizeof(buffer)) <= 0) {
+        return -1;
+    }
+    char* end = nullptr;
+    const long long value = strtoll(buffer, &end, 10);
+    return end == buffer ? -1 : value;
+}
+
+// 解析 /proc/<pid>/stat：comm 可能含空格和括号，以最后一个 ')' 为界
+// 返回 utime+stime（时钟滴答），name 非空时填入 comm
+bool parseStatTicks(const char* text, quint64* ticks, QString* name) {
+    const char* open = strchr(text, '(');
+    const char* close = strrchr(text, ')');
+    if (!open || !close || close < open) {
+        return false;
+    }
+    if (name) {
+        *name = QString::fromUtf8(open + 1, static_cast<int>(close - open - 1));
+    }
+
+    // ')' 之后依次是第 3 个字段（state）起；utime/stime 为第 14/15 个字段
+    const char* p = close + 1;
+    int field = 2;
+    quint64 utime = 0;
+    quint64 stime = 0;
+    while (*p && field < 15) {
+        while (*p == ' ') {
+            ++p;
+        }
+        ++field;
+        if (field == 14 || field == 15) {
+            char* end = nullptr;
+            const unsigned long long value = strtoull(p, &end, 10);
+            (field == 14 ? utime : stime) = value;
+            p = end;
+        } else {
+            while (*p && *p != ' ') {
+                ++p;
+            }
+        }
+    }
+    if (field < 15) {
+        return false;
+    }
+    *ticks = utime + stime;
+    return true;
+}
+
+// 在 "Key:   123 kB" 形式的文本中查找数值（kB）
+qint64 findKbField(const char* text, const char* key) {
+    const char* p = strstr(text, key);
+    if (!p) {
+        return -1;
+    }
+    p += strlen(key);
+    char* end = nullptr;
+    const long long value = strtoll(p, &end, 10);
+    return end == p ? -1 : value;
+}
+
+bool fileExists(const QByteArray& path) {
+    return ::access(path.constData(), R_OK) == 0;
+}
+
+// 指标句柄：首次采样时注册，之后只做原子写
+struct SystemGauges {
+    MetricGauge* processCpu;
+    MetricGauge* systemCpu;
+    MetricGauge* hottestThreadCpu;
+    MetricGauge* rssMb;
+    MetricGauge* pssMb;
+    MetricGauge* load1;
+    MetricGauge* cgroupMemoryMb;
+
+    static SystemGauges& instance() {
+        static SystemGauges gauges;
+        return gauges;
+    }
+
+private:
+    SystemGauges() {
+        MetricsRegistry& metrics = MetricsRegistry::instance();
+        processCpu = metrics.gauge("sys.cpu.process_pct");
+        systemCpu = metrics.gauge("sys.cpu.system_pct");
+        hottestThreadCpu = metrics.gauge("sys.cpu.hottest_thread_pct");
+        rssMb = metrics.gauge("sys.mem.rss_mb");
+        pssMb = metrics.gauge("sys.mem.pss_mb");
+        load1 = metrics.gauge("sys.load.1m");
+        cgroupMemoryMb = metrics.gauge("sys.cgroup.memory_mb");
+    }
+};
+
+} // namespace
+
+// ========== 后台采样线程 ==========
+class SystemMetrics::Sampler : public QThread {
+public:
+    explicit Sampler(SystemMetrics* owner) : m_owner(owner) {
+        setObjectName("sv-sysmetrics");
+    }
+
+    void setInterval(int intervalMs) {
+        QMutexLocker locker(&m_mutex);
+        m_intervalMs = qMax(100, intervalMs);
+    }
+
+    void requestStop() {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+
+protected:
+    void run() override {
+        QMutexLocker locker(&m_mutex);
+        while (!m_stopping) {
+            locker.unlock();
+            m_owner->sampleNow();
+            locker.relock();
+            if (!m_stopping) {
+                m_wake.wait(&m_mutex, m_intervalMs);
+            }
+        }
+    }
+
+private:
+    SystemMetrics* m_owner;
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    int m_intervalMs = 1000;
+    bool m_stopping = false;
+};
+
+// ========== SystemMetrics ==========
+SystemMetrics& SystemMetrics::instance() {
+    static SystemMetrics metrics;
+    return metrics;
+}
+
+SystemMetrics::SystemMetrics() = default;
+
+SystemMetrics::~SystemMetrics() {
+    stop();
+}
+
+void SystemMetrics::start(int intervalMs) {
+    QMutexLocker locker(&m_controlMutex);
+    if (m_sampler) {
+        m_sampler->setInterval(intervalMs);
+        return;
+    }
+
+    m_sampler = new Sampler(this);
+    m_sampler->setInterval(intervalMs);
+    m_sampler->start(QThread::LowPriority);
+}
+
+void SystemMetrics::stop() {
+    QMutexLocker locker(&m_controlMutex);
+    if (!m_sampler) {
+        return;
+    }
+
+    m_sampler->requestStop();
+    m_sampler->wait();
+    delete m_sampler;
+    m_sampler = nullptr;
+}
+
+bool SystemMetrics::isRunning() const {
+    QMutexLocker locker(&m_controlMutex);
+    return m_sampler != nullptr;
+}
+
+SystemSnapshot SystemMetrics::latest() const {
+    QMutexLocker locker(&m_mutex);
+    return m_latest;
+}
+
+void SystemMetrics::resolveCgroupPaths() {
+    m_cgroupResolved = true;
+
+    char buffer[2048];
+    if (readProcFile("/proc/self/cgroup", buffer, sizeof(buffer)) <= 0) {
+        return;
+    }
+
+    // 每行 "hierarchy:controllers:path"；v2 为 "0::/path"
+    QByteArray v2Path;
+    QByteArray memoryPath;
+    QByteArray cpuPath;
+    for (const QByteArray& line : QByteArray(buffer).split('\n')) {
+        const int first = line.indexOf(':');
+        const int second = line.indexOf(':', first + 1);
+        if (first < 0 || second < 0) {
+            continue;
+        }
+        const QByteArray controllers = line.mid(first + 1, second - first - 1);
+        const QByteArray path = line.mid(second + 1);
+        if (controllers.isEmpty()) {
+            v2Path = path;
+        } else if (controllers.split(',').contains("memory")) {
+            memoryPath = path;
+        } else if (controllers.split(',').contains("cpu")) {
+            cpuPath = path;
+        }
+    }
+
+    // 容器内 /proc/self/cgroup 给出的是宿主视角路径，不存在时退回挂载点根目录
+    auto pick = [](const QByteArray& base, const QByteArray& path, const char* file) {
+        const QByteArray nested = base + path + '/' + file;
+        if (fileExists(nested)) {
+            return nested;
+        }
+        const QByteArray root = base + '/' + file;
+        return fileExists(root) ? root : QByteArray();
+    };
+
+    if (!memoryPath.isEmpty() || !cpuPath.isEmpty()) {
+        m_cgroup.memoryUsage = pick("/sys/fs/cgroup/memory", memoryPath, "memory.usage_in_bytes");
+        m_cgroup.memoryLimit = pick("/sys/fs/cgroup/memory", memoryPath, "memory.limit_in_bytes");
+        m_cgroup.cpuQuota = pick("/sys/fs/cgroup/cpu", cpuPath, "cpu.cfs_quota_us");
+        m_cgroup.cpuPeriod = pick("/sys/fs/cgroup/cpu", cpuPath, "cpu.cfs_period_us");
+    } else if (!v2Path.isEmpty()) {
+        m_cgroup.memoryUsage = pick("/sys/fs/cgroup", v2Path, "memory.current");
+        m_cgroup.memoryLimit = pick("/sys/fs/cgroup", v2Path, "memory.max");
+        m_cgroup.cpuMax = pick("/sys/fs/cgroup", v2Path, "cpu.max");
+    }
+
+    qDebug() << "SystemMetrics: cgroup memory:" << m_cgroup.memoryUsage
+             << "cpu:" << (m_cgroup.cpuMax.isEmpty() ? m_cgroup.cpuQuota : m_cgroup.cpuMax);
+}
+
+void SystemMetrics::sampleNow() {
+    QMutexLocker sampleLocker(&m_sampleMutex);
+
+    if (!m_cgroupResolved) {
+        resolveCgroupPaths();
+    }
+
+    SystemSnapshot snapshot;
+    snapshot.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    snapshot.cpuCount = qMax(1L, sysconf(_SC_NPROCESSORS_ONLN));
+
+    const qint64 nowNs = steadyNowNs();
+    const double elapsedSec = m_lastSampleNs > 0 ? (nowNs - m_lastSampleNs) / 1e9 : 0.0;
+    static const double ticksPerSec = qMax(1L, sysconf(_SC_CLK_TCK));
+    auto ticksToPercent = [&](quint64 deltaTicks) {
+        return elapsedSec > 0.0 ? deltaTicks * 100.0 / (ticksPerSec * elapsedSec) : 0.0;
+    };
+
+    char buffer[4096];
+
+    // 1. 进程 CPU
+    quint64 processTicks = 0;
+    if (readProcFile("/proc/self/stat", buffer, sizeof(buffer)) > 0 &&
+        parseStatTicks(buffer, &processTicks, nullptr)) {
+        if (processTicks >= m_lastProcessTicks) {
+            snapshot.processCpuPercent = ticksToPercent(processTicks - m_lastProcessTicks);
+        }
+        m_lastProcessTicks = processTicks;
+    }
+
+    // 2. 每线程 CPU：退出的线程从差分表中移除
+    QHash<int, quint64> threadTicks;
+    threadTicks.reserve(m_lastThreadTicks.size() + 4);
+    if (DIR* dir = opendir("/proc/self/task")) {
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+                continue;
+            }
+            char path[64];
+            snprintf(path, sizeof(path), "/proc/self/task/%s/stat", entry->d_name);
+
+            ThreadCpuUsage usage;
+            quint64 ticks = 0;
+            if (readProcFile(path, buffer, sizeof(buffer)) <= 0 ||
+                !parseStatTicks(buffer, &ticks, &usage.name)) {
+                continue;
+            }
+            usage.tid = atoi(entry->d_name);
+            const auto previous = m_lastThreadTicks.constFind(usage.tid);
+            if (previous != m_lastThreadTicks.constEnd() && ticks >= previous.value()) {
+                usage.cpuPercent = ticksToPercent(ticks - previous.value());
+            }
+            threadTicks.insert(usage.tid, ticks);
+            snapshot.threads.append(usage);
+        }
+        closedir(dir);
+    }
+    m_lastThreadTicks.swap(threadTicks);
+    std::sort(snapshot.threads.begin(), snapshot.threads.end(),
+              [](const ThreadCpuUsage& a, const ThreadCpuUsage& b) { return a.cpuPercent > b.cpuPercent; });
+
+    // 3. 整机 CPU："cpu user nice system idle iowait irq softirq steal ..."
+    if (readProcFile("/proc/stat", buffer, sizeof(buffer)) > 0 && strncmp(buffer, "cpu ", 4) == 0) {
+        quint64 values[8] = { 0 };
+        const char* p = buffer + 4;
+        for (int i = 0; i < 8; ++i) {
+            char* end = nullptr;
+            values[i] = strtoull(p, &end, 10);
+            p = end;
+        }
+        quint64 total = 0;
+        for (quint64 value : values) {
+            total += value;
+        }
+        const quint64 busy = total - values[3] - values[4];
+        if (m_lastSystemTotal > 0 && total > m_lastSystemTotal && busy >= m_lastSystemBusy) {
+            snapshot.systemCpuPercent = (busy - m_lastSystemBusy) * 100.0 / (total - m_lastSystemTotal);
+        }
+        m_lastSystemBusy = busy;
+        m_lastSystemTotal = total;
+    }
+
+    // 4. 负载
+    if (readProcFile("/proc/loadavg", buffer, sizeof(buffer)) > 0) {
+        sscanf(buffer, "%lf %lf %lf", &snapshot.load1, &snapshot.load5, &snapshot.load15);
+    }
+
+    // 5. 内存：smaps_rollup 同时给出 Rss 与 Pss
+    if (readProcFile("/proc/self/smaps_rollup", buffer, sizeof(buffer)) > 0) {
+        const qint64 rssKb = findKbField(buffer, "\nRss:");
+        const qint64 pssKb = findKbField(buffer, "\nPss:");
+        snapshot.rssMb = rssKb >= 0 ? rssKb / 1024.0 : -1.0;
+        snapshot.pssMb = pssKb >= 0 ? pssKb / 1024.0 : -1.0;
+    }
+    if (snapshot.rssMb < 0 && readProcFile("/proc/self/statm", buffer, sizeof(buffer)) > 0) {
+        unsigned long long sizePages = 0;
+        unsigned long long residentPages = 0;
+        if (sscanf(buffer, "%llu %llu", &sizePages, &residentPages) == 2) {
+            snapshot.rssMb = residentPages * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+        }
+    }
+
+    // 6. cgroup：上限为 "max" 或接近 LONG_MAX（v1 无限制）时视为不限制
+    const qint64 memoryUsage = readProcValue(m_cgroup.memoryUsage);
+    const qint64 memoryLimit = readProcValue(m_cgroup.memoryLimit);
+    snapshot.cgroupMemoryMb = memoryUsage >= 0 ? memoryUsage / (1024.0 * 1024.0) : -1.0;
+    if (memoryLimit > 0 && memoryLimit < (Q_INT64_C(1) << 60)) {
+        snapshot.cgroupMemoryLimitMb = memoryLimit / (1024.0 * 1024.0);
+    }
+
+    qint64 quota = -1;
+    qint64 period = -1;
+    if (!m_cgroup.cpuMax.isEmpty()) {
+        if (readProcFile(m_cgroup.cpuMax.constData(), buffer, sizeof(buffer)) > 0) {
+            long long q = 0;
+            long long pd = 0;
+            if (sscanf(buffer, "%lld %lld", &q, &pd) == 2) {
+                quota = q;
+                period = pd;
+            }
+        }
+    } else {
+        quota = readProcValue(m_cgroup.cpuQuota);
+        period = readProcValue(m_cgroup.cpuPeriod);
+    }
+    if (quota > 0 && period > 0) {
+        snapshot.cgroupCpuLimit = static_cast<double>(quota) / period;
+    }
+
+    m_lastSampleNs = nowNs;
+
+    SystemGauges& gauges = SystemGauges::instance();
+    gauges.processCpu->set(snapshot.processCpuPercent);
+    gauges.systemCpu->set(snapshot.systemCpuPercent);
+    gauges.hottestThreadCpu->set(snapshot.threads.isEmpty() ? 0.0 : snapshot.threads.first().cpuPercent);
+    gauges.rssMb->set(snapshot.rssMb);
+    gauges.pssMb->set(snapshot.pssMb);
+    gauges.load1->set(snapshot.load1);
+    gauges.cgroupMemoryMb->set(snapshot.cgroupMemoryMb);
+
+    QMutexLocker locker(&m_mutex);
+    m_latest = snapshot;
+}
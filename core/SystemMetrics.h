@@ -0,0 +1,93 @@
+#ifndef SYSTEMMETRICS_H
+#define SYSTEMMETRICS_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+
+// 单个线程的 CPU 占用（相对单核，满载一个核为 100%）
+struct ThreadCpuUsage {
+    int tid = 0;
+    QString name;           // /proc/self/task/<tid>/comm，QThread 启动时按 objectName/类名设置，最长 15 字节
+    double cpuPercent = 0.0;
+};
+
+// 一次采样的系统与进程资源状态；不可用的项为 -1
+struct SystemSnapshot {
+    qint64 timestampMs = 0;             // 0 表示尚未采样
+
+    int cpuCount = 1;
+    double processCpuPercent = 0.0;     // 本进程，相对单核（多核满载可超过 100）
+    double systemCpuPercent = 0.0;      // 整机，相对全部核
+    double load1 = 0.0;
+    double load5 = 0.0;
+    double load15 = 0.0;
+
+    double rssMb = -1.0;
+    double pssMb = -1.0;                // 需要 /proc/self/smaps_rollup（内核 4.14+）
+
+    double cgroupMemoryMb = -1.0;       // cgroup 内存用量
+    double cgroupMemoryLimitMb = -1.0;  // 无限制时为 -1
+    double cgroupCpuLimit = -1.0;       // CPU 配额折合核数，无限制时为 -1
+
+    QVector<ThreadCpuUsage> threads;    // 按 CPU 占用降序
+};
+
+// 🆕 系统指标采集：后台线程定时读取 /proc 与 cgroup，替代界面上的模拟数值
+// - 每线程 CPU：/proc/self/task/*/stat 的 utime+stime 差分，可直接看出哪个采集/AI 线程占满一个核
+// - 内存：/proc/self/smaps_rollup 的 Rss/Pss，缺失时退回 /proc/self/statm
+// - 负载：/proc/loadavg；整机 CPU：/proc/stat
+// - cgroup v1/v2 的内存用量、上限与 CPU 配额（路径在 start() 时解析一次）
+// 采样结果同时写入 MetricsRegistry 的 "sys." 指标；读取只拷贝最近一次快照，不触发文件读取
+class SystemMetrics {
+public:
+    static SystemMetrics& instance();
+
+    // 启动后台采样（重复调用只更新间隔）
+    void start(int intervalMs = 1000);
+    void stop();
+    bool isRunning() const;
+
+    // 立即在调用线程采样一次（测试与无后台线程时使用）
+    void sampleNow();
+
+    SystemSnapshot latest() const;
+
+private:
+    SystemMetrics();
+    ~SystemMetrics();
+
+    class Sampler;
+    friend class Sampler;
+
+    struct CgroupPaths {
+        QByteArray memoryUsage;
+        QByteArray memoryLimit;
+        QByteArray cpuMax;      // v2: "quota period"
+        QByteArray cpuQuota;    // v1: cfs_quota_us
+        QByteArray cpuPeriod;   // v1: cfs_period_us
+    };
+    void resolveCgroupPaths();
+
+    mutable QMutex m_mutex;     // 保护 m_latest
+    SystemSnapshot m_latest;
+
+    // 以下只在采样线程（或 sampleNow 的调用方）访问，由 m_sampleMutex 串行化
+    QMutex m_sampleMutex;
+    CgroupPaths m_cgroup;
+    bool m_cgroupResolved = false;
+    qint64 m_lastSampleNs = 0;
+    quint64 m_lastProcessTicks = 0;
+    quint64 m_lastSystemBusy = 0;
+    quint64 m_lastSystemTotal = 0;
+    QHash<int, quint64> m_lastThreadTicks;     // tid -> utime+stime
+
+    mutable QMutex m_controlMutex;  // 保护 start/stop
+    Sampler* m_sampler = nullptr;
+
+    Q_DISABLE_COPY(SystemMetrics)
+};
+
+#endif // SYSTEMMETRICS_H
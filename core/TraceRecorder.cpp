@@ -0,0 +1,207 @@
+#include "TraceRecorder.h"
+#include "FrameMeta.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+#include <QDebug>
+#include <cstdio>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct TraceRecorder::ThreadBuffer {
+    int tid = 0;
+    char name[17] = {};
+    quint32 generation = 0;
+    std::atomic<quint64> written{0};
+    Event events[kEventsPerThread];
+};
+
+namespace {
+
+// record 正在写入的线程数：导出前等待归零，避免读到写了一半的事件
+std::atomic<int> g_writersInFlight{0};
+
+void waitForWriters() {
+    while (g_writersInFlight.load() > 0) {
+        QThread::yieldCurrentThread();
+    }
+}
+
+// 线程名写入 JSON 前去掉引号和控制字符
+void appendSanitized(QByteArray& out, const char* text) {
+    for (const char* p = text; *p; ++p) {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        out.append((c < 0x20 || c == '"' || c == '\\') ? '_' : *p);
+    }
+}
+
+} // namespace
+
+TraceRecorder& TraceRecorder::instance() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::threadBuffer() {
+    static thread_local ThreadBuffer* t_buffer = nullptr;
+    if (t_buffer) {
+        return t_buffer;
+    }
+
+    // 每个线程首次写入时分配一次，线程退出后保留（其事件仍可导出）
+    ThreadBuffer* buffer = new ThreadBuffer;
+    buffer->tid = static_cast<int>(syscall(SYS_gettid));
+    prctl(PR_GET_NAME, buffer->name, 0, 0, 0);
+    buffer->generation = m_generation.load(std::memory_order_acquire);
+
+    QMutexLocker locker(&m_buffersMutex);
+    m_buffers.append(buffer);
+    t_buffer = buffer;
+    return buffer;
+}
+
+void TraceRecorder::start() {
+    // 线程缓冲在下次写入时发现代数变化后自行清空
+    m_generation.fetch_add(1, std::memory_order_acq_rel);
+    m_recording.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::stop() {
+    m_recording.store(false);
+}
+
+void TraceRecorder::record(const char* category, const char* name, qint64 startNs, qint64 endNs, qint64 arg) {
+    // 与 dumpChromeJson 的 stop()/等待构成对称握手，需要顺序一致
+    g_writersInFlight.fetch_add(1);
+    if (!m_recording.load()) {
+        g_writersInFlight.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    ThreadBuffer* buffer = threadBuffer();
+    const quint32 generation = m_generation.load(std::memory_order_relaxed);
+    if (buffer->generation != generation) {
+        buffer->generation = generation;
+        buffer->written.store(0, std::memory_order_relaxed);
+    }
+
+    const quint64 index = buffer->written.load(std::memory_order_relaxed);
+    Event& event = buffer->events[index % kEventsPerThread];
+    event.category = category;
+    event.name = name;
+    event.startNs = startNs;
+    event.durationNs = endNs - startNs;
+    event.arg = arg;
+    buffer->written.store(index + 1, std::memory_order_release);
+
+    g_writersInFlight.fetch_sub(1, std::memory_order_release);
+}
+
+QString TraceRecorder::defaultDumpPath() {
+    return QCoreApplication::applicationDirPath() + "/data/trace/trace-" +
+           QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".json";
+}
+
+QVector<TraceRecorder::Event> TraceRecorder::collect() {
+    stop();
+    waitForWriters();
+
+    const quint32 generation = m_generation.load(std::memory_order_acquire);
+    QVector<Event> events;
+    QMutexLocker locker(&m_buffersMutex);
+    for (const ThreadBuffer* buffer : m_buffers) {
+        if (buffer->generation != generation) {
+            continue;
+        }
+        const quint64 written = buffer->written.load(std::memory_order_acquire);
+        const quint64 first = written > kEventsPerThread ? written - kEventsPerThread : 0;
+        for (quint64 i = first; i < written; ++i) {
+            events.append(buffer->events[i % kEventsPerThread]);
+        }
+    }
+    return events;
+}
+
+bool TraceRecorder::dumpChromeJson(const QString& path) {
+    stop();
+    waitForWriters();
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "TraceRecorder: Failed to open" << path;
+        return false;
+    }
+
+    const quint32 generation = m_generation.load(std::memory_order_acquire);
+    const int pid = static_cast<int>(getpid());
+    QByteArray out;
+    out.reserve(1 << 20);
+    out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    char line[256];
+    snprintf(line, sizeof(line),
+             "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"SecureVision\"}}", pid);
+    out.append(line);
+
+    int eventCount = 0;
+    QMutexLocker locker(&m_buffersMutex);
+    for (const ThreadBuffer* buffer : m_buffers) {
+        if (buffer->generation != generation) {
+            continue;   // 本次录制中没有写入过
+        }
+
+        out.append(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":");
+        out.append(QByteArray::number(pid));
+        out.append(",\"tid\":");
+        out.append(QByteArray::number(buffer->tid));
+        out.append(",\"args\":{\"name\":\"");
+        appendSanitized(out, buffer->name);
+        out.append("\"}}");
+
+        const quint64 written = buffer->written.load(std::memory_order_acquire);
+        const quint64 first = written > kEventsPerThread ? written - kEventsPerThread : 0;
+        for (quint64 i = first; i < written; ++i) {
+            const Event& event = buffer->events[i % kEventsPerThread];
+            int n = snprintf(line, sizeof(line),
+                             ",\n{\"cat\":\"%s\",\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                             "\"ts\":%.3f,\"dur\":%.3f",
+                             event.category, event.name, pid, buffer->tid,
+                             event.startNs / 1000.0, event.durationNs / 1000.0);
+            if (event.arg >= 0 && n > 0 && n < static_cast<int>(sizeof(line))) {
+                n += snprintf(line + n, sizeof(line) - n, ",\"args\":{\"frame\":%lld}",
+                              static_cast<long long>(event.arg));
+            }
+            out.append(line);
+            out.append('}');
+            ++eventCount;
+        }
+    }
+    locker.unlock();
+
+    out.append("\n]}\n");
+    const bool ok = file.write(out) == out.size();
+    file.close();
+
+    qDebug() << "TraceRecorder:" << eventCount << "events written to" << path;
+    return ok;
+}
+
+// ========== TraceScope ==========
+TraceScope::TraceScope(const char* category, const char* name, qint64 arg)
+    : m_category(category)
+    , m_name(name)
+    , m_arg(arg)
+    , m_startNs(TraceRecorder::instance().isRecording() ? frameClockNs() : 0) {
+}
+
+TraceScope::~TraceScope() {
+    if (m_startNs > 0) {
+        TraceRecorder::instance().record(m_category, m_name, m_startNs, frameClockNs(), m_arg);
+    }
+}
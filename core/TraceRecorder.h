@@ -0,0 +1,90 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <QString>
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+
+// 🆕 流水线阶段追踪：导出 Chrome trace-event JSON（chrome://tracing 与 ui.perfetto.dev 均可直接打开）
+// - 作用域事件：SV_TRACE_SCOPE("ai", "face_detect") 在作用域结束时写入一条完整事件（"ph":"X"）
+// - 每个线程一个定长环形缓冲，写入只有本线程访问，不加锁、不分配；缓冲写满后覆盖最旧事件
+//   （缓冲在线程第一次录到事件时分配，之后常驻，约 320KB/线程）
+// - 未录制时每个作用域只有一次原子读；SV_ENABLE_TRACING=0 时宏整体编译掉
+// 名称与分类必须是字符串字面量（只保存指针）
+#ifndef SV_ENABLE_TRACING
+#define SV_ENABLE_TRACING 1
+#endif
+
+class TraceRecorder {
+public:
+    static const int kEventsPerThread = 8192;    // 30fps 下单线程约可保留 20 秒
+
+    struct Event {
+        const char* category;
+        const char* name;
+        qint64 startNs;         // frameClockNs 时间基准
+        qint64 durationNs;
+        qint64 arg;             // 附加参数（如帧序号），-1 表示无
+    };
+
+    static TraceRecorder& instance();
+
+    // 开始录制（清空此前的事件）；stop 后事件保留直到下次 start 或导出
+    void start();
+    void stop();
+    bool isRecording() const { return m_recording.load(std::memory_order_relaxed); }
+
+    // 写出 Chrome trace JSON；录制中调用会先停止录制
+    bool dumpChromeJson(const QString& path);
+
+    // 停止录制并取出本次录制的全部事件（每个线程内按时间先后），供基准程序按阶段汇总；继续录制需再次 start()
+    QVector<Event> collect();
+
+    // 默认导出路径：<应用目录>/data/trace/trace-<时间>.json
+    static QString defaultDumpPath();
+
+    // 作用域结束时调用
+    void record(const char* category, const char* name, qint64 startNs, qint64 endNs, qint64 arg);
+
+private:
+    TraceRecorder() = default;
+
+    struct ThreadBuffer;
+    ThreadBuffer* threadBuffer();
+
+    std::atomic<bool> m_recording{false};
+    std::atomic<quint32> m_generation{0};   // start() 时递增，线程缓冲据此惰性清空
+    QMutex m_buffersMutex;                  // 保护 m_buffers（只在线程首次写入和导出时加锁）
+    QVector<ThreadBuffer*> m_buffers;
+
+    Q_DISABLE_COPY(TraceRecorder)
+};
+
+// 作用域计时：构造时若未录制则不做任何事
+class TraceScope {
+public:
+    TraceScope(const char* category, const char* name, qint64 arg = -1);
+    ~TraceScope();
+
+private:
+    const char* m_category;
+    const char* m_name;
+    qint64 m_arg;
+    qint64 m_startNs;       // 0 表示未录制
+};
+
+#define SV_TRACE_CONCAT_INNER(a, b) a##b
+#define SV_TRACE_CONCAT(a, b) SV_TRACE_CONCAT_INNER(a, b)
+
+#if SV_ENABLE_TRACING
+#define SV_TRACE_SCOPE(category, name) \
+    TraceScope SV_TRACE_CONCAT(sv_trace_scope_, __LINE__)(category, name)
+#define SV_TRACE_SCOPE_ARG(category, name, arg) \
+    TraceScope SV_TRACE_CONCAT(sv_trace_scope_, __LINE__)(category, name, static_cast<qint64>(arg))
+#else
+#define SV_TRACE_SCOPE(category, name) do {} while (0)
+#define SV_TRACE_SCOPE_ARG(category, name, arg) do {} while (0)
+#endif
+
+#endif // TRACERECORDER_H
@@ -1,8 +1,13 @@
 ﻿#include "secureVision.h"
+#include "../core/Logging.h"
+#include "../core/SystemMetrics.h"
+#include "../core/TraceRecorder.h"
+#include "../core/FlightRecorder.h"
 #include <QtWidgets/QApplication>
 #include <QFont>
 #include <QGraphicsView>
 #include <QDebug>
+#include <QTimer>
 #include <QGraphicsScene>
 #include <QGraphicsProxyWidget>
 #include <rkmedia/rkmedia_api.h>
@@ -11,6 +16,22 @@ int main(int argc, char* argv[])
 {
     QApplication a(argc, argv);
 
+    // 🆕 异步日志：之后的 qDebug/svDebug 都经环形缓冲由后台线程输出
+    Logging::install();
+    // 🆕 后台采样 /proc 与 cgroup，供性能面板和 "sys." 指标使用
+    SystemMetrics::instance().start(1000);
+    // 🆕 常开飞行记录器：延迟超 SLO、采集卡顿或 kill -USR1 时把最近历史写到 data/flight/
+    FlightRecorder::instance().start();
+
+    // 🆕 SV_TRACE_SECONDS=N：启动后录制 N 秒流水线追踪并导出到 data/trace/
+    const int traceSeconds = qEnvironmentVariableIntValue("SV_TRACE_SECONDS");
+    if (traceSeconds > 0) {
+        TraceRecorder::instance().start();
+        QTimer::singleShot(traceSeconds * 1000, [] {
+            TraceRecorder::instance().dumpChromeJson(TraceRecorder::defaultDumpPath());
+        });
+    }
+
     // 设置全局字体为黑体
     QFont font("SimHei");  // 设置字体为黑体
     font.setStyleHint(QFont::SansSerif);
@@ -19,6 +40,9 @@ int main(int argc, char* argv[])
     int ret = RK_MPI_SYS_Init();
     if (ret != 0) {
         qDebug() << "RKMedia Init Fail, ret =" << ret;
+        FlightRecorder::instance().stop();
+        SystemMetrics::instance().stop();
+        Logging::shutdown();
         return 1;
     }  
 
@@ -44,5 +68,9 @@ int main(int argc, char* argv[])
 #endif
 
 
-    return a.exec();
+    const int exitCode = a.exec();
+    FlightRecorder::instance().stop();
+    SystemMetrics::instance().stop();
+    Logging::shutdown();
+    return exitCode;
 }
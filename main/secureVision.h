@@ -9,6 +9,7 @@
 #include "../capture/capturethread.h"
 #include "../capture/rtspthread.h"
 #include "../capture/usbcapturethread.h"
+#include "../capture/recordmanager.h"
 #include "../ai/aidetectionthread.h"
 #include "../ai/aitypes.h"
 
@@ -16,7 +17,12 @@ class MonitorListPage;
 class DetectionListPage;
 class VideoDetectionPage;
 class ShowMonitorPage;
+class AnomalyPage;
 class AudioDetectionPage;
+class RecordingSink;
+class SegmentIndex;
+class StorageManager;
+class EventStore;
 
 class SecureVision : public QMainWindow
 {
@@ -27,6 +33,7 @@ public:
     ~SecureVision() override;
 
     AIDetectionThread* getAIThread() const { return aiThread; }
+    RecordManager* getRecordManager() const { return recordManager; }
 
 private slots:  
     void handleDetectClick(int index);  // 处理检测页卡片点击
@@ -46,12 +53,22 @@ private:
     void createLeftNavigationBar();
     void setupGlobalStack();
     void setupThread();
+    void setupRecording();
+    void setupEventStore();
+    void setupSnapshots();
 
     CaptureThread* mipiThread = nullptr;
     RtspThread* rtspThread1 = nullptr;
     RtspThread* rtspThread2 = nullptr;
     USBCaptureThread* usbThread = nullptr;
 
+    // 🆕 录像：MIPI 帧 → RecordingSink（编码线程），RecordManager 决定何时开始/结束
+    RecordingSink* recordSink = nullptr;
+    RecordManager* recordManager = nullptr;
+    std::unique_ptr<SegmentIndex> segmentIndex;     // 🆕 分段录像索引（按时间定位）
+    StorageManager* storageManager = nullptr;       // 🆕 磁盘配额，循环覆盖最旧的分段
+    EventStore* eventStore = nullptr;               // 🆕 检测/录像事件库（异常信息页的数据来源）
+
     // UI Components
     QStackedWidget* globalStack;     // 全局堆栈：管理两种模式
     QWidget* normalModeWidget;       // 模式1：左侧导航栏 + rightStack
@@ -61,7 +78,7 @@ private:
     // Pages
     std::unique_ptr<MonitorListPage> monitorPage;
     std::unique_ptr<ShowMonitorPage> showMonitorPage;
-    std::unique_ptr<QWidget> anomalyPage;
+    std::unique_ptr<AnomalyPage> anomalyPage;
     std::unique_ptr<DetectionListPage> detectionPage;
     std::unique_ptr<VideoDetectionPage> videoPage;
     std::unique_ptr<AudioDetectionPage> audioPage;
@@ -0,0 +1,244 @@
+// tests/test_detectionresult_alloc.cpp
+// 逐帧检测结果路径的堆分配计数测试：
+// 用 AIDetectionThread 同一套结果池与攒批队列（DetectionResultPool + PendingFaceResults）走稳态流程
+// （借出结果 → 写入人脸 → 入批 → 按票据回填 → 统计 → 记为上次分析结果 → 界面侧拷贝 → 归还），
+// 统计期间全局 operator new 的调用次数必须为 0
+
+#include "aitypes.h"
+#include "detectionresultpool.h"
+#include "pendingfaceresults.h"
+#include "personnametable.h"
+#include <QDebug>
+#include <QVector>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+namespace {
+
+std::atomic<bool> g_counting(false);
+std::atomic<long> g_allocations(0);
+
+void* countedAlloc(std::size_t size)
+{
+    if (g_counting.load(std::memory_order_relaxed)) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+// 统计区间内的分配次数
+class AllocationScope
+{
+public:
+    AllocationScope() : m_start(g_allocations.load()) { g_counting = true; }
+    ~AllocationScope() { g_counting = false; }
+    long count() const { return g_allocations.load() - m_start; }
+
+private:
+    long m_start;
+};
+
+} // namespace
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+static_assert(std::is_trivially_copyable<DetectionResult>::value,
+              "DetectionResult must stay trivially copyable (queued signals and UI copies are memcpy)");
+
+namespace {
+
+const int kWarmupFrames = 100;
+const int kMeasuredFrames = 10000;
+
+// 模拟推理阶段的输出（属于推理阶段，不计入结果路径）
+QVector<FaceInfo> makeDetectedFaces(int count)
+{
+    QVector<FaceInfo> faces;
+    for (int i = 0; i < count; ++i) {
+        FaceInfo face;
+        face.bbox = QRect(40 * i, 30, 80, 96);
+        face.confidence = 0.9f - 0.01f * i;
+        faces.append(face);
+    }
+    return faces;
+}
+
+QVector<FaceInfo> makeRecognizedFaces(const QVector<FaceInfo>& detected)
+{
+    static const char* const kNames[] = { "Zhang San", "Li Si", "Wang Wu" };
+    QVector<FaceInfo> recognized = detected;
+    for (int i = 0; i < recognized.size(); ++i) {
+        if (i % 4 == 3) {
+            continue;   // 每四个留一个未知人脸
+        }
+        recognized[i].isRecognized = true;
+        recognized[i].personName = QString::fromLatin1(kNames[i % 3]);
+        recognized[i].faceId = i % 3 + 1;
+        recognized[i].similarity = 0.8f;
+    }
+    return recognized;
+}
+
+// 随结果保存的帧信息（AI 线程里是 QueuedFrame，这里只需来源号）
+struct FrameTag {
+    int sourceId = 0;
+};
+
+// 一帧的结果路径：检测 → 入批 → 识别回填 → 统计 → 记为上次分析结果 → 界面拷贝 → 归还
+// 同时挂起两帧（批里跨帧的人脸），再按识别返回顺序回填
+void processOneFrame(DetectionResultPool& pool,
+                     PendingFaceResults<FrameTag>& pending,
+                     const QVector<FaceInfo>& detected,
+                     const QVector<FaceInfo>& recognized,
+                     DetectionResult& lastAnalyzed,
+                     DetectionResult& uiCopy,
+                     int frame)
+{
+    const quint64 frameIds[2] = { quint64(frame) * 2 + 1, quint64(frame) * 2 + 2 };
+    for (quint64 frameId : frameIds) {
+        DetectionResult* result = pool.acquire();
+        result->timestampNs = monotonicNowNs();
+        result->sourceId = frame % 4;
+        result->hasMotion = (frame % 3) == 0;
+        result->motionArea = QRect(10, 10, 200 + frame % 50, 120);
+        result->setFaces(detected);
+
+        FrameTag tag;
+        tag.sourceId = result->sourceId;
+        pending.add(frameId, tag, result, detected.size());
+    }
+
+    // 识别结果按批返回：两帧的人脸交错回填
+    for (int i = 0; i < recognized.size(); ++i) {
+        for (quint64 frameId : frameIds) {
+            pending.fill(frameId, i, recognized[i]);
+        }
+    }
+
+    // 与 AIDetectionThread::flushFaceBatch 相同：统计 → 记为上次分析结果 → 发出（界面拷贝）
+    pending.takeCompleted([&lastAnalyzed, &uiCopy](FrameTag&, DetectionResult& result) {
+        result.updateFaceCounts();
+        lastAnalyzed = result;
+        uiCopy = lastAnalyzed;
+    });
+}
+
+bool testSteadyStateIsAllocationFree()
+{
+    qDebug() << "========== Testing Steady-State Allocations ==========";
+
+    DetectionResultPool pool(4);
+    PendingFaceResults<FrameTag> pending(pool);
+    const QVector<FaceInfo> detected = makeDetectedFaces(5);
+    const QVector<FaceInfo> recognized = makeRecognizedFaces(detected);
+    DetectionResult lastAnalyzed;
+    DetectionResult uiCopy;
+
+    // 预热：人名首次驻留会分配
+    for (int i = 0; i < kWarmupFrames; ++i) {
+        processOneFrame(pool, pending, detected, recognized, lastAnalyzed, uiCopy, i);
+    }
+
+    long allocations = 0;
+    {
+        AllocationScope scope;
+        for (int i = 0; i < kMeasuredFrames; ++i) {
+            processOneFrame(pool, pending, detected, recognized, lastAnalyzed, uiCopy, i);
+        }
+        allocations = scope.count();
+    }
+
+    qDebug() << "Allocations over" << kMeasuredFrames << "frames:" << allocations;
+    qDebug() << "Pool capacity:" << pool.capacity() << "grow count:" << pool.growCount();
+
+    bool ok = allocations == 0 && pool.growCount() == 0 && pool.inUse() == 0 && pending.isEmpty();
+    ok = ok && uiCopy.faceCount == 5 && uiCopy.recognizedFaceCount == 4 && uiCopy.unknownFaceCount == 1;
+    qDebug() << "Steady state:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testNameInterning()
+{
+    qDebug() << "========== Testing Name Interning ==========";
+
+    PersonNameTable& table = PersonNameTable::instance();
+    const quint16 a = table.intern("Zhao Liu");
+    const quint16 b = table.intern(QString("Zhao") + " Liu");
+    const quint16 c = table.intern("Sun Qi");
+
+    bool ok = a != PersonNameTable::kNoName && a == b && a != c;
+    ok = ok && table.name(a) == "Zhao Liu" && table.name(c) == "Sun Qi";
+    ok = ok && table.intern(QString()) == PersonNameTable::kNoName;
+    ok = ok && table.name(PersonNameTable::kNoName).isEmpty();
+
+    // 经结果往返后人名保持一致；未识别人脸不带人名
+    FaceInfo known;
+    known.isRecognized = true;
+    known.personName = "Zhao Liu";
+    FaceInfo unknown;
+    unknown.personName = "ignored";
+
+    DetectionResult result;
+    result.appendFace(known);
+    result.appendFace(unknown);
+    ok = ok && result.personName(0) == "Zhao Liu" && result.faceInfo(0).personName == "Zhao Liu";
+    ok = ok && result.personName(1).isEmpty() && !result.faceInfo(1).isRecognized;
+
+    qDebug() << "Name interning:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testCapacityAndTimestamps()
+{
+    qDebug() << "========== Testing Capacity And Timestamps ==========";
+
+    DetectionResult result;
+    bool ok = !result.isValid() && result.wallTime().isNull();
+
+    result.setFaces(makeDetectedFaces(DetectionResult::kMaxFaces + 3));
+    ok = ok && result.faceCount == DetectionResult::kMaxFaces && result.droppedFaceCount == 3;
+
+    // 越界回填被忽略
+    FaceInfo face;
+    face.isRecognized = true;
+    face.personName = "Zhang San";
+    result.setFace(DetectionResult::kMaxFaces + 1, face);
+    ok = ok && result.faceCount == DetectionResult::kMaxFaces;
+
+    const qint64 first = monotonicNowNs();
+    const qint64 second = monotonicNowNs();
+    result.timestampNs = second;
+    ok = ok && first > 0 && second >= first && result.isValid();
+    ok = ok && qAbs(result.wallTime().msecsTo(QDateTime::currentDateTime())) < 1000;
+
+    result.clear();
+    ok = ok && result.faceCount == 0 && !result.isValid();
+
+    qDebug() << "Capacity and timestamps:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    int failures = 0;
+    failures += testNameInterning() ? 0 : 1;
+    failures += testCapacityAndTimestamps() ? 0 : 1;
+    failures += testSteadyStateIsAllocationFree() ? 0 : 1;
+
+    qDebug() << (failures == 0 ? "✅ All detection result tests passed"
+                               : "❌ Detection result tests failed:") << failures;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,433 @@
+// tests/test_eventstore.cpp
+// 事件库：跨几个月、多路来源批量写入后，游标翻页按 (时间, id) 严格倒序、不重不漏，
+// 按来源过滤的条数正确，翻到最后一页的查询仍在延迟上限内；检测结果合并与过期清理；
+// 录像开始后回填预录阶段的事件（已写入与仍在队列中的都关联上）；
+// 约 100 万条的库上，翻到深处的一页与第一页耗时相当（游标直接作为索引区间起点）
+//
+// 用法: test_eventstore [事件数=20000] [单页p99上限ms=20] [深翻页库事件数=1000000]
+
+#include "eventstore.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+const int kSources = 4;
+const int kPageSize = 100;
+
+struct Dataset {
+    qint64 firstMs = 0;
+    qint64 lastMs = 0;
+    int perSource[kSources] = {0, 0, 0, 0};
+    int total = 0;
+};
+
+// 90 天内随机时刻，约 1/10 的事件与前一条同一毫秒（验证同时间戳按 id 翻页）
+Dataset fillStore(EventStore& store, int count)
+{
+    Dataset data;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<qint64> offset(0, 90LL * 24 * 3600 * 1000);
+    std::uniform_int_distribution<int> source(0, kSources - 1);
+    std::uniform_int_distribution<int> trigger(1, 6);
+
+    data.firstMs = QDateTime(QDate(2026, 1, 1), QTime(0, 0)).toMSecsSinceEpoch();
+    data.lastMs = data.firstMs;
+    qint64 previous = data.firstMs;
+    for (int i = 0; i < count; ++i) {
+        StoredEvent event;
+        event.timeMs = (i % 10 == 0) ? previous : data.firstMs + offset(rng);
+        event.sourceId = source(rng);
+        event.trigger = static_cast<RecordTrigger>(trigger(rng));
+        event.faceCount = i % 3;
+        for (int f = 0; f < event.faceCount; ++f) {
+            event.faceIds.append(f == 0 ? i : -1);
+        }
+        event.motionArea = QRect(i % 640, i % 480, 32, 32);
+        store.append(event);
+
+        previous = event.timeMs;
+        data.lastMs = qMax(data.lastMs, event.timeMs);
+        data.perSource[event.sourceId]++;
+        data.total++;
+    }
+    store.flush();
+    return data;
+}
+
+// 从头翻到尾：检查顺序与重复，返回总条数
+int walkPages(EventStore& store, int sourceId, bool* ordered, QVector<double>* pageMs)
+{
+    EventQuery request;
+    request.sourceId = sourceId;
+    request.limit = kPageSize;
+
+    QSet<qint64> seen;
+    qint64 lastMs = std::numeric_limits<qint64>::max();
+    qint64 lastId = std::numeric_limits<qint64>::max();
+    int total = 0;
+    *ordered = true;
+    while (true) {
+        QElapsedTimer timer;
+        timer.start();
+        const EventPage page = store.query(request);
+        if (pageMs) {
+            pageMs->append(timer.nsecsElapsed() / 1e6);
+        }
+
+        for (const StoredEvent& event : page.events) {
+            const bool descending = event.timeMs < lastMs || (event.timeMs == lastMs && event.id < lastId);
+            const bool sourceOk = sourceId < 0 || event.sourceId == sourceId;
+            if (!descending || !sourceOk || seen.contains(event.id)) {
+                *ordered = false;
+            }
+            seen.insert(event.id);
+            lastMs = event.timeMs;
+            lastId = event.id;
+        }
+        total += page.events.size();
+
+        if (!page.hasMore) {
+            break;
+        }
+        request.beforeMs = page.nextBeforeMs;
+        request.beforeId = page.nextBeforeId;
+    }
+    return total;
+}
+
+bool testPagedWalk(const QString& dir, int count, double p99LimitMs)
+{
+    qDebug() << "========== Testing Paged Walk ==========";
+
+    EventStore store;
+    EventStore::Options options;
+    options.maxPending = count + 1;     // 本用例不允许丢弃
+    store.setOptions(options);
+    if (!store.open(dir + "/events.db")) {
+        qDebug() << "Failed to open event store";
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const Dataset data = fillStore(store, count);
+    const qint64 insertMs = timer.elapsed();
+
+    bool ordered = false;
+    QVector<double> pageMs;
+    const int all = walkPages(store, -1, &ordered, &pageMs);
+    bool allOrdered = ordered;
+
+    bool perSourceOk = true;
+    for (int source = 0; source < kSources; ++source) {
+        const int n = walkPages(store, source, &ordered, &pageMs);
+        perSourceOk = perSourceOk && ordered && n == data.perSource[source];
+    }
+
+    // 时间窗口过滤：只取第一个月
+    EventQuery window;
+    window.fromMs = data.firstMs;
+    window.toMs = data.firstMs + 31LL * 24 * 3600 * 1000 - 1;
+    window.limit = count;
+    const EventPage firstMonth = store.query(window);
+    bool windowOk = !firstMonth.hasMore && !firstMonth.events.isEmpty();
+    for (const StoredEvent& event : firstMonth.events) {
+        windowOk = windowOk && event.timeMs >= window.fromMs && event.timeMs <= window.toMs;
+    }
+
+    // 翻页与事件字段往返
+    EventQuery newest;
+    newest.limit = 1;
+    const EventPage head = store.query(newest);
+    const bool fieldsOk = head.events.size() == 1 && head.events[0].timeMs == data.lastMs
+        && head.events[0].faceIds.size() == head.events[0].faceCount
+        && head.events[0].motionArea.width() == 32;
+
+    std::sort(pageMs.begin(), pageMs.end());
+    const double p99 = pageMs.isEmpty() ? 0.0 : pageMs[qMin(pageMs.size() - 1, int(pageMs.size() * 0.99))];
+
+    const bool ok = all == data.total && allOrdered && perSourceOk && windowOk && fieldsOk
+        && p99 <= p99LimitMs;
+    qDebug() << "Events:" << data.total << "inserted in" << insertMs << "ms, walked:" << all
+             << "pages:" << pageMs.size() << "page p99:" << p99 << "ms (limit" << p99LimitMs << ")";
+    qDebug() << "Ordered:" << allOrdered << "per source:" << perSourceOk
+             << "first month:" << firstMonth.events.size() << "fields:" << fieldsOk;
+    qDebug() << "Paged walk:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+DetectionResult makeResult(qint64 timestampNs, int sourceId, int faceId)
+{
+    DetectionResult result;
+    result.timestampNs = timestampNs;
+    result.sourceId = sourceId;
+    result.hasMotion = true;
+    result.motionArea = QRect(10, 20, 30, 40);
+    if (faceId >= 0) {
+        result.faceCount = 1;
+        result.faces[0].faceId = faceId;
+        result.faces[0].isRecognized = true;
+        result.recognizedFaceCount = 1;
+    }
+    return result;
+}
+
+// 同一页查询重复执行取中位数耗时（毫秒）
+double medianPageMs(EventStore& store, const EventQuery& request, int* rows)
+{
+    QVector<double> samples;
+    for (int i = 0; i < 21; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        const EventPage page = store.query(request);
+        samples.append(timer.nsecsElapsed() / 1e6);
+        *rows = page.events.size();
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+bool testDeepPageCost(const QString& dir, int count)
+{
+    qDebug() << "========== Testing Deep Page Cost ==========";
+
+    EventStore store;
+    EventStore::Options options;
+    options.maxPending = count + 1;
+    options.batchSize = 50000;
+    store.setOptions(options);
+    if (!store.open(dir + "/deep.db")) {
+        qDebug() << "Failed to open event store";
+        return false;
+    }
+
+    // 时间递增、每 3 条同一毫秒；新库 id 从 1 开始按写入顺序分配，第 i 条的游标可直接算出
+    const qint64 baseMs = QDateTime(QDate(2026, 1, 1), QTime(0, 0)).toMSecsSinceEpoch();
+    QElapsedTimer fillTimer;
+    fillTimer.start();
+    for (int i = 0; i < count; ++i) {
+        StoredEvent event;
+        event.timeMs = baseMs + i / 3;
+        event.sourceId = i % kSources;
+        event.trigger = RecordTrigger::MotionDetected;
+        store.append(event);
+        if ((i + 1) % options.batchSize == 0) {
+            store.flush();
+        }
+    }
+    store.flush();
+    const qint64 fillMs = fillTimer.elapsed();
+
+    EventQuery first;
+    first.limit = kPageSize;
+    EventQuery deep = first;
+    const int deepIndex = count / 10;               // 距最新约 90% 的位置
+    deep.beforeMs = baseMs + deepIndex / 3;
+    deep.beforeId = deepIndex + 1;
+
+    EventQuery firstBySource = first;
+    firstBySource.sourceId = 1;
+    EventQuery deepBySource = deep;
+    deepBySource.sourceId = 1;
+
+    int firstRows = 0;
+    int deepRows = 0;
+    int firstSourceRows = 0;
+    int deepSourceRows = 0;
+    const double firstMs = medianPageMs(store, first, &firstRows);
+    const double deepMs = medianPageMs(store, deep, &deepRows);
+    const double firstSourceMs = medianPageMs(store, firstBySource, &firstSourceRows);
+    const double deepSourceMs = medianPageMs(store, deepBySource, &deepSourceRows);
+
+    // 深页与第一页同量级：允许 5 倍加 1ms 的抖动（逐行跳过已翻过的行时会慢两个数量级）
+    const auto comparable = [](double deepPageMs, double firstPageMs) {
+        return deepPageMs <= firstPageMs * 5.0 + 1.0;
+    };
+    const bool rowsOk = firstRows == kPageSize && deepRows == kPageSize
+        && firstSourceRows == kPageSize && deepSourceRows == kPageSize;
+    const bool ok = rowsOk && comparable(deepMs, firstMs) && comparable(deepSourceMs, firstSourceMs);
+
+    qDebug() << "Events:" << count << "filled in" << fillMs << "ms";
+    qDebug() << "First page:" << firstMs << "ms, deep page:" << deepMs << "ms; by source:"
+             << firstSourceMs << "ms /" << deepSourceMs << "ms";
+    qDebug() << "Deep page cost:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testCoalesceAndPurge(const QString& dir)
+{
+    qDebug() << "========== Testing Coalesce And Purge ==========";
+
+    EventStore store;
+    EventStore::Options options;
+    options.coalesceMs = 2000;
+    store.setOptions(options);
+    if (!store.open(dir + "/coalesce.db")) {
+        qDebug() << "Failed to open event store";
+        return false;
+    }
+
+    const qint64 base = 1000000000LL;   // 单调时钟纳秒
+    const qint64 msNs = 1000000LL;
+    int accepted = 0;
+
+    // 同一人连续 1.5 秒、每 100ms 一帧：只记 1 条
+    for (int i = 0; i < 15; ++i) {
+        accepted += store.recordDetection(makeResult(base + i * 100 * msNs, 0, 7), 123) ? 1 : 0;
+    }
+    // 换人：立即记录
+    accepted += store.recordDetection(makeResult(base + 1500 * msNs, 0, 8)) ? 1 : 0;
+    // 另一路来源同一人：各自独立
+    accepted += store.recordDetection(makeResult(base + 1500 * msNs, 1, 8)) ? 1 : 0;
+    // 超过合并间隔：再记一条
+    accepted += store.recordDetection(makeResult(base + 4000 * msNs, 0, 8)) ? 1 : 0;
+    // 无运动无人脸：忽略
+    DetectionResult idle = makeResult(base + 4100 * msNs, 0, -1);
+    idle.hasMotion = false;
+    accepted += store.recordDetection(idle) ? 1 : 0;
+    store.flush();
+
+    EventQuery all;
+    all.limit = 100;
+    const EventPage page = store.query(all);
+    bool fieldsOk = page.events.size() == 4;
+    if (fieldsOk) {
+        const StoredEvent& oldest = page.events.last();
+        fieldsOk = oldest.trigger == RecordTrigger::KnownFaceDetected && oldest.recordingStartMs == 123
+            && oldest.faceIds.size() == 1 && oldest.faceIds[0] == 7;
+    }
+
+    // 清理：删掉第二条之前的事件
+    const qint64 cutoff = page.events.size() == 4 ? page.events[2].timeMs : 0;
+    store.purgeBefore(cutoff);
+    store.flush();
+    const EventPage afterPurge = store.query(all);
+    bool purgeOk = !afterPurge.events.isEmpty();
+    for (const StoredEvent& event : afterPurge.events) {
+        purgeOk = purgeOk && event.timeMs >= cutoff;
+    }
+
+    store.close();
+    const bool closedOk = !store.isOpen() && store.query(all).events.isEmpty();
+
+    const bool ok = accepted == 4 && fieldsOk && purgeOk && closedOk;
+    qDebug() << "Accepted:" << accepted << "stored:" << page.events.size()
+             << "after purge:" << afterPurge.events.size();
+    qDebug() << "Coalesce and purge:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testLinkRecording(const QString& dir)
+{
+    qDebug() << "========== Testing Recording Link ==========";
+
+    EventStore store;
+    if (!store.open(dir + "/link.db")) {
+        qDebug() << "Failed to open event store";
+        return false;
+    }
+
+    const qint64 startMs = 1700000010000LL;
+    const auto makeEvent = [](qint64 timeMs, qint64 recordingStartMs) {
+        StoredEvent event;
+        event.timeMs = timeMs;
+        event.trigger = RecordTrigger::MotionDetected;
+        event.recordingStartMs = recordingStartMs;
+        return event;
+    };
+
+    // 窗口外的旧事件、属于上一段录像的事件、已写入的触发事件
+    store.append(makeEvent(startMs - 10000, 0));
+    store.append(makeEvent(startMs - 1800, 555));
+    store.append(makeEvent(startMs - 1500, 0));
+    store.flush();
+    // 仍在队列中的预录阶段事件
+    store.append(makeEvent(startMs - 300, 0));
+
+    store.linkRecording(startMs - 2000, startMs);
+    store.flush();
+
+    EventQuery all;
+    all.limit = 100;
+    const EventPage page = store.query(all);
+    QHash<qint64, qint64> linked;
+    for (const StoredEvent& event : page.events) {
+        linked.insert(event.timeMs, event.recordingStartMs);
+    }
+
+    const bool ok = page.events.size() == 4
+        && linked.value(startMs - 10000, -1) == 0
+        && linked.value(startMs - 1800, -1) == 555
+        && linked.value(startMs - 1500, -1) == startMs
+        && linked.value(startMs - 300, -1) == startMs;
+    qDebug() << "Linked:" << linked.value(startMs - 1500) << linked.value(startMs - 300)
+             << "untouched:" << linked.value(startMs - 10000) << linked.value(startMs - 1800);
+    qDebug() << "Recording link:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testReopen(const QString& dir)
+{
+    qDebug() << "========== Testing Reopen ==========";
+
+    const QString path = dir + "/reopen.db";
+    {
+        EventStore store;
+        store.open(path);
+        for (int i = 0; i < 10; ++i) {
+            StoredEvent event;
+            event.timeMs = 1000 + i;
+            event.trigger = RecordTrigger::MotionDetected;
+            store.append(event);
+        }
+        // 不调用 flush：close 必须写完队列
+    }
+
+    EventStore store;
+    store.open(path);
+    EventQuery all;
+    all.limit = 100;
+    const EventPage page = store.query(all);
+
+    const bool ok = page.events.size() == 10 && page.events.first().timeMs == 1009;
+    qDebug() << "Events after reopen:" << page.events.size();
+    qDebug() << "Reopen:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const int count = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const double p99LimitMs = argc > 2 ? std::atof(argv[2]) : 20.0;
+    const int deepCount = argc > 3 ? std::atoi(argv[3]) : 1000000;
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qDebug() << "❌ Failed to create temporary directory";
+        return 1;
+    }
+
+    int failures = 0;
+    failures += testPagedWalk(dir.path(), count, p99LimitMs) ? 0 : 1;
+    failures += testDeepPageCost(dir.path(), deepCount) ? 0 : 1;
+    failures += testCoalesceAndPurge(dir.path()) ? 0 : 1;
+    failures += testLinkRecording(dir.path()) ? 0 : 1;
+    failures += testReopen(dir.path()) ? 0 : 1;
+
+    qDebug() << (failures == 0 ? "✅ All event store tests passed"
+                               : "❌ Event store tests failed:") << failures;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+// tests/test_facedatabase.cpp
+// FaceDatabase 基本功能：注册（含同名追加模板）、查询、特征匹配与未知人脸拒识、识别统计、
+// 注册后人脸库增量更新、推迟写出的快照在重新打开时可直接映射；数据库放在临时目录
+
+#include "facedatabase.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QByteArray>
+#include <QTemporaryDir>
+
+namespace {
+
+// 按人名生成确定的 512 维特征（分量在 0~1 之间，不同人之间余弦相似度约 0.75）
+QByteArray createMockFaceFeature(const QString& personName)
+{
+    QByteArray feature;
+    feature.resize(512 * sizeof(float));
+
+    float* data = reinterpret_cast<float*>(feature.data());
+    srand(qHash(personName));
+    for (int i = 0; i < 512; ++i) {
+        data[i] = (rand() % 1000) / 1000.0f;
+    }
+    return feature;
+}
+
+bool testDatabaseBasicOperations(const QString& dir)
+{
+    qDebug() << "========== Testing Basic Database Operations ==========";
+
+    FaceDatabase db;
+    if (!db.initialize(dir + "/test_face.db")) {
+        qDebug() << "❌ Database initialization failed";
+        return false;
+    }
+
+    const bool result1 = db.addFaceRecord("Zhang San", "/path/to/zhangsan.jpg",
+                                          createMockFaceFeature("Zhang San"), "Employee");
+    const bool result2 = db.addFaceRecord("Li Si", "/path/to/lisi.jpg",
+                                          createMockFaceFeature("Li Si"), "Visitor");
+
+    // 同名再次注册：追加模板而不是新建人员
+    const bool result3 = db.addFaceRecord("Zhang San", "/path/to/zhangsan2.jpg",
+                                          createMockFaceFeature("Zhang San (profile)"), "Second pose", 0.8f);
+    int zhangSanTemplates = 0;
+    for (const FaceRecord& record : db.getAllFaceRecords()) {
+        if (record.name == "Zhang San") {
+            zhangSanTemplates = record.templateCount;
+        }
+    }
+
+    const int totalCount = db.getTotalFaceCount();
+    const bool exists1 = db.faceExists("Zhang San");
+    const bool exists2 = db.faceExists("Wang Wu");
+
+    // 无效特征必须被拒绝
+    const bool rejected = !db.addFaceRecord("Broken", "/broken.jpg", QByteArray(16, '\0'));
+
+    const bool ok = result1 && result2 && result3 && zhangSanTemplates == 2 &&
+                    exists1 && !exists2 && totalCount == 2 && rejected;
+
+    qDebug() << "Persons:" << totalCount << "Zhang San templates:" << zhangSanTemplates;
+    qDebug() << "Basic operations:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testFeatureMatching(const QString& dir)
+{
+    qDebug() << "========== Testing Feature Matching ==========";
+
+    FaceDatabase db;
+    if (!db.initialize(dir + "/test_matching.db")) {
+        qDebug() << "❌ Database initialization failed";
+        return false;
+    }
+
+    const QByteArray featureAlice = createMockFaceFeature("Alice");
+    db.addFaceRecord("Alice", "/alice.jpg", featureAlice);
+    db.addFaceRecord("Bob", "/bob.jpg", createMockFaceFeature("Bob"));
+    db.addFaceRecord("Charlie", "/charlie.jpg", createMockFaceFeature("Charlie"));
+
+    // 精确匹配：返回 Alice，人名直接取自快照
+    float similarity = 0.0f;
+    QString name;
+    const int matchId = db.findBestMatch(featureAlice, similarity, 0.5f, &name);
+    const bool exactOk = matchId > 0 && name == "Alice" && similarity > 0.99f &&
+                         db.getFaceRecord(matchId).name == "Alice";
+
+    // 未知人脸在高阈值下拒识
+    const int unknownId = db.findBestMatch(createMockFaceFeature("Unknown_Person"), similarity, 0.9f);
+
+    // 命中后识别次数加一
+    const int originalCount = exactOk ? db.getFaceRecord(matchId).recognitionCount : 0;
+    db.incrementRecognitionCount(matchId);
+    const int newCount = db.getFaceRecord(matchId).recognitionCount;
+
+    const bool ok = exactOk && unknownId == -1 && newCount == originalCount + 1;
+
+    qDebug() << "Exact match id:" << matchId << name << "unknown id:" << unknownId
+             << "recognition count:" << originalCount << "->" << newCount;
+    qDebug() << "Feature matching:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testGalleryRebuildAfterEnrollment(const QString& dir)
+{
+    qDebug() << "========== Testing Gallery Rebuild After Enrollment ==========";
+
+    const QString path = dir + "/test_rebuild.db";
+    int before = 0;
+    int after = 0;
+    QString name;
+    bool incrementalOk = false;
+    {
+        FaceDatabase db;
+        if (!db.initialize(path)) {
+            qDebug() << "❌ Database initialization failed";
+            return false;
+        }
+
+        db.addFaceRecord("Alice", "/alice.jpg", createMockFaceFeature("Alice"));
+
+        // 先匹配一次，让快照缓存下来
+        float similarity = 0.0f;
+        const QByteArray featureDave = createMockFaceFeature("Dave");
+        before = db.findBestMatch(featureDave, similarity, 0.99f);
+
+        // 新注册的人员必须在下一次匹配时可见；已有人员追加模板后模板数随之更新
+        db.addFaceRecord("Dave", "/dave.jpg", featureDave);
+        after = db.findBestMatch(featureDave, similarity, 0.99f, &name);
+        db.addFaceRecord("Alice", "/alice2.jpg", createMockFaceFeature("Alice (profile)"), QString(), 0.8f);
+
+        const QSharedPointer<const FaceGallery> gallery = db.gallery();
+        incrementalOk = gallery && gallery->personCount() == 2 && gallery->templateCount() == 3
+            && db.findBestMatch(createMockFaceFeature("Alice"), similarity, 0.99f) > 0;
+    }
+
+    // 析构时写出推迟的快照：重新打开直接映射，内容与注册后的人脸库一致
+    FaceDatabase reopened;
+    const bool reopenOk = reopened.initialize(path);
+    const QSharedPointer<const FaceGallery> mapped = reopened.gallery();
+    const bool snapshotOk = reopenOk && mapped && mapped->isMapped()
+        && mapped->personCount() == 2 && mapped->templateCount() == 3;
+
+    const bool ok = before == -1 && after > 0 && name == "Dave" && incrementalOk && snapshotOk;
+
+    qDebug() << "Before enrollment:" << before << "after:" << after << name
+             << "incremental:" << incrementalOk << "snapshot:" << snapshotOk;
+    qDebug() << "Gallery rebuild:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qDebug() << "❌ Failed to create temporary directory";
+        return 1;
+    }
+
+    int failures = 0;
+    failures += testDatabaseBasicOperations(dir.path()) ? 0 : 1;
+    failures += testFeatureMatching(dir.path()) ? 0 : 1;
+    failures += testGalleryRebuildAfterEnrollment(dir.path()) ? 0 : 1;
+
+    qDebug() << (failures == 0 ? "✅ All face database tests passed"
+                               : "❌ Face database tests failed:") << failures;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,276 @@
+// tests/test_facedatabase_scale.cpp
+// FaceDatabase 规模与并发：批量注册 N 人后逐一可匹配、匹配延迟 p99 不超过上限；
+// 多个线程持续 findBestMatch 的同时所在线程 addFaceRecord，结果不串人、不死锁，
+// 匹配线程不碰数据库连接，识别统计排队回所在线程后一条不丢
+//
+// 用法: test_facedatabase_scale [注册人数=10000] [p99上限ms=10+0.005*人数]
+
+#include "facedatabase.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int kQueries = 200;
+const int kConcurrentBase = 2000;       // 并发用例的初始人数
+const int kConcurrentWrites = 100;      // 并发期间新注册的人数
+const int kReaderThreads = 4;
+const int kDeadlockTimeoutSec = 120;
+
+// 第 index 个人的特征：由下标确定，无需保存；正态分布使不同人之间相似度接近 0
+QByteArray personFeature(int index)
+{
+    std::mt19937 rng(index + 1);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    QByteArray feature(512 * sizeof(float), Qt::Uninitialized);
+    float* data = reinterpret_cast<float*>(feature.data());
+    for (int i = 0; i < 512; ++i) {
+        data[i] = dist(rng);
+    }
+    return feature;
+}
+
+QString personName(int index)
+{
+    return QString("Person_%1").arg(index, 7, 10, QChar('0'));
+}
+
+bool enroll(FaceDatabase& db, int first, int count)
+{
+    QVector<FaceEnrollment> batch;
+    batch.reserve(count);
+    for (int i = first; i < first + count; ++i) {
+        FaceEnrollment enrollment;
+        enrollment.name = personName(i);
+        enrollment.imagePath = QString("faces/%1.jpg").arg(enrollment.name);
+        enrollment.feature = personFeature(i);
+        batch.append(enrollment);
+    }
+    return db.addFaceRecords(batch) == count;
+}
+
+double percentile(QVector<double> values, double p)
+{
+    std::sort(values.begin(), values.end());
+    const int index = qBound(0, int(p * (values.size() - 1) + 0.5), values.size() - 1);
+    return values[index];
+}
+
+bool testBulkEnrollment(FaceDatabase& db, int persons)
+{
+    qDebug() << "========== Testing Bulk Enrollment ==========";
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool enrolled = enroll(db, 0, persons);
+    const qint64 enrollMs = timer.elapsed();
+
+    timer.restart();
+    const QSharedPointer<const FaceGallery> gallery = db.gallery();
+    const qint64 galleryMs = timer.elapsed();
+
+    const bool ok = enrolled && db.getTotalFaceCount() == persons &&
+                    gallery && gallery->personCount() == persons && gallery->templateCount() == persons;
+
+    qDebug() << "Enrolled" << persons << "persons in" << enrollMs << "ms, gallery built in" << galleryMs << "ms";
+    qDebug() << "Bulk enrollment:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testMatchLatency(FaceDatabase& db, int persons, double ceilingMs)
+{
+    qDebug() << "========== Testing Match Correctness and Latency ==========";
+
+    QVector<double> latencies;
+    latencies.reserve(kQueries);
+    int wrong = 0;
+
+    const int stride = qMax(1, persons / kQueries);
+    for (int q = 0; q < kQueries; ++q) {
+        const int index = (q * stride) % persons;
+        const QByteArray query = personFeature(index);
+
+        QElapsedTimer timer;
+        timer.start();
+        float similarity = 0.0f;
+        QString name;
+        const int id = db.findBestMatch(query, similarity, 0.7f, &name);
+        latencies.append(timer.nsecsElapsed() / 1e6);
+
+        if (id <= 0 || name != personName(index) || similarity < 0.99f) {
+            ++wrong;
+        }
+    }
+
+    // 未注册的人脸必须拒识
+    float similarity = 0.0f;
+    const int unknownId = db.findBestMatch(personFeature(persons + 12345), similarity, 0.7f);
+
+    const double p50 = percentile(latencies, 0.50);
+    const double p99 = percentile(latencies, 0.99);
+    const bool ok = wrong == 0 && unknownId == -1 && p99 <= ceilingMs;
+
+    qDebug() << "Queries:" << kQueries << "wrong:" << wrong << "unknown id:" << unknownId;
+    qDebug() << "findBestMatch p50:" << p50 << "ms, p99:" << p99 << "ms, ceiling:" << ceilingMs << "ms";
+    qDebug() << "Match latency:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+int totalRecognitions(FaceDatabase& db)
+{
+    int total = 0;
+    for (const FaceRecord& record : db.getAllFaceRecords()) {
+        total += record.recognitionCount;
+    }
+    return total;
+}
+
+// 读线程：反复匹配已注册的人员，返回结果不符的次数
+int readerLoop(FaceDatabase* db, int seed, const std::atomic<bool>* stop,
+               std::atomic<int>* queries, std::atomic<int>* hits)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, kConcurrentBase - 1);
+    int wrong = 0;
+    while (!stop->load()) {
+        const int index = pick(rng);
+        float similarity = 0.0f;
+        QString name;
+        const int id = db->findBestMatch(personFeature(index), similarity, 0.7f, &name);
+        if (id <= 0 || name != personName(index)) {
+            ++wrong;
+        }
+        if (id > 0) {
+            hits->fetch_add(1);
+        }
+        queries->fetch_add(1);
+    }
+    return wrong;
+}
+
+bool testConcurrentMatchDuringEnrollment(const QString& dir)
+{
+    qDebug() << "========== Testing Concurrent Match During Enrollment ==========";
+
+    FaceDatabase db;
+    if (!db.initialize(dir + "/test_concurrent.db") || !enroll(db, 0, kConcurrentBase)) {
+        qDebug() << "❌ Failed to prepare database";
+        return false;
+    }
+
+    const int recognitionsBefore = totalRecognitions(db);
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> queries(0);
+    std::atomic<int> hits(0);
+    std::vector<std::future<int>> readers;
+    for (int t = 0; t < kReaderThreads; ++t) {
+        readers.push_back(std::async(std::launch::async, readerLoop, &db, t + 1, &stop, &queries, &hits));
+    }
+
+    // 🔧 注册在数据库所在线程（本线程）逐条进行，每条提交后增量发布人脸库；
+    // 同时处理读线程排队过来的识别统计写入，连接始终只在本线程使用。
+    // 注册本身卡住时循环里的检查走不到，由看门狗线程在超时后直接退出
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(kDeadlockTimeoutSec);
+    std::atomic<bool> enrollmentDone(false);
+    std::thread watchdog([&enrollmentDone, deadline]() {
+        while (!enrollmentDone.load()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                qDebug() << "❌ Enrollment did not finish, possible deadlock";
+                std::_Exit(1);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    });
+
+    int added = 0;
+    for (int i = kConcurrentBase; i < kConcurrentBase + kConcurrentWrites; ++i) {
+        if (db.addFaceRecord(personName(i), QString("faces/%1.jpg").arg(personName(i)), personFeature(i))) {
+            ++added;
+        }
+        QCoreApplication::processEvents();
+    }
+    enrollmentDone.store(true);
+    watchdog.join();
+    stop.store(true);
+
+    // 任何一方卡住都视为死锁，无法安全回收线程，直接退出
+    int wrong = 0;
+    for (std::future<int>& reader : readers) {
+        if (reader.wait_until(deadline) != std::future_status::ready) {
+            qDebug() << "❌ Reader did not finish, possible deadlock";
+            std::_Exit(1);
+        }
+        wrong += reader.get();
+    }
+
+    // 并发期间注册的人员全部可匹配
+    int missing = 0;
+    for (int i = kConcurrentBase; i < kConcurrentBase + kConcurrentWrites; ++i) {
+        float similarity = 0.0f;
+        QString name;
+        if (db.findBestMatch(personFeature(i), similarity, 0.7f, &name) <= 0 || name != personName(i)) {
+            ++missing;
+        } else {
+            hits.fetch_add(1);
+        }
+    }
+
+    // 排队的识别统计在事件循环中写入：每次命中都计入识别次数
+    QCoreApplication::processEvents();
+    const int recognized = totalRecognitions(db) - recognitionsBefore;
+
+    const bool ok = added == kConcurrentWrites && wrong == 0 && missing == 0 && queries.load() > 0 &&
+                    recognized == hits.load() &&
+                    db.getTotalFaceCount() == kConcurrentBase + kConcurrentWrites;
+
+    qDebug() << "Added:" << added << "reader queries:" << queries.load()
+             << "wrong:" << wrong << "missing after enrollment:" << missing
+             << "recognitions recorded:" << recognized << "of" << hits.load();
+    qDebug() << "Concurrent match:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = app.arguments();
+    const int persons = qMax(kQueries, args.size() > 1 ? args.at(1).toInt() : 10000);
+    const double ceilingMs = args.size() > 2 ? args.at(2).toDouble() : 10.0 + 0.005 * persons;
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qDebug() << "❌ Failed to create temporary directory";
+        return 1;
+    }
+
+    int failures = 0;
+    {
+        FaceDatabase db;
+        if (!db.initialize(dir.path() + "/test_scale.db")) {
+            qDebug() << "❌ Database initialization failed";
+            return 1;
+        }
+        const bool enrolled = testBulkEnrollment(db, persons);
+        failures += enrolled ? 0 : 1;
+        failures += enrolled && testMatchLatency(db, persons, ceilingMs) ? 0 : 1;
+    }
+    failures += testConcurrentMatchDuringEnrollment(dir.path()) ? 0 : 1;
+
+    qDebug() << (failures == 0 ? "✅ All face database scale tests passed"
+                               : "❌ Face database scale tests failed:") << failures;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// tests/test_flight_recorder.cpp
+// FlightRecorder 的环形保留、SLO 触发与采集卡顿检测：
+// 缓冲只保留最近 kCapacity 条；冷却期内超时帧不再记违规；无冷却时连续超时只记一次违规、只挂起一次落盘；
+// 心跳停止后看门狗自动写出记录
+
+#include "FlightRecorder.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QThread>
+#include <cstring>
+
+namespace {
+
+const char* kDumpDir = "/tmp/sv_test_flight";
+
+FrameMeta tracedFrame(int source, quint64 sequence, qint64 latencyMs)
+{
+    FrameMeta meta = FrameMeta::begin(source, sequence);
+    meta.stampNs[FrameMeta::Display] = meta.stampNs[FrameMeta::Capture] + latencyMs * 1000000;
+    return meta;
+}
+
+bool testRingKeepsNewest()
+{
+    qDebug() << "========== Testing Ring Keeps Newest ==========";
+
+    FlightRecorder& recorder = FlightRecorder::instance();
+    const quint64 before = recorder.totalRecorded();
+    const int extra = 100;
+    for (int i = 0; i < FlightRecorder::kCapacity + extra; ++i) {
+        recorder.recordQueueDepth("test.queue", 0, i);
+    }
+
+    const QVector<FlightRecorder::Record> records = recorder.snapshot();
+    bool ok = records.size() == FlightRecorder::kCapacity;
+    ok = ok && recorder.totalRecorded() == before + FlightRecorder::kCapacity + extra;
+    ok = ok && records.first().value == extra && records.last().value == FlightRecorder::kCapacity + extra - 1;
+
+    qDebug() << "Records kept:" << records.size() << "oldest value:" << records.first().value;
+    qDebug() << "Ring keeps newest:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testSloCooldownSuppressesViolations()
+{
+    qDebug() << "========== Testing SLO Cooldown ==========";
+
+    FlightRecorder& recorder = FlightRecorder::instance();
+    recorder.setLatencySlo(FrameMeta::Display, 100.0);
+    recorder.setAutoDumpCooldownMs(60000);
+
+    // 正常帧不触发
+    recorder.recordFrame(tracedFrame(FrameSource::Rtsp1, 1, 20));
+    const bool quietOk = recorder.requestDump("probe");
+
+    // requestDump("probe") 已占用冷却窗口，之后的超时帧不再记录违规事件
+    for (quint64 sequence = 2; sequence < 10; ++sequence) {
+        recorder.recordFrame(tracedFrame(FrameSource::Rtsp1, sequence, 500));
+    }
+
+    int violations = 0;
+    int frames = 0;
+    for (const FlightRecorder::Record& record : recorder.snapshot()) {
+        if (record.type == FlightRecorder::Event && record.kind == FlightRecorder::SloViolation) {
+            ++violations;
+        } else if (record.type == FlightRecorder::FrameTiming && record.sourceId == FrameSource::Rtsp1) {
+            ++frames;
+        }
+    }
+
+    const FlightRecorder::Record last = recorder.snapshot().last();
+    bool ok = quietOk && violations == 0 && frames == 9;
+    ok = ok && last.stageUs[FrameMeta::Display] == 500000 && last.stageUs[FrameMeta::Decode] == -1;
+
+    qDebug() << "Frames:" << frames << "violations during cooldown:" << violations;
+    qDebug() << "SLO cooldown:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testSloViolationTriggersOnce()
+{
+    qDebug() << "========== Testing SLO Violation ==========";
+
+    // 无冷却、无待落盘请求（看门狗已停止，上一个用例的落盘已完成）
+    FlightRecorder& recorder = FlightRecorder::instance();
+    recorder.setLatencySlo(FrameMeta::Display, 100.0);
+    recorder.setAutoDumpCooldownMs(0);
+    const bool idleOk = recorder.pendingDumpReason() == nullptr;
+
+    // 连续多帧超时：第一帧挂起落盘并记违规，之后的帧因已有待落盘请求不再重复
+    const qint64 startNs = frameClockNs();
+    for (quint64 sequence = 100; sequence < 108; ++sequence) {
+        recorder.recordFrame(tracedFrame(FrameSource::Rtsp1, sequence, 500));
+    }
+
+    int violations = 0;
+    qint64 violationUs = 0;
+    for (const FlightRecorder::Record& record : recorder.snapshot()) {
+        if (record.timeNs >= startNs && record.type == FlightRecorder::Event &&
+            record.kind == FlightRecorder::SloViolation) {
+            ++violations;
+            violationUs = record.value;
+        }
+    }
+
+    const char* pending = recorder.pendingDumpReason();
+    const bool pendingOk = pending && std::strcmp(pending, "slo") == 0;
+    const bool secondRefused = !recorder.requestDump("probe");
+    const bool ok = idleOk && violations == 1 && violationUs == 500000 && pendingOk && secondRefused;
+
+    qDebug() << "Violations:" << violations << "pending dump:" << (pending ? pending : "none");
+    qDebug() << "SLO violation:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testStallDumpsToDisk()
+{
+    qDebug() << "========== Testing Capture Stall Dump ==========";
+
+    QDir(kDumpDir).removeRecursively();
+
+    FlightRecorder& recorder = FlightRecorder::instance();
+    recorder.setAutoDumpCooldownMs(0);
+    recorder.setStallThresholdMs(300);
+    recorder.start(kDumpDir);
+
+    // 上一个用例留下的 "probe" 请求在触发后保留期结束时落盘
+    const int dumpsBefore = recorder.dumpCount();
+    QThread::msleep(1000 + 400);
+    const int probeDumps = recorder.dumpCount() - dumpsBefore;
+
+    // 心跳 10 次后停止，超过阈值应记录卡顿并落盘
+    for (int i = 0; i < 10; ++i) {
+        recorder.heartbeat(FrameSource::Usb);
+        QThread::msleep(20);
+    }
+    QThread::msleep(300 + 200 + 1000 + 400);   // 阈值 + 看门狗周期 + 触发后保留 + 余量
+
+    bool stallRecorded = false;
+    for (const FlightRecorder::Record& record : recorder.snapshot()) {
+        if (record.type == FlightRecorder::Event && record.kind == FlightRecorder::CaptureStall &&
+            record.sourceId == FrameSource::Usb) {
+            stallRecorded = true;
+        }
+    }
+
+    const int stallDumps = recorder.dumpCount() - dumpsBefore - probeDumps;
+    recorder.endHeartbeat(FrameSource::Usb);
+    recorder.stop();
+
+    const QStringList files = QDir(kDumpDir).entryList(QStringList() << "flight-*-stall.json", QDir::Files, QDir::Name);
+    bool ok = probeDumps == 1 && stallRecorded && stallDumps == 1 && files.size() == 1;
+
+    if (ok) {
+        QFile file(QString(kDumpDir) + "/" + files.first());
+        ok = file.open(QIODevice::ReadOnly);
+        const QByteArray json = ok ? file.readAll() : QByteArray();
+        ok = ok && json.indexOf("\"reason\":\"stall\"") >= 0 && json.indexOf("\"event\":\"capture_stall\"") >= 0;
+    }
+
+    QDir(kDumpDir).removeRecursively();
+
+    qDebug() << "Probe dumps:" << probeDumps << "stall dumps:" << stallDumps << "files:" << files.size();
+    qDebug() << "Capture stall dump:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    int failures = 0;
+    failures += testRingKeepsNewest() ? 0 : 1;
+    failures += testSloCooldownSuppressesViolations() ? 0 : 1;
+    failures += testStallDumpsToDisk() ? 0 : 1;
+    failures += testSloViolationTriggersOnce() ? 0 : 1;
+
+    qDebug() << (failures == 0 ? "✅ All flight recorder tests passed"
+                               : "❌ Flight recorder tests failed:") << failures;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+// tests/test_frame_latency.cpp
+// FrameLatencyTracker 的丢帧与延迟统计：
+// 按采集线程分配的来源内序号检测断档，晚到的乱序帧不应被计为丢失；
+// 显示端切走再切回（resync）期间没有显示的帧不算丢帧
+
+#include "FrameLatencyTracker.h"
+#include <QDebug>
+#include <QThread>
+
+namespace {
+
+bool testLossBySequenceGap()
+{
+    qDebug() << "========== Testing Loss By Sequence Gap ==========";
+
+    const int source = FrameSource::Rtsp1;
+    FrameLatencyTracker& tracker = FrameLatencyTracker::instance();
+
+    // 100 帧全部解码，每 10 帧在入队前丢 1 帧
+    for (quint64 sequence = 1; sequence <= 100; ++sequence) {
+        FrameMeta meta = FrameMeta::begin(source, sequence);
+        tracker.mark(meta, FrameMeta::Decode);
+        if (sequence % 10 == 5) {
+            continue;
+        }
+        tracker.mark(meta, FrameMeta::AIStart);
+    }
+
+    const FrameLatencyTracker::StageStats decode = tracker.stats(source, FrameMeta::Decode);
+    const FrameLatencyTracker::StageStats start = tracker.stats(source, FrameMeta::AIStart);
+
+    bool ok = decode.seen == 100 && decode.lost == 0 && decode.lastSequence == 100;
+    ok = ok && start.seen == 90 && start.lost == 10;
+
+    qDebug() << "Decode seen/lost:" << decode.seen << decode.lost << "AI start seen/lost:" << start.seen << start.lost;
+    qDebug() << "Loss by sequence gap:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testOutOfOrderIsNotLoss()
+{
+    qDebug() << "========== Testing Out Of Order Arrival ==========";
+
+    const int source = FrameSource::Rtsp2;
+    FrameLatencyTracker& tracker = FrameLatencyTracker::instance();
+
+    // 攒批识别可能让后一帧先发出
+    const quint64 order[] = { 1, 2, 4, 3, 5, 7, 6, 8 };
+    for (quint64 sequence : order) {
+        FrameMeta meta = FrameMeta::begin(source, sequence);
+        tracker.mark(meta, FrameMeta::AIDone);
+    }
+
+    const FrameLatencyTracker::StageStats done = tracker.stats(source, FrameMeta::AIDone);
+    const bool ok = done.seen == 8 && done.lost == 0 && done.lastSequence == 8;
+
+    qDebug() << "AI done seen/lost:" << done.seen << done.lost;
+    qDebug() << "Out of order arrival:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testResyncAfterViewSwitch()
+{
+    qDebug() << "========== Testing Resync After View Switch ==========";
+
+    const int source = FrameSource::Mipi;
+    FrameLatencyTracker& tracker = FrameLatencyTracker::instance();
+
+    // 显示 1..20，其中真正丢了 10；切到别的来源期间 21..500 没有显示；切回后显示 501..520
+    for (quint64 sequence = 1; sequence <= 20; ++sequence) {
+        if (sequence == 10) {
+            continue;
+        }
+        FrameMeta meta = FrameMeta::begin(source, sequence);
+        tracker.mark(meta, FrameMeta::Display);
+    }
+    tracker.resync(source, FrameMeta::Display);
+    for (quint64 sequence = 501; sequence <= 520; ++sequence) {
+        FrameMeta meta = FrameMeta::begin(source, sequence);
+        tracker.mark(meta, FrameMeta::Display);
+    }
+
+    // 未出现过的（来源，阶段）上 resync 不注册也不崩溃
+    tracker.resync(FrameSource::Rtsp1, FrameMeta::Overlay);
+
+    const FrameLatencyTracker::StageStats display = tracker.stats(source, FrameMeta::Display);
+    const bool ok = display.seen == 39 && display.lost == 1 && display.lastSequence == 520
+        && tracker.stats(FrameSource::Rtsp1, FrameMeta::Overlay).seen == 0;
+
+    qDebug() << "Display seen/lost:" << display.seen << display.lost;
+    qDebug() << "Resync after view switch:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testLatencyAndUntracedFrames()
+{
+    qDebug() << "========== Testing Latency And Untraced Frames ==========";
+
+    const int source = FrameSource::Usb;
+    FrameLatencyTracker& tracker = FrameLatencyTracker::instance();
+
+    for (quint64 sequence = 1; sequence <= 20; ++sequence) {
+        FrameMeta meta = FrameMeta::begin(source, sequence);
+        QThread::msleep(2);
+        tracker.mark(meta, FrameMeta::Display);
+    }
+
+    // 未经采集线程追踪的帧不计入统计
+    FrameMeta untraced;
+    untraced.sourceId = source;
+    tracker.mark(untraced, FrameMeta::Display);
+
+    // 超出来源上限被忽略
+    FrameMeta outOfRange = FrameMeta::begin(FrameLatencyTracker::kMaxSources, 1);
+    tracker.mark(outOfRange, FrameMeta::Display);
+
+    const FrameLatencyTracker::StageStats display = tracker.stats(source, FrameMeta::Display);
+    bool ok = display.seen == 20 && display.lost == 0;
+    ok = ok && display.p50Ms >= 1.0 && display.p95Ms >= display.p50Ms && display.maxMs >= 2.0;
+    ok = ok && !untraced.hasStage(FrameMeta::Display);
+
+    qDebug() << "Glass-to-display p50/p95/max:" << display.p50Ms << display.p95Ms << display.maxMs;
+    qDebug() << "Latency and untraced frames:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    int failures = 0;
+    failures += testLossBySequenceGap() ? 0 : 1;
+    failures += testOutOfOrderIsNotLoss() ? 0 : 1;
+    failures += testResyncAfterViewSwitch() ? 0 : 1;
+    failures += testLatencyAndUntracedFrames() ? 0 : 1;
+
+    qDebug() << (failures == 0 ? "✅ All frame latency tests passed"
+                               : "❌ Frame latency tests failed:") << failures;
+    return failures == 0 ? 0 : 1;
+}
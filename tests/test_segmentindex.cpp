@@ -0,0 +1,224 @@
+// tests/test_segmentindex.cpp
+// 分段录像索引：随机时刻的定位结果与线性扫描的参考答案一致（含空档与跨零点的片段）；
+// 断电留下的半条记录在续写时被截掉，墙钟回拨时记录仍保持有序；事件按时间区间查询
+
+#include "segmentindex.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QPair>
+#include <QTime>
+#include <random>
+
+namespace {
+
+const char* kRoot = "/tmp/sv_test_segmentindex";
+
+struct RefSegment {
+    qint64 startMs;
+    qint64 endMs;
+    QVector<QPair<qint64, qint64>> keyframes;   // 墙钟时间, 字节偏移
+};
+
+qint64 localMs(const QDate& day, int hour, int minute, int second)
+{
+    return QDateTime(day, QTime(hour, minute, second)).toMSecsSinceEpoch();
+}
+
+// 参考答案：线性扫描
+SegmentIndex::Location expectedLocation(const QVector<RefSegment>& segments, qint64 timeMs)
+{
+    SegmentIndex::Location location;
+    for (const RefSegment& segment : segments) {
+        if (segment.startMs <= timeMs && timeMs < segment.endMs) {
+            location.found = true;
+            location.exact = true;
+            location.segmentStartMs = segment.startMs;
+            for (const auto& keyframe : segment.keyframes) {
+                if (keyframe.first <= timeMs) {
+                    location.keyframeMs = keyframe.first;
+                    location.byteOffset = keyframe.second;
+                }
+            }
+            return location;
+        }
+        if (segment.startMs > timeMs) {
+            location.found = true;
+            location.segmentStartMs = segment.startMs;
+            location.keyframeMs = segment.startMs;
+            return location;
+        }
+    }
+    return location;
+}
+
+bool sameLocation(const SegmentIndex::Location& a, const SegmentIndex::Location& b)
+{
+    if (a.found != b.found) {
+        return false;
+    }
+    return !a.found || (a.exact == b.exact && a.segmentStartMs == b.segmentStartMs
+                        && a.keyframeMs == b.keyframeMs && a.byteOffset == b.byteOffset);
+}
+
+bool testLocateMatchesLinearScan()
+{
+    qDebug() << "========== Testing Locate ==========";
+
+    // 从 22:30:30 开始写 3 个小时：60 秒分段、2 秒一个关键帧，每隔几段留一段空档，
+    // 起点选在让某个分段正好跨过零点
+    SegmentIndex index(kRoot, 1);
+    const QDate day(2026, 3, 1);
+    qint64 t = localMs(day, 22, 30, 30);
+    const qint64 endMs = t + 3 * 3600 * 1000;
+
+    QVector<RefSegment> segments;
+    int segmentNo = 0;
+    while (t < endMs) {
+        RefSegment segment;
+        segment.startMs = t;
+        segment.endMs = t + 60000;
+        index.beginSegment(segment.startMs, SegmentIndex::TransportStream);
+        for (qint64 k = segment.startMs, offset = 0; k < segment.endMs; k += 2000, offset += 188 * 1000) {
+            index.addKeyframe(k, offset);
+            segment.keyframes.append(qMakePair(k, offset));
+        }
+        index.endSegment(segment.endMs, 188 * 30000);
+        segments.append(segment);
+
+        // 连续分段紧接下一帧开始；每 4 段之后空 45 秒
+        t = segment.endMs + (++segmentNo % 4 == 0 ? 45000 : 66);
+    }
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<qint64> pick(segments.first().startMs - 60000, endMs + 60000);
+    int mismatches = 0;
+    int exact = 0;
+    int gaps = 0;
+    const int queries = 2000;
+    for (int i = 0; i < queries; ++i) {
+        const qint64 query = pick(rng);
+        const SegmentIndex::Location expected = expectedLocation(segments, query);
+        const SegmentIndex::Location actual = index.locate(query);
+        if (!sameLocation(expected, actual)) {
+            if (++mismatches <= 5) {
+                qDebug() << "Mismatch at" << query << "expected start" << expected.segmentStartMs
+                         << "got" << actual.segmentStartMs << "keyframe" << actual.keyframeMs;
+            }
+        }
+        exact += actual.exact ? 1 : 0;
+        gaps += (actual.found && !actual.exact) ? 1 : 0;
+    }
+
+    // 跨零点的片段：开始于前一天，查询次日零点之后的时刻
+    const qint64 midnight = QDateTime(day.addDays(1), QTime(0, 0)).toMSecsSinceEpoch();
+    int spanning = -1;
+    for (int i = 0; i < segments.size(); ++i) {
+        if (segments[i].startMs < midnight && segments[i].endMs > midnight) {
+            spanning = i;
+        }
+    }
+    bool midnightOk = spanning >= 0;
+    if (midnightOk) {
+        const SegmentIndex::Location location = index.locate(segments[spanning].endMs - 1);
+        midnightOk = location.exact && location.segmentStartMs == segments[spanning].startMs
+            && location.path == index.segmentPath(segments[spanning].startMs, SegmentIndex::TransportStream);
+    }
+
+    const SegmentIndex::Location first = index.locate(segments.first().startMs + 5000);
+    const bool pathOk = first.path.endsWith(".ts") && first.ptsMs() == 4000;
+
+    const bool ok = mismatches == 0 && exact > 0 && gaps > 0 && midnightOk && pathOk;
+    qDebug() << "Segments:" << segments.size() << "queries:" << queries << "exact:" << exact
+             << "gaps:" << gaps << "mismatches:" << mismatches << "spanning midnight:" << (spanning >= 0);
+    qDebug() << "Locate:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testRecoveryAndMonotonicTime()
+{
+    qDebug() << "========== Testing Recovery ==========";
+
+    const QDate day(2026, 3, 5);
+    const qint64 base = localMs(day, 12, 0, 0);
+    QString indexFile;
+    {
+        SegmentIndex index(kRoot, 2);
+        index.beginSegment(base, SegmentIndex::FragmentedMp4);
+        index.addKeyframe(base, 1024);
+        index.endSegment(base + 10000, 4096);
+        indexFile = index.indexPath(day);
+    }
+
+    // 模拟断电：文件尾部只写了半条记录
+    {
+        QFile file(indexFile);
+        file.open(QIODevice::Append);
+        file.write("partial", 7);
+    }
+
+    // 重启后墙钟回拨 1 分钟：新片段的开始时间被钳到上一条记录之后
+    SegmentIndex index(kRoot, 2);
+    index.beginSegment(base - 60000, SegmentIndex::FragmentedMp4);
+    index.addKeyframe(base - 60000, 1024);
+    index.endSegment(base - 50000, 2048);
+
+    const QVector<SegmentIndex::Record> records = SegmentIndex::readAll(indexFile);
+    bool ordered = true;
+    for (int i = 1; i < records.size(); ++i) {
+        ordered = ordered && records[i].timeMs >= records[i - 1].timeMs;
+    }
+
+    const bool ok = records.size() == 6 && ordered
+        && records[3].type == SegmentIndex::SegmentStart && records[3].timeMs == base + 10000
+        && QFile(indexFile).size() == SegmentIndex::kHeaderSize + 6 * SegmentIndex::kRecordSize
+        && index.locate(base + 5000).path.endsWith(".mp4");
+
+    qDebug() << "Records after recovery:" << records.size() << "ordered:" << ordered;
+    qDebug() << "Recovery:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testEventRange()
+{
+    qDebug() << "========== Testing Event Range ==========";
+
+    SegmentIndex index(kRoot, 3);
+    const QDate day(2026, 3, 8);
+    const qint64 evening = localMs(day, 23, 59, 0);
+    index.addEvent(evening, SegmentIndex::MotionEvent);
+    index.addEvent(evening + 30000, SegmentIndex::FaceEvent, 2);
+    index.addEvent(evening + 90000, SegmentIndex::ManualEvent);      // 次日
+    index.addEvent(evening + 150000, SegmentIndex::ClipEnd, 60000);  // 次日
+
+    const QVector<SegmentIndex::Record> all = index.events(evening, evening + 150000);
+    const QVector<SegmentIndex::Record> middle = index.events(evening + 1, evening + 90000);
+    const QVector<SegmentIndex::Record> none = index.events(evening + 150001, evening + 200000);
+
+    const bool ok = all.size() == 4 && middle.size() == 2
+        && middle[0].flags == SegmentIndex::FaceEvent && middle[0].value == 2
+        && middle[1].flags == SegmentIndex::ManualEvent && none.isEmpty();
+
+    qDebug() << "All:" << all.size() << "middle:" << middle.size() << "after:" << none.size();
+    qDebug() << "Event range:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    QDir(kRoot).removeRecursively();
+
+    int failures = 0;
+    failures += testLocateMatchesLinearScan() ? 0 : 1;
+    failures += testRecoveryAndMonotonicTime() ? 0 : 1;
+    failures += testEventRange() ? 0 : 1;
+
+    QDir(kRoot).removeRecursively();
+
+    qDebug() << (failures == 0 ? "✅ All segment index tests passed"
+                               : "❌ Segment index tests failed:") << failures;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+// tests/test_snapshotservice.cpp
+// 快照服务：同一场景的连拍只截一次（与事件库合并规则一致），新人脸/其它来源各自成事件；
+// 整帧、缩略图、人脸裁剪图都能解码且尺寸符合上限；saveImage 写到指定路径；队列满时丢弃计数与写盘数吻合
+
+#include "snapshotservice.h"
+#include "../core/MetricsRegistry.h"
+#include <QDebug>
+#include <QFile>
+#include <QTemporaryDir>
+#include <opencv2/imgcodecs.hpp>
+
+namespace {
+
+const qint64 kMsNs = 1000000LL;
+
+DetectionResult makeResult(qint64 timestampNs, int sourceId, int faceId)
+{
+    DetectionResult result;
+    result.timestampNs = timestampNs;
+    result.sourceId = sourceId;
+    result.hasMotion = true;
+    result.motionArea = QRect(10, 20, 30, 40);
+    result.faceCount = 1;
+    result.faces[0].bbox = QRect(100, 100, 120, 160);
+    result.faces[0].faceId = faceId;
+    result.faces[0].isRecognized = true;
+    result.recognizedFaceCount = 1;
+    return result;
+}
+
+QImage makeFrame()
+{
+    QImage frame(640, 480, QImage::Format_RGB888);
+    for (int y = 0; y < frame.height(); ++y) {
+        uchar* line = frame.scanLine(y);
+        for (int x = 0; x < frame.width(); ++x) {
+            line[x * 3] = uchar(x);
+            line[x * 3 + 1] = uchar(y);
+            line[x * 3 + 2] = uchar(x + y);
+        }
+    }
+    return frame;
+}
+
+bool checkJpeg(const QString& path, int expectedWidth, int expectedHeight)
+{
+    const cv::Mat image = cv::imread(path.toStdString());
+    if (image.empty() || image.cols != expectedWidth || image.rows != expectedHeight) {
+        qDebug() << "Unexpected image" << path << image.cols << "x" << image.rows;
+        return false;
+    }
+    return true;
+}
+
+qint64 eventTimeMs(const DetectionResult& result)
+{
+    return result.wallTime().toMSecsSinceEpoch();
+}
+
+bool testCoalescedSnapshots()
+{
+    qDebug() << "========== Testing Coalesced Snapshots ==========";
+
+    SnapshotService& service = SnapshotService::instance();
+    const QImage frame = makeFrame();
+    const qint64 base = 1000000000LL;   // 单调时钟纳秒
+    int accepted = 0;
+
+    // 同一人连续 1.5 秒、每 100ms 一帧：只截 1 次
+    for (int i = 0; i < 15; ++i) {
+        accepted += service.submitEvent(makeResult(base + i * 100 * kMsNs, 0, 7), frame) ? 1 : 0;
+    }
+    const bool burstOk = accepted == 1;
+
+    // 换了一个人、另一路来源同一人：各自成事件
+    const DetectionResult newFace = makeResult(base + 1600 * kMsNs, 0, 8);
+    const DetectionResult otherSource = makeResult(base + 1600 * kMsNs, 1, 7);
+    const bool splitOk = service.submitEvent(newFace, frame) && service.submitEvent(otherSource, frame);
+    service.flush();
+
+    // 文件按事件时刻命名：整帧 640x480 不超过上限原样保存，缩略图长边 160，人脸框外扩 20%
+    const qint64 firstMs = eventTimeMs(makeResult(base, 0, 7));
+    const bool filesOk = checkJpeg(service.framePath(0, firstMs), 640, 480)
+        && checkJpeg(service.thumbnailPath(0, firstMs), 160, 120)
+        && checkJpeg(service.facePath(0, firstMs, 0), 168, 224)
+        && QFile::exists(service.framePath(0, eventTimeMs(newFace)))
+        && QFile::exists(service.framePath(1, eventTimeMs(otherSource)))
+        && !QFile::exists(service.facePath(0, firstMs, 1));
+
+    const bool ok = burstOk && splitOk && filesOk;
+    qDebug() << "Burst accepted:" << accepted << "split:" << splitOk << "files:" << filesOk;
+    qDebug() << "Coalesced snapshots:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testSaveImage(const QString& root)
+{
+    qDebug() << "========== Testing Save Image ==========";
+
+    SnapshotService& service = SnapshotService::instance();
+    const QString path = root + "/faces/images/person_1.jpg";
+    service.saveImage(makeFrame().copy(0, 0, 200, 250), path);
+    service.flush();
+
+    const bool ok = checkJpeg(path, 200, 250);
+    qDebug() << "Save image:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testBoundedQueue()
+{
+    qDebug() << "========== Testing Bounded Queue ==========";
+
+    SnapshotService& service = SnapshotService::instance();
+    SnapshotService::Options options = service.options();
+    options.maxPendingEvents = 1;
+    service.setOptions(options);
+
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    const quint64 writtenBefore = metrics.counter("snapshot.files.written")->value();
+    const quint64 droppedBefore = metrics.counter("snapshot.dropped")->value();
+
+    // 每帧换一个人，全部是新事件；每个写盘的事件产生 3 个文件（整帧、缩略图、1 张人脸）
+    const QImage frame = makeFrame();
+    const qint64 base = 5000000000LL;
+    int accepted = 0;
+    for (int i = 0; i < 50; ++i) {
+        accepted += service.submitEvent(makeResult(base + i * kMsNs, 2, 100 + i), frame) ? 1 : 0;
+    }
+    service.flush();
+
+    const quint64 written = metrics.counter("snapshot.files.written")->value() - writtenBefore;
+    const quint64 dropped = metrics.counter("snapshot.dropped")->value() - droppedBefore;
+    const qint64 lastMs = eventTimeMs(makeResult(base + 49 * kMsNs, 2, 149));
+
+    // 丢弃的总是最旧的，最后一个事件一定写盘
+    const bool ok = accepted == 50 && dropped < quint64(accepted)
+        && written == 3 * (quint64(accepted) - dropped)
+        && QFile::exists(service.framePath(2, lastMs));
+
+    qDebug() << "Accepted:" << accepted << "written files:" << written << "dropped:" << dropped;
+    qDebug() << "Bounded queue:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qDebug() << "❌ Failed to create temporary directory";
+        return 1;
+    }
+
+    SnapshotService& service = SnapshotService::instance();
+    SnapshotService::Options options;
+    options.retentionDays = 0;
+    service.setOptions(options);
+    service.start(dir.path() + "/snapshots");
+
+    int failures = 0;
+    failures += testCoalescedSnapshots() ? 0 : 1;
+    failures += testSaveImage(dir.path()) ? 0 : 1;
+    failures += testBoundedQueue() ? 0 : 1;
+
+    service.stop();
+
+    qDebug() << (failures == 0 ? "✅ All snapshot service tests passed"
+                               : "❌ Snapshot service tests failed:") << failures;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+// tests/test_storagemanager.cpp
+// 存储配额：每路配额与总配额都从最旧的分段开始删除，每路最新的分段（可能正在写入）从不删除，
+// 删空的日期目录连同当天索引一起删除，计入目录只计量不删除；分段文件预分配后大小等于实际写入
+
+#include "storagemanager.h"
+#include "segmentfile.h"
+#include "segmentindex.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <cstdio>
+
+namespace {
+
+const qint64 kSegmentBytes = 100 * 1024;
+
+// 在 <root>/cam<N>/<day>/ 下生成 count 个分段，从 hour:00 起每分钟一个；同时生成当天的索引文件
+QStringList makeSegments(const QString& root, int sourceId, const QDate& day, int hour, int count)
+{
+    SegmentIndex index(root, sourceId);
+    QStringList paths;
+    for (int i = 0; i < count; ++i) {
+        const qint64 startMs = QDateTime(day, QTime(hour, i)).toMSecsSinceEpoch();
+        index.beginSegment(startMs, SegmentIndex::TransportStream);
+        index.endSegment(startMs + 60000, kSegmentBytes);
+
+        const QString path = index.segmentPath(startMs, SegmentIndex::TransportStream);
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QFile file(path);
+        file.open(QIODevice::WriteOnly);
+        file.write(QByteArray(int(kSegmentBytes), 'x'));
+        paths.append(path);
+    }
+    index.addEvent(QDateTime(day, QTime(hour, 0)).toMSecsSinceEpoch(), SegmentIndex::MotionEvent);
+    return paths;
+}
+
+int countExisting(const QStringList& paths)
+{
+    int n = 0;
+    for (const QString& path : paths) {
+        n += QFile::exists(path) ? 1 : 0;
+    }
+    return n;
+}
+
+bool testCameraQuota(const QString& root)
+{
+    qDebug() << "========== Testing Camera Quota ==========";
+
+    const QDate day1(2026, 4, 1);
+    const QDate day2(2026, 4, 2);
+    const QStringList cam0Day1 = makeSegments(root, 0, day1, 10, 5);
+    const QStringList cam0Day2 = makeSegments(root, 0, day2, 10, 5);
+    const QStringList cam1 = makeSegments(root, 1, day1, 10, 5);
+
+    StorageManager manager(root);
+    StorageManager::Options options;
+    options.cameraQuotaBytes = 6 * kSegmentBytes;
+    options.minFreeBytes = 0;
+    manager.setOptions(options);
+    manager.setCameraQuota(1, 0);       // cam1 不限
+
+    const StorageManager::Usage usage = manager.enforceNow();
+
+    // cam0 共 10 段、配额 6 段：第一天的 4 个最旧分段被删除
+    const SegmentIndex index0(root, 0);
+    const bool ok = usage.deletedSegments == 4
+        && countExisting(cam0Day1) == 1 && QFile::exists(cam0Day1.last())
+        && countExisting(cam0Day2) == 5 && countExisting(cam1) == 5
+        && QFile::exists(index0.indexPath(day1))
+        && usage.recordBytes == 11 * kSegmentBytes
+        && usage.cameras.size() == 2 && usage.cameras[0].segments == 6
+        && usage.cameras[0].oldestMs == QDateTime(day1, QTime(10, 4)).toMSecsSinceEpoch();
+
+    qDebug() << "Deleted:" << usage.deletedSegments << "remaining bytes:" << usage.recordBytes;
+    qDebug() << "Camera quota:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testGlobalQuotaAndEmptyDays(const QString& root)
+{
+    qDebug() << "========== Testing Global Quota ==========";
+
+    const QDate day1(2026, 5, 1);
+    const QDate day2(2026, 5, 2);
+    const QString records = root + "/records";
+    const QStringList cam0Day1 = makeSegments(records, 0, day1, 8, 3);
+    const QStringList cam1Day1 = makeSegments(records, 1, day1, 9, 3);
+    const QStringList cam0Day2 = makeSegments(records, 0, day2, 8, 2);
+
+    // 计入目录：占 2 段的空间，从不删除
+    const QString faces = root + "/faces";
+    QDir().mkpath(faces);
+    QFile face(faces + "/someone.jpg");
+    face.open(QIODevice::WriteOnly);
+    face.write(QByteArray(int(2 * kSegmentBytes), 'f'));
+    face.close();
+
+    StorageManager manager(records);
+    StorageManager::Options options;
+    options.globalQuotaBytes = 6 * kSegmentBytes;
+    options.minFreeBytes = 0;
+    manager.setOptions(options);
+    manager.addAccountedDirectory(faces);
+
+    const StorageManager::Usage usage = manager.enforceNow();
+
+    // 共 8 段 + 2 段计入，总配额 6：按全局时间删最旧的 4 段（cam0 第一天 3 段，cam1 最早的 1 段）
+    const SegmentIndex index0(records, 0);
+    const bool dayRemoved = !QDir(QFileInfo(cam0Day1.first()).absolutePath()).exists()
+        && !QFile::exists(index0.indexPath(day1)) && !QFile::exists(index0.eventPath(day1))
+        && QFile::exists(index0.indexPath(day2));
+    const bool ok = usage.deletedSegments == 4 && dayRemoved
+        && countExisting(cam0Day1) == 0 && countExisting(cam1Day1) == 2 && !QFile::exists(cam1Day1.first())
+        && countExisting(cam0Day2) == 2 && QFile::exists(face.fileName())
+        && usage.accountedBytes == 2 * kSegmentBytes
+        && usage.recordBytes + usage.accountedBytes <= options.globalQuotaBytes;
+
+    qDebug() << "Deleted:" << usage.deletedSegments << "day removed:" << dayRemoved
+             << "records:" << usage.recordBytes << "accounted:" << usage.accountedBytes;
+    qDebug() << "Global quota:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testNewestSegmentProtected(const QString& root)
+{
+    qDebug() << "========== Testing Newest Segment ==========";
+
+    const QStringList segments = makeSegments(root, 2, QDate(2026, 6, 1), 12, 3);
+
+    StorageManager manager(root);
+    StorageManager::Options options;
+    options.cameraQuotaBytes = 1;       // 远小于一个分段
+    options.minFreeBytes = 0;
+    manager.setOptions(options);
+
+    const StorageManager::Usage usage = manager.enforceNow();
+    const bool ok = usage.deletedSegments == 2 && countExisting(segments) == 1 && QFile::exists(segments.last());
+
+    qDebug() << "Deleted:" << usage.deletedSegments << "remaining:" << countExisting(segments);
+    qDebug() << "Newest segment:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testSegmentFile(const QString& root)
+{
+    qDebug() << "========== Testing Segment File ==========";
+
+    const QString path = root + "/segment.ts";
+    SegmentFile file;
+    SegmentFile::Options options;
+    options.preallocateBytes = 4 * 1024 * 1024;
+    options.syncBytes = 64 * 1024;
+    bool ok = file.open(path, options);
+
+    const QByteArray chunk(188 * 100, 'a');
+    qint64 written = 0;
+    for (int i = 0; ok && i < 20; ++i) {
+        ok = file.write(chunk.constData(), chunk.size()) == chunk.size();
+        written += chunk.size();
+    }
+
+    // 回到开头改写（MP4 写文件尾时会回填），大小不变
+    ok = ok && file.seek(0, SEEK_SET) == 0 && file.write("SVTS", 4) == 4
+        && file.seek(0, SEEK_END) == written && file.size() == written;
+    ok = file.close() && ok;
+
+    QFile check(path);
+    check.open(QIODevice::ReadOnly);
+    ok = ok && check.size() == written && check.read(4) == "SVTS";
+
+    qDebug() << "Written:" << written << "on disk:" << check.size();
+    qDebug() << "Segment file:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    int failures = 0;
+    {
+        QTemporaryDir dir;
+        failures += testCameraQuota(dir.path()) ? 0 : 1;
+    }
+    {
+        QTemporaryDir dir;
+        failures += testGlobalQuotaAndEmptyDays(dir.path()) ? 0 : 1;
+    }
+    {
+        QTemporaryDir dir;
+        failures += testNewestSegmentProtected(dir.path()) ? 0 : 1;
+    }
+    {
+        QTemporaryDir dir;
+        failures += testSegmentFile(dir.path()) ? 0 : 1;
+    }
+
+    qDebug() << (failures == 0 ? "✅ All storage manager tests passed"
+                               : "❌ Storage manager tests failed:") << failures;
+    return failures == 0 ? 0 : 1;
+}
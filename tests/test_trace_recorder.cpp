@@ -0,0 +1,130 @@
+// tests/test_trace_recorder.cpp
+// TraceRecorder 的录制与导出：
+// 未录制时作用域不产生事件；多线程并发写入后导出的事件数与写入数一致；线程缓冲写满后只保留最新事件
+
+#include "TraceRecorder.h"
+#include <QDebug>
+#include <QFile>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* kTracePath = "/tmp/sv_test_trace.json";
+
+int countOccurrences(const QByteArray& text, const char* needle)
+{
+    int count = 0;
+    for (int pos = text.indexOf(needle); pos >= 0; pos = text.indexOf(needle, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+QByteArray dumpAndRead()
+{
+    if (!TraceRecorder::instance().dumpChromeJson(kTracePath)) {
+        return QByteArray();
+    }
+    QFile file(kTracePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+void tracedWork(int iterations)
+{
+    for (int i = 0; i < iterations; ++i) {
+        SV_TRACE_SCOPE_ARG("test", "work", i);
+        SV_TRACE_SCOPE("test", "inner");
+    }
+}
+
+bool testIdleScopesRecordNothing()
+{
+    qDebug() << "========== Testing Idle Scopes ==========";
+
+    TraceRecorder& recorder = TraceRecorder::instance();
+    recorder.start();
+    recorder.stop();
+    tracedWork(100);
+
+    const QByteArray json = dumpAndRead();
+    const bool ok = json.indexOf("\"traceEvents\"") >= 0 && countOccurrences(json, "\"ph\":\"X\"") == 0;
+
+    qDebug() << "Idle scopes:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testConcurrentRecording()
+{
+    qDebug() << "========== Testing Concurrent Recording ==========";
+
+    const int threadCount = 4;
+    const int iterations = 500;
+
+    TraceRecorder::instance().start();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back(tracedWork, iterations);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    const QByteArray json = dumpAndRead();
+    const int events = countOccurrences(json, "\"ph\":\"X\"");
+    const int frames = countOccurrences(json, "\"args\":{\"frame\":");
+    const int threadNames = countOccurrences(json, "\"thread_name\"");
+
+    // 每次迭代两个作用域，其中一个带帧序号
+    bool ok = events == threadCount * iterations * 2;
+    ok = ok && frames == threadCount * iterations;
+    ok = ok && threadNames == threadCount;
+    ok = ok && !TraceRecorder::instance().isRecording();
+
+    qDebug() << "Events:" << events << "with frame arg:" << frames << "threads:" << threadNames;
+    qDebug() << "Concurrent recording:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+bool testRingKeepsNewest()
+{
+    qDebug() << "========== Testing Ring Overwrite ==========";
+
+    const int iterations = TraceRecorder::kEventsPerThread;   // 产生两倍于容量的事件
+
+    TraceRecorder::instance().start();
+    std::thread worker(tracedWork, iterations);
+    worker.join();
+
+    const QByteArray json = dumpAndRead();
+    const int events = countOccurrences(json, "\"ph\":\"X\"");
+
+    // 最后一次迭代的事件必须保留，最早的被覆盖
+    const QByteArray newest = "\"args\":{\"frame\":" + QByteArray::number(iterations - 1) + "}";
+    bool ok = events == TraceRecorder::kEventsPerThread;
+    ok = ok && json.indexOf(newest) >= 0;
+    ok = ok && json.indexOf("\"args\":{\"frame\":0}") < 0;
+
+    qDebug() << "Events kept:" << events << "capacity:" << TraceRecorder::kEventsPerThread;
+    qDebug() << "Ring overwrite:" << (ok ? "✅ Passed" : "❌ Failed");
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    int failures = 0;
+    failures += testIdleScopesRecordNothing() ? 0 : 1;
+    failures += testConcurrentRecording() ? 0 : 1;
+    failures += testRingKeepsNewest() ? 0 : 1;
+
+    QFile::remove(kTracePath);
+
+    qDebug() << (failures == 0 ? "✅ All trace recorder tests passed"
+                               : "❌ Trace recorder tests failed:") << failures;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+#include "AnomalyPage.h"
+#include "../ai/eventstore.h"
+#include "../core/FrameMeta.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QComboBox>
+#include <QPushButton>
+#include <QLabel>
+#include <QTimer>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+
+QString sourceName(int sourceId)
+{
+    switch (sourceId) {
+    case FrameSource::Mipi:  return u8"MIPI 01";
+    case FrameSource::Rtsp1: return u8"IP 01";
+    case FrameSource::Rtsp2: return u8"IP 02";
+    case FrameSource::Usb:   return u8"USB";
+    default:                 return QString::number(sourceId);
+    }
+}
+
+QString triggerName(RecordTrigger trigger)
+{
+    switch (trigger) {
+    case RecordTrigger::MotionDetected:        return u8"运动";
+    case RecordTrigger::FaceDetected:          return u8"人脸";
+    case RecordTrigger::UnknownFaceDetected:   return u8"陌生人";
+    case RecordTrigger::KnownFaceDetected:     return u8"已知人员";
+    case RecordTrigger::MultipleFacesDetected: return u8"多人";
+    case RecordTrigger::ManualTrigger:         return u8"手动";
+    default:                                   return u8"未知";
+    }
+}
+
+} // namespace
+
+AnomalyPage::AnomalyPage(QWidget* parent)
+    : QWidget(parent)
+{
+    setupUi();
+}
+
+void AnomalyPage::setupUi()
+{
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(10);
+
+    QHBoxLayout* toolbar = new QHBoxLayout();
+    m_sourceFilter = new QComboBox(this);
+    m_sourceFilter->addItem(u8"全部来源", -1);
+    for (int source : {FrameSource::Mipi, FrameSource::Rtsp1, FrameSource::Rtsp2, FrameSource::Usb}) {
+        m_sourceFilter->addItem(sourceName(source), source);
+    }
+    connect(m_sourceFilter, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &AnomalyPage::refresh);
+
+    m_prevButton = new QPushButton(u8"上一页", this);
+    m_nextButton = new QPushButton(u8"下一页", this);
+    m_pageLabel = new QLabel(this);
+    m_pageLabel->setStyleSheet("color: white;");
+    connect(m_prevButton, &QPushButton::clicked, this, &AnomalyPage::previousPage);
+    connect(m_nextButton, &QPushButton::clicked, this, &AnomalyPage::nextPage);
+
+    toolbar->addWidget(m_sourceFilter);
+    toolbar->addStretch();
+    toolbar->addWidget(m_pageLabel);
+    toolbar->addWidget(m_prevButton);
+    toolbar->addWidget(m_nextButton);
+    layout->addLayout(toolbar);
+
+    m_table = new QTableWidget(0, 6, this);
+    m_table->setHorizontalHeaderLabels({u8"时间", u8"来源", u8"类型", u8"人脸", u8"运动区域", u8"录像"});
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    layout->addWidget(m_table);
+
+    // 写线程每批提交都会通知，页面可见时最多每秒刷新一次
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(1000);
+    connect(m_refreshTimer, &QTimer::timeout, this, &AnomalyPage::loadPage);
+
+    setLayout(layout);
+}
+
+void AnomalyPage::setEventStore(EventStore* store)
+{
+    if (m_store) {
+        disconnect(m_store, nullptr, this, nullptr);
+    }
+    m_store = store;
+    if (m_store) {
+        // eventsWritten 在写线程发出，自动排队到 GUI 线程
+        connect(m_store, &EventStore::eventsWritten, this, &AnomalyPage::onEventsWritten);
+    }
+    refresh();
+}
+
+void AnomalyPage::showEvent(QShowEvent* event)
+{
+    QWidget::showEvent(event);
+    refresh();
+}
+
+void AnomalyPage::onEventsWritten()
+{
+    // 只有停在第一页时才跟随新事件刷新，翻到后面的页不被打乱
+    if (isVisible() && m_cursorStack.isEmpty() && !m_refreshTimer->isActive()) {
+        m_refreshTimer->start();
+    }
+}
+
+void AnomalyPage::refresh()
+{
+    m_cursorStack.clear();
+    m_cursor = qMakePair(qint64(-1), qint64(0));
+    loadPage();
+}
+
+void AnomalyPage::nextPage()
+{
+    if (!m_hasMore) {
+        return;
+    }
+    m_cursorStack.append(m_cursor);
+    m_cursor = m_nextCursor;
+    loadPage();
+}
+
+void AnomalyPage::previousPage()
+{
+    if (m_cursorStack.isEmpty()) {
+        return;
+    }
+    m_cursor = m_cursorStack.takeLast();
+    loadPage();
+}
+
+void AnomalyPage::loadPage()
+{
+    if (!m_store || !m_store->isOpen() || !isVisible()) {
+        return;
+    }
+
+    EventQuery request;
+    request.sourceId = m_sourceFilter->currentData().toInt();
+    request.limit = kPageSize;
+    request.beforeMs = m_cursor.first;
+    request.beforeId = m_cursor.second;
+
+    QElapsedTimer timer;
+    timer.start();
+    const EventPage page = m_store->query(request);
+    const qint64 queryUs = timer.nsecsElapsed() / 1000;
+
+    m_hasMore = page.hasMore;
+    m_nextCursor = qMakePair(page.nextBeforeMs, page.nextBeforeId);
+
+    m_table->setUpdatesEnabled(false);
+    m_table->setRowCount(page.events.size());
+    for (int row = 0; row < page.events.size(); ++row) {
+        fillRow(row, page.events[row]);
+    }
+    m_table->setUpdatesEnabled(true);
+
+    m_pageLabel->setText(QString(u8"第 %1 页").arg(m_cursorStack.size() + 1));
+    m_prevButton->setEnabled(!m_cursorStack.isEmpty());
+    m_nextButton->setEnabled(m_hasMore);
+
+    qDebug() << "AnomalyPage: Loaded" << page.events.size() << "events in" << queryUs << "us";
+}
+
+void AnomalyPage::fillRow(int row, const StoredEvent& event)
+{
+    QStringList faces;
+    for (qint32 faceId : event.faceIds) {
+        faces << (faceId >= 0 ? QString::number(faceId) : QString("?"));
+    }
+
+    const QRect& area = event.motionArea;
+    const QString motion = area.isEmpty()
+        ? QString("-")
+        : QString("%1,%2 %3x%4").arg(area.x()).arg(area.y()).arg(area.width()).arg(area.height());
+
+    const QString recording = event.recordingStartMs > 0
+        ? QDateTime::fromMSecsSinceEpoch(event.recordingStartMs).toString("HH:mm:ss")
+        : QString("-");
+
+    const QStringList cells = {
+        QDateTime::fromMSecsSinceEpoch(event.timeMs).toString("yyyy-MM-dd HH:mm:ss.zzz"),
+        sourceName(event.sourceId),
+        triggerName(event.trigger),
+        faces.isEmpty() ? QString::number(event.faceCount)
+                        : QString("%1 [%2]").arg(event.faceCount).arg(faces.join(',')),
+        motion,
+        recording
+    };
+    for (int column = 0; column < cells.size(); ++column) {
+        m_table->setItem(row, column, new QTableWidgetItem(cells[column]));
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef ANOMALYPAGE_H
+#define ANOMALYPAGE_H
+
+#include <QWidget>
+#include <QVector>
+#include <QPair>
+
+class QTableWidget;
+class QComboBox;
+class QPushButton;
+class QLabel;
+class QTimer;
+class EventStore;
+struct StoredEvent;
+
+// 🆕 异常信息页：按时间倒序分页浏览事件库中的检测/录像事件
+// 翻页用 EventStore 的游标（上一页最后一条的时间和 id），返回上一页时弹出游标栈
+class AnomalyPage : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit AnomalyPage(QWidget* parent = nullptr);
+
+    void setEventStore(EventStore* store);
+
+public slots:
+    void refresh();                 // 回到第一页
+
+protected:
+    void showEvent(QShowEvent* event) override;
+
+private slots:
+    void nextPage();
+    void previousPage();
+    void onEventsWritten();
+
+private:
+    void setupUi();
+    void loadPage();
+    void fillRow(int row, const StoredEvent& event);
+
+    EventStore* m_store = nullptr;
+
+    QTableWidget* m_table = nullptr;
+    QComboBox* m_sourceFilter = nullptr;
+    QPushButton* m_prevButton = nullptr;
+    QPushButton* m_nextButton = nullptr;
+    QLabel* m_pageLabel = nullptr;
+    QTimer* m_refreshTimer = nullptr;   // 写入通知合并，避免连续刷新
+
+    // 当前页的游标与之前各页的游标栈；-1 表示第一页
+    QPair<qint64, qint64> m_cursor = qMakePair(qint64(-1), qint64(0));
+    QVector<QPair<qint64, qint64>> m_cursorStack;
+    QPair<qint64, qint64> m_nextCursor = qMakePair(qint64(-1), qint64(0));
+    bool m_hasMore = false;
+
+    static const int kPageSize = 50;
+};
+
+#endif // ANOMALYPAGE_H
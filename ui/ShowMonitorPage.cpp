@@ -12,6 +12,8 @@ extern "C" {
 }
 #include "ShowMonitorPage.h"
 #include "../main/secureVision.h"
+#include "../core/TraceRecorder.h"
+#include "../core/FlightRecorder.h"
 
 // ============================================================================
 // PerformanceMonitor实现（简化版本）
@@ -19,6 +21,8 @@ extern "C" {
 
 PerformanceMonitor::PerformanceMonitor(QObject* parent)
     : QObject(parent)
+    , m_aiQueueDepth(MetricsRegistry::instance().gauge("ai.queue.depth"))
+    , m_aiQueueFill(MetricsRegistry::instance().gauge("ai.queue.fill_pct"))
 {
     m_metricsTimer = new QTimer(this);
     connect(m_metricsTimer, &QTimer::timeout, this, &PerformanceMonitor::calculateFPS);
@@ -35,7 +39,7 @@ PerformanceMonitor::PerformanceMonitor(QObject* parent)
     debugTimer->start(60000); // 每分钟输出一次
 }
 
-void PerformanceMonitor::recordFrame(const QImage& frame)
+void PerformanceMonitor::recordFrame(const QImage& frame, const FrameMeta& meta)
 {
     QDateTime now = QDateTime::currentDateTime();
     m_frameTimestamps.enqueue(now);
@@ -55,18 +59,14 @@ void PerformanceMonitor::recordFrame(const QImage& frame)
     double frameSize = frame.width() * frame.height() * 3 / (1024.0 * 1024.0); // MB
     m_totalDataReceived += frameSize;
 
-    // 检测延迟
-    if (m_lastFrameTime.isValid()) {
-        m_metrics.frameLatency = m_lastFrameTime.msecsTo(now);
-
-        // 检测丢帧
-        double expectedInterval = 1000.0 / 30.0; // 假设30fps
-        if (m_metrics.frameLatency > expectedInterval * 1.5) {
-            m_droppedFrames++;
-            m_metrics.droppedFrames = m_droppedFrames;
+    // 🔧 延迟取该帧采集到显示的真实耗时，丢帧由序号断档精确统计（见 calculateFPS）
+    if (meta.isTraced()) {
+        m_sourceId = meta.sourceId;
+        const double latencyMs = meta.sinceCaptureMs(FrameMeta::Display);
+        if (latencyMs >= 0.0) {
+            m_metrics.frameLatency = qRound(latencyMs);
         }
     }
-    m_lastFrameTime = now;
 }
 
 void PerformanceMonitor::calculateFPS()
@@ -95,16 +95,36 @@ void PerformanceMonitor::calculateFPS()
     m_metrics.bitrate = dataInLastSecond * 8; // MB/s to Mbps
     lastDataReceived = m_totalDataReceived;
 
+    // 🆕 全链路延迟分位数与丢帧
+    if (m_sourceId >= 0) {
+        FrameLatencyTracker& tracker = FrameLatencyTracker::instance();
+        const FrameLatencyTracker::StageStats display = tracker.stats(m_sourceId, FrameMeta::Display);
+        const FrameLatencyTracker::StageStats detection = tracker.stats(m_sourceId, FrameMeta::AIDone);
+        m_metrics.displayLatencyP50 = display.p50Ms;
+        m_metrics.displayLatencyP95 = display.p95Ms;
+        m_metrics.detectionLatencyP50 = detection.p50Ms;
+        m_metrics.detectionLatencyP95 = detection.p95Ms;
+        m_metrics.droppedFrames = static_cast<int>(display.lost);
+    }
+
     emit metricsUpdated(m_metrics);
 }
 
 void PerformanceMonitor::updateSystemMetrics()
 {
-    m_metrics.cpuUsage = getCPUUsage();
-    m_metrics.memoryUsage = getMemoryUsage();
+    // 🔧 读取后台采样的最近快照，不在界面线程读 /proc
+    const SystemSnapshot snapshot = SystemMetrics::instance().latest();
+    m_metrics.cpuUsage = snapshot.processCpuPercent;
+    m_metrics.systemCpuUsage = snapshot.systemCpuPercent;
+    m_metrics.memoryUsage = snapshot.pssMb >= 0 ? snapshot.pssMb : qMax(0.0, snapshot.rssMb);
+    m_metrics.loadAverage = snapshot.load1;
+    if (!snapshot.threads.isEmpty()) {
+        m_metrics.hottestThread = snapshot.threads.first().name;
+        m_metrics.hottestThreadCpu = snapshot.threads.first().cpuPercent;
+    }
 
-    // 更新缓冲区水平（模拟）
-    m_metrics.bufferLevel = qrand() % 20 + 80; // 模拟缓冲区使用率80-100%
+    m_metrics.aiQueueDepth = static_cast<int>(m_aiQueueDepth->value());
+    m_metrics.bufferLevel = m_aiQueueFill->value();
 }
 
 void PerformanceMonitor::debugOutputMetrics()
@@ -118,28 +138,44 @@ void PerformanceMonitor::debugOutputMetrics()
                     .arg(m_metrics.resolution.height())
                     .arg(m_metrics.colorFormat);
     qDebug() << QString("Bitrate: %1 Mbps").arg(m_metrics.bitrate, 0, 'f', 1);
-    qDebug() << QString("Latency: %1 ms").arg(m_metrics.frameLatency);
+    qDebug() << QString("Latency: %1 ms (glass-to-display p50=%2 p95=%3, glass-to-detection p50=%4 p95=%5)")
+                    .arg(m_metrics.frameLatency)
+                    .arg(m_metrics.displayLatencyP50, 0, 'f', 1)
+                    .arg(m_metrics.displayLatencyP95, 0, 'f', 1)
+                    .arg(m_metrics.detectionLatencyP50, 0, 'f', 1)
+                    .arg(m_metrics.detectionLatencyP95, 0, 'f', 1);
+
+    // 🆕 各阶段累计丢帧（采集后到达该阶段前），相邻阶段之差即该阶段丢弃的帧
+    if (m_sourceId >= 0) {
+        QStringList stages;
+        for (int stage = FrameMeta::Decode; stage < FrameMeta::StageCount; ++stage) {
+            const FrameLatencyTracker::StageStats stats =
+                FrameLatencyTracker::instance().stats(m_sourceId, static_cast<FrameMeta::Stage>(stage));
+            if (stats.seen > 0) {
+                stages << QString("%1=%2").arg(FrameMeta::stageName(static_cast<FrameMeta::Stage>(stage)))
+                                          .arg(stats.lost);
+            }
+        }
+        qDebug() << "Lost before stage:" << stages.join(" ");
+    }
     qDebug() << QString("Dropped Frames: %1").arg(m_metrics.droppedFrames);
-    qDebug() << QString("CPU Usage: %1%").arg(m_metrics.cpuUsage, 0, 'f', 1);
+    qDebug() << QString("CPU Usage: %1% (system %2%, load %3)")
+                    .arg(m_metrics.cpuUsage, 0, 'f', 1)
+                    .arg(m_metrics.systemCpuUsage, 0, 'f', 1)
+                    .arg(m_metrics.loadAverage, 0, 'f', 2);
     qDebug() << QString("Memory Usage: %1 MB").arg(m_metrics.memoryUsage, 0, 'f', 0);
-    qDebug() << QString("Buffer Level: %1%").arg(m_metrics.bufferLevel, 0, 'f', 0);
+    qDebug() << QString("AI Queue: %1 (%2%)").arg(m_metrics.aiQueueDepth).arg(m_metrics.bufferLevel, 0, 'f', 0);
+
+    // 🆕 占用最高的几个线程，定位占满单核的采集/AI 线程
+    const SystemSnapshot snapshot = SystemMetrics::instance().latest();
+    for (int i = 0; i < qMin(5, snapshot.threads.size()); ++i) {
+        const ThreadCpuUsage& thread = snapshot.threads[i];
+        qDebug() << QString("  Thread %1 [%2]: %3%")
+                        .arg(thread.name).arg(thread.tid).arg(thread.cpuPercent, 0, 'f', 1);
+    }
     qDebug() << "========================================";
 }
 
-double PerformanceMonitor::getCPUUsage()
-{
-    // 简化的CPU使用率获取（实际项目中需要读取/proc/stat）
-    static int counter = 0;
-    counter = (counter + 1) % 100;
-    return 15.0 + (counter % 30); // 模拟15-45%的CPU使用率
-}
-
-double PerformanceMonitor::getMemoryUsage()
-{
-    // 简化的内存使用获取
-    return 256.0 + (qrand() % 100); // 模拟256-356MB使用量
-}
-
 // ============================================================================
 // ShowMonitorPage实现（完整保留原有功能 + 性能监控）
 // ============================================================================
@@ -259,7 +295,7 @@ void ShowMonitorPage::initPerformanceLabel()
 
     // 设置绝对定位，覆盖在视频左上角
     performanceLabel->move(10, 10);
-    performanceLabel->resize(350, 200); // 设置固定大小
+    performanceLabel->resize(350, 254); // 设置固定大小
     performanceLabel->raise(); // 确保在最上层显示
 }
 
@@ -280,7 +316,12 @@ void ShowMonitorPage::setupAIComponents()
     // 原有AI组件初始化逻辑（保持不变）
     m_visualizer = new DetectionVisualizer(this);
 
-    m_recordManager = new RecordManager(this);
+    // 🔧 与主窗口共用同一个 RecordManager（其后挂着真正的录像编码线程）
+    SecureVision* mainWindow = qobject_cast<SecureVision*>(parentWidget());
+    m_recordManager = mainWindow ? mainWindow->getRecordManager() : nullptr;
+    if (!m_recordManager) {
+        m_recordManager = new RecordManager(this);
+    }
     connect(m_recordManager, &RecordManager::recordingStateChanged,
             this, &ShowMonitorPage::onRecordingStateChanged);
 
@@ -426,39 +467,56 @@ void ShowMonitorPage::connectMipiThread()
     // 修改原有逻辑，添加性能监控
     if (captureThread) {
         disconnectThreads();
+        resyncDisplayTracking(FrameSource::Mipi);
 
-        connect(captureThread, &CaptureThread::resultReady, this, [=](QImage image) {
-            // 1. 记录帧用于性能统计（新增）
-            m_performanceMonitor->recordFrame(image);
-
-            // 2. 更新显示图像（原有逻辑）
-            updateDisplayImage(image);
-
-            // 3. 发送到AI检测（原有逻辑）
+        connect(captureThread, &CaptureThread::resultReady, this, [=](QImage image, FrameMeta meta) {
+            // 1. 发送到AI检测（🔧 先入队，显示耗时不计入检测延迟）
             if (aiEnabled && aiDetectionThread) {
                 if (!image.isNull()) {
-                    aiDetectionThread->addFrame(image);
+                    aiDetectionThread->addFrame(image, meta);
                 }
             }
+
+            // 2. 更新显示图像并记录帧用于性能统计
+            updateDisplayImage(image, meta);
         });
 
         qDebug() << "MIPI thread connected with performance monitoring";
     }
 }
 
-void ShowMonitorPage::updateDisplayImage(const QImage& originalImage)
+void ShowMonitorPage::updateDisplayImage(const QImage& originalImage, FrameMeta meta)
 {
-    // 原有显示逻辑（保持不变）
-    QImage displayImage = originalImage;
-
     // 叠加检测结果可视化
-    if (m_showDetectionOverlay && !m_lastDetectionResult.timestamp.isNull()) {
-        displayImage = m_visualizer->drawDetections(originalImage, m_lastDetectionResult);
+    if (m_showDetectionOverlay && m_lastDetectionResult.isValid()) {
+        QImage overlaid;
+        {
+            SV_TRACE_SCOPE_ARG("ui", "overlay", meta.sequence);
+            overlaid = m_visualizer->drawDetections(originalImage, m_lastDetectionResult);
+        }
+        showFrame(overlaid, meta, true);
+        return;
+    }
+    showFrame(originalImage, meta, false);
+}
+
+void ShowMonitorPage::showFrame(const QImage& image, FrameMeta meta, bool overlaid)
+{
+    FrameLatencyTracker& tracker = FrameLatencyTracker::instance();
+    if (overlaid) {
+        tracker.mark(meta, FrameMeta::Overlay);
     }
 
     // 显示到界面
-    videoLabel->setPixmap(QPixmap::fromImage(displayImage).scaled(
-        videoLabel->size(), Qt::KeepAspectRatio));
+    {
+        SV_TRACE_SCOPE_ARG("ui", "display", meta.sequence);
+        videoLabel->setPixmap(QPixmap::fromImage(image).scaled(videoLabel->size(), Qt::KeepAspectRatio));
+    }
+
+    // 🆕 采集到显示（glass-to-display）
+    tracker.mark(meta, FrameMeta::Display);
+    FlightRecorder::instance().recordFrame(meta);
+    m_performanceMonitor->recordFrame(image, meta);
 }
 
 void ShowMonitorPage::connectRtspThread1()
@@ -466,9 +524,10 @@ void ShowMonitorPage::connectRtspThread1()
     // 原有逻辑保持不变
     if (rtspThread1) {
         disconnectThreads();
+        resyncDisplayTracking(FrameSource::Rtsp1);
 
-        connect(rtspThread1, &RtspThread::resultReady, this, [=](QImage image) {
-            videoLabel->setPixmap(QPixmap::fromImage(image).scaled(videoLabel->size(), Qt::KeepAspectRatio));
+        connect(rtspThread1, &RtspThread::resultReady, this, [=](QImage image, FrameMeta meta) {
+            showFrame(image, meta, false);
         });
 
         qDebug() << "RTSP thread1 connected to videoLabel";
@@ -480,9 +539,10 @@ void ShowMonitorPage::connectRtspThread2()
     // 原有逻辑保持不变
     if (rtspThread2) {
         disconnectThreads();
+        resyncDisplayTracking(FrameSource::Rtsp2);
 
-        connect(rtspThread2, &RtspThread::resultReady, this, [=](QImage image) {
-            videoLabel->setPixmap(QPixmap::fromImage(image).scaled(videoLabel->size(), Qt::KeepAspectRatio));
+        connect(rtspThread2, &RtspThread::resultReady, this, [=](QImage image, FrameMeta meta) {
+            showFrame(image, meta, false);
         });
 
         qDebug() << "RTSP thread2 connected to videoLabel";
@@ -494,8 +554,9 @@ void ShowMonitorPage::connectUSBThread()
     // 原有逻辑保持不变
     if (usbCaptureThread) {
         disconnectThreads();
-        connect(usbCaptureThread, &USBCaptureThread::resultReady, this, [=](QImage image) {
-            videoLabel->setPixmap(QPixmap::fromImage(image).scaled(videoLabel->size(), Qt::KeepAspectRatio));
+        resyncDisplayTracking(FrameSource::Usb);
+        connect(usbCaptureThread, &USBCaptureThread::resultReady, this, [=](QImage image, FrameMeta meta) {
+            showFrame(image, meta, false);
         });
     }
 }
@@ -517,6 +578,14 @@ void ShowMonitorPage::disconnectThreads()
     }
 }
 
+void ShowMonitorPage::resyncDisplayTracking(int sourceId)
+{
+    // 没在显示这一路期间的帧本来就不会到达显示/叠加阶段，不能算作丢帧
+    FrameLatencyTracker& tracker = FrameLatencyTracker::instance();
+    tracker.resync(sourceId, FrameMeta::Overlay);
+    tracker.resync(sourceId, FrameMeta::Display);
+}
+
 void ShowMonitorPage::setStreamUrl(const QString& url)
 {
     // 原有逻辑保持不变
@@ -611,12 +680,14 @@ void ShowMonitorPage::updatePerformanceDisplay(const PerformanceMetrics& metrics
                            "│ FPS: %1 (平均: %2)                    │\n"
                            "│ 分辨率: %3×%4 %5                      │\n"
                            "│ 码率: %6 Mbps                        │\n"
-                           "│ 延迟: %7 ms                          │\n"
+                           "│ 延迟: %7 ms (p95: %16)               │\n"
+                           "│ 检测延迟: p50 %17 / p95 %18 ms       │\n"
                            "│ 丢帧: %8                             │\n"
                            "├── 系统资源 ──────────────────────────┤\n"
-                           "│ CPU: %9%                             │\n"
+                           "│ CPU: %9% (整机 %12%)                 │\n"
+                           "│ 热点线程: %13 %14%                   │\n"
                            "│ 内存: %10 MB                         │\n"
-                           "│ 缓冲区: %11%                         │\n"
+                           "│ AI队列: %11% (%15帧)                 │\n"
                            "└─────────────────────────────────────┘"
                            ).arg(QString::number(metrics.currentFPS, 'f', 1))
                            .arg(QString::number(metrics.avgFPS, 'f', 1))
@@ -628,7 +699,14 @@ void ShowMonitorPage::updatePerformanceDisplay(const PerformanceMetrics& metrics
                            .arg(metrics.droppedFrames)
                            .arg(QString::number(metrics.cpuUsage, 'f', 1))
                            .arg(QString::number(metrics.memoryUsage, 'f', 0))
-                           .arg(QString::number(metrics.bufferLevel, 'f', 0));
+                           .arg(QString::number(metrics.bufferLevel, 'f', 0))
+                           .arg(QString::number(metrics.systemCpuUsage, 'f', 1))
+                           .arg(metrics.hottestThread)
+                           .arg(QString::number(metrics.hottestThreadCpu, 'f', 0))
+                           .arg(metrics.aiQueueDepth)
+                           .arg(QString::number(metrics.displayLatencyP95, 'f', 0))
+                           .arg(QString::number(metrics.detectionLatencyP50, 'f', 0))
+                           .arg(QString::number(metrics.detectionLatencyP95, 'f', 0));
 
     performanceLabel->setText(perfText);
 }
@@ -19,6 +19,8 @@
 #include "../ai/detectionvisualizer.h"
 #include "../capture/recordmanager.h"
 #include "../widgets/aicontrolwidget.h"
+#include "../core/SystemMetrics.h"
+#include "../core/FrameLatencyTracker.h"
 
 // 性能监控相关结构（简化版本）
 struct PerformanceMetrics {
@@ -27,11 +29,24 @@ struct PerformanceMetrics {
     QSize resolution = QSize(0, 0);
     QString colorFormat;
     double bitrate = 0.0;        // Mbps
-    int frameLatency = 0;        // ms
-    double cpuUsage = 0.0;       // %
-    double memoryUsage = 0.0;    // MB
-    int droppedFrames = 0;
-    double bufferLevel = 0.0;    // %
+    int frameLatency = 0;        // ms 最近一帧采集到显示（glass-to-display）
+    double cpuUsage = 0.0;       // % 本进程，相对单核
+    double memoryUsage = 0.0;    // MB，PSS 不可用时为 RSS
+    int droppedFrames = 0;       // 采集后未到达显示的帧（按序号断档精确计数）
+    double bufferLevel = 0.0;    // % AI 待分析帧队列占用
+
+    // 🆕 来自 SystemMetrics 的真实系统指标
+    double systemCpuUsage = 0.0; // % 整机
+    double loadAverage = 0.0;    // 1 分钟负载
+    QString hottestThread;       // CPU 占用最高的线程
+    double hottestThreadCpu = 0.0;
+    int aiQueueDepth = 0;
+
+    // 🆕 全链路延迟分位数（FrameLatencyTracker）
+    double displayLatencyP50 = 0.0;     // ms 采集到显示
+    double displayLatencyP95 = 0.0;
+    double detectionLatencyP50 = 0.0;   // ms 采集到检测结果发出
+    double detectionLatencyP95 = 0.0;
 };
 
 class PerformanceMonitor : public QObject
@@ -41,7 +56,7 @@ class PerformanceMonitor : public QObject
 public:
     PerformanceMonitor(QObject* parent = nullptr);
 
-    void recordFrame(const QImage& frame);
+    void recordFrame(const QImage& frame, const FrameMeta& meta);
     PerformanceMetrics getMetrics() const { return m_metrics; }
 
 signals:
@@ -57,14 +72,14 @@ private:
 
     QQueue<QDateTime> m_frameTimestamps;
     QTimer* m_metricsTimer;
-    QDateTime m_lastFrameTime;
+    int m_sourceId = -1;        // 最近一帧的来源，用于读取该来源的延迟统计
 
     qint64 m_totalFrames = 0;
-    qint64 m_droppedFrames = 0;
     double m_totalDataReceived = 0.0;
 
-    double getCPUUsage();
-    double getMemoryUsage();
+    // 🆕 AI 队列深度由 AIDetectionThread 写入指标注册表
+    MetricGauge* m_aiQueueDepth;
+    MetricGauge* m_aiQueueFill;
 };
 
 class ShowMonitorPage : public QWidget
@@ -154,7 +169,9 @@ private:
     void connectRtspThread2();
     void connectUSBThread();
     void disconnectThreads();
-    void updateDisplayImage(const QImage& originalImage);
+    void resyncDisplayTracking(int sourceId);   // 🆕 切换到某一路后，显示端丢帧从下一帧重新计
+    void updateDisplayImage(const QImage& originalImage, FrameMeta meta);
+    void showFrame(const QImage& image, FrameMeta meta, bool overlaid);
 
     // 新增的性能监控相关方法（仅此部分是新的）
     void initPerformanceLabel();
@@ -1,4 +1,6 @@
 #include "aicontrolwidget.h"
+#include "../core/MetricsRegistry.h"
+#include "../core/TraceRecorder.h"
 #include <QDebug>
 
 AIControlWidget::AIControlWidget(QWidget *parent)
@@ -20,6 +22,12 @@ AIControlWidget::AIControlWidget(QWidget *parent)
     m_currentConfig.motionThreshold = 0.3f;
     m_currentConfig.skipFrames = 2;
 
+    // 🆕 指标采样：每秒读取一次 MetricsRegistry，与检测帧率无关
+    m_metricsTimer = new QTimer(this);
+    m_metricsTimer->setInterval(1000);
+    connect(m_metricsTimer, &QTimer::timeout, this, &AIControlWidget::refreshMetrics);
+    m_metricsTimer->start();
+
     qDebug() << "AIControlWidget: Initialization completed";
 }
 
@@ -400,6 +408,37 @@ void AIControlWidget::createStatusCard(QVBoxLayout* layout)
         );
     cardLayout->addWidget(m_recordStatusLabel);
 
+    // 🆕 性能指标
+    m_metricsLabel = new QLabel("⏱ 延迟: --");
+    m_metricsLabel->setStyleSheet(
+        "QLabel {"
+        "color: #9E9E9E;"
+        "font-size: 12px;"
+        "padding: 8px;"
+        "background-color: rgba(0, 0, 0, 100);"
+        "border-radius: 8px;"
+        "}"
+        );
+    cardLayout->addWidget(m_metricsLabel);
+
+    // 🆕 流水线追踪：录制 10 秒后导出，可用 ui.perfetto.dev 打开
+    m_traceButton = new QPushButton("🧭 录制追踪 10 秒");
+    m_traceButton->setFixedHeight(40);
+    m_traceButton->setStyleSheet(
+        "QPushButton {"
+        "color: white;"
+        "font-size: 13px;"
+        "border-radius: 8px;"
+        "background-color: rgba(0, 0, 0, 100);"
+        "border: 1px solid rgba(255, 255, 255, 50);"
+        "}"
+        "QPushButton:disabled {"
+        "color: #9E9E9E;"
+        "}"
+        );
+    connect(m_traceButton, &QPushButton::clicked, this, &AIControlWidget::onTraceCaptureClicked);
+    cardLayout->addWidget(m_traceButton);
+
     layout->addWidget(card);
 }
 
@@ -501,8 +540,8 @@ void AIControlWidget::updateDetectionStatus(const DetectionResult& result)
         bgColor = "rgba(136, 136, 136, 20)";
     }
 
-    if (!result.faces.isEmpty()) {
-        statusText += QString(" | 👤 %1张人脸").arg(result.faces.size());
+    if (result.faceCount > 0) {
+        statusText += QString(" | 👤 %1张人脸").arg(result.faceCount);
     }
 
     m_statusLabel->setText(statusText);
@@ -519,6 +558,42 @@ void AIControlWidget::updateDetectionStatus(const DetectionResult& result)
         );
 }
 
+void AIControlWidget::refreshMetrics()
+{
+    if (!m_aiEnabled || !isVisible()) return;
+
+    // 多路来源汇总：计数求和，延迟与降级级别取最差的一路
+    quint64 analyzed = 0;
+    quint64 reused = 0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double detectP95 = 0.0;
+    int level = 0;
+
+    for (const MetricsRegistry::Sample& sample : MetricsRegistry::instance().snapshot("ai.")) {
+        if (sample.name == "ai.frames.analyzed") {
+            analyzed += static_cast<quint64>(sample.value);
+        } else if (sample.name == "ai.frames.reused") {
+            reused += static_cast<quint64>(sample.value);
+        } else if (sample.name == "ai.latency.end_to_end_ms") {
+            p50 = qMax(p50, sample.p50);
+            p95 = qMax(p95, sample.p95);
+        } else if (sample.name == "ai.stage.detection_ms") {
+            detectP95 = qMax(detectP95, sample.p95);
+        } else if (sample.name == "ai.scheduler.level") {
+            level = qMax(level, static_cast<int>(sample.value));
+        }
+    }
+
+    const quint64 total = analyzed + reused;
+    m_metricsLabel->setText(QString("⏱ 延迟 p50/p95: %1/%2 ms | 检测 p95: %3 ms | 复用: %4% | 降级: %5")
+                                .arg(p50, 0, 'f', 0)
+                                .arg(p95, 0, 'f', 0)
+                                .arg(detectP95, 0, 'f', 0)
+                                .arg(total ? 100.0 * reused / total : 0.0, 0, 'f', 0)
+                                .arg(level));
+}
+
 void AIControlWidget::updateRecordingStatus(RecordManager::RecordState state)
 {
     QString statusText;
@@ -641,3 +716,25 @@ void AIControlWidget::updateStatusDisplay()
             );
     }
 }
+
+void AIControlWidget::onTraceCaptureClicked()
+{
+    if (TraceRecorder::instance().isRecording()) {
+        return;
+    }
+
+    TraceRecorder::instance().start();
+    m_traceButton->setEnabled(false);
+    m_traceButton->setText("🧭 追踪录制中...");
+    QTimer::singleShot(10000, this, &AIControlWidget::finishTraceCapture);
+}
+
+void AIControlWidget::finishTraceCapture()
+{
+    const QString path = TraceRecorder::defaultDumpPath();
+    const bool ok = TraceRecorder::instance().dumpChromeJson(path);
+    qDebug() << "AIControlWidget: Trace capture" << (ok ? "saved to" : "failed to save to") << path;
+
+    m_traceButton->setEnabled(true);
+    m_traceButton->setText(ok ? "🧭 追踪已保存，再录 10 秒" : "🧭 追踪保存失败，重试");
+}
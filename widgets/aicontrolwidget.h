@@ -11,6 +11,7 @@
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QFrame>
+#include <QTimer>
 #include "../ai/aitypes.h"
 #include "../capture/recordmanager.h"
 
@@ -36,6 +37,9 @@ private slots:
     void onVisualizationToggled(bool enabled);
     void onRecordingToggled(bool enabled);
     void onThresholdChanged(int value);
+    void refreshMetrics();      // 🆕 按固定节奏采样 AI 指标
+    void onTraceCaptureClicked();   // 🆕 录制一段流水线追踪
+    void finishTraceCapture();
 
 private:
     // UI组件
@@ -46,6 +50,9 @@ private:
     QLabel* m_thresholdLabel;
     QLabel* m_statusLabel;
     QLabel* m_recordStatusLabel;
+    QLabel* m_metricsLabel;     // 🆕 延迟/复用/降级指标
+    QTimer* m_metricsTimer;
+    QPushButton* m_traceButton; // 🆕 录制 10 秒追踪并导出 Chrome trace JSON
 
     // 状态
     bool m_aiEnabled = false;